@@ -24,6 +24,7 @@
 #include <stmm-input/capability.h>
 
 #include <string>
+#include <vector>
 
 #include <stdint.h>
 
@@ -52,10 +53,71 @@ namespace stmi
  * to receive a SndFinishedEvent when the sound has finished playing or the
  * device was removed. A listeners being removed will receive the SndFinishedEvent
  * only if it was added with the finalization flag.
+ *
+ * When preloadSounds() is called, an event listener can expect to receive a
+ * SndPreloadedEvent for each file when it is ready or failed to load and one
+ * when the whole batch is done. Batches are loaded in the background: a sound
+ * played while its batch is still loading doesn't wait for the batch and
+ * batches with higher priority are loaded first.
+ *
+ * Sounds can be played in a sound group (bus) obtained with getSoundGroup().
+ * The volume of all the sounds of a group can be changed and they can be
+ * paused, resumed and stopped with one call.
+ *
+ * Sounds can be scheduled to start at a time of the device clock with
+ * playSoundAt() and playSoundsTogether(). Unlike sounds started with playSound(),
+ * their start doesn't depend on when the backend gets to the command.
+ *
+ * Sounds that must start with minimal latency (ex. weapon fire) can be
+ * prepared ahead of time with prepareSound() and started with triggerSound().
+ *
+ * The state and play position of a sound can be queried with getSoundState()
+ * without waiting for its SndFinishedEvent.
  */
 class PlaybackCapability : public Capability
 {
 public:
+	/** The priority of a batch of pre-loads.
+	 */
+	enum PRELOAD_PRIORITY
+	{
+		PRELOAD_PRIORITY_FIRST = 0
+		, PRELOAD_PRIORITY_LOW = 0 /**< Loaded after all other batches (ex. sounds of the next level). */
+		, PRELOAD_PRIORITY_NORMAL = 1 /**< The default. */
+		, PRELOAD_PRIORITY_HIGH = 2 /**< Loaded before all other batches (ex. sounds needed right now). */
+		, PRELOAD_PRIORITY_LAST = 2
+	};
+	/** The shape of a volume ramp.
+	 */
+	enum RAMP_CURVE
+	{
+		RAMP_CURVE_FIRST = 0
+		, RAMP_CURVE_LINEAR = 0 /**< The volume changes linearly. */
+		, RAMP_CURVE_SMOOTH = 1 /**< The volume changes slowly at the start and the end (smoothstep). */
+		, RAMP_CURVE_EXPONENTIAL = 2 /**< The volume changes linearly in decibels (down to -60 dB).
+										 * Usually perceived as the most even fade. */
+		, RAMP_CURVE_LAST = 2
+	};
+	/** The state of a sound as seen by the backend.
+	 */
+	enum SOUND_STATE
+	{
+		SOUND_STATE_FIRST = 0
+		, SOUND_STATE_UNKNOWN = 0 /**< Not a sound of the device or too old to be known. */
+		, SOUND_STATE_PENDING = 1 /**< Not started yet (not yet executed, scheduled or prepared). */
+		, SOUND_STATE_PLAYING = 2 /**< Playing. */
+		, SOUND_STATE_PAUSED = 3 /**< Paused by pauseSound(), its group or the device. */
+		, SOUND_STATE_STOPPED = 4 /**< Finished or stopped. The SndFinishedEvent might not have been delivered yet. */
+		, SOUND_STATE_LAST = 4
+	};
+	/** Return data type of getSoundState().
+	 */
+	struct SoundState
+	{
+		SOUND_STATE m_eState = SOUND_STATE_UNKNOWN; /**< The state. Default is SOUND_STATE_UNKNOWN. */
+		double m_fOffsetSec = -1.0; /**< The play position in seconds from the start of the sound or -1 if not known. */
+		double m_fLengthSec = -1.0; /**< The length of the sound in seconds or -1 if not known (ex. streamed). */
+	};
 	/** Return data type.
 	 */
 	struct SoundData
@@ -64,6 +126,33 @@ public:
 		int32_t m_nFileId = -1; /**< The file id. Allows to play the file or buffer again
 									 * possibly more efficiently (using cache). Negative if error. Default is -1. */
 	};
+	/** Return data type of preloadSounds().
+	 */
+	struct PreloadBatch
+	{
+		int32_t m_nBatchId = -1; /**< The batch id. Negative if error. Default is -1. */
+		std::vector<int32_t> m_aFileIds; /**< The file ids, in the same order as the file names. */
+	};
+	/** Sound of playSoundsTogether().
+	 */
+	struct SyncedSound
+	{
+		int32_t m_nFileId = -1; /**< The id of a previously played or pre-loaded file or buffer. */
+		int32_t m_nGroupId = -1; /**< The group id returned by getSoundGroup() or -1 if none. Default is -1. */
+		double m_fVolume = 1.0; /**< The volume (0.0 inaudible, 1.0 maximum). Default is 1.0. */
+		bool m_bLoop = false; /**< Whether to loop. Default is false. */
+		bool m_bRelative = true; /**< Whether the position is relative to the listener. Default is true. */
+		double m_fX = 0.0; /**< The x coord. */
+		double m_fY = 0.0; /**< The y coord. */
+		double m_fZ = 0.0; /**< The z coord. */
+	};
+	/** Sound bank entry data type.
+	 */
+	struct BankEntry
+	{
+		std::string m_sName; /**< The name of the entry within the bank. */
+		int32_t m_nFileId = -1; /**< The file id. Can be used with the playSound method. */
+	};
 public:
 	/** Pre-load sound file.
 	 * The returned file id can be used with the playSound method.
@@ -78,6 +167,42 @@ public:
 	 * @return The file id or negative if error (ex. device removed).
 	 */
 	virtual int32_t preloadSound(uint8_t const* p0Buffer, int32_t nBufferSize) noexcept = 0;
+	/** Pre-load many sound files at once.
+	 * The files might be decoded in parallel. For each file a SndPreloadedEvent
+	 * is sent when it is ready or if it couldn't be loaded, followed by a
+	 * SndPreloadedEvent for the whole batch.
+	 * The returned file ids can be used with the playSound method.
+	 *
+	 * Batches are loaded after the other commands (ex. playSound) sent to the
+	 * device, in order of priority, batches with the same priority in the order
+	 * they were requested.
+	 * @param aFileNames The absolute paths of the sound files. Cannot be empty. The names cannot be empty.
+	 * @param ePriority The priority of the batch.
+	 * @return The batch id and the file ids. The batch id is negative if error (ex. device removed).
+	 */
+	virtual PreloadBatch preloadSounds(const std::vector<std::string>& aFileNames, PRELOAD_PRIORITY ePriority) noexcept = 0;
+	/** Pre-load many sound files at once with normal priority.
+	 * See preloadSounds(const std::vector<std::string>&, PRELOAD_PRIORITY).
+	 * @param aFileNames The absolute paths of the sound files. Cannot be empty. The names cannot be empty.
+	 * @return The batch id and the file ids. The batch id is negative if error (ex. device removed).
+	 */
+	PreloadBatch preloadSounds(const std::vector<std::string>& aFileNames) noexcept;
+	/** Cancel the not yet loaded files of a batch.
+	 * The files of the batch already loaded stay loaded.
+	 * Note: no further SndPreloadedEvent is sent to listeners for the batch.
+	 * @param nBatchId The batch id returned by preloadSounds().
+	 * @return Whether the batch was still loading.
+	 */
+	virtual bool cancelPreloadBatch(int32_t nBatchId) noexcept = 0;
+	/** Pre-load all the sounds of a sound bank.
+	 * A sound bank is a single file containing many sounds, indexed by name.
+	 * The bank is mapped into memory once and stays mapped for the lifetime
+	 * of the device manager, each entry is pre-loaded as a buffer.
+	 * Pre-loading the same bank again returns the same file ids.
+	 * @param sBankPath The absolute path of the bank file. Cannot be empty.
+	 * @return The entries and their file ids. Empty if error (ex. device removed, invalid bank).
+	 */
+	virtual std::vector<BankEntry> preloadBank(const std::string& sBankPath) noexcept = 0;
 	/** Play sound file at a given position.
 	 * @param sFileName The absolute path of the sound file. Cannot be empty.
 	 * @param bRelative Whether the position is relative to the listener.
@@ -116,6 +241,123 @@ public:
 	 */
 	virtual int32_t playSound(int32_t nFileId, double fVolume, bool bLoop
 							, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Play sound file at a given position in a sound group.
+	 * The volume of the sound is multiplied by the volume of the group.
+	 * If the group is paused the sound starts paused.
+	 * @param nGroupId The group id returned by getSoundGroup().
+	 * @param sFileName The absolute path of the sound file. Cannot be empty.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @return The sound data. The sound id is negative if error (ex. invalid group).
+	 */
+	virtual SoundData playSoundInGroup(int32_t nGroupId, const std::string& sFileName, double fVolume, bool bLoop
+										, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Play sound buffer at a given position in a sound group.
+	 * See playSoundInGroup(int32_t, const std::string&, double, bool, bool, double, double, double).
+	 * @param nGroupId The group id returned by getSoundGroup().
+	 * @param p0Buffer The pointer to a buffer. Cannot be null.
+	 * @param nBufferSize The size of the buffer. Cannot be negative.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @return The sound data. The sound id is negative if error (ex. invalid group).
+	 */
+	virtual SoundData playSoundInGroup(int32_t nGroupId, uint8_t const* p0Buffer, int32_t nBufferSize, double fVolume, bool bLoop
+										, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Play previously played or pre-loaded file or buffer at a given position in a sound group.
+	 * See playSoundInGroup(int32_t, const std::string&, double, bool, bool, double, double, double).
+	 * @param nGroupId The group id returned by getSoundGroup().
+	 * @param nFileId The id of the previously played file or buffer to play as a new sound.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @return The sound id or negative if error.
+	 */
+	virtual int32_t playSoundInGroup(int32_t nGroupId, int32_t nFileId, double fVolume, bool bLoop
+									, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** The current time of the device clock.
+	 * The clock of the device the scheduled sounds start at (the rendered time
+	 * of the device if the backend supports it, a steady clock otherwise).
+	 * Note that the clock might not advance while the device isn't rendering.
+	 * @return The time in nanoseconds or negative if error (ex. device removed).
+	 */
+	virtual int64_t getDeviceClockNanosec() noexcept = 0;
+	/** Play previously played or pre-loaded file or buffer at a given time of the device clock.
+	 * The sound is started by the backend as precisely as the device allows
+	 * (sample accurate if supported). If the time has already passed the sound
+	 * starts as soon as possible. The sound is always fully loaded, never streamed.
+	 * @param nFileId The id of the previously played file or buffer to play as a new sound.
+	 * @param nDeviceClockNanosec The start time. See getDeviceClockNanosec(). Cannot be negative.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @return The sound id or negative if error.
+	 */
+	virtual int32_t playSoundAt(int32_t nFileId, int64_t nDeviceClockNanosec, double fVolume, bool bLoop
+								, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Play many previously played or pre-loaded files or buffers starting at the same time.
+	 * Either all the sounds are played or none. They start in the same
+	 * rendering cycle of the device. See playSoundAt().
+	 * @param aSounds The sounds. Cannot be empty.
+	 * @param nDeviceClockNanosec The start time. See getDeviceClockNanosec(). Cannot be negative.
+	 *                            Pass 0 to start the sounds as soon as possible.
+	 * @return The sound ids, in the same order as the sounds, or empty if error.
+	 */
+	virtual std::vector<int32_t> playSoundsTogether(const std::vector<SyncedSound>& aSounds, int64_t nDeviceClockNanosec) noexcept = 0;
+	/** Prepare a previously played or pre-loaded file or buffer to be started by triggerSound().
+	 * The backend sets up the sound ahead of time, but doesn't start it.
+	 * Until triggered the sound can be paused, moved, stopped, etc. like any other
+	 * sound. The sound is always fully loaded, never streamed.
+	 *
+	 * The number of prepared sounds not triggered yet is limited.
+	 * @param nFileId The id of the previously played file or buffer to prepare as a new sound.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @return The sound id or negative if error (ex. too many prepared sounds).
+	 */
+	virtual int32_t prepareSound(int32_t nFileId, double fVolume, bool bLoop
+								, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Start a prepared sound.
+	 * No command is queued and no lock is taken: a flag is set that wakes
+	 * up the backend, which starts the sound.
+	 * @param nSoundId The id returned by prepareSound().
+	 * @return Whether the sound was prepared and not triggered yet.
+	 */
+	virtual bool triggerSound(int32_t nSoundId) noexcept = 0;
+	/** The state of a sound.
+	 * The backend publishes the state of its sounds regularly (usually more than
+	 * once per period of the main loop). This function reads the last published
+	 * state without locks and without queuing a command.
+	 * The play position of a playing sound is extrapolated to now.
+	 *
+	 * Commands not yet executed by the backend (ex. pauseSound()) are not reflected
+	 * in the state except that a sound stopped with stopSound(), stopGroup() or
+	 * stopAllSounds() is SOUND_STATE_STOPPED (SOUND_STATE_UNKNOWN if the backend
+	 * never got to it).
+	 *
+	 * Only the state of a limited number of recent sounds is kept: the state of
+	 * a sound that stopped long ago might be SOUND_STATE_UNKNOWN.
+	 * @param nSoundId The sound id.
+	 * @return The state.
+	 */
+	virtual SoundState getSoundState(int32_t nSoundId) noexcept = 0;
 	/** Play sound file at current listener position.
 	 * The sound is played at maximum volume.
 	 * @param sFileName The absolute path of the sound file. Cannot be empty.
@@ -137,6 +379,42 @@ public:
 	 * @return The sound id or negative if error.
 	 */
 	int32_t playSound(int32_t nFileId) noexcept;
+	/** Play sound file at a given position moving with a given velocity.
+	 * Same as playSound(const std::string&, double, bool, bool, double, double, double)
+	 * followed by setSoundMotion().
+	 * @param sFileName The absolute path of the sound file. Cannot be empty.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @param fVelX The x component of the velocity in units per second.
+	 * @param fVelY The y component of the velocity in units per second.
+	 * @param fVelZ The z component of the velocity in units per second.
+	 * @return The sound data.
+	 */
+	SoundData playSound(const std::string& sFileName, double fVolume, bool bLoop
+						, bool bRelative, double fX, double fY, double fZ
+						, double fVelX, double fVelY, double fVelZ) noexcept;
+	/** Play previously played or pre-loaded file or buffer at a given position moving with a given velocity.
+	 * Same as playSound(int32_t, double, bool, bool, double, double, double)
+	 * followed by setSoundMotion().
+	 * @param nFileId The id of the previously played file or buffer to play as a new sound.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @param bLoop Whether to loop.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @param fVelX The x component of the velocity in units per second.
+	 * @param fVelY The y component of the velocity in units per second.
+	 * @param fVelZ The z component of the velocity in units per second.
+	 * @return The sound id or negative if error.
+	 */
+	int32_t playSound(int32_t nFileId, double fVolume, bool bLoop
+					, bool bRelative, double fX, double fY, double fZ
+					, double fVelX, double fVelY, double fVelZ) noexcept;
 
 	/** Set position of a currently playing sound.
 	 * @param nSoundId The sound id.
@@ -147,12 +425,98 @@ public:
 	 * @return Whether could set the position.
 	 */
 	virtual bool setSoundPos(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ) noexcept = 0;
+	/** Set position and velocity of a currently playing sound.
+	 * The sound keeps moving from the given position with the given velocity
+	 * until it stops, setSoundPos() is called or its motion is changed.
+	 * The position is updated by the backend, the velocity is also used
+	 * for the Doppler effect if the backend supports it.
+	 * @param nSoundId The sound id.
+	 * @param bRelative Whether the position is relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @param fVelX The x component of the velocity in units per second.
+	 * @param fVelY The y component of the velocity in units per second.
+	 * @param fVelZ The z component of the velocity in units per second.
+	 * @return Whether could set the motion.
+	 */
+	virtual bool setSoundMotion(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+								, double fVelX, double fVelY, double fVelZ) noexcept = 0;
+	/** Move a currently playing sound to a target position.
+	 * The sound moves from the given position to the target with constant
+	 * velocity and stays there once it has arrived.
+	 * See setSoundMotion().
+	 * @param nSoundId The sound id.
+	 * @param bRelative Whether the positions are relative to the listener.
+	 * @param fX The x coord.
+	 * @param fY The y coord.
+	 * @param fZ The z coord.
+	 * @param fTargetX The x coord of the target.
+	 * @param fTargetY The y coord of the target.
+	 * @param fTargetZ The z coord of the target.
+	 * @param nArrivalMillisec The time from now the target is reached. Must be positive.
+	 * @return Whether could set the motion.
+	 */
+	virtual bool setSoundMotionTo(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+								, double fTargetX, double fTargetY, double fTargetZ, int32_t nArrivalMillisec) noexcept = 0;
 	/** Set volume of a currently playing sound.
 	 * @param nSoundId The sound id.
 	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
 	 * @return Whether could set the volume.
 	 */
 	virtual bool setSoundVol(int32_t nSoundId, double fVolume) noexcept = 0;
+	/** Gradually change the volume of a currently playing sound.
+	 * The ramp starts from the current volume of the sound and is evaluated
+	 * by the backend at a fixed cadence. setSoundVol() cancels the ramp.
+	 * @param nSoundId The sound id.
+	 * @param fTargetVolume The volume at the end of the ramp (0.0 inaudible, 1.0 maximum).
+	 * @param nDurationMillisec The duration of the ramp. Cannot be negative.
+	 * @param eCurve The shape of the ramp.
+	 * @return Whether could start the ramp.
+	 */
+	virtual bool rampSoundVol(int32_t nSoundId, double fTargetVolume, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept = 0;
+	/** Fade out a currently playing sound and stop it.
+	 * Unlike stopSound(), when the volume reaches 0.0 a SndFinishedEvent
+	 * of type SndFinishedEvent::FINISHED_TYPE_FADED_OUT is sent to listeners.
+	 * setSoundVol() and rampSoundVol() cancel the fade out.
+	 * @param nSoundId The sound id.
+	 * @param nDurationMillisec The duration of the fade out. Cannot be negative.
+	 * @param eCurve The shape of the ramp.
+	 * @return Whether could start the fade out.
+	 */
+	virtual bool fadeOutAndStop(int32_t nSoundId, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept = 0;
+
+	/** Get or create a sound group.
+	 * The group id is only valid within the instance that created it.
+	 * A new group has volume 1.0 and is not paused.
+	 * @param sGroupName The name of the group (ex. "sfx", "ambient"). Cannot be empty.
+	 * @return The group id or negative if error (ex. device removed).
+	 */
+	virtual int32_t getSoundGroup(const std::string& sGroupName) noexcept = 0;
+	/** Set volume of a sound group.
+	 * The volume of each sound of the group is multiplied by the group volume.
+	 * @param nGroupId The group id.
+	 * @param fVolume The volume (0.0 inaudible, 1.0 maximum).
+	 * @return Whether the group exists.
+	 */
+	virtual bool setGroupVol(int32_t nGroupId, double fVolume) noexcept = 0;
+	/** Pause all the sounds of a group, including those played later.
+	 * @param nGroupId The group id.
+	 * @return Whether the group exists and was not paused (independent from device and sound pausing).
+	 */
+	virtual bool pauseGroup(int32_t nGroupId) noexcept = 0;
+	/** Resume the sounds of a group.
+	 * Sounds individually paused with pauseSound() stay paused.
+	 * @param nGroupId The group id.
+	 * @return Whether the group exists and was paused (independent from device and sound pausing).
+	 */
+	virtual bool resumeGroup(int32_t nGroupId) noexcept = 0;
+	/** Stop all the sounds of a group.
+	 * Note: no SndFinishedEvent is sent to listeners.
+	 * @param nGroupId The group id.
+	 * @return Whether the group exists.
+	 */
+	virtual bool stopGroup(int32_t nGroupId) noexcept = 0;
 
 	/** Set listener position.
 	 * @param fX The x coord.
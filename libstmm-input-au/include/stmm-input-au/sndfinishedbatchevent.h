@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndfinishedbatchevent.h
+ */
+
+#ifndef STMI_SND_FINISHED_BATCH_EVENT_H
+#define STMI_SND_FINISHED_BATCH_EVENT_H
+
+#include "sndfinishedevent.h"
+
+#include <stmm-input/event.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace stmi { class Capability; }
+namespace stmi { class PlaybackCapability; }
+
+namespace stmi
+{
+
+using std::shared_ptr;
+using std::weak_ptr;
+
+/** Event generated for the sounds that finished at once.
+ * A device manager that batches the finished sounds sends this event
+ * instead of a SndFinishedEvent for each sound.
+ * The entries are in the order the sounds finished.
+ *
+ * Note that the reference to the capability that generated this event is weak.
+ */
+class SndFinishedBatchEvent : public Event
+{
+public:
+	struct Entry
+	{
+		int32_t m_nSoundId; /**< The sound id that finished playing. */
+		SndFinishedEvent::FINISHED_TYPE m_eFinishedType; /**< The type of finish. */
+		int64_t m_nTimeUsec; /**< When the sound finished. Time from epoch in microseconds. */
+	};
+	/** Constructor.
+	 * @param nTimeUsec Time from epoch in microseconds.
+	 * @param refPlaybackCapability The capability that generated this event. Cannot be null.
+	 * @param aEntries The finished sounds. Cannot be empty.
+	 */
+	SndFinishedBatchEvent(int64_t nTimeUsec, const shared_ptr<PlaybackCapability>& refPlaybackCapability
+						, std::vector<Entry>&& aEntries) noexcept;
+	/** The playback capability that generated the event.
+	 * @return The capability or null if the capability was deleted.
+	 */
+	inline shared_ptr<PlaybackCapability> getPlaybackCapability() const noexcept { return m_refPlaybackCapability.lock(); }
+	//
+	shared_ptr<Capability> getCapability() const noexcept override;
+	/** The number of finished sounds.
+	 * @return The number of entries. Is positive.
+	 */
+	int32_t getTotEntries() const noexcept { return static_cast<int32_t>(m_aEntries.size()); }
+	/** The finished sound at the given position.
+	 * @param nIdx The index. Must be &gt;= 0 and &lt; getTotEntries().
+	 * @return The entry.
+	 */
+	const Entry& getEntry(int32_t nIdx) const noexcept;
+	/** The finished sounds.
+	 * @return The contiguous array of entries.
+	 */
+	const std::vector<Entry>& getEntries() const noexcept { return m_aEntries; }
+
+	//
+	static const char* const s_sClassId;
+	static const Event::Class& getClass() noexcept
+	{
+		static const Event::Class s_oSndFinishedBatchClass = s_oInstall.getEventClass();
+		return s_oSndFinishedBatchClass;
+	}
+private:
+	std::vector<Entry> m_aEntries;
+	weak_ptr<PlaybackCapability> m_refPlaybackCapability;
+	//
+	static RegisterClass<SndFinishedBatchEvent> s_oInstall;
+private:
+	SndFinishedBatchEvent() = delete;
+};
+
+} // namespace stmi
+
+#endif /* STMI_SND_FINISHED_BATCH_EVENT_H */
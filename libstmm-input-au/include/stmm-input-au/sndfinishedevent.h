@@ -49,7 +49,8 @@ public:
 		, FINISHED_TYPE_LISTENER_REMOVED = 2 /**< The listener receiving this event is being removed.
 												* The sound might actually still be playing. */
 		, FINISHED_TYPE_FILE_NOT_FOUND = 3 /**< The sound couldn't be started because file not found. */
-		, FINISHED_TYPE_LAST = 3
+		, FINISHED_TYPE_FADED_OUT = 4 /**< The sound was stopped at the end of PlaybackCapability::fadeOutAndStop(). */
+		, FINISHED_TYPE_LAST = 4
 	};
 	/** Constructor.
 	 * @param nTimeUsec Time from epoch in microseconds.
@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndpreloadedevent.h
+ */
+
+#ifndef STMI_SND_PRELOADED_EVENT_H
+#define STMI_SND_PRELOADED_EVENT_H
+
+#include <stmm-input/event.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace stmi { class Capability; }
+namespace stmi { class PlaybackCapability; }
+
+namespace stmi
+{
+
+using std::shared_ptr;
+using std::weak_ptr;
+
+/** Event generated when the files of a PlaybackCapability::preloadSounds() batch are loaded.
+ * An event is sent for each file of the batch when it is ready or couldn't be loaded,
+ * followed by an event for the whole batch.
+ *
+ * Note that the reference to the capability that generated this event is weak.
+ */
+class SndPreloadedEvent : public Event
+{
+public:
+	enum PRELOADED_TYPE
+	{
+		PRELOADED_TYPE_FIRST = 0
+		, PRELOADED_TYPE_FILE_LOADED = 0 /**< A file of the batch is ready to be played. */
+		, PRELOADED_TYPE_FILE_FAILED = 1 /**< A file of the batch couldn't be loaded (ex. file not found). */
+		, PRELOADED_TYPE_BATCH_COMPLETED = 2 /**< All the files of the batch were handled. See getTotFailed(). */
+		, PRELOADED_TYPE_BATCH_ABORTED = 3 /**< The batch couldn't be completed (probably device is being removed). */
+		, PRELOADED_TYPE_LAST = 3
+	};
+	/** Constructor.
+	 * @param nTimeUsec Time from epoch in microseconds.
+	 * @param refPlaybackCapability The capability that generated this event. Cannot be null.
+	 * @param ePreloadedType The type.
+	 * @param nBatchId The batch id. Must be &gt;= 0.
+	 * @param nFileId The file id or -1 if the event is about the whole batch.
+	 * @param nTotFailed The number of files of the batch that couldn't be loaded so far. Cannot be negative.
+	 */
+	SndPreloadedEvent(int64_t nTimeUsec, const shared_ptr<PlaybackCapability>& refPlaybackCapability
+					, PRELOADED_TYPE ePreloadedType, int32_t nBatchId, int32_t nFileId, int32_t nTotFailed) noexcept;
+	/** The playback capability that generated the event.
+	 * @return The capability or null if the capability was deleted.
+	 */
+	inline shared_ptr<PlaybackCapability> getPlaybackCapability() const noexcept { return m_refPlaybackCapability.lock(); }
+	//
+	shared_ptr<Capability> getCapability() const noexcept override;
+	/** The type of the event.
+	 * @return The type.
+	 */
+	PRELOADED_TYPE getPreloadedType() const noexcept { return m_ePreloadedType; }
+	/** The batch id as returned by PlaybackCapability::preloadSounds().
+	 * @return The batch id.
+	 */
+	int32_t getBatchId() const noexcept { return m_nBatchId; }
+	/** The file id.
+	 * @return The file id or -1 if the event is about the whole batch.
+	 */
+	int32_t getFileId() const noexcept { return m_nFileId; }
+	/** The number of files of the batch that couldn't be loaded so far.
+	 * @return The number of failed files.
+	 */
+	int32_t getTotFailed() const noexcept { return m_nTotFailed; }
+
+	//
+	static const char* const s_sClassId;
+	static const Event::Class& getClass() noexcept
+	{
+		static const Event::Class s_oSndPreloadedClass = s_oInstall.getEventClass();
+		return s_oSndPreloadedClass;
+	}
+private:
+	PRELOADED_TYPE m_ePreloadedType;
+	int32_t m_nBatchId;
+	int32_t m_nFileId;
+	int32_t m_nTotFailed;
+	weak_ptr<PlaybackCapability> m_refPlaybackCapability;
+	//
+	static RegisterClass<SndPreloadedEvent> s_oInstall;
+private:
+	SndPreloadedEvent() = delete;
+};
+
+} // namespace stmi
+
+#endif /* STMI_SND_PRELOADED_EVENT_H */
@@ -41,5 +41,29 @@ int32_t PlaybackCapability::playSound(int32_t nFileId) noexcept
 {
 	return playSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
 }
+PlaybackCapability::SoundData PlaybackCapability::playSound(const std::string& sFileName, double fVolume, bool bLoop
+																, bool bRelative, double fX, double fY, double fZ
+																, double fVelX, double fVelY, double fVelZ) noexcept
+{
+	const SoundData oSoundData = playSound(sFileName, fVolume, bLoop, bRelative, fX, fY, fZ);
+	if (oSoundData.m_nSoundId >= 0) {
+		setSoundMotion(oSoundData.m_nSoundId, bRelative, fX, fY, fZ, fVelX, fVelY, fVelZ);
+	}
+	return oSoundData;
+}
+int32_t PlaybackCapability::playSound(int32_t nFileId, double fVolume, bool bLoop
+									, bool bRelative, double fX, double fY, double fZ
+									, double fVelX, double fVelY, double fVelZ) noexcept
+{
+	const int32_t nSoundId = playSound(nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+	if (nSoundId >= 0) {
+		setSoundMotion(nSoundId, bRelative, fX, fY, fZ, fVelX, fVelY, fVelZ);
+	}
+	return nSoundId;
+}
+PlaybackCapability::PreloadBatch PlaybackCapability::preloadSounds(const std::vector<std::string>& aFileNames) noexcept
+{
+	return preloadSounds(aFileNames, PRELOAD_PRIORITY_NORMAL);
+}
 
 } // namespace stmi
@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndfinishedbatchevent.cc
+ */
+
+#include "sndfinishedbatchevent.h"
+
+#include "playbackcapability.h"
+
+#include <stmm-input/event.h>
+
+#include <memory>
+#include <utility>
+#include <cassert>
+
+namespace stmi { class Accessor; }
+
+namespace stmi
+{
+
+const char* const SndFinishedBatchEvent::s_sClassId = "stmi::Playback:SndFinishedBatchEvent";
+Event::RegisterClass<SndFinishedBatchEvent> SndFinishedBatchEvent::s_oInstall(s_sClassId);
+
+SndFinishedBatchEvent::SndFinishedBatchEvent(int64_t nTimeUsec, const shared_ptr<PlaybackCapability>& refPlaybackCapability
+											, std::vector<Entry>&& aEntries) noexcept
+: Event(s_oInstall.getEventClass(), nTimeUsec, (refPlaybackCapability ? refPlaybackCapability->getId() : -1)
+			, shared_ptr<Accessor>{})
+, m_aEntries(std::move(aEntries))
+, m_refPlaybackCapability(refPlaybackCapability)
+{
+	assert(! m_aEntries.empty());
+	#ifndef NDEBUG
+	for (const auto& oEntry : m_aEntries) {
+		assert(oEntry.m_nSoundId >= 0);
+		assert((oEntry.m_eFinishedType >= SndFinishedEvent::FINISHED_TYPE_FIRST)
+				&& (oEntry.m_eFinishedType <= SndFinishedEvent::FINISHED_TYPE_LAST));
+	}
+	#endif //NDEBUG
+}
+
+shared_ptr<Capability> SndFinishedBatchEvent::getCapability() const noexcept
+{
+	return m_refPlaybackCapability.lock();
+}
+const SndFinishedBatchEvent::Entry& SndFinishedBatchEvent::getEntry(int32_t nIdx) const noexcept
+{
+	assert((nIdx >= 0) && (nIdx < getTotEntries()));
+	return m_aEntries[nIdx];
+}
+
+} // namespace stmi
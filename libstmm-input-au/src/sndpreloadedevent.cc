@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndpreloadedevent.cc
+ */
+
+#include "sndpreloadedevent.h"
+
+#include "playbackcapability.h"
+
+#include <stmm-input/event.h>
+
+#include <memory>
+#include <cassert>
+
+namespace stmi { class Accessor; }
+
+namespace stmi
+{
+
+const char* const SndPreloadedEvent::s_sClassId = "stmi::Playback:SndPreloadedEvent";
+Event::RegisterClass<SndPreloadedEvent> SndPreloadedEvent::s_oInstall(s_sClassId);
+
+SndPreloadedEvent::SndPreloadedEvent(int64_t nTimeUsec, const shared_ptr<PlaybackCapability>& refPlaybackCapability
+									, PRELOADED_TYPE ePreloadedType, int32_t nBatchId, int32_t nFileId, int32_t nTotFailed) noexcept
+: Event(s_oInstall.getEventClass(), nTimeUsec, (refPlaybackCapability ? refPlaybackCapability->getId() : -1)
+			, shared_ptr<Accessor>{})
+, m_ePreloadedType(ePreloadedType)
+, m_nBatchId(nBatchId)
+, m_nFileId(nFileId)
+, m_nTotFailed(nTotFailed)
+, m_refPlaybackCapability(refPlaybackCapability)
+{
+	assert((ePreloadedType >= PRELOADED_TYPE_FIRST) && (ePreloadedType <= PRELOADED_TYPE_LAST));
+	assert(nBatchId >= 0);
+	assert(nFileId >= -1);
+	assert(nTotFailed >= 0);
+}
+
+shared_ptr<Capability> SndPreloadedEvent::getCapability() const noexcept
+{
+	return m_refPlaybackCapability.lock();
+}
+
+} // namespace stmi
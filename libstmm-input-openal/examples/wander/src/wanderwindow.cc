@@ -1200,6 +1200,8 @@ void WanderWindow::printToEvents(stmi::SndFinishedEvent& oEvent) noexcept
 		sType = "Listener gone ";
 	} else if (eFT == stmi::SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND) {
 		sType = "File Not Found";
+	} else if (eFT == stmi::SndFinishedEvent::FINISHED_TYPE_FADED_OUT) {
+		sType = "Faded out     ";
 	} else {
 		sType = "Error         ";
 	}
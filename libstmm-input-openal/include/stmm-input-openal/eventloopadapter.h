@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   eventloopadapter.h
+ */
+
+#ifndef STMI_EVENT_LOOP_ADAPTER_H
+#define STMI_EVENT_LOOP_ADAPTER_H
+
+#include <functional>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+/** The integration of a device manager with the event loop of the application.
+ * @see OpenAlDeviceManager::setEventLoopAdapter()
+ *
+ * The backend queues the events (ex. SndFinishedEvent) from its own thread
+ * and makes a file descriptor readable. The adapter watches it with the event
+ * loop (epoll, asio, libuv, ...) and, when readable, calls the dispatch function
+ * which sends the events to the listeners and drains the file descriptor.
+ *
+ * All the methods are called by the thread that created the device manager.
+ */
+class EventLoopAdapter
+{
+public:
+	virtual ~EventLoopAdapter() noexcept = default;
+	/** Starts watching the file descriptor.
+	 * @param nFD The non-blocking file descriptor. It's readable while events are pending.
+	 * @param oDispatch The function to call from the event loop when nFD is readable.
+	 */
+	virtual void attach(int32_t nFD, std::function<void()>&& oDispatch) noexcept = 0;
+	/** Stops watching the file descriptor.
+	 * The dispatch function passed to attach() must not be called anymore.
+	 */
+	virtual void detach() noexcept = 0;
+};
+
+} // namespace stmi
+
+#endif /* STMI_EVENT_LOOP_ADAPTER_H */
@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   glibeventloopadapter.h
+ */
+
+#ifndef STMI_GLIB_EVENT_LOOP_ADAPTER_H
+#define STMI_GLIB_EVENT_LOOP_ADAPTER_H
+
+#include "eventloopadapter.h"
+
+#include <sigc++/connection.h>
+
+#include <functional>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+/** Adapter for the default Glib main context (used by Gtk applications).
+ * It's the adapter of the instances created without one (ex. OpenAlDeviceManager::create()
+ * without refEventLoopAdapter parameter).
+ */
+class GlibEventLoopAdapter : public EventLoopAdapter
+{
+public:
+	GlibEventLoopAdapter() noexcept = default;
+	void attach(int32_t nFD, std::function<void()>&& oDispatch) noexcept override;
+	void detach() noexcept override;
+private:
+	std::function<void()> m_oDispatch;
+	sigc::connection m_oIOConn;
+private:
+	GlibEventLoopAdapter(const GlibEventLoopAdapter& oSource) = delete;
+	GlibEventLoopAdapter& operator=(const GlibEventLoopAdapter& oSource) = delete;
+};
+
+} // namespace stmi
+
+#endif /* STMI_GLIB_EVENT_LOOP_ADAPTER_H */
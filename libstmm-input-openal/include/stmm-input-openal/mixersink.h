@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixersink.h
+ */
+
+#ifndef STMI_MIXER_SINK_H
+#define STMI_MIXER_SINK_H
+
+#include <memory>
+#include <string>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+class WavFileWriter;
+} // namespace OpenAl
+} // namespace Private
+
+/** The output of the software mixer.
+ * @see OpenAlDeviceManager::createMixer()
+ *
+ * All the methods are called by the mixer thread (or by the thread calling
+ * OpenAlDeviceManager::renderOffline() for offline mixers).
+ */
+class MixerSink
+{
+public:
+	virtual ~MixerSink() noexcept = default;
+	/** Prepares the sink for output.
+	 * Called once before any write().
+	 * @param nFrequency The sample rate in Hz.
+	 * @param nChannels The number of interleaved channels.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	virtual std::string open(int32_t nFrequency, int32_t nChannels) noexcept = 0;
+	/** Outputs interleaved 16 bit samples.
+	 * @param p0Samples The samples. Cannot be null.
+	 * @param nTotFrames The number of frames.
+	 */
+	virtual void write(const int16_t* p0Samples, int32_t nTotFrames) noexcept = 0;
+	/** Whether write() blocks until the samples can be consumed in real time.
+	 * Sinks connected to audio hardware return true, in which case the mixer
+	 * outputs silence when no sound plays. Otherwise the mixer paces itself with
+	 * the clock and doesn't output anything when no sound plays.
+	 * @return Whether blocking.
+	 */
+	virtual bool isBlocking() const noexcept = 0;
+};
+
+/** Sink that discards the output.
+ */
+class NullMixerSink : public MixerSink
+{
+public:
+	std::string open(int32_t /*nFrequency*/, int32_t /*nChannels*/) noexcept override { return ""; }
+	void write(const int16_t* /*p0Samples*/, int32_t /*nTotFrames*/) noexcept override {}
+	bool isBlocking() const noexcept override { return false; }
+};
+
+/** Sink that writes the output to a 16 bit PCM WAV file.
+ * The file is finalized when the sink is destroyed.
+ */
+class WavMixerSink : public MixerSink
+{
+public:
+	/** Constructor.
+	 * @param sFilePath The file path. Cannot be empty.
+	 */
+	explicit WavMixerSink(const std::string& sFilePath) noexcept;
+	~WavMixerSink() noexcept;
+	std::string open(int32_t nFrequency, int32_t nChannels) noexcept override;
+	void write(const int16_t* p0Samples, int32_t nTotFrames) noexcept override;
+	bool isBlocking() const noexcept override { return false; }
+private:
+	const std::string m_sFilePath;
+	int32_t m_nChannels;
+	std::unique_ptr<Private::OpenAl::WavFileWriter> m_refWriter;
+private:
+	WavMixerSink() = delete;
+	WavMixerSink(const WavMixerSink& oSource) = delete;
+	WavMixerSink& operator=(const WavMixerSink& oSource) = delete;
+};
+
+} // namespace stmi
+
+#endif /* STMI_MIXER_SINK_H */
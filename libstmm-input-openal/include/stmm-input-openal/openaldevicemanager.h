@@ -21,15 +21,23 @@
 #ifndef STMI_OPENAL_DEVICE_MANAGER_H
 #define STMI_OPENAL_DEVICE_MANAGER_H
 
+#include "eventloopadapter.h"
+#include "mixersink.h"
+#include "sndrealtimelistener.h"
+#include "sndstatscapability.h"
+
 #include <stmm-input-au/sndmgmtcapability.h>
 
 #include <stmm-input-ev/stddevicemanager.h>
 
 #include <stmm-input/event.h>
 
+#include <array>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <utility>
 
 #include <stdint.h>
@@ -49,6 +57,7 @@ namespace OpenAl
 {
 	class Backend;
 	class PlaybackDevice;
+	class SoundBank;
 	class OpenAlListenerExtraData;
 } // namespace OpenAl
 } // namespace Private
@@ -67,7 +76,7 @@ public:
 	 * if `false` then all event classes supported by this instance are enabled except those in aEnDisableEventClasses.
 	 * OpenAlDeviceManager doesn't allow disabling event classes once constructed, only enabling.
 	 *
-	 * Example: To enable all the event classes supported by this instance (currently just SndFinishedEvent) pass
+	 * Example: To enable all the event classes supported by this instance pass
 	 *
 	 *     bEnableEventClasses = false,  aEnDisableEventClasses = {}
 	 *
@@ -78,6 +87,493 @@ public:
 	 */
 	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> create(const std::string& sAppName
 																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Creates an instance of this class delivering the events with the given adapter.
+	 * Like create() but no GlibEventLoopAdapter is created: the events
+	 * are delivered through refEventLoopAdapter (see setEventLoopAdapter()).
+	 * @param sAppName The application name. Can be empty.
+	 * @param refEventLoopAdapter The adapter. If null the application must watch getEventFD() itself.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> create(const std::string& sAppName
+																		, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+
+	/** The parameters of a loopback device manager.
+	 * @see createLoopback()
+	 */
+	struct LoopbackInit
+	{
+		int32_t m_nFrequency = 44100; /**< The sample rate in Hz. Must be positive. Default is 44100. */
+		bool m_bStereo = true; /**< Whether two channels are rendered, one otherwise. Default is true. */
+		int32_t m_nRenderFrames = 1024; /**< The number of sample frames rendered at once. Must be positive. Default is 1024. */
+		std::string m_sWavFilePath; /**< The 16 bit PCM WAV file the output is written to. If empty the output is discarded. */
+	};
+	/** Creates an instance with a single loopback playback device.
+	 * The device (named "Loopback") is not connected to audio hardware and
+	 * needs the ALC_SOFT_loopback OpenAL extension.
+	 *
+	 * While at least one sound is playing the output is rendered as fast as the CPU allows,
+	 * therefore sounds usually finish faster than in real time. When no sound is
+	 * playing nothing is rendered (silence isn't written to the file).
+	 *
+	 * See create() for the event classes parameters.
+	 * @param oLoopbackInit The loopback parameters.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> createLoopback(const LoopbackInit& oLoopbackInit
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Creates a loopback instance delivering the events with the given adapter.
+	 * Like createLoopback() but no GlibEventLoopAdapter is created.
+	 * @param oLoopbackInit The loopback parameters.
+	 * @param refEventLoopAdapter The adapter. If null the application must watch getEventFD() itself.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> createLoopback(const LoopbackInit& oLoopbackInit
+																		, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Creates an instance for offline rendering.
+	 * Like createLoopback() but there is no OpenAL thread and no Gtk event loop is needed:
+	 * the commands of the "Loopback" playback device are only executed and the output
+	 * only rendered by renderOffline().
+	 *
+	 * A timeline is scripted by alternating calls to the playback capability
+	 * (playSound(), setSoundPos(), setSoundVol(), ...) with calls to renderOffline().
+	 *
+	 * The OpenAL context is bound to the calling thread (ALC_EXT_thread_local_context
+	 * extension is needed), therefore many offline instances can render in parallel
+	 * as long as each is created, used and destroyed by its own thread.
+	 * The WAV file is finalized when the instance is destroyed.
+	 *
+	 * See create() for the event classes parameters.
+	 * @param oLoopbackInit The loopback parameters.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> createOffline(const LoopbackInit& oLoopbackInit
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** The parameters of a software mixer device manager.
+	 * @see createMixer()
+	 */
+	struct MixerInit
+	{
+		int32_t m_nFrequency = 44100; /**< The output sample rate in Hz. Must be positive. Default is 44100. */
+		int32_t m_nPeriodFrames = 512; /**< The number of stereo frames mixed at once. Must be positive. Default is 512. */
+		bool m_bOffline = false; /**< Whether the output is only rendered by renderOffline(). Default is false. */
+	};
+	/** Creates an instance that mixes in software without OpenAL.
+	 * It has a single stereo playback device (named "Mixer") whose output
+	 * is written to refSink. Only PCM WAV (8 or 16 bit, mono or stereo) files
+	 * and buffers are supported, they are converted to the mixer rate when loaded.
+	 *
+	 * The mixing uses the fastest SIMD instruction set supported by the CPU (AVX2, SSE2)
+	 * or scalar code. Mono sounds are attenuated with distance like OpenAL's default
+	 * model and panned according to the PlaybackCapability coordinate conventions,
+	 * stereo sounds are not spatialized.
+	 *
+	 * If the sink is blocking the mixer thread renders continuously, otherwise it
+	 * paces itself in real time and stops rendering when no sound is playing.
+	 * If MixerInit::m_bOffline is true there is no mixer thread, and no Gtk event loop
+	 * is needed, see renderOffline().
+	 *
+	 * See create() for the event classes parameters.
+	 * @param oMixerInit The mixer parameters.
+	 * @param refSink The sink of the output. Cannot be null.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> createMixer(const MixerInit& oMixerInit
+																		, std::unique_ptr<MixerSink> refSink
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Creates a software mixer instance delivering the events with the given adapter.
+	 * Like createMixer() but no GlibEventLoopAdapter is created.
+	 * @param oMixerInit The mixer parameters.
+	 * @param refSink The sink of the output. Cannot be null.
+	 * @param refEventLoopAdapter The adapter. If null the application must watch getEventFD() itself.
+	 * @param bEnableEventClasses Whether to enable or disable all but aEnDisableEventClasses.
+	 * @param aEnDisableEventClasses The event classes to be enabled or disabled according to bEnableEventClasses.
+	 * @return The created instance and an empty string or null and an error string.
+	 */
+	static std::pair<shared_ptr<OpenAlDeviceManager>, std::string> createMixer(const MixerInit& oMixerInit
+																		, std::unique_ptr<MixerSink> refSink
+																		, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
+																		, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Renders the output of an offline instance.
+	 * Executes the commands sent by the playback device so far and renders
+	 * up to nMillisec of output (silence included) in chunks of LoopbackInit::m_nRenderFrames
+	 * (MixerInit::m_nPeriodFrames for offline mixer instances).
+	 * After each chunk the sound finished events are sent to the listeners
+	 * and the commands they sent are executed before the next chunk.
+	 * Must be called by the thread that created the instance but not by a listener
+	 * while the events are being sent: such a nested call renders nothing and returns 0.
+	 * @param nMillisec The time to render. Cannot be negative.
+	 * @param bStopWhenIdle Whether to return early when no sound is playing.
+	 * @return The rendered milliseconds or -1 if the instance wasn't created with createOffline()
+	 *         or with createMixer() in offline mode.
+	 */
+	int32_t renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept;
+
+	/** Sets how the events are delivered by the event loop of the application.
+	 * The events (ex. SndFinishedEvent) are queued by the backend thread and sent
+	 * to the listeners when the adapter calls dispatchPending(), which happens
+	 * as soon as the file descriptor returned by getEventFD() is readable.
+	 *
+	 * The instances created without adapter use a GlibEventLoopAdapter (the default
+	 * Glib main context must be run). Applications with another event loop should pass
+	 * their adapter to the create functions so that no Glib watch is created.
+	 * If refAdapter is null the application must watch getEventFD() itself and
+	 * call dispatchPending() when it's readable.
+	 *
+	 * Offline instances (see renderOffline()) send the events while rendering
+	 * and don't need an adapter.
+	 * Must be called by the thread that created the instance.
+	 * @param refAdapter The adapter. Can be null.
+	 */
+	void setEventLoopAdapter(std::unique_ptr<EventLoopAdapter> refAdapter) noexcept;
+	/** The file descriptor that is readable while events are pending.
+	 * It must only be watched for readability, not read or closed.
+	 * @return The non-blocking file descriptor.
+	 */
+	int32_t getEventFD() const noexcept;
+	/** Sends the pending events to the listeners.
+	 * Afterwards the file descriptor returned by getEventFD() isn't readable
+	 * until new events are pending.
+	 * Must be called by the thread that created the instance. Cannot be re-entered:
+	 * if called by a listener while the events are being sent it does nothing,
+	 * the events queued in the meantime are sent by the next call.
+	 */
+	void dispatchPending() noexcept;
+
+	/** The command types sent by playback devices to the backend.
+	 * Used to index the latency statistics.
+	 */
+	enum COMMAND_TYPE
+	{
+		COMMAND_TYPE_FIRST           = 0
+		, COMMAND_TYPE_PRELOAD       = 0 /**< PlaybackCapability::preloadSound() */
+		, COMMAND_TYPE_PLAY          = 1 /**< PlaybackCapability::playSound() */
+		, COMMAND_TYPE_PAUSE         = 2 /**< PlaybackCapability::pauseSound() */
+		, COMMAND_TYPE_RESUME        = 3 /**< PlaybackCapability::resumeSound() */
+		, COMMAND_TYPE_STOP          = 4 /**< PlaybackCapability::stopSound() */
+		, COMMAND_TYPE_PAUSE_DEVICE  = 5 /**< PlaybackCapability::pauseDevice() */
+		, COMMAND_TYPE_RESUME_DEVICE = 6 /**< PlaybackCapability::resumeDevice() */
+		, COMMAND_TYPE_STOP_ALL      = 7 /**< PlaybackCapability::stopAllSounds() */
+		, COMMAND_TYPE_SOUND_POS     = 8 /**< PlaybackCapability::setSoundPos() */
+		, COMMAND_TYPE_SOUND_VOL     = 9 /**< PlaybackCapability::setSoundVol() */
+		, COMMAND_TYPE_LISTENER_POS  = 10 /**< PlaybackCapability::setListenerPos() */
+		, COMMAND_TYPE_LISTENER_VOL  = 11 /**< PlaybackCapability::setListenerVol() */
+		, COMMAND_TYPE_CANCEL_PRELOADS = 12 /**< PlaybackCapability::cancelPreloadBatch() */
+		, COMMAND_TYPE_GROUP_VOL     = 13 /**< PlaybackCapability::setGroupVol() */
+		, COMMAND_TYPE_PAUSE_GROUP   = 14 /**< PlaybackCapability::pauseGroup() */
+		, COMMAND_TYPE_RESUME_GROUP  = 15 /**< PlaybackCapability::resumeGroup() */
+		, COMMAND_TYPE_STOP_GROUP    = 16 /**< PlaybackCapability::stopGroup() */
+		, COMMAND_TYPE_SOUND_MOTION  = 17 /**< PlaybackCapability::setSoundMotion() and setSoundMotionTo() */
+		, COMMAND_TYPE_SOUND_RAMP    = 18 /**< PlaybackCapability::rampSoundVol() and fadeOutAndStop() */
+		, COMMAND_TYPE_LAST          = 18
+	};
+	/** Histogram of latencies.
+	 * Bucket 0 counts latencies smaller than 1 microsecond, bucket n (n &gt; 0)
+	 * those in the interval [2^(n-1), 2^n) microseconds. The last bucket
+	 * (starting at about 8.4 seconds) also counts all bigger latencies.
+	 */
+	struct LatencyHistogram
+	{
+		static constexpr int32_t s_nTotBuckets = 25;
+		std::array<uint64_t, s_nTotBuckets> m_aBucketCounts{}; /**< The counts. */
+		uint64_t m_nTotCount = 0; /**< The sum of all the counts. */
+		int64_t m_nTotUsec = 0; /**< The sum of all latencies in microseconds. */
+		int64_t m_nMaxUsec = 0; /**< The biggest latency in microseconds. */
+	};
+	/** Latency statistics.
+	 * The times are measured with a steady clock.
+	 */
+	struct LatencyStats
+	{
+		/** Time from the call to the PlaybackCapability function to the start of the execution
+		 * of the command by the backend. Index: COMMAND_TYPE. */
+		std::array<LatencyHistogram, COMMAND_TYPE_LAST + 1> m_aQueueWait;
+		/** Time the backend took to execute the command. Index: COMMAND_TYPE. */
+		std::array<LatencyHistogram, COMMAND_TYPE_LAST + 1> m_aExecution;
+		/** Time from when the backend detects a sound has finished to when
+		 * the SndFinishedEvent is sent to the listeners. */
+		LatencyHistogram m_oFinishedDelivery;
+		/** Time the backend took to decode a sound into a buffer (when preloaded or first played),
+		 * or to open its stream (see setDecodedBufferBudget()). */
+		LatencyHistogram m_oDecode;
+		/** Time from PlaybackCapability::triggerSound() to when the backend starts
+		 * the prepared sound (alSourcePlay). */
+		LatencyHistogram m_oTrigger;
+	};
+	/** Enables or disables latency instrumentation.
+	 * Disabled by default. When disabled the cost is an atomic load per command and event.
+	 * The statistics are not reset.
+	 * @param bEnabled Whether to enable.
+	 */
+	void setLatencyStatsEnabled(bool bEnabled) noexcept;
+	/** Whether latency instrumentation is enabled.
+	 * @return Whether enabled.
+	 */
+	bool isLatencyStatsEnabled() const noexcept;
+	/** The latency statistics collected so far.
+	 * Can be called from any thread.
+	 * @return The statistics.
+	 */
+	LatencyStats getLatencyStats() const noexcept;
+	/** Resets the latency statistics.
+	 */
+	void resetLatencyStats() noexcept;
+
+	/** Enables or disables tracing.
+	 * When enabled the duration of each command execution, alureUpdate() call,
+	 * device enumeration pass and event dispatch is recorded in per-thread
+	 * ring buffers (the oldest spans are overwritten). Disabled by default.
+	 * @param bEnabled Whether to enable.
+	 */
+	void setTraceEnabled(bool bEnabled) noexcept;
+	/** Whether tracing is enabled.
+	 * @return Whether enabled.
+	 */
+	bool isTraceEnabled() const noexcept;
+	/** Writes the recorded spans to a file in the Chrome trace JSON format.
+	 * The file can be opened with chrome://tracing or https://ui.perfetto.dev .
+	 * Can be called from any thread.
+	 * @param sFilePath The file path. Cannot be empty.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	std::string writeTrace(const std::string& sFilePath) const noexcept;
+	/** Sets the file the trace is written to when the device manager is destroyed.
+	 * @param sFilePath The file path. If empty the trace isn't written at exit.
+	 */
+	void setTraceExitFilePath(const std::string& sFilePath) noexcept;
+
+	/** Sets whether sounds are converted to the format of the device when loaded.
+	 * If enabled, PCM WAV files and buffers (8 or 16 bit) are decoded by this library,
+	 * and resampled once to the device's ALC_FREQUENCY, so that OpenAL doesn't need
+	 * to resample them each time they are mixed. Other formats are still decoded by alure.
+	 *
+	 * Only affects the sounds loaded (preloaded or first played) afterwards.
+	 * Default is false. The software mixer (see createMixer()) always converts.
+	 * @param bEnabled Whether enabled.
+	 */
+	void setNativeFormatConversion(bool bEnabled) noexcept;
+	/** Whether sounds are converted to the format of the device when loaded.
+	 * @return Whether enabled.
+	 */
+	bool isNativeFormatConversion() const noexcept;
+
+	/** The sample formats the buffers are stored in.
+	 */
+	enum SAMPLE_FORMAT
+	{
+		SAMPLE_FORMAT_PCM16 = 0 /**< Uncompressed 16 bit. */
+		, SAMPLE_FORMAT_MULAW = 1 /**< 8 bit μ-law (AL_EXT_MULAW), half the size of PCM16. */
+		, SAMPLE_FORMAT_IMA4 = 2 /**< IMA ADPCM (AL_EXT_IMA4), about a quarter of the size of PCM16. */
+	};
+	/** Sets the compressed format sounds are encoded to when loaded.
+	 * If not SAMPLE_FORMAT_PCM16, PCM WAV files and buffers (8 or 16 bit) are decoded
+	 * by this library and encoded to the given format. OpenAL decodes them while mixing,
+	 * which reduces the resident memory of large sound libraries at a small mixing cost.
+	 * If the device doesn't support the format's extension the sounds stay PCM16.
+	 * Other formats are still decoded by alure.
+	 *
+	 * Only affects the sounds loaded (preloaded or first played) afterwards.
+	 * Default is SAMPLE_FORMAT_PCM16. The software mixer (see createMixer()) ignores it.
+	 * @param eFormat The format.
+	 */
+	void setCompressedSampleFormat(SAMPLE_FORMAT eFormat) noexcept;
+	/** The compressed format sounds are encoded to when loaded.
+	 * @return The format.
+	 */
+	SAMPLE_FORMAT getCompressedSampleFormat() const noexcept;
+
+	/** Sets whether preloading keeps sounds encoded until they are played.
+	 * If enabled, PlaybackCapability::preloadSound() of a file only reads the file
+	 * into memory (once for all devices) and preloading a buffer does nothing.
+	 * The sound is decoded the first time it is played from the bytes in memory.
+	 * This is meant for big libraries of rarely played compressed (ex. Ogg) sounds.
+	 *
+	 * Only affects the sounds preloaded afterwards. Default is false.
+	 * The software mixer (see createMixer()) ignores it.
+	 * @param bEnabled Whether enabled.
+	 */
+	void setDecodeOnDemand(bool bEnabled) noexcept;
+	/** Whether preloading keeps sounds encoded until they are played.
+	 * @return Whether enabled.
+	 */
+	bool isDecodeOnDemand() const noexcept;
+	/** Sets the limits of the decoded buffers kept by each device.
+	 * When a buffer is added and the limits are exceeded, the buffers of
+	 * the least recently played sounds are deleted (unless they are playing).
+	 * They are decoded again the next time they are played (see setDecodeOnDemand()).
+	 * The time it takes to decode is measured in LatencyStats::m_oDecode
+	 * and the deleted buffers are counted in SndStatsCapability::DeviceStats::m_nEvictedBuffers.
+	 *
+	 * Default is unlimited. The software mixer (see createMixer()) ignores it.
+	 * @param nMaxBuffers The maximum number of buffers or -1 if unlimited.
+	 * @param nMaxBytes The maximum total size of the buffers or -1 if unlimited.
+	 */
+	void setDecodedBufferBudget(int32_t nMaxBuffers, int64_t nMaxBytes) noexcept;
+	/** The maximum number of decoded buffers of each device.
+	 * @return The number or -1 if unlimited.
+	 */
+	int32_t getDecodedBufferBudgetBuffers() const noexcept;
+	/** The maximum total size of the decoded buffers of each device.
+	 * @return The bytes or -1 if unlimited.
+	 */
+	int64_t getDecodedBufferBudgetBytes() const noexcept;
+	/** Sets the encoded size from which sounds are streamed rather than decoded into a buffer.
+	 * Streamed sounds are decoded a chunk at a time by alure while playing, they are
+	 * neither resampled, compressed, nor down-mixed (see setMonoDownmixPolicy()).
+	 * A sound that already has a buffer (ex. preloaded without setDecodeOnDemand())
+	 * isn't streamed. Offline device managers (see createOffline()) never stream.
+	 *
+	 * Default is -1. The software mixer (see createMixer()) ignores it.
+	 * @param nMinEncodedBytes The minimum size of the file or buffer or -1 if sounds are never streamed.
+	 */
+	void setStreamingThreshold(int32_t nMinEncodedBytes) noexcept;
+	/** The encoded size from which sounds are streamed.
+	 * @return The size in bytes or -1 if sounds are never streamed.
+	 */
+	int32_t getStreamingThreshold() const noexcept;
+	/** Sets the directory of the persistent cache of decoded sounds.
+	 * When a PCM WAV file is decoded by this library (see setNativeFormatConversion(),
+	 * setCompressedSampleFormat() and setMonoDownmixPolicy()), the result is
+	 * written to the cache. The next time, even in another process, the file
+	 * is loaded from the memory mapped cache without decoding or converting it.
+	 * An entry is keyed by the path, size and modification time of the file and the
+	 * conversion options. Buffers and the formats decoded by alure aren't cached.
+	 *
+	 * The directory is created if needed. Stale entries are never deleted.
+	 * Default is empty. The software mixer (see createMixer()) ignores it.
+	 * @param sDirectory The directory or empty to disable the cache.
+	 */
+	void setPcmDiskCacheDirectory(const std::string& sDirectory) noexcept;
+	/** The directory of the persistent cache of decoded sounds.
+	 * @return The directory or empty if disabled.
+	 */
+	std::string getPcmDiskCacheDirectory() const noexcept;
+	/** Sets whether the playback devices can be used by several threads.
+	 * If enabled, the following PlaybackCapability methods of the devices of this
+	 * instance can be called concurrently by any thread: preloadSound(),
+	 * playSound(), playSoundInGroup() (of an existing group), playSoundAt(),
+	 * playSoundsTogether(), prepareSound(), triggerSound(), getSoundState(),
+	 * getDeviceClockNanosec(), setSoundPos(), setSoundMotion(), setSoundMotionTo(),
+	 * setSoundVol(), rampSoundVol(), fadeOutAndStop(), pauseSound(), resumeSound(),
+	 * stopSound(), setListenerPos(), setListenerVol(), pauseDevice(), resumeDevice(),
+	 * stopAllSounds() and isDefaultDevice().
+	 * The other methods of this class and of the devices (ex. preloadSounds(),
+	 * preloadBank() and the group methods) and the events stay in the main thread.
+	 *
+	 * The commands are queued without locks, the sounds and files are tracked in
+	 * tables that are read without locks or locked per sound. The commands sent
+	 * by a thread are executed in the order they were sent, a command sent by another
+	 * thread after it received the result of a call (ex. the sound id) is executed after it.
+	 *
+	 * A sound played by another thread than the main thread is reported (see
+	 * SndFinishedEvent) to all the listeners present when it finishes,
+	 * even those added after it was played.
+	 * The instance must outlive the calls of the other
+	 * threads, a removed device can still be used (all calls fail) but in this mode
+	 * its Device::getDeviceManager() isn't reset.
+	 *
+	 * Must be called in the main thread before other threads use the devices.
+	 * Default is false.
+	 * @param bEnabled Whether enabled.
+	 */
+	void setThreadSafePlayback(bool bEnabled) noexcept;
+	/** Whether the playback devices can be used by several threads.
+	 * @return Whether enabled.
+	 */
+	bool isThreadSafePlayback() const noexcept;
+	/** Sets the listener called by the backend thread when a sound finishes.
+	 * It allows to chain sounds without gaps: a sound prepared with
+	 * PlaybackCapability::prepareSound() and triggered by the listener is started
+	 * by the backend before it renders again (the OpenAL backend before it
+	 * waits for new commands, the software mixer at the start of the next period),
+	 * without waiting for the event loop. The SndFinishedEvent is sent to the
+	 * event listeners as usual.
+	 *
+	 * Since the listener is called by another thread the thread safe mode
+	 * must be enabled (see setThreadSafePlayback()).
+	 * Once this function returns the previous listener is no longer called, but
+	 * a call that already started might still be running in the backend thread.
+	 * Pass null before releasing the last reference to this instance.
+	 *
+	 * Must be called in the main thread. Default is null.
+	 * @param refListener The listener or null.
+	 * @return Whether set. False if not null and the thread safe mode is not enabled.
+	 */
+	bool setRealTimeListener(const shared_ptr<SndRealTimeListener>& refListener) noexcept;
+	/** Sets whether the finished sounds are sent to the listeners in batches.
+	 * If enabled, instead of a SndFinishedEvent for each finished sound, a listener
+	 * receives a single SndFinishedBatchEvent per device for:
+	 * - the sounds that finished since the last delivery (see dispatchPending()),
+	 * - the sounds aborted because the device is being removed,
+	 * - the sounds of the listener being removed (FINISHED_TYPE_LISTENER_REMOVED).
+	 *
+	 * As with SndFinishedEvent, a listener only receives the sounds played after it was added.
+	 * The listeners opt in by accepting the SndFinishedBatchEvent class
+	 * (which must be enabled), those only accepting SndFinishedEvent receive nothing.
+	 * The SndFinishedBatchEvent::Entry::m_nTimeUsec of the sounds that finished
+	 * in the backend is the time the backend detected it.
+	 *
+	 * Must be called in the main thread. Default is false.
+	 * @param bEnabled Whether enabled.
+	 */
+	void setSndFinishedBatching(bool bEnabled) noexcept;
+	/** Whether the finished sounds are sent in batches.
+	 * @return Whether enabled.
+	 */
+	bool isSndFinishedBatching() const noexcept { return m_bSndFinishedBatching; }
+
+	/** What happens to stereo sounds played positionally.
+	 * OpenAL (and the software mixer) only spatialize mono sounds.
+	 */
+	enum MONO_DOWNMIX_POLICY
+	{
+		MONO_DOWNMIX_POLICY_KEEP_STEREO = 0 /**< The sound is played in stereo, therefore not spatialized. */
+		, MONO_DOWNMIX_POLICY_POSITIONAL = 1 /**< A mono down-mix of the sound is played. */
+	};
+	/** Sets the policy for stereo sounds played positionally.
+	 * A sound is played positionally if it's not relative to the listener
+	 * or not at the origin (see PlaybackCapability::playSound()).
+	 *
+	 * With MONO_DOWNMIX_POLICY_POSITIONAL a PCM WAV (8 or 16 bit) file or buffer
+	 * is down-mixed to mono the first time it is played positionally.
+	 * The stereo version is only loaded if the sound is also preloaded or
+	 * played relative to the listener at the origin. This also halves the buffer
+	 * memory: see SndStatsCapability::DeviceStats::m_nDownmixSavedBytes.
+	 * Other formats are always played as decoded by alure.
+	 *
+	 * Only affects the sounds played afterwards. Default is MONO_DOWNMIX_POLICY_KEEP_STEREO.
+	 * @param ePolicy The policy for the files without own policy and all the buffers.
+	 */
+	void setMonoDownmixPolicy(MONO_DOWNMIX_POLICY ePolicy) noexcept;
+	/** The policy for stereo sounds played positionally.
+	 * @return The policy for files without own policy and buffers.
+	 */
+	MONO_DOWNMIX_POLICY getMonoDownmixPolicy() const noexcept { return m_eMonoDownmixPolicy.load(std::memory_order_relaxed); }
+	/** Sets the policy of a file overriding the one set with setMonoDownmixPolicy().
+	 * @param sFileName The file name as passed to PlaybackCapability::playSound(). Cannot be empty.
+	 * @param ePolicy The policy.
+	 */
+	void setFileMonoDownmixPolicy(const std::string& sFileName, MONO_DOWNMIX_POLICY ePolicy) noexcept;
+	/** Removes the own policy of a file.
+	 * @param sFileName The file name.
+	 */
+	void resetFileMonoDownmixPolicy(const std::string& sFileName) noexcept;
+	/** The policy of a file.
+	 * @param sFileName The file name. If empty the policy of buffers is returned.
+	 * @return The own policy if set, the general one otherwise.
+	 */
+	MONO_DOWNMIX_POLICY getFileMonoDownmixPolicy(const std::string& sFileName) const noexcept;
 
 	void enableEventClass(const Event::Class& oEventClass) noexcept override;
 
@@ -105,29 +601,59 @@ private:
 	private:
 		OpenAlDeviceManager* m_p1Owner;
 	};
+	friend class SndStatsImpl;
+	class SndStatsImpl : public SndStatsCapability
+	{
+	public:
+		SndStatsImpl(OpenAlDeviceManager* p1Owner) noexcept
+		: m_p1Owner(p1Owner)
+		{
+		}
+		Stats getStats() const noexcept override;
+		shared_ptr<DeviceManager> getDeviceManager() const noexcept override;
+	private:
+		OpenAlDeviceManager* m_p1Owner;
+	};
 protected:
 	void finalizeListener(ListenerData& oListenerData) noexcept override;
 	/** Constructor.
 	 * @see create()
 	 */
 	OpenAlDeviceManager(bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept;
+	/** Sets and starts the backend.
+	 * Has to be called right after the constructor by create() or by subclasses.
+	 * @param refBackend The backend. Cannot be null.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	std::string init(std::unique_ptr<Private::OpenAl::Backend>&& refBackend) noexcept;
 private:
-	void init(std::unique_ptr<Private::OpenAl::Backend>&& refBackend, shared_ptr<SndMgmtImpl>&& refSndMgmtImpl) noexcept;
 
 	friend class Private::OpenAl::Backend;
-	void onPlayFinished(int32_t nBackendDeviceId, int32_t nSoundId) noexcept;
+	void onEventsDispatchBegin() noexcept;
+	void onEventsDispatchEnd() noexcept;
+	void onPlayFinished(int32_t nBackendDeviceId, int32_t nSoundId, bool bFadedOut, int64_t nFinishedTimeUsec) noexcept;
 	void onDeviceAdded(std::string&& sName, int32_t nBackendDeviceId, bool bIsDefault) noexcept;
 	void onDeviceRemoved(int32_t nBackendDeviceId) noexcept;
 	void onDeviceChanged(int32_t nBackendDeviceId, bool bIsDefault) noexcept;
-	void onDeviceError(int32_t nBackendDeviceId, int32_t nFileId, int32_t nSoundId, std::string&& sError) noexcept;
+	void onDeviceError(int32_t nBackendDeviceId, int32_t nFileId, int32_t nSoundId, int64_t nFinishedTimeUsec
+						, std::string&& sError) noexcept;
+	void onPreloaded(int32_t nBackendDeviceId, int32_t nBatchId, int32_t nFileId, bool bLoaded) noexcept;
 
 	void finishDeviceSounds(const shared_ptr<Private::OpenAl::PlaybackDevice>& refPlaybackDevice) noexcept;
+	// Sends the finished sounds collected by the playback devices in batch mode
+	void sendSndFinishedBatches() noexcept;
 
 	friend class Private::OpenAl::PlaybackDevice;
 	friend class Private::OpenAl::OpenAlListenerExtraData;
+	// Maps the bank the first time, returns null and sets sError if error
+	shared_ptr<Private::OpenAl::SoundBank> openSoundBank(const std::string& sBankPath, std::string& sError) noexcept;
 private:
+	// The backend might access the mapped banks until it is destroyed,
+	// so they have to be declared before it
+	std::vector< shared_ptr<Private::OpenAl::SoundBank> > m_aSoundBanks;
 	std::unique_ptr<Private::OpenAl::Backend> m_refBackend;
 	std::shared_ptr<SndMgmtImpl> m_refSndMgmtImpl;
+	std::shared_ptr<SndStatsImpl> m_refSndStatsImpl;
 	//
 	std::vector< shared_ptr<Private::OpenAl::PlaybackDevice> > m_aPlaybackDevices; // Index: nBackendDeviceId, Value: can be null!
 
@@ -136,6 +662,20 @@ private:
 	int32_t m_nFinishingNestedDepth;
 	//
 	const int32_t m_nClassIdxSndFinishedEvent;
+	const int32_t m_nClassIdxSndPreloadedEvent;
+	const int32_t m_nClassIdxSndFinishedBatchEvent;
+
+	bool m_bSndFinishedBatching;
+	// While positive the finished sounds are collected by the playback devices
+	int32_t m_nEventsDispatchDepth;
+
+	std::atomic<MONO_DOWNMIX_POLICY> m_eMonoDownmixPolicy;
+	// Read by the threads playing sounds (see setThreadSafePlayback())
+	mutable std::mutex m_oFileMonoDownmixPoliciesMutex;
+	// only accessed under m_oFileMonoDownmixPoliciesMutex
+	std::vector<std::pair<std::string, MONO_DOWNMIX_POLICY>> m_aFileMonoDownmixPolicies;
+	// The size of m_aFileMonoDownmixPolicies, allows to skip the lock when empty
+	std::atomic<int32_t> m_nTotFileMonoDownmixPolicies;
 private:
 	OpenAlDeviceManager(const OpenAlDeviceManager& oSource) = delete;
 	OpenAlDeviceManager& operator=(const OpenAlDeviceManager& oSource) = delete;
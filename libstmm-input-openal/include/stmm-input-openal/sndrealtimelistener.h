@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndrealtimelistener.h
+ */
+
+#ifndef STMI_SND_REAL_TIME_LISTENER_H
+#define STMI_SND_REAL_TIME_LISTENER_H
+
+#include <stmm-input-au/sndfinishedevent.h>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+/** Listener called by the backend thread as soon as a sound finishes.
+ * @see OpenAlDeviceManager::setRealTimeListener()
+ *
+ * Unlike the listeners of SndFinishedEvent there is no hop through the
+ * event loop: the sound that follows a finished one can be prepared
+ * beforehand with PlaybackCapability::prepareSound() and triggered by the
+ * listener itself. It is started by the backend before it renders again.
+ *
+ * The methods are called by the backend thread (or by the thread calling
+ * OpenAlDeviceManager::renderOffline() for offline instances) and must not block:
+ * no locks, no I/O, no memory allocation that might wait, no waiting on other threads.
+ */
+class SndRealTimeListener
+{
+public:
+	virtual ~SndRealTimeListener() noexcept = default;
+	/** A sound has finished.
+	 * Called before the corresponding SndFinishedEvent is queued for the event listeners.
+	 * Only the types FINISHED_TYPE_COMPLETED, FINISHED_TYPE_FADED_OUT and FINISHED_TYPE_FILE_NOT_FOUND
+	 * are reported. It might be called for a sound that was just stopped by another thread.
+	 *
+	 * Of the playback methods only PlaybackCapability::triggerSound() can be called
+	 * from here: it takes no locks and doesn't allocate memory. The other methods,
+	 * even those that can be called by any thread (see OpenAlDeviceManager::setThreadSafePlayback()),
+	 * might lock or allocate.
+	 * @param nSoundId The sound id as returned by PlaybackCapability::playSound().
+	 * @param eFinishedType The finished type.
+	 */
+	virtual void onSoundFinished(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType) noexcept = 0;
+};
+
+} // namespace stmi
+
+#endif /* STMI_SND_REAL_TIME_LISTENER_H */
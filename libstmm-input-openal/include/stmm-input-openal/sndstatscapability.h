@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndstatscapability.h
+ */
+
+#ifndef STMI_SND_STATS_CAPABILITY_H
+#define STMI_SND_STATS_CAPABILITY_H
+
+#include <stmm-input/capability.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+/** Sound statistics device manager capability.
+ * Gives a snapshot of the internal state of the OpenAL backend
+ * for monitoring purposes.
+ */
+class SndStatsCapability : public DeviceManagerCapability
+{
+public:
+	/** The statistics of a playback device. */
+	struct DeviceStats
+	{
+		int32_t m_nDeviceId = -1; /**< The device id (see Device::getId()) or -1 if not yet known. */
+		int32_t m_nActiveSources = 0; /**< The number of playing or paused sounds. */
+		int32_t m_nUnusedSources = 0; /**< The number of pooled sources that can be reused. */
+		int32_t m_nBuffers = 0; /**< The number of loaded sound buffers. */
+		int64_t m_nBufferBytes = 0; /**< The total size of the loaded sound buffers. */
+		/** The buffer memory saved by playing mono down-mixes of stereo sounds
+		 * that were not also loaded in stereo (see OpenAlDeviceManager::setMonoDownmixPolicy()). */
+		int64_t m_nDownmixSavedBytes = 0;
+		/** The number of buffers deleted to stay within the budget
+		 * (see OpenAlDeviceManager::setDecodedBufferBudget()). */
+		int64_t m_nEvictedBuffers = 0;
+	};
+	/** The statistics of the device manager. */
+	struct Stats
+	{
+		/** The devices. At most s_nMaxStatsDevices are reported. */
+		std::vector<DeviceStats> m_aDevices;
+		/** The number of commands found by the backend in the queue the last time it emptied it. */
+		int32_t m_nCommandQueueDepth = 0;
+		/** The maximum number of commands that were in the queue at the same time. */
+		int32_t m_nCommandQueueHighWater = 0;
+		/** The number of executed commands. Index: OpenAlDeviceManager::COMMAND_TYPE. */
+		std::vector<uint64_t> m_aExecutedCommands;
+		/** The number of events sent by the backend not yet delivered to the device manager. */
+		int32_t m_nEventsPending = 0;
+		/** How many times the devices were re-created because the system's devices changed. */
+		int64_t m_nDeviceRecreations = 0;
+		/** The total size of the files kept encoded in memory (see OpenAlDeviceManager::setDecodeOnDemand()). */
+		int64_t m_nEncodedBytes = 0;
+	};
+	/** The maximum number of devices the statistics are reported for. */
+	static constexpr int32_t s_nMaxStatsDevices = 16;
+	/** The current statistics.
+	 * Can be called from any thread. The backend publishes the statistics without
+	 * locks, so that reading them never contends with the playback functions.
+	 * @return The snapshot.
+	 */
+	virtual Stats getStats() const noexcept = 0;
+
+	static const char* const s_sClassId;
+	static const Capability::Class& getClass() noexcept { return s_oInstall.getCapabilityClass(); }
+protected:
+	SndStatsCapability() noexcept;
+private:
+	static RegisterClass<SndStatsCapability> s_oInstall;
+private:
+};
+
+} // namespace stmi
+
+#endif /* STMI_SND_STATS_CAPABILITY_H */
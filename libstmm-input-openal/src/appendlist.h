@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   appendlist.h
+ */
+
+#ifndef STMI_OPENAL_APPEND_LIST_H
+#define STMI_OPENAL_APPEND_LIST_H
+
+#include <array>
+#include <atomic>
+#include <utility>
+#include <cassert>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Append only list with lock-free reads.
+ * The elements are never moved nor removed, so that readers can access the
+ * elements published so far while a writer appends new ones.
+ * The elements are stored in chunks, each twice the size of the previous one.
+ */
+template <class T>
+class AppendList final
+{
+public:
+	AppendList() noexcept
+	: m_nSize(0)
+	{
+		for (auto& p0Chunk : m_aChunks) {
+			p0Chunk.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+	~AppendList() noexcept
+	{
+		for (auto& p0Chunk : m_aChunks) {
+			delete [] p0Chunk.load(std::memory_order_relaxed);
+		}
+	}
+	/** The number of published elements.
+	 * Can be called by any thread.
+	 * @return The size.
+	 */
+	int32_t size() const noexcept
+	{
+		return m_nSize.load(std::memory_order_acquire);
+	}
+	/** A published element.
+	 * Can be called by any thread.
+	 * @param nIdx The index. Must be smaller than a previously returned size().
+	 * @return The element.
+	 */
+	const T& operator[](int32_t nIdx) const noexcept
+	{
+		int32_t nChunk;
+		int32_t nOffset;
+		getChunkAndOffset(nIdx, nChunk, nOffset);
+		return m_aChunks[nChunk].load(std::memory_order_relaxed)[nOffset];
+	}
+	/** The index of the first published element satisfying a predicate.
+	 * Can be called by any thread.
+	 * @param oPred The predicate taking a `const T&`.
+	 * @return The index or -1 if not found.
+	 */
+	template <class PRED>
+	int32_t findIf(PRED oPred) const noexcept
+	{
+		const int32_t nSize = size();
+		for (int32_t nIdx = 0; nIdx < nSize; ++nIdx) {
+			if (oPred(operator[](nIdx))) {
+				return nIdx; //-------------------------------------------------
+			}
+		}
+		return -1;
+	}
+	/** Appends and publishes an element.
+	 * Writers must be serialized by the caller.
+	 * @param oValue The value.
+	 */
+	void push_back(T&& oValue) noexcept
+	{
+		const int32_t nIdx = m_nSize.load(std::memory_order_relaxed);
+		int32_t nChunk;
+		int32_t nOffset;
+		getChunkAndOffset(nIdx, nChunk, nOffset);
+		T* p0Chunk = m_aChunks[nChunk].load(std::memory_order_relaxed);
+		if (p0Chunk == nullptr) {
+			p0Chunk = new T[s_nFirstChunkSize << nChunk];
+			m_aChunks[nChunk].store(p0Chunk, std::memory_order_relaxed);
+		}
+		p0Chunk[nOffset] = std::move(oValue);
+		// the chunk and the element are visible to the readers that see the new size
+		m_nSize.store(nIdx + 1, std::memory_order_release);
+	}
+private:
+	static void getChunkAndOffset(int32_t nIdx, int32_t& nChunk, int32_t& nOffset) noexcept
+	{
+		assert(nIdx >= 0);
+		nChunk = 0;
+		int32_t nChunkSize = s_nFirstChunkSize;
+		while (nIdx >= nChunkSize) {
+			nIdx -= nChunkSize;
+			nChunkSize *= 2;
+			++nChunk;
+		}
+		assert(nChunk < s_nMaxChunks);
+		nOffset = nIdx;
+	}
+private:
+	static constexpr int32_t s_nFirstChunkSize = 32;
+	// More than a billion elements
+	static constexpr int32_t s_nMaxChunks = 25;
+	std::atomic<int32_t> m_nSize;
+	std::array<std::atomic<T*>, s_nMaxChunks> m_aChunks;
+private:
+	AppendList(const AppendList& oSource) = delete;
+	AppendList& operator=(const AppendList& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_APPEND_LIST_H */
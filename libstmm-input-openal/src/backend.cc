@@ -0,0 +1,845 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   backend.cc
+ */
+
+#include "backend.h"
+
+#include "openaldevicemanager.h"
+
+#include <stmm-input-au/playbackcapability.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+static_assert(static_cast<int32_t>(Backend::AL_COMMAND_FIRST) == static_cast<int32_t>(OpenAlDeviceManager::COMMAND_TYPE_FIRST)
+			&& static_cast<int32_t>(Backend::AL_COMMAND_LAST) == static_cast<int32_t>(OpenAlDeviceManager::COMMAND_TYPE_LAST)
+			&& static_cast<int32_t>(Backend::AL_COMMAND_PLAY) == static_cast<int32_t>(OpenAlDeviceManager::COMMAND_TYPE_PLAY)
+			&& static_cast<int32_t>(Backend::AL_COMMAND_STOP) == static_cast<int32_t>(OpenAlDeviceManager::COMMAND_TYPE_STOP)
+			, "Command types mismatch");
+
+Backend::Backend(::stmi::OpenAlDeviceManager* p0Owner) noexcept
+: m_oRawStats()
+, m_oMainTraceRing(m_oTraceRecorder.addThread("main"))
+, m_p0Owner(p0Owner)
+, m_nEventFD(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+, m_refEventLoopAdapter()
+, m_bEventLoopAttached(false)
+, m_bDispatchingEvents(false)
+, m_p0CommandsHead(nullptr)
+, m_p0CommandsTail(nullptr)
+, m_nCommandQueueHighWater(0)
+, m_refCommandNodePool(new CommandNode[s_nCommandNodePoolSize])
+, m_nFreeCommandNodes(0)
+, m_bWaitingForCommands(false)
+, m_nEventsPending(0)
+, m_bNativeFormatConversion(false)
+, m_nCompressedSampleFormat(0)
+, m_bDecodeOnDemand(false)
+, m_nBudgetMaxBuffers(-1)
+, m_nBudgetMaxBytes(-1)
+, m_nStreamingThreshold(-1)
+, m_bThreadSafePlayback(false)
+, m_oMainThreadId(std::this_thread::get_id())
+, m_nTriggersPending(0)
+, m_bHasRealTimeListener(false)
+{
+	assert(p0Owner != nullptr);
+	// chain the free nodes, the first is the initial tail
+	for (int32_t nIdx = 0; nIdx < s_nCommandNodePoolSize; ++nIdx) {
+		CommandNode& oNode = m_refCommandNodePool[nIdx];
+		oNode.m_p0Next.store(nullptr, std::memory_order_relaxed);
+		oNode.m_nPoolIndex = nIdx;
+		oNode.m_nNextFree.store(((nIdx + 1 < s_nCommandNodePoolSize) ? nIdx + 1 : -1), std::memory_order_relaxed);
+	}
+	m_nFreeCommandNodes.store(packFreeCommandNodes(1, 0), std::memory_order_relaxed);
+	// the tail is always a node whose command was already taken
+	m_p0CommandsTail = &(m_refCommandNodePool[0]);
+	m_p0CommandsHead.store(m_p0CommandsTail, std::memory_order_relaxed);
+	for (auto& nDeviceId : m_aStatsDeviceIds) {
+		nDeviceId.store(-1, std::memory_order_relaxed);
+	}
+	for (auto& nValue : m_aTriggerSlots) {
+		nValue.store(TRIGGER_SLOT_FREE, std::memory_order_relaxed);
+	}
+	for (auto& nUsec : m_aTriggerUsecs) {
+		nUsec.store(-1, std::memory_order_relaxed);
+	}
+}
+Backend::~Backend() noexcept
+{
+	assert(! m_bEventLoopAttached);
+	if (m_nEventFD >= 0) {
+		::close(m_nEventFD);
+	}
+	// the commands not taken (the pool nodes are freed with the pool)
+	CommandNode* p0Node = m_p0CommandsTail;
+	while (p0Node != nullptr) {
+		CommandNode* p0Next = p0Node->m_p0Next.load(std::memory_order_acquire);
+		if (p0Node->m_nPoolIndex < 0) {
+			delete p0Node;
+		}
+		p0Node = p0Next;
+	}
+	if (m_sTraceExitFilePath.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	// At exit there's nobody to report an error to
+	m_oTraceRecorder.write(m_sTraceExitFilePath);
+}
+const char* Backend::getCommandTraceName(AL_COMMAND_TYPE eType) noexcept
+{
+	switch (eType) {
+	case AL_COMMAND_PRELOAD: return "openalPreload";
+	case AL_COMMAND_PLAY: return "openalPlay";
+	case AL_COMMAND_PAUSE: return "openalPause";
+	case AL_COMMAND_RESUME: return "openalResume";
+	case AL_COMMAND_STOP: return "openalStop";
+	case AL_COMMAND_PAUSE_DEVICE: return "openalPauseDevice";
+	case AL_COMMAND_RESUME_DEVICE: return "openalResumeDevice";
+	case AL_COMMAND_STOP_ALL: return "openalStopAll";
+	case AL_COMMAND_SOUND_POS: return "openalSoundPos";
+	case AL_COMMAND_SOUND_VOL: return "openalSoundVol";
+	case AL_COMMAND_LISTENER_POS: return "openalListenerPos";
+	case AL_COMMAND_LISTENER_VOL: return "openalListenerVol";
+	case AL_COMMAND_CANCEL_PRELOADS: return "openalCancelPreloads";
+	case AL_COMMAND_GROUP_VOL: return "openalGroupVol";
+	case AL_COMMAND_PAUSE_GROUP: return "openalPauseGroup";
+	case AL_COMMAND_RESUME_GROUP: return "openalResumeGroup";
+	case AL_COMMAND_STOP_GROUP: return "openalStopGroup";
+	case AL_COMMAND_SOUND_MOTION: return "openalSoundMotion";
+	case AL_COMMAND_SOUND_RAMP: return "openalSoundRamp";
+	default: break;
+	}
+	assert(false);
+	return "openalUnknown";
+}
+bool Backend::isPositional(const AlCommand& oCommand) noexcept
+{
+	return (! oCommand.m_bRelative) || (oCommand.m_fPosX != 0.0) || (oCommand.m_fPosY != 0.0) || (oCommand.m_fPosZ != 0.0);
+}
+Backend::SoundGroup& Backend::getSoundGroup(std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept
+{
+	assert(nGroupId >= 0);
+	if (nGroupId >= static_cast<int32_t>(aSoundGroups.size())) {
+		aSoundGroups.resize(nGroupId + 1);
+	}
+	return aSoundGroups[nGroupId];
+}
+double Backend::getSoundGroupVolume(const std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept
+{
+	if ((nGroupId < 0) || (nGroupId >= static_cast<int32_t>(aSoundGroups.size()))) {
+		return 1.0; //----------------------------------------------------------
+	}
+	return aSoundGroups[nGroupId].m_fVolume;
+}
+bool Backend::isSoundGroupPaused(const std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept
+{
+	if ((nGroupId < 0) || (nGroupId >= static_cast<int32_t>(aSoundGroups.size()))) {
+		return false; //--------------------------------------------------------
+	}
+	return aSoundGroups[nGroupId].m_bPaused;
+}
+void Backend::startSoundMotion(SoundMotion& oMotion, const AlCommand& oCommand, int64_t nNowUsec) noexcept
+{
+	assert(oCommand.m_eType == AL_COMMAND_SOUND_MOTION);
+	oMotion.m_bMoving = (oCommand.m_fVelX != 0.0) || (oCommand.m_fVelY != 0.0) || (oCommand.m_fVelZ != 0.0);
+	oMotion.m_fVelX = oCommand.m_fVelX;
+	oMotion.m_fVelY = oCommand.m_fVelY;
+	oMotion.m_fVelZ = oCommand.m_fVelZ;
+	oMotion.m_nLastUsec = nNowUsec;
+	if (oCommand.m_nDurationMillisec < 0) {
+		oMotion.m_nArrivalUsec = -1;
+		return; //--------------------------------------------------------------
+	}
+	oMotion.m_nArrivalUsec = nNowUsec + static_cast<int64_t>(oCommand.m_nDurationMillisec) * 1000;
+	const double fSeconds = oCommand.m_nDurationMillisec / 1000.0;
+	oMotion.m_fTargetX = oCommand.m_fPosX + oCommand.m_fVelX * fSeconds;
+	oMotion.m_fTargetY = oCommand.m_fPosY + oCommand.m_fVelY * fSeconds;
+	oMotion.m_fTargetZ = oCommand.m_fPosZ + oCommand.m_fVelZ * fSeconds;
+}
+bool Backend::advanceSoundMotion(SoundMotion& oMotion, int64_t nNowUsec, double& fX, double& fY, double& fZ) noexcept
+{
+	if (! oMotion.m_bMoving) {
+		return false; //--------------------------------------------------------
+	}
+	if ((oMotion.m_nArrivalUsec >= 0) && (nNowUsec >= oMotion.m_nArrivalUsec)) {
+		// no rounding errors at arrival
+		fX = oMotion.m_fTargetX;
+		fY = oMotion.m_fTargetY;
+		fZ = oMotion.m_fTargetZ;
+		oMotion = SoundMotion{};
+		return true; //---------------------------------------------------------
+	}
+	const double fSeconds = (nNowUsec - oMotion.m_nLastUsec) / 1000000.0;
+	fX += oMotion.m_fVelX * fSeconds;
+	fY += oMotion.m_fVelY * fSeconds;
+	fZ += oMotion.m_fVelZ * fSeconds;
+	oMotion.m_nLastUsec = nNowUsec;
+	return true;
+}
+void Backend::startSoundRamp(SoundRamp& oRamp, double fFromVolume, const AlCommand& oCommand, int64_t nNowUsec) noexcept
+{
+	assert(oCommand.m_eType == AL_COMMAND_SOUND_RAMP);
+	assert(oCommand.m_nDurationMillisec >= 0);
+	oRamp.m_bRamping = true;
+	oRamp.m_fFromVolume = fFromVolume;
+	oRamp.m_fToVolume = std::max(0.0, std::min(1.0, oCommand.m_fVolume));
+	oRamp.m_nStartUsec = nNowUsec;
+	oRamp.m_nEndUsec = nNowUsec + static_cast<int64_t>(oCommand.m_nDurationMillisec) * 1000;
+	oRamp.m_nCurve = oCommand.m_nCurve;
+	oRamp.m_bStopAtEnd = oCommand.m_bStopAtEnd;
+}
+bool Backend::advanceSoundRamp(SoundRamp& oRamp, int64_t nNowUsec, double& fVolume, bool& bStop) noexcept
+{
+	bStop = false;
+	if (! oRamp.m_bRamping) {
+		return false; //--------------------------------------------------------
+	}
+	if (nNowUsec >= oRamp.m_nEndUsec) {
+		fVolume = oRamp.m_fToVolume;
+		bStop = oRamp.m_bStopAtEnd;
+		oRamp = SoundRamp{};
+		return true; //---------------------------------------------------------
+	}
+	const double fT = static_cast<double>(nNowUsec - oRamp.m_nStartUsec) / (oRamp.m_nEndUsec - oRamp.m_nStartUsec);
+	switch (oRamp.m_nCurve) {
+	case PlaybackCapability::RAMP_CURVE_SMOOTH:
+	{
+		const double fS = fT * fT * (3.0 - 2.0 * fT);
+		fVolume = oRamp.m_fFromVolume + (oRamp.m_fToVolume - oRamp.m_fFromVolume) * fS;
+	} break;
+	case PlaybackCapability::RAMP_CURVE_EXPONENTIAL:
+	{
+		// -60 dB is considered silence
+		const double fMinVolume = 0.001;
+		const double fFromDb = 20.0 * std::log10(std::max(fMinVolume, oRamp.m_fFromVolume));
+		const double fToDb = 20.0 * std::log10(std::max(fMinVolume, oRamp.m_fToVolume));
+		fVolume = std::pow(10.0, (fFromDb + (fToDb - fFromDb) * fT) / 20.0);
+		if (fVolume <= fMinVolume) {
+			fVolume = 0.0;
+		}
+	} break;
+	default:
+	{
+		fVolume = oRamp.m_fFromVolume + (oRamp.m_fToVolume - oRamp.m_fFromVolume) * fT;
+	} break;
+	}
+	return true;
+}
+void Backend::setPcmDiskCacheDirectory(const std::string& sDirectory) noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oPcmDiskCacheMutex);
+	m_sPcmDiskCacheDirectory = sDirectory;
+}
+std::string Backend::getPcmDiskCacheDirectory() const noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oPcmDiskCacheMutex);
+	return m_sPcmDiskCacheDirectory;
+}
+void Backend::sendCommand(AlCommand&& oAlCommand) noexcept
+{
+	if (isLatencyEnabled()) {
+		oAlCommand.m_nSentTimeUsec = getSteadyTimeUsec();
+	}
+	CommandNode* p0Node = newCommandNode(std::move(oAlCommand));
+	pushCommands(p0Node, p0Node);
+}
+void Backend::sendCommands(std::vector<AlCommand>&& aAlCommands) noexcept
+{
+	if (aAlCommands.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	const int64_t nSentTimeUsec = (isLatencyEnabled() ? getSteadyTimeUsec() : -1);
+	// link the nodes before publishing them all at once
+	CommandNode* p0First = nullptr;
+	CommandNode* p0Last = nullptr;
+	for (auto& oAlCommand : aAlCommands) {
+		oAlCommand.m_nSentTimeUsec = nSentTimeUsec;
+		CommandNode* p0Node = newCommandNode(std::move(oAlCommand));
+		if (p0Last == nullptr) {
+			p0First = p0Node;
+		} else {
+			p0Last->m_p0Next.store(p0Node, std::memory_order_relaxed);
+		}
+		p0Last = p0Node;
+	}
+	aAlCommands.clear();
+	pushCommands(p0First, p0Last);
+}
+Backend::CommandNode* Backend::newCommandNode(AlCommand&& oAlCommand) noexcept
+{
+	CommandNode* p0Node = nullptr;
+	uint64_t nHead = m_nFreeCommandNodes.load(std::memory_order_acquire);
+	while (true) {
+		const int32_t nPoolIndex = getFirstFreeCommandNode(nHead);
+		if (nPoolIndex < 0) {
+			// the pool is exhausted
+			p0Node = new CommandNode();
+			p0Node->m_nPoolIndex = -1;
+			break; // while ----
+		}
+		CommandNode& oFree = m_refCommandNodePool[nPoolIndex];
+		// If another sender pops the node in the meantime the value might be stale
+		// but then the tag of the head has changed and the exchange fails
+		const int32_t nNextFree = oFree.m_nNextFree.load(std::memory_order_relaxed);
+		if (m_nFreeCommandNodes.compare_exchange_weak(nHead, packFreeCommandNodes(nNextFree, nHead)
+													, std::memory_order_acquire, std::memory_order_acquire)) {
+			p0Node = &oFree;
+			break; // while ----
+		}
+	}
+	p0Node->m_oAlCommand = std::move(oAlCommand);
+	p0Node->m_p0Next.store(nullptr, std::memory_order_relaxed);
+	return p0Node;
+}
+void Backend::recycleCommandNode(CommandNode* p0Node) noexcept
+{
+	if (p0Node->m_nPoolIndex < 0) {
+		delete p0Node;
+		return; //--------------------------------------------------------------
+	}
+	uint64_t nHead = m_nFreeCommandNodes.load(std::memory_order_relaxed);
+	do {
+		p0Node->m_nNextFree.store(getFirstFreeCommandNode(nHead), std::memory_order_relaxed);
+	} while (! m_nFreeCommandNodes.compare_exchange_weak(nHead, packFreeCommandNodes(p0Node->m_nPoolIndex, nHead)
+														, std::memory_order_release, std::memory_order_relaxed));
+}
+void Backend::pushCommands(CommandNode* p0First, CommandNode* p0Last) noexcept
+{
+	// Wait-free: the only contended operation is the exchange.
+	// Sequentially consistent, see notifyIfWaiting()
+	CommandNode* p0Prev = m_p0CommandsHead.exchange(p0Last);
+	// Until this store the backend thread can't take the new nodes (nor the nodes
+	// pushed in the meantime by other threads) but hasCommands() returns true
+	p0Prev->m_p0Next.store(p0First, std::memory_order_release);
+	notifyIfWaiting();
+}
+void Backend::notifyIfWaiting() noexcept
+{
+	// The sender changes the queue (or the triggers) then reads m_bWaitingForCommands,
+	// the backend thread sets m_bWaitingForCommands then reads the queue, all sequentially
+	// consistent: at least one of the two sees the change of the other.
+	if (! m_bWaitingForCommands.load()) {
+		return; //--------------------------------------------------------------
+	}
+	// The backend thread checks the queue and starts waiting with the mutex locked,
+	// so that locking it here ensures it is already waiting or sees the change
+	{
+		std::lock_guard<std::mutex> oLock(m_oAlCommandMutex);
+	}
+	m_oAlCommandsNotEmpty.notify_one();
+}
+int32_t Backend::reserveTriggerSlot(int32_t nSoundId) noexcept
+{
+	assert(nSoundId >= 0);
+	for (int32_t nTriggerSlot = 0; nTriggerSlot < s_nMaxTriggerSlots; ++nTriggerSlot) {
+		auto& nValue = m_aTriggerSlots[nTriggerSlot];
+		int64_t nOldValue = nValue.load(std::memory_order_relaxed);
+		if (getTriggerSlotState(nOldValue) != TRIGGER_SLOT_FREE) {
+			continue; // for nTriggerSlot ----
+		}
+		if (nValue.compare_exchange_strong(nOldValue, getTriggerSlotValue(nSoundId, TRIGGER_SLOT_PREPARED), std::memory_order_relaxed)) {
+			return nTriggerSlot; //---------------------------------------------
+		}
+	}
+	return -1;
+}
+bool Backend::trigger(int32_t nSoundId) noexcept
+{
+	if (nSoundId < 0) {
+		return false; //--------------------------------------------------------
+	}
+	const int64_t nPrepared = getTriggerSlotValue(nSoundId, TRIGGER_SLOT_PREPARED);
+	for (int32_t nTriggerSlot = 0; nTriggerSlot < s_nMaxTriggerSlots; ++nTriggerSlot) {
+		auto& nValue = m_aTriggerSlots[nTriggerSlot];
+		if (nValue.load(std::memory_order_relaxed) != nPrepared) {
+			continue; // for nTriggerSlot ----
+		}
+		// if the slot is reused in the meantime the latency of the other sound might be off
+		m_aTriggerUsecs[nTriggerSlot].store((isLatencyEnabled() ? getSteadyTimeUsec() : -1), std::memory_order_relaxed);
+		int64_t nExpected = nPrepared;
+		if (! nValue.compare_exchange_strong(nExpected, getTriggerSlotValue(nSoundId, TRIGGER_SLOT_TRIGGERED), std::memory_order_release)) {
+			// cancelled or released
+			return false; //----------------------------------------------------
+		}
+		// Sequentially consistent, see notifyIfWaiting()
+		m_nTriggersPending.fetch_add(1);
+		notifyIfWaiting();
+		return true; //---------------------------------------------------------
+	}
+	return false;
+}
+void Backend::cancelTrigger(int32_t nSoundId) noexcept
+{
+	if (nSoundId < 0) {
+		return; //--------------------------------------------------------------
+	}
+	const int64_t nPrepared = getTriggerSlotValue(nSoundId, TRIGGER_SLOT_PREPARED);
+	for (auto& nValue : m_aTriggerSlots) {
+		int64_t nExpected = nPrepared;
+		if (nValue.compare_exchange_strong(nExpected, getTriggerSlotValue(nSoundId, TRIGGER_SLOT_CANCELLED), std::memory_order_relaxed)) {
+			return; //----------------------------------------------------------
+		}
+	}
+}
+bool Backend::takeTrigger(int32_t nTriggerSlot) noexcept
+{
+	assert((nTriggerSlot >= 0) && (nTriggerSlot < s_nMaxTriggerSlots));
+	auto& nValue = m_aTriggerSlots[nTriggerSlot];
+	if (getTriggerSlotState(nValue.load(std::memory_order_acquire)) != TRIGGER_SLOT_TRIGGERED) {
+		return false; //--------------------------------------------------------
+	}
+	// only this thread changes a triggered slot
+	const int64_t nTriggerUsec = m_aTriggerUsecs[nTriggerSlot].load(std::memory_order_relaxed);
+	nValue.store(TRIGGER_SLOT_FREE, std::memory_order_release);
+	m_nTriggersPending.fetch_sub(1, std::memory_order_relaxed);
+	if ((nTriggerUsec >= 0) && isLatencyEnabled()) {
+		m_oLatencyRecorder.addTrigger(getSteadyTimeUsec() - nTriggerUsec);
+	}
+	return true;
+}
+void Backend::releaseTriggerSlot(int32_t nTriggerSlot) noexcept
+{
+	if (nTriggerSlot < 0) {
+		return; //--------------------------------------------------------------
+	}
+	assert(nTriggerSlot < s_nMaxTriggerSlots);
+	const int64_t nOldValue = m_aTriggerSlots[nTriggerSlot].exchange(TRIGGER_SLOT_FREE, std::memory_order_acq_rel);
+	if (getTriggerSlotState(nOldValue) == TRIGGER_SLOT_TRIGGERED) {
+		m_nTriggersPending.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+int64_t Backend::getDeviceClockNanosec(int32_t nBackendDeviceId) const noexcept
+{
+	assert(nBackendDeviceId >= 0);
+	const DeviceClock oDeviceClock = m_aDeviceClocks[nBackendDeviceId % s_nMaxDeviceClocks].load();
+	if (oDeviceClock.m_nBackendDeviceId != nBackendDeviceId) {
+		// not published yet
+		return -1; //-----------------------------------------------------------
+	}
+	if ((oDeviceClock.m_nClockNanosec < 0) || ! oDeviceClock.m_bAdvancing) {
+		return oDeviceClock.m_nClockNanosec; //---------------------------------
+	}
+	const int64_t nElapsedUsec = std::max<int64_t>(0, getSteadyTimeUsec() - oDeviceClock.m_nPublishedUsec);
+	return oDeviceClock.m_nClockNanosec + nElapsedUsec * 1000;
+}
+void Backend::publishDeviceClock(int32_t nBackendDeviceId, int64_t nClockNanosec, bool bAdvancing) noexcept
+{
+	assert(nBackendDeviceId >= 0);
+	const int64_t nNowUsec = getSteadyTimeUsec();
+	DeviceClock oDeviceClock;
+	oDeviceClock.m_nBackendDeviceId = nBackendDeviceId;
+	oDeviceClock.m_nClockNanosec = nClockNanosec;
+	oDeviceClock.m_nPublishedUsec = nNowUsec;
+	oDeviceClock.m_bAdvancing = bAdvancing;
+	m_aDeviceClocks[nBackendDeviceId % s_nMaxDeviceClocks].store(oDeviceClock);
+}
+bool Backend::getSoundState(int32_t nBackendDeviceId, int32_t nSoundId, PlaybackCapability::SoundState& oState) const noexcept
+{
+	if (nSoundId < 0) {
+		return false; //--------------------------------------------------------
+	}
+	const SoundSnapshot oSnapshot = m_aSoundSnapshots[nSoundId % s_nMaxSoundStates].load();
+	if (! isSnapshotOf(oSnapshot, nBackendDeviceId, nSoundId)) {
+		return false; //--------------------------------------------------------
+	}
+	oState.m_eState = static_cast<PlaybackCapability::SOUND_STATE>(oSnapshot.m_nState);
+	oState.m_fLengthSec = oSnapshot.m_fLengthSec;
+	oState.m_fOffsetSec = oSnapshot.m_fOffsetSec;
+	if ((oState.m_eState != PlaybackCapability::SOUND_STATE_PLAYING) || (! oSnapshot.m_bAdvancing)
+			|| (oSnapshot.m_fOffsetSec < 0.0)) {
+		return true; //---------------------------------------------------------
+	}
+	const int64_t nElapsedUsec = std::max<int64_t>(0, getSteadyTimeUsec() - oSnapshot.m_nPublishedUsec);
+	double fOffsetSec = oSnapshot.m_fOffsetSec + nElapsedUsec / 1000000.0;
+	if (oSnapshot.m_fLengthSec > 0.0) {
+		if (oSnapshot.m_bLoop) {
+			fOffsetSec = std::fmod(fOffsetSec, oSnapshot.m_fLengthSec);
+		} else {
+			fOffsetSec = std::min(fOffsetSec, oSnapshot.m_fLengthSec);
+		}
+	}
+	oState.m_fOffsetSec = fOffsetSec;
+	return true;
+}
+bool Backend::isSnapshotOf(const SoundSnapshot& oSnapshot, int32_t nBackendDeviceId, int32_t nSoundId) noexcept
+{
+	return (oSnapshot.m_nState != PlaybackCapability::SOUND_STATE_UNKNOWN) && (oSnapshot.m_nSoundId == nSoundId)
+			&& (oSnapshot.m_nBackendDeviceId == nBackendDeviceId);
+}
+void Backend::publishSoundState(int32_t nBackendDeviceId, int32_t nSoundId, PlaybackCapability::SOUND_STATE eState
+								, double fOffsetSec, double fLengthSec, bool bLoop, bool bAdvancing) noexcept
+{
+	assert(nBackendDeviceId >= 0);
+	assert(nSoundId >= 0);
+	assert(eState != PlaybackCapability::SOUND_STATE_UNKNOWN);
+	SoundSnapshot oSnapshot;
+	oSnapshot.m_nSoundId = nSoundId;
+	oSnapshot.m_nBackendDeviceId = nBackendDeviceId;
+	oSnapshot.m_nState = eState;
+	oSnapshot.m_bLoop = bLoop;
+	oSnapshot.m_bAdvancing = bAdvancing;
+	oSnapshot.m_fOffsetSec = fOffsetSec;
+	oSnapshot.m_fLengthSec = fLengthSec;
+	oSnapshot.m_nPublishedUsec = (bAdvancing ? getSteadyTimeUsec() : 0);
+	m_aSoundSnapshots[nSoundId % s_nMaxSoundStates].store(oSnapshot);
+}
+void Backend::publishSoundRemoved(int32_t nBackendDeviceId, int32_t nSoundId, bool bFinished) noexcept
+{
+	assert(nSoundId >= 0);
+	SeqLock<SoundSnapshot>& oSeqLock = m_aSoundSnapshots[nSoundId % s_nMaxSoundStates];
+	// only this thread writes
+	SoundSnapshot oSnapshot = oSeqLock.load();
+	if (! isSnapshotOf(oSnapshot, nBackendDeviceId, nSoundId)) {
+		oSnapshot.m_nSoundId = nSoundId;
+		oSnapshot.m_nBackendDeviceId = nBackendDeviceId;
+		oSnapshot.m_bLoop = false;
+		oSnapshot.m_fOffsetSec = -1.0;
+		oSnapshot.m_fLengthSec = -1.0;
+		oSnapshot.m_nPublishedUsec = 0;
+	}
+	oSnapshot.m_nState = PlaybackCapability::SOUND_STATE_STOPPED;
+	oSnapshot.m_bAdvancing = false;
+	if (bFinished && (oSnapshot.m_fLengthSec >= 0.0)) {
+		oSnapshot.m_fOffsetSec = oSnapshot.m_fLengthSec;
+	}
+	oSeqLock.store(oSnapshot);
+}
+void Backend::sendEvent(AlEvent&& oAlEvent) noexcept
+{
+	if (m_bHasRealTimeListener.load(std::memory_order_acquire)) {
+		callRealTimeListener(oAlEvent);
+	}
+	if (isLatencyEnabled()) {
+		oAlEvent.m_nSentTimeUsec = getSteadyTimeUsec();
+	}
+	if ((oAlEvent.m_eType == AL_EVENT_PLAY_FINISHED) || (oAlEvent.m_eType == AL_EVENT_PLAY_ERROR)) {
+		oAlEvent.m_nFinishedTimeUsec = DeviceManager::getNowTimeMicroseconds();
+	}
+	std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
+	if (m_aAlEvents.empty() && (m_nEventFD >= 0)) {
+		// make the file descriptor readable, the adapter calls dispatchEvents()
+		const uint64_t nIncrement = 1;
+		ssize_t nWritten;
+		do {
+			nWritten = ::write(m_nEventFD, &nIncrement, sizeof(nIncrement));
+		} while ((nWritten < 0) && (errno == EINTR));
+		// the counter can't overflow since it's reset by each dispatch
+		assert(nWritten == static_cast<ssize_t>(sizeof(nIncrement)));
+	}
+	m_aAlEvents.push_back(std::move(oAlEvent));
+	m_nEventsPending.fetch_add(1, std::memory_order_relaxed);
+}
+bool Backend::setRealTimeListener(const shared_ptr<SndRealTimeListener>& refListener) noexcept
+{
+	if (refListener && ! isThreadSafePlayback()) {
+		// the listener is called by another thread
+		return false; //--------------------------------------------------------
+	}
+	shared_ptr<SndRealTimeListener> refOldListener;
+	{
+		std::lock_guard<std::mutex> oLock(m_oRealTimeListenerMutex);
+		refOldListener = std::move(m_refRealTimeListener);
+		m_refRealTimeListener = refListener;
+		m_bHasRealTimeListener.store(refListener.operator bool(), std::memory_order_release);
+	}
+	// released outside the lock, if the backend is calling it its copy is the last reference
+	return true;
+}
+void Backend::callRealTimeListener(const AlEvent& oAlEvent) noexcept
+{
+	SndFinishedEvent::FINISHED_TYPE eFinishedType;
+	if (oAlEvent.m_eType == AL_EVENT_PLAY_FINISHED) {
+		eFinishedType = (oAlEvent.m_bFadedOut ? SndFinishedEvent::FINISHED_TYPE_FADED_OUT : SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+	} else if ((oAlEvent.m_eType == AL_EVENT_PLAY_ERROR) && (oAlEvent.m_nSoundId >= 0)) {
+		eFinishedType = SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND;
+	} else {
+		return; //--------------------------------------------------------------
+	}
+	shared_ptr<SndRealTimeListener> refListener;
+	{
+		std::lock_guard<std::mutex> oLock(m_oRealTimeListenerMutex);
+		refListener = m_refRealTimeListener;
+	}
+	// called without holding the lock: the main thread can replace it meanwhile
+	if (refListener) {
+		// the triggered sounds are started before the backend renders again
+		refListener->onSoundFinished(oAlEvent.m_nSoundId, eFinishedType);
+	}
+}
+void Backend::sendPreloadedEvent(const AlCommand& oAlCommand, bool bLoaded) noexcept
+{
+	assert(oAlCommand.m_eType == AL_COMMAND_PRELOAD);
+	if (oAlCommand.m_nBatchId < 0) {
+		return; //--------------------------------------------------------------
+	}
+	AlEvent oEv;
+	oEv.m_eType = AL_EVENT_PRELOADED;
+	oEv.m_nBackendDeviceId = oAlCommand.m_nBackendDeviceId;
+	oEv.m_nFileId = oAlCommand.m_nFileId;
+	oEv.m_nBatchId = oAlCommand.m_nBatchId;
+	oEv.m_bLoaded = bLoaded;
+	sendEvent(std::move(oEv));
+}
+void Backend::takeCommands(std::vector<AlCommand>& aReadAlCommands) noexcept
+{
+	aReadAlCommands.clear();
+	CommandNode* p0Tail = m_p0CommandsTail;
+	CommandNode* p0Next = p0Tail->m_p0Next.load(std::memory_order_acquire);
+	while (p0Next != nullptr) {
+		aReadAlCommands.push_back(std::move(p0Next->m_oAlCommand));
+		recycleCommandNode(p0Tail);
+		p0Tail = p0Next;
+		p0Next = p0Tail->m_p0Next.load(std::memory_order_acquire);
+	}
+	m_p0CommandsTail = p0Tail;
+	// the queue only grows between two calls
+	const int32_t nDepth = static_cast<int32_t>(aReadAlCommands.size());
+	if (nDepth > m_nCommandQueueHighWater) {
+		m_nCommandQueueHighWater = nDepth;
+	}
+	m_oRawStats.m_nCommandQueueDepth = nDepth;
+	m_oRawStats.m_nCommandQueueHighWater = m_nCommandQueueHighWater;
+}
+void Backend::publishStats() noexcept
+{
+	m_oStatsSeqLock.store(m_oRawStats);
+}
+bool Backend::deferPreload(AlCommand& oAlCommand) noexcept
+{
+	if ((oAlCommand.m_eType != AL_COMMAND_PRELOAD) || (oAlCommand.m_nBatchId < 0)) {
+		return false; //--------------------------------------------------------
+	}
+	// after all the preloads with the same or higher priority
+	const auto itInsert = std::upper_bound(m_aDeferredPreloads.begin(), m_aDeferredPreloads.end(), oAlCommand.m_nPriority
+											, [](int32_t nPriority, const AlCommand& oDeferred)
+	{
+		return (nPriority > oDeferred.m_nPriority);
+	});
+	m_aDeferredPreloads.insert(itInsert, std::move(oAlCommand));
+	return true;
+}
+void Backend::cancelDeferredPreloads(int32_t nBackendDeviceId, int32_t nBatchId) noexcept
+{
+	m_aDeferredPreloads.erase(std::remove_if(m_aDeferredPreloads.begin(), m_aDeferredPreloads.end(), [&](const AlCommand& oDeferred)
+	{
+		return (oDeferred.m_nBackendDeviceId == nBackendDeviceId) && ((nBatchId < 0) || (oDeferred.m_nBatchId == nBatchId));
+	}), m_aDeferredPreloads.end());
+}
+void Backend::takeDeferredPreloads(int32_t nMaxPreloads, std::vector<AlCommand>& aPreloads) noexcept
+{
+	assert(nMaxPreloads > 0);
+	const int32_t nTotTaken = std::min(nMaxPreloads, static_cast<int32_t>(m_aDeferredPreloads.size()));
+	const auto itEnd = m_aDeferredPreloads.begin() + nTotTaken;
+	aPreloads.insert(aPreloads.end(), std::make_move_iterator(m_aDeferredPreloads.begin()), std::make_move_iterator(itEnd));
+	m_aDeferredPreloads.erase(m_aDeferredPreloads.begin(), itEnd);
+}
+SndStatsCapability::Stats Backend::getStats() const noexcept
+{
+	const RawStats oRawStats = m_oStatsSeqLock.load();
+	SndStatsCapability::Stats oStats;
+	const int32_t nMaxDevices = SndStatsCapability::s_nMaxStatsDevices;
+	for (int32_t nBackendDeviceId = 0; nBackendDeviceId < nMaxDevices; ++nBackendDeviceId) {
+		const RawDeviceStats& oRawDeviceStats = oRawStats.m_aDevices[nBackendDeviceId];
+		if (! oRawDeviceStats.m_bExists) {
+			continue;
+		}
+		SndStatsCapability::DeviceStats oDeviceStats;
+		oDeviceStats.m_nDeviceId = m_aStatsDeviceIds[nBackendDeviceId].load(std::memory_order_relaxed);
+		oDeviceStats.m_nActiveSources = oRawDeviceStats.m_nActiveSources;
+		oDeviceStats.m_nUnusedSources = oRawDeviceStats.m_nUnusedSources;
+		oDeviceStats.m_nBuffers = oRawDeviceStats.m_nBuffers;
+		oDeviceStats.m_nBufferBytes = oRawDeviceStats.m_nBufferBytes;
+		oDeviceStats.m_nDownmixSavedBytes = oRawDeviceStats.m_nDownmixSavedBytes;
+		oDeviceStats.m_nEvictedBuffers = oRawDeviceStats.m_nEvictedBuffers;
+		oStats.m_aDevices.push_back(oDeviceStats);
+	}
+	oStats.m_nCommandQueueDepth = oRawStats.m_nCommandQueueDepth;
+	oStats.m_nCommandQueueHighWater = oRawStats.m_nCommandQueueHighWater;
+	oStats.m_aExecutedCommands.assign(oRawStats.m_aExecutedCommands.begin(), oRawStats.m_aExecutedCommands.end());
+	oStats.m_nEventsPending = m_nEventsPending.load(std::memory_order_relaxed);
+	oStats.m_nDeviceRecreations = oRawStats.m_nDeviceRecreations;
+	oStats.m_nEncodedBytes = oRawStats.m_nEncodedBytes;
+	return oStats;
+}
+void Backend::setStatsDeviceId(int32_t nBackendDeviceId, int32_t nDeviceId) noexcept
+{
+	assert(nBackendDeviceId >= 0);
+	if (nBackendDeviceId >= SndStatsCapability::s_nMaxStatsDevices) {
+		return; //--------------------------------------------------------------
+	}
+	m_aStatsDeviceIds[nBackendDeviceId].store(nDeviceId, std::memory_order_relaxed);
+}
+void Backend::addInitialDevice(std::string&& sName, int32_t nBackendDeviceId, bool bIsDefault) noexcept
+{
+	m_p0Owner->onDeviceAdded(std::move(sName), nBackendDeviceId, bIsDefault);
+}
+int64_t Backend::getSteadyTimeUsec() const noexcept
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+void Backend::recordCommandLatency(const AlCommand& oAlCommand, int64_t nExecStartUsec, int64_t nExecEndUsec) noexcept
+{
+	if (oAlCommand.m_nSentTimeUsec < 0) {
+		// latency stats were enabled after the command was sent
+		return; //--------------------------------------------------------------
+	}
+	const int32_t nType = static_cast<int32_t>(oAlCommand.m_eType);
+	m_oLatencyRecorder.addQueueWait(nType, nExecStartUsec - oAlCommand.m_nSentTimeUsec);
+	m_oLatencyRecorder.addExecution(nType, nExecEndUsec - nExecStartUsec);
+}
+void Backend::recordDecodeLatency(int64_t nDecodeStartUsec, int64_t nDecodeEndUsec) noexcept
+{
+	if (nDecodeStartUsec < 0) {
+		return; //--------------------------------------------------------------
+	}
+	m_oLatencyRecorder.addDecode(nDecodeEndUsec - nDecodeStartUsec);
+}
+std::string Backend::attachEventLoop() noexcept
+{
+	assert(! m_bEventLoopAttached);
+	if (m_nEventFD < 0) {
+		return "Error: eventfd() failed"; //------------------------------------
+	}
+	m_bEventLoopAttached = true;
+	if (m_refEventLoopAdapter) {
+		m_refEventLoopAdapter->attach(m_nEventFD, [this]()
+		{
+			dispatchEvents();
+		});
+	}
+	return "";
+}
+void Backend::detachEventLoop() noexcept
+{
+	if (! m_bEventLoopAttached) {
+		return; //--------------------------------------------------------------
+	}
+	m_bEventLoopAttached = false;
+	if (m_refEventLoopAdapter) {
+		m_refEventLoopAdapter->detach();
+	}
+}
+void Backend::setEventLoopAdapter(std::unique_ptr<EventLoopAdapter> refAdapter) noexcept
+{
+	const bool bAttached = m_bEventLoopAttached;
+	detachEventLoop();
+	m_refEventLoopAdapter = std::move(refAdapter);
+	if (bAttached) {
+		attachEventLoop();
+	}
+}
+void Backend::dispatchEvents() noexcept
+{
+	if (m_bDispatchingEvents) {
+		// m_aReadAlEvents is being iterated, the new events are delivered
+		// when the file descriptor is readable again
+		return; //--------------------------------------------------------------
+	}
+	assert(m_aReadAlEvents.empty());
+	{
+		std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
+		m_aReadAlEvents = std::move(m_aAlEvents);
+		m_aAlEvents.clear();
+		m_nEventsPending.fetch_sub(static_cast<int32_t>(m_aReadAlEvents.size()), std::memory_order_relaxed);
+		if ((! m_aReadAlEvents.empty()) && (m_nEventFD >= 0)) {
+			// reset the counter, not readable until the next sendEvent()
+			uint64_t nCounter;
+			ssize_t nRead;
+			do {
+				nRead = ::read(m_nEventFD, &nCounter, sizeof(nCounter));
+			} while ((nRead < 0) && (errno == EINTR));
+		}
+	}
+	if (m_aReadAlEvents.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	TraceSpan oSpan(*this, m_oMainTraceRing, "dispatchEvents");
+//std::cout << "Backend::dispatchEvents() tot AL_EVENTs = " << m_aReadAlEvents.size() << '\n';
+	const bool bLatency = isLatencyEnabled();
+	m_bDispatchingEvents = true;
+	m_p0Owner->onEventsDispatchBegin();
+	for (AlEvent& oAlEvent : m_aReadAlEvents) {
+//std::cout << "Backend::dispatchEvents() oAlEvent.m_nBackendDeviceId = " << oAlEvent.m_nBackendDeviceId << '\n';
+//std::cout << "Backend::dispatchEvents()         .m_nFileId   = " << oAlEvent.m_nFileId << '\n';
+//std::cout << "Backend::dispatchEvents()         .m_nSoundId  = " << oAlEvent.m_nSoundId << '\n';
+//std::cout << "Backend::dispatchEvents()         .m_eType     = " << static_cast<int32_t>(oAlEvent.m_eType) << '\n';
+		switch (oAlEvent.m_eType) {
+		case AL_EVENT_PLAY_FINISHED:
+		{
+			if (bLatency && (oAlEvent.m_nSentTimeUsec >= 0)) {
+				m_oLatencyRecorder.addFinishedDelivery(getSteadyTimeUsec() - oAlEvent.m_nSentTimeUsec);
+			}
+			m_p0Owner->onPlayFinished(oAlEvent.m_nBackendDeviceId, oAlEvent.m_nSoundId, oAlEvent.m_bFadedOut
+									, oAlEvent.m_nFinishedTimeUsec);
+		} break;
+		case AL_EVENT_DEVICE_ADDED:
+		{
+			m_p0Owner->onDeviceAdded(std::move(oAlEvent.m_sDeviceName), oAlEvent.m_nBackendDeviceId, oAlEvent.m_bDeviceIsDefault);
+		} break;
+		case AL_EVENT_DEVICE_REMOVED:
+		{
+			m_p0Owner->onDeviceRemoved(oAlEvent.m_nBackendDeviceId);
+		} break;
+		case AL_EVENT_DEVICE_CHANGED:
+		{
+			m_p0Owner->onDeviceChanged(oAlEvent.m_nBackendDeviceId, oAlEvent.m_bDeviceIsDefault);
+		} break;
+		case AL_EVENT_PLAY_ERROR:
+		{
+			m_p0Owner->onDeviceError(oAlEvent.m_nBackendDeviceId, oAlEvent.m_nFileId, oAlEvent.m_nSoundId
+									, oAlEvent.m_nFinishedTimeUsec, std::move(oAlEvent.m_sError));
+		} break;
+		case AL_EVENT_PRELOADED:
+		{
+			m_p0Owner->onPreloaded(oAlEvent.m_nBackendDeviceId, oAlEvent.m_nBatchId, oAlEvent.m_nFileId, oAlEvent.m_bLoaded);
+		} break;
+		default:
+		{
+			assert(false);
+		} break;
+		}
+	}
+	m_aReadAlEvents.clear();
+	// the finished sounds collected in batch mode are sent now
+	m_p0Owner->onEventsDispatchEnd();
+	m_bDispatchingEvents = false;
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
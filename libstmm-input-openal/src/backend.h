@@ -0,0 +1,604 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   backend.h
+ */
+
+#ifndef STMI_OPENAL_BACKEND_BASE_H
+#define STMI_OPENAL_BACKEND_BASE_H
+
+#include "eventloopadapter.h"
+#include "latencyrecorder.h"
+#include "seqlock.h"
+#include "sndrealtimelistener.h"
+#include "sndstatscapability.h"
+#include "tracerecorder.h"
+
+#include <stmm-input-au/playbackcapability.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+class OpenAlDeviceManager;
+
+namespace Private
+{
+namespace OpenAl
+{
+
+using std::shared_ptr;
+using std::unique_ptr;
+using std::weak_ptr;
+
+////////////////////////////////////////////////////////////////////////////////
+/** The backend of OpenAlDeviceManager.
+ * PlaybackDevice instances send commands to the backend with sendCommand().
+ * The backend executes them (usually in its own thread) and queues events
+ * with sendEvent(), which are delivered to the owner device manager in the
+ * main thread by dispatchEvents(). The event loop adapter calls it when the
+ * event file descriptor (see getEventFD()) is readable.
+ *
+ * Subclasses implement the actual playback (OpenAL, fake for testing, etc.).
+ */
+class Backend
+{
+public:
+	// Writes the trace file if setTraceExitFilePath() was called.
+	// Subclasses must have stopped their threads.
+	virtual ~Backend() noexcept;
+
+	// return empty if ok error otherwise
+	// This has to be called when the OpenAlDeviceManager is ready to receive callbacks.
+	// The devices available at start must be added with addInitialDevice()
+	// before this function returns.
+	virtual std::string start() noexcept = 0;
+
+	// Main thread: only supported by offline backends, see OpenAlDeviceManager::renderOffline().
+	// Returns the rendered milliseconds or -1 if not supported.
+	virtual int32_t renderOffline(int32_t /*nMillisec*/, bool /*bStopWhenIdle*/) noexcept { return -1; }
+
+	// Main thread: deliver the queued events to the owner and drain the event file descriptor.
+	// Does nothing if called (by a listener) while the events are being delivered.
+	void dispatchEvents() noexcept;
+	// Main thread: whether dispatchEvents() is delivering events.
+	bool isDispatchingEvents() const noexcept { return m_bDispatchingEvents; }
+	// Any thread: the file descriptor that is readable while events are queued, -1 if it
+	// couldn't be created (start() then fails for backends with their own thread).
+	int32_t getEventFD() const noexcept { return m_nEventFD; }
+	// Main thread: replaces the event loop adapter. Can be null (the application then
+	// watches getEventFD() itself). If attached the old one is detached and the new one attached.
+	void setEventLoopAdapter(std::unique_ptr<EventLoopAdapter> refAdapter) noexcept;
+
+	enum AL_COMMAND_TYPE
+	{
+		AL_COMMAND_FIRST           = 0
+		, AL_COMMAND_PRELOAD       = 0
+		, AL_COMMAND_PLAY          = 1
+		, AL_COMMAND_PAUSE         = 2
+		, AL_COMMAND_RESUME        = 3
+		, AL_COMMAND_STOP          = 4
+		, AL_COMMAND_PAUSE_DEVICE  = 5
+		, AL_COMMAND_RESUME_DEVICE = 6
+		, AL_COMMAND_STOP_ALL      = 7
+		, AL_COMMAND_SOUND_POS     = 8
+		, AL_COMMAND_SOUND_VOL     = 9
+		, AL_COMMAND_LISTENER_POS  = 10
+		, AL_COMMAND_LISTENER_VOL  = 11
+		, AL_COMMAND_CANCEL_PRELOADS = 12 /**< Drops the deferred preloads of a batch. */
+		, AL_COMMAND_GROUP_VOL     = 13
+		, AL_COMMAND_PAUSE_GROUP   = 14
+		, AL_COMMAND_RESUME_GROUP  = 15
+		, AL_COMMAND_STOP_GROUP    = 16
+		, AL_COMMAND_SOUND_MOTION  = 17 /**< Sets position and velocity of a sound. */
+		, AL_COMMAND_SOUND_RAMP    = 18 /**< Starts a volume ramp of a sound. */
+		, AL_COMMAND_LAST          = 18
+	};
+	struct AlCommand
+	{
+		int32_t m_nBackendDeviceId;
+		AL_COMMAND_TYPE m_eType;
+		int32_t m_nSoundId = -1;
+		int32_t m_nFileId = -1;
+		std::string m_sFileName;
+		const uint8_t* m_p0Buffer = nullptr;
+		int32_t m_nBufferSize = 0;
+		bool m_bLoop = false; /*< Whether sound is looping */
+		bool m_bRelative = false; /*< Whether relative to listener. Default is false. */
+		double m_fPosX = 0; /*< Used for setting the x position or x direction */
+		double m_fPosY = 0; /*< Used for setting the y position or x direction */
+		double m_fPosZ = 0; /*< Used for setting the z position or x direction */
+		double m_fVolume = 1.0; /*< The volume. Default is 1.0. */
+		bool m_bMonoDownmix = false; /*< Whether a stereo sound played positionally is down-mixed to mono. */
+		int32_t m_nBatchId = -1; /*< The preload batch or -1. If not -1 the preload sends AL_EVENT_PRELOADED. */
+		int32_t m_nPriority = 0; /*< The PlaybackCapability::PRELOAD_PRIORITY of a batch preload. */
+		int32_t m_nGroupId = -1; /*< The sound group of a play or group command or -1. */
+		double m_fVelX = 0; /*< The x velocity in units per second of a motion command. */
+		double m_fVelY = 0; /*< The y velocity in units per second of a motion command. */
+		double m_fVelZ = 0; /*< The z velocity in units per second of a motion command. */
+		int32_t m_nDurationMillisec = -1; /*< The duration of a motion (-1 if it doesn't end) or ramp command. */
+		int32_t m_nCurve = 0; /*< The PlaybackCapability::RAMP_CURVE of a ramp command. */
+		bool m_bStopAtEnd = false; /*< Whether a ramp command stops the sound at the end (fade out). */
+		int64_t m_nStartClockNanosec = -1; /*< The device clock time a play command starts at or -1 if immediately. */
+		int32_t m_nTriggerSlot = -1; /*< The trigger slot of a prepared sound's play command or -1. */
+		int64_t m_nSentTimeUsec = -1; /*< Set by sendCommand() if latency stats enabled. */
+	};
+
+	enum AL_EVENT_TYPE
+	{
+		AL_EVENT_INVALID          = -1
+		, AL_EVENT_FIRST          = 0
+		, AL_EVENT_PLAY_FINISHED  = 0
+		, AL_EVENT_DEVICE_ADDED   = 1
+		, AL_EVENT_DEVICE_REMOVED = 2
+		, AL_EVENT_DEVICE_CHANGED = 3 /**< Either the device has become default or no longer is default. */
+		, AL_EVENT_PLAY_ERROR     = 4
+		, AL_EVENT_PRELOADED      = 5 /**< A preload of a batch was executed. */
+		, AL_EVENT_LAST           = 5
+	};
+	struct AlEvent
+	{
+		std::string m_sDeviceName;
+		AL_EVENT_TYPE m_eType = AL_EVENT_INVALID;
+		bool m_bDeviceIsDefault = false;
+		std::string m_sError;
+		int32_t m_nBackendDeviceId = -1;
+		int32_t m_nSoundId = -1;
+		int32_t m_nFileId = -1;
+		int32_t m_nBatchId = -1;
+		bool m_bLoaded = false; /*< AL_EVENT_PRELOADED: whether the file could be loaded. */
+		bool m_bFadedOut = false; /*< AL_EVENT_PLAY_FINISHED: whether stopped at the end of a fade out. */
+		int64_t m_nSentTimeUsec = -1; /*< Set by sendEvent() if latency stats enabled. */
+		int64_t m_nFinishedTimeUsec = -1; /*< AL_EVENT_PLAY_FINISHED, AL_EVENT_PLAY_ERROR: set by sendEvent(), time from epoch. */
+	};
+
+	// Any thread: lock-free, the commands sent by a thread are executed in the same order.
+	void sendCommand(AlCommand&& oAlCommand) noexcept;
+	// Any thread: lock-free, the commands are queued at once so that
+	// the backend takes them in the same iteration.
+	void sendCommands(std::vector<AlCommand>&& aAlCommands) noexcept;
+	// Any thread: the estimated current device clock of a device or -1 if not known
+	// See PlaybackCapability::getDeviceClockNanosec()
+	int64_t getDeviceClockNanosec(int32_t nBackendDeviceId) const noexcept;
+	// Any thread: reserves the trigger slot of a prepared sound, -1 if all are in use.
+	// The slot is owned by the sound id until the backend thread releases it
+	// when the sound is started or removed.
+	int32_t reserveTriggerSlot(int32_t nSoundId) noexcept;
+	// Any thread: lock-free, the backend thread starts the prepared sound.
+	// Returns false if the sound was not prepared, already triggered, cancelled or released.
+	bool trigger(int32_t nSoundId) noexcept;
+	// Any thread: lock-free, a stopped prepared sound can no longer be triggered.
+	// The slot stays in use until the backend thread releases it.
+	// Does nothing if the sound is not prepared or was already triggered.
+	void cancelTrigger(int32_t nSoundId) noexcept;
+	// The maximum number of prepared sounds that are not triggered yet
+	static constexpr const int32_t s_nMaxTriggerSlots = 64;
+	// Any thread: lock-free, the last published state of a sound of a device extrapolated to now.
+	// Returns false if not published (not executed yet or overwritten by a more recent sound).
+	// See PlaybackCapability::getSoundState()
+	bool getSoundState(int32_t nBackendDeviceId, int32_t nSoundId, PlaybackCapability::SoundState& oState) const noexcept;
+	// The number of sound states kept, indexed by sound id modulo this number
+	static constexpr const int32_t s_nMaxSoundStates = 1024;
+
+	// Any thread
+	LatencyRecorder& getLatencyRecorder() noexcept { return m_oLatencyRecorder; }
+	const LatencyRecorder& getLatencyRecorder() const noexcept { return m_oLatencyRecorder; }
+	// Any thread: the last published statistics
+	SndStatsCapability::Stats getStats() const noexcept;
+	// Main thread: sets the stmi::Device id of a backend device (-1 if removed)
+	void setStatsDeviceId(int32_t nBackendDeviceId, int32_t nDeviceId) noexcept;
+	// Any thread
+	TraceRecorder& getTraceRecorder() noexcept { return m_oTraceRecorder; }
+	const TraceRecorder& getTraceRecorder() const noexcept { return m_oTraceRecorder; }
+	// Main thread: if not empty the trace is written to the file on destruction
+	void setTraceExitFilePath(const std::string& sFilePath) noexcept { m_sTraceExitFilePath = sFilePath; }
+	// Any thread: whether PCM WAV sounds loaded from now on are converted to the device format
+	void setNativeFormatConversion(bool bEnabled) noexcept { m_bNativeFormatConversion.store(bEnabled, std::memory_order_relaxed); }
+	bool isNativeFormatConversion() const noexcept { return m_bNativeFormatConversion.load(std::memory_order_relaxed); }
+	// Any thread: the OpenAlDeviceManager::SAMPLE_FORMAT sounds loaded from now on are encoded to
+	void setCompressedSampleFormat(int32_t nFormat) noexcept { m_nCompressedSampleFormat.store(nFormat, std::memory_order_relaxed); }
+	int32_t getCompressedSampleFormat() const noexcept { return m_nCompressedSampleFormat.load(std::memory_order_relaxed); }
+	// Any thread: see OpenAlDeviceManager::setDecodeOnDemand()
+	void setDecodeOnDemand(bool bEnabled) noexcept { m_bDecodeOnDemand.store(bEnabled, std::memory_order_relaxed); }
+	bool isDecodeOnDemand() const noexcept { return m_bDecodeOnDemand.load(std::memory_order_relaxed); }
+	// Any thread: see OpenAlDeviceManager::setDecodedBufferBudget(), -1 means unlimited
+	void setDecodedBufferBudget(int32_t nMaxBuffers, int64_t nMaxBytes) noexcept
+	{
+		m_nBudgetMaxBuffers.store(nMaxBuffers, std::memory_order_relaxed);
+		m_nBudgetMaxBytes.store(nMaxBytes, std::memory_order_relaxed);
+	}
+	int32_t getDecodedBufferBudgetBuffers() const noexcept { return m_nBudgetMaxBuffers.load(std::memory_order_relaxed); }
+	int64_t getDecodedBufferBudgetBytes() const noexcept { return m_nBudgetMaxBytes.load(std::memory_order_relaxed); }
+	// Any thread: see OpenAlDeviceManager::setStreamingThreshold(), -1 means never stream
+	void setStreamingThreshold(int32_t nMinEncodedBytes) noexcept { m_nStreamingThreshold.store(nMinEncodedBytes, std::memory_order_relaxed); }
+	int32_t getStreamingThreshold() const noexcept { return m_nStreamingThreshold.load(std::memory_order_relaxed); }
+	// Any thread: see OpenAlDeviceManager::setPcmDiskCacheDirectory(), empty if disabled
+	void setPcmDiskCacheDirectory(const std::string& sDirectory) noexcept;
+	std::string getPcmDiskCacheDirectory() const noexcept;
+	// Any thread: see OpenAlDeviceManager::setThreadSafePlayback()
+	void setThreadSafePlayback(bool bEnabled) noexcept { m_bThreadSafePlayback.store(bEnabled, std::memory_order_relaxed); }
+	bool isThreadSafePlayback() const noexcept { return m_bThreadSafePlayback.load(std::memory_order_relaxed); }
+	// Any thread: whether the calling thread is the one that constructed the backend
+	bool isMainThread() const noexcept { return (std::this_thread::get_id() == m_oMainThreadId); }
+	// Main thread: see OpenAlDeviceManager::setRealTimeListener()
+	// When it returns the old listener is no longer called, but a call already started might not have returned.
+	// Returns false (and does nothing) if not null and the thread safe mode is not enabled.
+	bool setRealTimeListener(const shared_ptr<SndRealTimeListener>& refListener) noexcept;
+protected:
+	explicit Backend(::stmi::OpenAlDeviceManager* p0Owner) noexcept;
+
+	// Backend thread: queue an event for the main thread.
+	// The real-time listener is called first for finished sounds.
+	void sendEvent(AlEvent&& oAlEvent) noexcept;
+	// Backend thread: queue an AL_EVENT_PRELOADED event if the preload command is part of a batch.
+	void sendPreloadedEvent(const AlCommand& oAlCommand, bool bLoaded) noexcept;
+	// Main thread: to be called by start() of subclasses with a backend thread.
+	// Attaches the event loop adapter (if not null) to the event file descriptor.
+	// Returns empty if ok error otherwise.
+	std::string attachEventLoop() noexcept;
+	// Main thread: to be called by the destructor of subclasses that called attachEventLoop().
+	void detachEventLoop() noexcept;
+	// Main thread: only to be called from within start().
+	void addInitialDevice(std::string&& sName, int32_t nBackendDeviceId, bool bIsDefault) noexcept;
+
+	// Any thread: the steady clock used for latency measurements.
+	virtual int64_t getSteadyTimeUsec() const noexcept;
+	// Backend thread: records queue wait and execution time of a command if it was stamped.
+	// The times are from getSteadyTimeUsec().
+	void recordCommandLatency(const AlCommand& oAlCommand, int64_t nExecStartUsec, int64_t nExecEndUsec) noexcept;
+	// Backend thread: records the time it took to decode a sound (nDecodeStartUsec is -1 if latency stats
+	// were disabled when decoding started).
+	void recordDecodeLatency(int64_t nDecodeStartUsec, int64_t nDecodeEndUsec) noexcept;
+	// Any thread
+	bool isLatencyEnabled() const noexcept { return m_oLatencyRecorder.isEnabled(); }
+
+	/** Adds a span to a trace ring on destruction if tracing is enabled.
+	 * The time is from getSteadyTimeUsec().
+	 */
+	class TraceSpan
+	{
+	public:
+		// p0Name must be a string literal
+		TraceSpan(const Backend& oBackend, TraceRecorder::Ring& oRing, const char* p0Name) noexcept
+		: m_oBackend(oBackend)
+		, m_oRing(oRing)
+		, m_p0Name(p0Name)
+		, m_nBeginUsec(oBackend.m_oTraceRecorder.isEnabled() ? oBackend.getSteadyTimeUsec() : -1)
+		{
+		}
+		~TraceSpan() noexcept
+		{
+			if (m_nBeginUsec >= 0) {
+				m_oRing.addSpan(m_p0Name, m_nBeginUsec, m_oBackend.getSteadyTimeUsec());
+			}
+		}
+	private:
+		const Backend& m_oBackend;
+		TraceRecorder::Ring& m_oRing;
+		const char* m_p0Name;
+		const int64_t m_nBeginUsec;
+	private:
+		TraceSpan() = delete;
+		TraceSpan(const TraceSpan& oSource) = delete;
+		TraceSpan& operator=(const TraceSpan& oSource) = delete;
+	};
+	// The span name of the command execution (ex. "openalPlay")
+	static const char* getCommandTraceName(AL_COMMAND_TYPE eType) noexcept;
+	// Whether the sound of a play command isn't at the listener's position
+	static bool isPositional(const AlCommand& oCommand) noexcept;
+
+	// The state of a sound group of a device
+	struct SoundGroup
+	{
+		double m_fVolume = 1.0; // Clamped
+		bool m_bPaused = false;
+	};
+	// Returns the group, creating it if necessary. nGroupId must not be negative.
+	static SoundGroup& getSoundGroup(std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept;
+	// Returns the volume of a group or 1.0 if nGroupId is -1 or the group doesn't exist yet
+	static double getSoundGroupVolume(const std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept;
+	// Returns whether a group is paused, false if nGroupId is -1 or the group doesn't exist yet
+	static bool isSoundGroupPaused(const std::vector<SoundGroup>& aSoundGroups, int32_t nGroupId) noexcept;
+
+	// The motion of a sound extrapolated by the backend
+	struct SoundMotion
+	{
+		bool m_bMoving = false;
+		double m_fVelX = 0.0; // Units per second
+		double m_fVelY = 0.0;
+		double m_fVelZ = 0.0;
+		int64_t m_nLastUsec = 0; // The time the position was last advanced to
+		int64_t m_nArrivalUsec = -1; // The time the target is reached or -1 if the motion doesn't end
+		double m_fTargetX = 0.0;
+		double m_fTargetY = 0.0;
+		double m_fTargetZ = 0.0;
+	};
+	// Starts the motion of an AL_COMMAND_SOUND_MOTION command at time nNowUsec.
+	// The position of the sound must be set to the position of the command.
+	static void startSoundMotion(SoundMotion& oMotion, const AlCommand& oCommand, int64_t nNowUsec) noexcept;
+	// Advances the position to time nNowUsec. Returns false if the sound isn't moving.
+	// The motion stops when the target is reached.
+	static bool advanceSoundMotion(SoundMotion& oMotion, int64_t nNowUsec, double& fX, double& fY, double& fZ) noexcept;
+
+	// The volume ramp of a sound evaluated by the backend
+	struct SoundRamp
+	{
+		bool m_bRamping = false;
+		double m_fFromVolume = 1.0;
+		double m_fToVolume = 1.0; // Clamped
+		int64_t m_nStartUsec = 0;
+		int64_t m_nEndUsec = 0;
+		int32_t m_nCurve = 0; // PlaybackCapability::RAMP_CURVE
+		bool m_bStopAtEnd = false;
+	};
+	// Starts the ramp of an AL_COMMAND_SOUND_RAMP command at time nNowUsec.
+	// fFromVolume is the current volume of the sound.
+	static void startSoundRamp(SoundRamp& oRamp, double fFromVolume, const AlCommand& oCommand, int64_t nNowUsec) noexcept;
+	// Sets fVolume to the volume at time nNowUsec. Returns false if the sound isn't ramping.
+	// When the end is reached the ramp stops and bStop tells whether the sound has to be stopped.
+	static bool advanceSoundRamp(SoundRamp& oRamp, int64_t nNowUsec, double& fVolume, bool& bStop) noexcept;
+
+	struct RawDeviceStats
+	{
+		bool m_bExists;
+		int32_t m_nActiveSources;
+		int32_t m_nUnusedSources;
+		int32_t m_nBuffers;
+		int64_t m_nBufferBytes;
+		int64_t m_nDownmixSavedBytes;
+		int64_t m_nEvictedBuffers;
+	};
+	struct RawStats
+	{
+		std::array<RawDeviceStats, SndStatsCapability::s_nMaxStatsDevices> m_aDevices; // Index: nBackendDeviceId
+		int32_t m_nCommandQueueDepth;
+		int32_t m_nCommandQueueHighWater;
+		std::array<uint64_t, AL_COMMAND_LAST + 1> m_aExecutedCommands; // Index: AL_COMMAND_TYPE
+		int64_t m_nDeviceRecreations;
+		int64_t m_nEncodedBytes;
+	};
+	// Backend thread: moves the queued commands to aReadAlCommands.
+	void takeCommands(std::vector<AlCommand>& aReadAlCommands) noexcept;
+	// Backend thread: whether commands were sent and not taken yet.
+	bool hasCommands() const noexcept { return (m_p0CommandsHead.load() != m_p0CommandsTail); }
+	// Backend thread: waits on m_oAlCommandsNotEmpty until commands are sent, a prepared
+	// sound is triggered, oPred returns true or the timeout expires.
+	// oLock must have m_oAlCommandMutex locked.
+	template <class PRED>
+	void waitForCommands(std::unique_lock<std::mutex>& oLock, std::chrono::microseconds oTimeout, PRED oPred) noexcept
+	{
+		// see notifyIfWaiting()
+		m_bWaitingForCommands.store(true);
+		m_oAlCommandsNotEmpty.wait_for(oLock, oTimeout, [&]{ return hasCommands() || isSomeTriggerPending() || oPred(); });
+		m_bWaitingForCommands.store(false, std::memory_order_relaxed);
+	}
+	// Backend thread: publishes m_oRawStats for getStats()
+	void publishStats() noexcept;
+	// Backend thread: publishes the device clock of a device for getDeviceClockNanosec()
+	// If bAdvancing is true the clock is assumed to advance in real time (like getSteadyTimeUsec())
+	// until the next call, otherwise it is assumed to stay the same.
+	void publishDeviceClock(int32_t nBackendDeviceId, int64_t nClockNanosec, bool bAdvancing) noexcept;
+	// Backend thread: publishes the state of a sound for getSoundState().
+	// fOffsetSec and fLengthSec are -1 if not known.
+	// If bAdvancing is true the offset of a playing sound is assumed to advance in real time
+	// (like getSteadyTimeUsec()) until the next call, otherwise it is assumed to stay the same.
+	void publishSoundState(int32_t nBackendDeviceId, int32_t nSoundId, PlaybackCapability::SOUND_STATE eState
+							, double fOffsetSec, double fLengthSec, bool bLoop, bool bAdvancing) noexcept;
+	// Backend thread: publishes that a sound was removed keeping the last published offset
+	// or, if bFinished is true, setting it to the length.
+	void publishSoundRemoved(int32_t nBackendDeviceId, int32_t nSoundId, bool bFinished) noexcept;
+
+	// Backend thread: batch preloads are deferred so that the commands sent after them
+	// (ex. playing a sound not loaded yet) don't have to wait.
+	// Returns false if the command isn't a batch preload and must be executed now.
+	bool deferPreload(AlCommand& oAlCommand) noexcept;
+	// Backend thread: drops the deferred preloads of a batch of a device (nBatchId -1 means all batches).
+	void cancelDeferredPreloads(int32_t nBackendDeviceId, int32_t nBatchId) noexcept;
+	// Backend thread: moves at most nMaxPreloads deferred preloads to the end of aPreloads,
+	// highest priority first, in the order they were sent within the same priority.
+	void takeDeferredPreloads(int32_t nMaxPreloads, std::vector<AlCommand>& aPreloads) noexcept;
+	// Backend thread
+	bool hasDeferredPreloads() const noexcept { return ! m_aDeferredPreloads.empty(); }
+
+	// Any thread: whether some prepared sound was triggered and not started yet
+	// Sequentially consistent, see notifyIfWaiting()
+	bool isSomeTriggerPending() const noexcept { return (m_nTriggersPending.load() > 0); }
+	// Backend thread: if the slot was triggered releases it, records the latency and returns true.
+	bool takeTrigger(int32_t nTriggerSlot) noexcept;
+	// Backend thread: releases the slot of a removed prepared sound. Does nothing if nTriggerSlot is -1.
+	void releaseTriggerSlot(int32_t nTriggerSlot) noexcept;
+	// The maximum number of deferred preloads executed before the command queue is checked again
+	static constexpr const int32_t s_nDeferredPreloadsPerSlice = 8;
+
+private:
+	struct CommandNode
+	{
+		AlCommand m_oAlCommand;
+		std::atomic<CommandNode*> m_p0Next;
+		// The index in m_refCommandNodePool or -1 if allocated on the heap
+		int32_t m_nPoolIndex;
+		// The next node of the free list (only meaningful while free)
+		std::atomic<int32_t> m_nNextFree;
+	};
+	// Any thread: takes a node from the pool (or allocates one if it is empty) and moves oAlCommand into it
+	CommandNode* newCommandNode(AlCommand&& oAlCommand) noexcept;
+	// Backend thread: gives back a node whose command was taken
+	void recycleCommandNode(CommandNode* p0Node) noexcept;
+	// The free list head packs the index of the first free node (low 32 bits, -1 if empty)
+	// with a tag (high 32 bits) incremented at each change, to avoid the ABA problem
+	static uint64_t packFreeCommandNodes(int32_t nPoolIndex, uint64_t nOldHead) noexcept
+	{
+		return (((nOldHead >> 32) + 1) << 32) | static_cast<uint32_t>(nPoolIndex);
+	}
+	static int32_t getFirstFreeCommandNode(uint64_t nHead) noexcept
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(nHead & 0xFFFFFFFFu));
+	}
+	// Links the nodes p0First to p0Last to the command queue
+	void pushCommands(CommandNode* p0First, CommandNode* p0Last) noexcept;
+	// Any thread: wakes up the backend thread if it is waiting in waitForCommands()
+	void notifyIfWaiting() noexcept;
+	// Backend thread: calls the real-time listener if the event is a finished sound
+	void callRealTimeListener(const AlEvent& oAlEvent) noexcept;
+
+protected:
+	std::mutex m_oAlCommandMutex;
+	std::condition_variable m_oAlCommandsNotEmpty;
+	// Only accessed by the backend thread, published with publishStats()
+	RawStats m_oRawStats;
+
+	TraceRecorder m_oTraceRecorder;
+	// The ring of the main thread
+	TraceRecorder::Ring& m_oMainTraceRing;
+private:
+	::stmi::OpenAlDeviceManager* m_p0Owner;
+
+	std::mutex m_oAlEventMutex;
+	// only accessed under m_oAlEventMutex
+	std::vector<AlEvent> m_aAlEvents;
+	// Used by the main thread to avoid reallocating at each dispatch
+	std::vector<AlEvent> m_aReadAlEvents;
+	// The eventfd counter is non zero while m_aAlEvents isn't empty,
+	// only written and read under m_oAlEventMutex
+	const int32_t m_nEventFD;
+	// Only accessed by the main thread
+	std::unique_ptr<EventLoopAdapter> m_refEventLoopAdapter;
+	bool m_bEventLoopAttached;
+	// Only accessed by the main thread
+	bool m_bDispatchingEvents;
+
+	// The command queue is a linked list of nodes: the senders append nodes
+	// by exchanging m_p0CommandsHead, the backend thread takes the nodes after
+	// m_p0CommandsTail, a node whose command was already taken.
+	std::atomic<CommandNode*> m_p0CommandsHead;
+	// Only accessed by the backend thread
+	CommandNode* m_p0CommandsTail;
+	// Only accessed by the backend thread
+	int32_t m_nCommandQueueHighWater;
+	// The preallocated command nodes. The senders pop free nodes, the backend thread
+	// pushes the taken ones. When empty nodes are allocated (and deleted) on the heap.
+	static constexpr const int32_t s_nCommandNodePoolSize = 512;
+	std::unique_ptr<CommandNode[]> m_refCommandNodePool;
+	std::atomic<uint64_t> m_nFreeCommandNodes;
+	// Whether the backend thread is (about to be) waiting in waitForCommands()
+	std::atomic<bool> m_bWaitingForCommands;
+
+	struct DeviceClock
+	{
+		int32_t m_nBackendDeviceId = -1; // The device the clock belongs to or -1 if none yet
+		int64_t m_nClockNanosec = -1;
+		int64_t m_nPublishedUsec = 0; // The getSteadyTimeUsec() of the publication
+		bool m_bAdvancing = false;
+	};
+	// A removed device no longer publishes its clock: its slot can be reused by the
+	// device ids added later
+	static constexpr const int32_t s_nMaxDeviceClocks = 64;
+	// Written only by the backend thread
+	std::array<SeqLock<DeviceClock>, s_nMaxDeviceClocks> m_aDeviceClocks; // Index: nBackendDeviceId % s_nMaxDeviceClocks
+
+	LatencyRecorder m_oLatencyRecorder;
+
+	SeqLock<RawStats> m_oStatsSeqLock;
+
+	// Zero initialized by SeqLock: not published if m_nState is PlaybackCapability::SOUND_STATE_UNKNOWN
+	struct SoundSnapshot
+	{
+		int32_t m_nSoundId;
+		int32_t m_nBackendDeviceId;
+		int32_t m_nState; // PlaybackCapability::SOUND_STATE
+		bool m_bLoop;
+		bool m_bAdvancing;
+		double m_fOffsetSec;
+		double m_fLengthSec;
+		int64_t m_nPublishedUsec; // The getSteadyTimeUsec() of the publication if advancing
+	};
+	// Whether oSnapshot is the published state of a sound
+	static bool isSnapshotOf(const SoundSnapshot& oSnapshot, int32_t nBackendDeviceId, int32_t nSoundId) noexcept;
+	// Written by the backend thread only
+	std::array<SeqLock<SoundSnapshot>, s_nMaxSoundStates> m_aSoundSnapshots; // Index: nSoundId % s_nMaxSoundStates
+	std::atomic<int32_t> m_nEventsPending;
+	std::array<std::atomic<int32_t>, SndStatsCapability::s_nMaxStatsDevices> m_aStatsDeviceIds; // Index: nBackendDeviceId
+
+	std::string m_sTraceExitFilePath;
+
+	// Only accessed by the backend thread. Sorted by descending priority.
+	std::deque<AlCommand> m_aDeferredPreloads;
+
+	std::atomic<bool> m_bNativeFormatConversion;
+	std::atomic<int32_t> m_nCompressedSampleFormat;
+	std::atomic<bool> m_bDecodeOnDemand;
+	std::atomic<int32_t> m_nBudgetMaxBuffers;
+	std::atomic<int64_t> m_nBudgetMaxBytes;
+	std::atomic<int32_t> m_nStreamingThreshold;
+	std::atomic<bool> m_bThreadSafePlayback;
+	const std::thread::id m_oMainThreadId;
+
+	enum TRIGGER_SLOT_STATE
+	{
+		TRIGGER_SLOT_FREE = 0
+		, TRIGGER_SLOT_PREPARED = 1 // Only reserveTriggerSlot() sets it (from free)
+		, TRIGGER_SLOT_TRIGGERED = 2
+		, TRIGGER_SLOT_CANCELLED = 3 // The prepared sound was stopped, not released yet
+	};
+	static constexpr const int32_t s_nTriggerSlotStateBits = 2;
+	static constexpr const int64_t s_nTriggerSlotStateMask = (int64_t{1} << s_nTriggerSlotStateBits) - 1;
+	// The value of a trigger slot: the owning sound id in the high bits, the state in the low ones.
+	// Since sound ids are not reused a stale sound id can't trigger the sound that reuses the slot.
+	static int64_t getTriggerSlotValue(int32_t nSoundId, TRIGGER_SLOT_STATE eState) noexcept
+	{
+		return (static_cast<int64_t>(nSoundId) << s_nTriggerSlotStateBits) | eState;
+	}
+	static TRIGGER_SLOT_STATE getTriggerSlotState(int64_t nValue) noexcept
+	{
+		return static_cast<TRIGGER_SLOT_STATE>(nValue & s_nTriggerSlotStateMask);
+	}
+	std::array<std::atomic<int64_t>, s_nMaxTriggerSlots> m_aTriggerSlots; // Value: see getTriggerSlotValue()
+	std::array<std::atomic<int64_t>, s_nMaxTriggerSlots> m_aTriggerUsecs; // Value: getSteadyTimeUsec() of trigger() or -1
+	std::atomic<int32_t> m_nTriggersPending;
+	mutable std::mutex m_oPcmDiskCacheMutex;
+	// only accessed under m_oPcmDiskCacheMutex
+	std::string m_sPcmDiskCacheDirectory;
+	// Whether m_refRealTimeListener is not null, avoids locking for each event
+	std::atomic<bool> m_bHasRealTimeListener;
+	// Only held to copy or set the listener, never while calling it
+	std::mutex m_oRealTimeListenerMutex;
+	// only accessed under m_oRealTimeListenerMutex
+	shared_ptr<SndRealTimeListener> m_refRealTimeListener;
+private:
+	Backend() = delete;
+	Backend(const Backend& oSource) = delete;
+	Backend& operator=(const Backend& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_BACKEND_BASE_H */
@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   bufferbudget.cc
+ */
+
+#include "bufferbudget.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+BufferBudget::BufferBudget() noexcept
+: m_nTotBytes(0)
+, m_nUseCounter(0)
+, m_nMaxBuffers(-1)
+, m_nMaxBytes(-1)
+{
+}
+void BufferBudget::setLimits(int32_t nMaxBuffers, int64_t nMaxBytes) noexcept
+{
+	m_nMaxBuffers = nMaxBuffers;
+	m_nMaxBytes = nMaxBytes;
+}
+std::vector<BufferBudget::Entry>::iterator BufferBudget::find(uint32_t nBufferId) noexcept
+{
+	return std::find_if(m_aEntries.begin(), m_aEntries.end(), [&](const Entry& oEntry)
+	{
+		return (oEntry.m_nBufferId == nBufferId);
+	});
+}
+void BufferBudget::add(uint32_t nBufferId, int64_t nBytes) noexcept
+{
+	assert(nBytes >= 0);
+	assert(find(nBufferId) == m_aEntries.end());
+	++m_nUseCounter;
+	m_aEntries.push_back(Entry{nBufferId, nBytes, m_nUseCounter});
+	m_nTotBytes += nBytes;
+}
+void BufferBudget::touch(uint32_t nBufferId) noexcept
+{
+	auto itFind = find(nBufferId);
+	if (itFind == m_aEntries.end()) {
+		return; //--------------------------------------------------------------
+	}
+	++m_nUseCounter;
+	itFind->m_nLastUse = m_nUseCounter;
+}
+void BufferBudget::remove(uint32_t nBufferId) noexcept
+{
+	auto itFind = find(nBufferId);
+	if (itFind == m_aEntries.end()) {
+		return; //--------------------------------------------------------------
+	}
+	m_nTotBytes -= itFind->m_nBytes;
+	// order is given by m_nLastUse
+	*itFind = m_aEntries.back();
+	m_aEntries.pop_back();
+}
+void BufferBudget::clear() noexcept
+{
+	m_aEntries.clear();
+	m_nTotBytes = 0;
+}
+bool BufferBudget::isOverLimits() const noexcept
+{
+	if ((m_nMaxBuffers >= 0) && (static_cast<int32_t>(m_aEntries.size()) > m_nMaxBuffers)) {
+		return true; //---------------------------------------------------------
+	}
+	return (m_nMaxBytes >= 0) && (m_nTotBytes > m_nMaxBytes);
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
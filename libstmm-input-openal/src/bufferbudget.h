@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   bufferbudget.h
+ */
+
+#ifndef STMI_OPENAL_BUFFER_BUDGET_H
+#define STMI_OPENAL_BUFFER_BUDGET_H
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Keeps track of the decoded buffers of a device in least recently used order.
+ * Tells which buffer should be deleted when there are more buffers or bytes
+ * than the limits allow.
+ */
+class BufferBudget
+{
+public:
+	BufferBudget() noexcept;
+	/** Sets the limits.
+	 * @param nMaxBuffers The maximum number of buffers or -1 if unlimited.
+	 * @param nMaxBytes The maximum total size of the buffers or -1 if unlimited.
+	 */
+	void setLimits(int32_t nMaxBuffers, int64_t nMaxBytes) noexcept;
+	/** Adds a buffer as the most recently used.
+	 * @param nBufferId The buffer id. Must not already have been added.
+	 * @param nBytes The size of the buffer. Cannot be negative.
+	 */
+	void add(uint32_t nBufferId, int64_t nBytes) noexcept;
+	/** Makes a buffer the most recently used.
+	 * @param nBufferId The buffer id. If not added, nothing happens.
+	 */
+	void touch(uint32_t nBufferId) noexcept;
+	/** Removes a buffer.
+	 * @param nBufferId The buffer id. If not added, nothing happens.
+	 */
+	void remove(uint32_t nBufferId) noexcept;
+	/** Removes all buffers.
+	 */
+	void clear() noexcept;
+	/** The least recently used buffer that should be deleted.
+	 * @param oIsInUse Called with a buffer id, returns whether the buffer cannot be deleted
+	 *                 because a sound is playing it.
+	 * @return The buffer id or 0 if within the limits or all candidates are in use.
+	 */
+	template<typename IsInUse>
+	uint32_t getEvictable(IsInUse oIsInUse) const noexcept
+	{
+		if (! isOverLimits()) {
+			return 0; //--------------------------------------------------------
+		}
+		const Entry* p0Oldest = nullptr;
+		for (const Entry& oEntry : m_aEntries) {
+			if (((p0Oldest == nullptr) || (oEntry.m_nLastUse < p0Oldest->m_nLastUse)) && ! oIsInUse(oEntry.m_nBufferId)) {
+				p0Oldest = &oEntry;
+			}
+		}
+		return ((p0Oldest == nullptr) ? 0 : p0Oldest->m_nBufferId);
+	}
+	/** Whether there are more buffers or bytes than allowed.
+	 * @return Whether over the limits.
+	 */
+	bool isOverLimits() const noexcept;
+	int32_t getTotBuffers() const noexcept { return static_cast<int32_t>(m_aEntries.size()); }
+	int64_t getTotBytes() const noexcept { return m_nTotBytes; }
+private:
+	struct Entry
+	{
+		uint32_t m_nBufferId;
+		int64_t m_nBytes;
+		uint64_t m_nLastUse;
+	};
+	std::vector<Entry>::iterator find(uint32_t nBufferId) noexcept;
+private:
+	std::vector<Entry> m_aEntries;
+	int64_t m_nTotBytes;
+	uint64_t m_nUseCounter;
+	int32_t m_nMaxBuffers;
+	int64_t m_nMaxBytes;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_BUFFER_BUDGET_H */
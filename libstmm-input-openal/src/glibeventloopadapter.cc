@@ -0,0 +1,48 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   glibeventloopadapter.cc
+ */
+
+#include "glibeventloopadapter.h"
+
+#include <glibmm.h>
+
+#include <cassert>
+#include <utility>
+
+namespace stmi
+{
+
+void GlibEventLoopAdapter::attach(int32_t nFD, std::function<void()>&& oDispatch) noexcept
+{
+	assert(nFD >= 0);
+	assert(oDispatch);
+	m_oDispatch = std::move(oDispatch);
+	m_oIOConn = Glib::signal_io().connect([this](Glib::IOCondition /*eCondition*/) -> bool
+	{
+		m_oDispatch();
+		return true;
+	}, nFD, Glib::IO_IN);
+}
+void GlibEventLoopAdapter::detach() noexcept
+{
+	m_oIOConn.disconnect();
+	m_oDispatch = nullptr;
+}
+
+} // namespace stmi
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   latencyrecorder.cc
+ */
+
+#include "latencyrecorder.h"
+
+#include <cassert>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+LatencyRecorder::AtomicHistogram::AtomicHistogram() noexcept
+{
+	reset();
+}
+void LatencyRecorder::AtomicHistogram::add(int64_t nUsec) noexcept
+{
+	if (nUsec < 0) {
+		// clock granularity
+		nUsec = 0;
+	}
+	// bucket n > 0 is [2^(n-1), 2^n)
+	int32_t nBucket = 0;
+	int64_t nRest = nUsec;
+	while ((nRest > 0) && (nBucket < OpenAlDeviceManager::LatencyHistogram::s_nTotBuckets - 1)) {
+		nRest >>= 1;
+		++nBucket;
+	}
+	m_aBucketCounts[nBucket].fetch_add(1, std::memory_order_relaxed);
+	m_nTotCount.fetch_add(1, std::memory_order_relaxed);
+	m_nTotUsec.fetch_add(nUsec, std::memory_order_relaxed);
+	int64_t nMaxUsec = m_nMaxUsec.load(std::memory_order_relaxed);
+	while ((nUsec > nMaxUsec) && ! m_nMaxUsec.compare_exchange_weak(nMaxUsec, nUsec, std::memory_order_relaxed)) {
+	}
+}
+void LatencyRecorder::AtomicHistogram::get(OpenAlDeviceManager::LatencyHistogram& oHistogram) const noexcept
+{
+	const int32_t nTotBuckets = OpenAlDeviceManager::LatencyHistogram::s_nTotBuckets;
+	for (int32_t nBucket = 0; nBucket < nTotBuckets; ++nBucket) {
+		oHistogram.m_aBucketCounts[nBucket] = m_aBucketCounts[nBucket].load(std::memory_order_relaxed);
+	}
+	oHistogram.m_nTotCount = m_nTotCount.load(std::memory_order_relaxed);
+	oHistogram.m_nTotUsec = m_nTotUsec.load(std::memory_order_relaxed);
+	oHistogram.m_nMaxUsec = m_nMaxUsec.load(std::memory_order_relaxed);
+}
+void LatencyRecorder::AtomicHistogram::reset() noexcept
+{
+	for (auto& nCount : m_aBucketCounts) {
+		nCount.store(0, std::memory_order_relaxed);
+	}
+	m_nTotCount.store(0, std::memory_order_relaxed);
+	m_nTotUsec.store(0, std::memory_order_relaxed);
+	m_nMaxUsec.store(0, std::memory_order_relaxed);
+}
+
+LatencyRecorder::LatencyRecorder() noexcept
+: m_bEnabled(false)
+{
+}
+void LatencyRecorder::addQueueWait(int32_t nCommandType, int64_t nUsec) noexcept
+{
+	assert((nCommandType >= 0) && (nCommandType < s_nTotCommandTypes));
+	m_aQueueWait[nCommandType].add(nUsec);
+}
+void LatencyRecorder::addExecution(int32_t nCommandType, int64_t nUsec) noexcept
+{
+	assert((nCommandType >= 0) && (nCommandType < s_nTotCommandTypes));
+	m_aExecution[nCommandType].add(nUsec);
+}
+void LatencyRecorder::addFinishedDelivery(int64_t nUsec) noexcept
+{
+	m_oFinishedDelivery.add(nUsec);
+}
+void LatencyRecorder::addDecode(int64_t nUsec) noexcept
+{
+	m_oDecode.add(nUsec);
+}
+void LatencyRecorder::addTrigger(int64_t nUsec) noexcept
+{
+	m_oTrigger.add(nUsec);
+}
+OpenAlDeviceManager::LatencyStats LatencyRecorder::getStats() const noexcept
+{
+	OpenAlDeviceManager::LatencyStats oStats;
+	for (int32_t nType = 0; nType < s_nTotCommandTypes; ++nType) {
+		m_aQueueWait[nType].get(oStats.m_aQueueWait[nType]);
+		m_aExecution[nType].get(oStats.m_aExecution[nType]);
+	}
+	m_oFinishedDelivery.get(oStats.m_oFinishedDelivery);
+	m_oDecode.get(oStats.m_oDecode);
+	m_oTrigger.get(oStats.m_oTrigger);
+	return oStats;
+}
+void LatencyRecorder::reset() noexcept
+{
+	for (int32_t nType = 0; nType < s_nTotCommandTypes; ++nType) {
+		m_aQueueWait[nType].reset();
+		m_aExecution[nType].reset();
+	}
+	m_oFinishedDelivery.reset();
+	m_oDecode.reset();
+	m_oTrigger.reset();
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
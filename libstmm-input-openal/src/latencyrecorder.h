@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   latencyrecorder.h
+ */
+
+#ifndef STMI_OPENAL_LATENCY_RECORDER_H
+#define STMI_OPENAL_LATENCY_RECORDER_H
+
+#include "openaldevicemanager.h"
+
+#include <array>
+#include <atomic>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Collects latency histograms.
+ * All the functions can be called from any thread: the counters are
+ * atomics updated with relaxed ordering, so a snapshot might not be
+ * perfectly consistent (the counts of a histogram might not add up to the total).
+ */
+class LatencyRecorder
+{
+public:
+	LatencyRecorder() noexcept;
+
+	void setEnabled(bool bEnabled) noexcept { m_bEnabled.store(bEnabled, std::memory_order_relaxed); }
+	bool isEnabled() const noexcept { return m_bEnabled.load(std::memory_order_relaxed); }
+
+	void addQueueWait(int32_t nCommandType, int64_t nUsec) noexcept;
+	void addExecution(int32_t nCommandType, int64_t nUsec) noexcept;
+	void addFinishedDelivery(int64_t nUsec) noexcept;
+	void addDecode(int64_t nUsec) noexcept;
+	void addTrigger(int64_t nUsec) noexcept;
+
+	OpenAlDeviceManager::LatencyStats getStats() const noexcept;
+	void reset() noexcept;
+private:
+	class AtomicHistogram
+	{
+	public:
+		AtomicHistogram() noexcept;
+		void add(int64_t nUsec) noexcept;
+		void get(OpenAlDeviceManager::LatencyHistogram& oHistogram) const noexcept;
+		void reset() noexcept;
+	private:
+		std::array<std::atomic<uint64_t>, OpenAlDeviceManager::LatencyHistogram::s_nTotBuckets> m_aBucketCounts;
+		std::atomic<uint64_t> m_nTotCount;
+		std::atomic<int64_t> m_nTotUsec;
+		std::atomic<int64_t> m_nMaxUsec;
+	};
+	static constexpr int32_t s_nTotCommandTypes = OpenAlDeviceManager::COMMAND_TYPE_LAST + 1;
+private:
+	std::atomic<bool> m_bEnabled;
+	std::array<AtomicHistogram, s_nTotCommandTypes> m_aQueueWait;
+	std::array<AtomicHistogram, s_nTotCommandTypes> m_aExecution;
+	AtomicHistogram m_oFinishedDelivery;
+	AtomicHistogram m_oDecode;
+	AtomicHistogram m_oTrigger;
+private:
+	LatencyRecorder(const LatencyRecorder& oSource) = delete;
+	LatencyRecorder& operator=(const LatencyRecorder& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_LATENCY_RECORDER_H */
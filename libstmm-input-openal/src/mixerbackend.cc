@@ -0,0 +1,666 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixerbackend.cc
+ */
+
+#include "mixerbackend.h"
+
+#include "pcmconverter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+static const char* const s_p0MixerDeviceName = "Mixer";
+static constexpr const int32_t s_nMixerDeviceId = 0;
+static constexpr const int32_t s_nMixerChannels = 2;
+
+static constexpr const double s_fQuarterPi = 0.78539816339744830962;
+
+namespace
+{
+double clampVolume(double fVolume) noexcept
+{
+	if (fVolume < 0.0) {
+		return 0.0;
+	} else if (fVolume > 1.0) {
+		return 1.0;
+	}
+	return fVolume;
+}
+} // unnamed namespace
+
+unique_ptr<MixerBackend> MixerBackend::create(::stmi::OpenAlDeviceManager* p0Owner
+											, const ::stmi::OpenAlDeviceManager::MixerInit& oMixerInit
+											, unique_ptr<MixerSink> refSink) noexcept
+{
+	return std::unique_ptr<MixerBackend>(new MixerBackend(p0Owner, oMixerInit, std::move(refSink), MixerKernel::get()));
+}
+
+MixerBackend::MixerBackend(::stmi::OpenAlDeviceManager* p0Owner, const ::stmi::OpenAlDeviceManager::MixerInit& oMixerInit
+							, unique_ptr<MixerSink> refSink, const MixerKernel& oKernel) noexcept
+: Backend(p0Owner)
+, m_oMixerInit(oMixerInit)
+, m_refSink(std::move(refSink))
+, m_oKernel(oKernel)
+, m_oMixerTraceRing(m_oTraceRecorder.addThread(oMixerInit.m_bOffline ? "offline" : "mixer"))
+, m_bIsRunning(true)
+, m_nLoadedBytes(0)
+, m_nDownmixSavedBytes(0)
+, m_nRenderedFrames(0)
+, m_bDevicePaused(false)
+, m_fListenerPosX(0.0)
+, m_fListenerPosY(0.0)
+, m_fListenerPosZ(0.0)
+, m_fListenerVolume(1.0)
+{
+	assert(m_refSink);
+	assert(m_oMixerInit.m_nFrequency > 0);
+	assert(m_oMixerInit.m_nPeriodFrames > 0);
+	// sounds are always decoded and resampled to the mixer rate
+	setNativeFormatConversion(true);
+}
+MixerBackend::~MixerBackend() noexcept
+{
+	detachEventLoop();
+	if (m_oMixerThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> oLock(m_oAlCommandMutex);
+			m_bIsRunning = false;
+		}
+		m_oAlCommandsNotEmpty.notify_all();
+		m_oMixerThread.join();
+	}
+}
+std::string MixerBackend::start() noexcept
+{
+	const std::string sErr = m_refSink->open(m_oMixerInit.m_nFrequency, s_nMixerChannels);
+	if (! sErr.empty()) {
+		return sErr; //---------------------------------------------------------
+	}
+	m_aMix.resize(m_oMixerInit.m_nPeriodFrames * s_nMixerChannels);
+	m_aOut.resize(m_oMixerInit.m_nPeriodFrames * s_nMixerChannels);
+	m_aFinished.reserve(s_nReservedFinishedVoices);
+	m_aFadedOut.reserve(s_nReservedFinishedVoices);
+	addInitialDevice(std::string{s_p0MixerDeviceName}, s_nMixerDeviceId, true);
+	publishDeviceClock(s_nMixerDeviceId, 0, false);
+	if (m_oMixerInit.m_bOffline) {
+		return ""; //-----------------------------------------------------------
+	}
+	m_oMixerThread = std::thread([&]()
+	{
+		mixerThreadRun();
+	});
+	return attachEventLoop();
+}
+void MixerBackend::mixerThreadRun() noexcept
+{
+	const int32_t nPeriodFrames = m_oMixerInit.m_nPeriodFrames;
+	const auto oPeriod = std::chrono::microseconds(int64_t{1000000} * nPeriodFrames / m_oMixerInit.m_nFrequency);
+	auto oNextPeriod = std::chrono::steady_clock::now();
+	while (m_bIsRunning) {
+		mixerExecCommands();
+		const bool bBlocking = m_refSink->isBlocking();
+		// Rendering silence to a non blocking sink would just burn the cpu
+		const bool bRender = bBlocking || isSomeVoiceProgressing();
+		if (bRender) {
+			mixerRender(nPeriodFrames);
+		}
+		mixerPublishStats();
+		// the clock only advances while rendering
+		publishDeviceClock(s_nMixerDeviceId, getRenderedNanosec(), bRender);
+		mixerPublishVoiceStates(bRender);
+		if (bBlocking) {
+			// the sink paces the thread
+			continue;
+		}
+		std::unique_lock<std::mutex> oLock(m_oAlCommandMutex);
+		if (bRender) {
+			// real time pacing, commands are executed at the next period
+			oNextPeriod += oPeriod;
+			const auto oNow = std::chrono::steady_clock::now();
+			if (oNow - oNextPeriod > oPeriod) {
+				// More than a period behind (the thread was descheduled): resync
+				// rather than rendering a burst of periods without waiting
+				oNextPeriod = oNow;
+			}
+			m_oAlCommandsNotEmpty.wait_until(oLock, oNextPeriod, [&]{ return ! m_bIsRunning; });
+		} else {
+			waitForCommands(oLock, oPeriod, [&]{ return ! m_bIsRunning; });
+			oNextPeriod = std::chrono::steady_clock::now();
+		}
+	}
+}
+int32_t MixerBackend::renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept
+{
+	if (! m_oMixerInit.m_bOffline) {
+		return -1; //-----------------------------------------------------------
+	}
+	assert(nMillisec >= 0);
+	if (isDispatchingEvents()) {
+		// called by a listener: the chunk being dispatched isn't finished
+		return 0; //------------------------------------------------------------
+	}
+	const int64_t nFrequency = m_oMixerInit.m_nFrequency;
+	const int64_t nTotFrames = nMillisec * nFrequency / 1000;
+	int64_t nRenderedFrames = 0;
+	mixerExecCommands();
+	while (nRenderedFrames < nTotFrames) {
+		if (bStopWhenIdle && ! isSomeVoiceProgressing()) {
+			break;
+		}
+		const int32_t nFrames = static_cast<int32_t>(std::min<int64_t>(m_oMixerInit.m_nPeriodFrames, nTotFrames - nRenderedFrames));
+		mixerRender(nFrames);
+		nRenderedFrames += nFrames;
+		mixerPublishStats();
+		publishDeviceClock(s_nMixerDeviceId, getRenderedNanosec(), false);
+		mixerPublishVoiceStates(false);
+		// the listeners of the finished events might play new sounds
+		dispatchEvents();
+		mixerExecCommands();
+	}
+	return static_cast<int32_t>(nRenderedFrames * 1000 / nFrequency);
+}
+void MixerBackend::mixerExecCommands() noexcept
+{
+	takeCommands(m_aReadAlCommands);
+	for (auto& oCommand : m_aReadAlCommands) {
+		if (deferPreload(oCommand)) {
+			continue;
+		}
+		mixerExecRecordedCommand(oCommand);
+	}
+	m_aReadAlCommands.clear();
+	// a slice each period, the others in the next periods
+	// offline there's no hurry: the timeline is the same as if preloads weren't deferred
+	const int32_t nMaxPreloads = (m_oMixerInit.m_bOffline ? std::numeric_limits<int32_t>::max() : s_nDeferredPreloadsPerSlice);
+	takeDeferredPreloads(nMaxPreloads, m_aReadAlCommands);
+	for (auto& oCommand : m_aReadAlCommands) {
+		mixerExecRecordedCommand(oCommand);
+	}
+	m_aReadAlCommands.clear();
+	// after the commands, that might have prepared the triggered voices
+	if (isSomeTriggerPending()) {
+		mixerStartTriggeredVoices();
+	}
+}
+void MixerBackend::mixerExecRecordedCommand(const AlCommand& oCommand) noexcept
+{
+	++m_oRawStats.m_aExecutedCommands[oCommand.m_eType];
+	TraceSpan oSpan(*this, m_oMixerTraceRing, getCommandTraceName(oCommand.m_eType));
+	if (isLatencyEnabled()) {
+		const int64_t nExecStartUsec = getSteadyTimeUsec();
+		mixerExecCommand(oCommand);
+		recordCommandLatency(oCommand, nExecStartUsec, getSteadyTimeUsec());
+	} else {
+		mixerExecCommand(oCommand);
+	}
+}
+void MixerBackend::mixerExecCommand(const AlCommand& oCommand) noexcept
+{
+	assert(oCommand.m_nBackendDeviceId == s_nMixerDeviceId);
+	switch (oCommand.m_eType) {
+	case AL_COMMAND_PRELOAD:
+	{
+		const bool bLoaded = (mixerLoad(oCommand, false) >= 0);
+		sendPreloadedEvent(oCommand, bLoaded);
+	} break;
+	case AL_COMMAND_PLAY:
+	{
+		mixerPlay(oCommand);
+	} break;
+	case AL_COMMAND_PAUSE:
+	{
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			p0Voice->m_bPaused = true;
+		}
+	} break;
+	case AL_COMMAND_RESUME:
+	{
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			p0Voice->m_bPaused = false;
+		}
+	} break;
+	case AL_COMMAND_STOP:
+	{
+		mixerRemoveVoice(oCommand.m_nSoundId);
+	} break;
+	case AL_COMMAND_PAUSE_DEVICE:
+	{
+		m_bDevicePaused = true;
+	} break;
+	case AL_COMMAND_RESUME_DEVICE:
+	{
+		if (m_bDevicePaused) {
+			for (Voice& oVoice : m_aVoices) {
+				oVoice.m_bStartedWhenDevicePaused = false;
+			}
+		}
+		m_bDevicePaused = false;
+	} break;
+	case AL_COMMAND_STOP_ALL:
+	{
+		for (const Voice& oVoice : m_aVoices) {
+			releaseTriggerSlot(oVoice.m_nTriggerSlot);
+			mixerPublishVoiceState(oVoice, true, false);
+		}
+		m_aVoices.clear();
+	} break;
+	case AL_COMMAND_SOUND_POS:
+	{
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			p0Voice->m_bRelative = oCommand.m_bRelative;
+			p0Voice->m_fPosX = oCommand.m_fPosX;
+			p0Voice->m_fPosY = oCommand.m_fPosY;
+			p0Voice->m_fPosZ = oCommand.m_fPosZ;
+			p0Voice->m_oMotion = SoundMotion{};
+		}
+	} break;
+	case AL_COMMAND_SOUND_MOTION:
+	{
+		// no Doppler effect, only the position is extrapolated
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			p0Voice->m_bRelative = oCommand.m_bRelative;
+			p0Voice->m_fPosX = oCommand.m_fPosX;
+			p0Voice->m_fPosY = oCommand.m_fPosY;
+			p0Voice->m_fPosZ = oCommand.m_fPosZ;
+			startSoundMotion(p0Voice->m_oMotion, oCommand, getAdvanceTimeUsec());
+		}
+	} break;
+	case AL_COMMAND_SOUND_VOL:
+	{
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			p0Voice->m_fVolume = oCommand.m_fVolume;
+			p0Voice->m_oRamp = SoundRamp{};
+		}
+	} break;
+	case AL_COMMAND_SOUND_RAMP:
+	{
+		Voice* p0Voice = getVoice(oCommand.m_nSoundId);
+		if (p0Voice != nullptr) {
+			startSoundRamp(p0Voice->m_oRamp, clampVolume(p0Voice->m_fVolume), oCommand, getAdvanceTimeUsec());
+		}
+	} break;
+	case AL_COMMAND_LISTENER_POS:
+	{
+		m_fListenerPosX = oCommand.m_fPosX;
+		m_fListenerPosY = oCommand.m_fPosY;
+		m_fListenerPosZ = oCommand.m_fPosZ;
+	} break;
+	case AL_COMMAND_LISTENER_VOL:
+	{
+		m_fListenerVolume = clampVolume(oCommand.m_fVolume);
+	} break;
+	case AL_COMMAND_CANCEL_PRELOADS:
+	{
+		cancelDeferredPreloads(oCommand.m_nBackendDeviceId, oCommand.m_nBatchId);
+	} break;
+	case AL_COMMAND_GROUP_VOL:
+	{
+		getSoundGroup(m_aSoundGroups, oCommand.m_nGroupId).m_fVolume = clampVolume(oCommand.m_fVolume);
+	} break;
+	case AL_COMMAND_PAUSE_GROUP:
+	{
+		getSoundGroup(m_aSoundGroups, oCommand.m_nGroupId).m_bPaused = true;
+	} break;
+	case AL_COMMAND_RESUME_GROUP:
+	{
+		getSoundGroup(m_aSoundGroups, oCommand.m_nGroupId).m_bPaused = false;
+	} break;
+	case AL_COMMAND_STOP_GROUP:
+	{
+		m_aVoices.erase(std::remove_if(m_aVoices.begin(), m_aVoices.end(), [&](const Voice& oVoice)
+		{
+			if (oVoice.m_nGroupId != oCommand.m_nGroupId) {
+				return false; //------------------------------------------------
+			}
+			releaseTriggerSlot(oVoice.m_nTriggerSlot);
+			mixerPublishVoiceState(oVoice, true, false);
+			return true;
+		}), m_aVoices.end());
+	} break;
+	default:
+	{
+		assert(false);
+	} break;
+	}
+}
+int32_t MixerBackend::mixerLoad(const AlCommand& oCommand, bool bDownmix) noexcept
+{
+	int32_t nStereoIdx = -1;
+	int32_t nDownmixedIdx = -1;
+	const int32_t nTotLoaded = static_cast<int32_t>(m_aLoadedSounds.size());
+	for (int32_t nIdx = 0; nIdx < nTotLoaded; ++nIdx) {
+		const LoadedSound& oLoaded = m_aLoadedSounds[nIdx];
+		if (oLoaded.m_nFileId == oCommand.m_nFileId) {
+			(oLoaded.m_bDownmixed ? nDownmixedIdx : nStereoIdx) = nIdx;
+		}
+	}
+	if (bDownmix) {
+		if (nDownmixedIdx >= 0) {
+			return nDownmixedIdx; //--------------------------------------------
+		}
+		if ((nStereoIdx >= 0) && (m_aLoadedSounds[nStereoIdx].m_oSound.m_nChannels == 1)) {
+			// nothing to down-mix
+			return nStereoIdx; //-----------------------------------------------
+		}
+	} else if (nStereoIdx >= 0) {
+		return nStereoIdx; //---------------------------------------------------
+	}
+	LoadedSound oLoaded;
+	oLoaded.m_nFileId = oCommand.m_nFileId;
+	oLoaded.m_bDownmixed = false;
+	const std::string sErr = ((oCommand.m_p0Buffer == nullptr)
+							? WavDecoder::decodeFile(oCommand.m_sFileName, oLoaded.m_oSound)
+							: WavDecoder::decode(oCommand.m_p0Buffer, oCommand.m_nBufferSize, oLoaded.m_oSound));
+	if (! sErr.empty()) {
+		mixerSendError(sErr, oCommand);
+		return -1; //-----------------------------------------------------------
+	}
+	if (bDownmix && (oLoaded.m_oSound.m_nChannels == 2)) {
+		PcmConverter::downmixToMono(oLoaded.m_oSound);
+		oLoaded.m_bDownmixed = true;
+	}
+	PcmConverter::resample(oLoaded.m_oSound, m_oMixerInit.m_nFrequency);
+	const int64_t nBytes = static_cast<int64_t>(oLoaded.m_oSound.m_aSamples.size() * sizeof(float));
+	m_nLoadedBytes += nBytes;
+	if (oLoaded.m_bDownmixed) {
+		if (nStereoIdx < 0) {
+			// the stereo version would be twice as big
+			m_nDownmixSavedBytes += nBytes;
+		}
+	} else if (nDownmixedIdx >= 0) {
+		// the stereo version is needed too
+		m_nDownmixSavedBytes -= static_cast<int64_t>(m_aLoadedSounds[nDownmixedIdx].m_oSound.m_aSamples.size() * sizeof(float));
+	}
+	m_aLoadedSounds.push_back(std::move(oLoaded));
+	return static_cast<int32_t>(m_aLoadedSounds.size()) - 1;
+}
+void MixerBackend::mixerPlay(const AlCommand& oCommand) noexcept
+{
+	assert(getVoice(oCommand.m_nSoundId) == nullptr);
+	const int32_t nLoadedIdx = mixerLoad(oCommand, oCommand.m_bMonoDownmix && isPositional(oCommand));
+	if (nLoadedIdx < 0) {
+		releaseTriggerSlot(oCommand.m_nTriggerSlot);
+		return; //--------------------------------------------------------------
+	}
+	Voice oVoice;
+	oVoice.m_nSoundId = oCommand.m_nSoundId;
+	oVoice.m_nLoadedIdx = nLoadedIdx;
+	oVoice.m_bLoop = oCommand.m_bLoop;
+	oVoice.m_bStartedWhenDevicePaused = m_bDevicePaused;
+	oVoice.m_bRelative = oCommand.m_bRelative;
+	oVoice.m_fPosX = oCommand.m_fPosX;
+	oVoice.m_fPosY = oCommand.m_fPosY;
+	oVoice.m_fPosZ = oCommand.m_fPosZ;
+	oVoice.m_fVolume = oCommand.m_fVolume;
+	oVoice.m_nGroupId = oCommand.m_nGroupId;
+	oVoice.m_nTriggerSlot = oCommand.m_nTriggerSlot;
+	if (oCommand.m_nStartClockNanosec >= 0) {
+		// the first frame whose time is not before the start, a past start plays immediately
+		const int64_t nStartFrame = static_cast<int64_t>(std::ceil(static_cast<double>(oCommand.m_nStartClockNanosec)
+																	* m_oMixerInit.m_nFrequency / 1000000000.0));
+		oVoice.m_nStartFrame = std::max(m_nRenderedFrames, nStartFrame);
+	}
+	m_aVoices.push_back(std::move(oVoice));
+}
+void MixerBackend::mixerStartTriggeredVoices() noexcept
+{
+	for (Voice& oVoice : m_aVoices) {
+		if ((oVoice.m_nTriggerSlot >= 0) && takeTrigger(oVoice.m_nTriggerSlot)) {
+			oVoice.m_nTriggerSlot = -1;
+		}
+	}
+}
+void MixerBackend::mixerRemoveVoice(int32_t nSoundId) noexcept
+{
+	const auto itFind = std::find_if(m_aVoices.begin(), m_aVoices.end(), [&](const Voice& oVoice)
+	{
+		return (oVoice.m_nSoundId == nSoundId);
+	});
+	if (itFind == m_aVoices.end()) {
+		return; //--------------------------------------------------------------
+	}
+	releaseTriggerSlot(itFind->m_nTriggerSlot);
+	mixerPublishVoiceState(*itFind, true, false);
+	m_aVoices.erase(itFind);
+}
+void MixerBackend::mixerRender(int32_t nFrames) noexcept
+{
+	assert((nFrames > 0) && (nFrames <= m_oMixerInit.m_nPeriodFrames));
+	TraceSpan oSpan(*this, m_oMixerTraceRing, "mixerRender");
+	float* p0Mix = m_aMix.data();
+	std::fill(p0Mix, p0Mix + nFrames * s_nMixerChannels, 0.0f);
+	m_aFinished.clear();
+	mixerAdvanceVoices();
+	for (Voice& oVoice : m_aVoices) {
+		if (! isProgressing(oVoice)) {
+			continue; // for oVoice ----
+		}
+		const PcmSound& oSound = m_aLoadedSounds[oVoice.m_nLoadedIdx].m_oSound;
+		const int32_t nSoundFrames = oSound.getTotFrames();
+		const bool bMono = (oSound.m_nChannels == 1);
+		float fGainL;
+		float fGainR;
+		computeGains(oVoice, bMono, fGainL, fGainR);
+		int32_t nDone = 0;
+		if (oVoice.m_nStartFrame >= 0) {
+			// sample accurate scheduled start
+			const int64_t nStartOffset = oVoice.m_nStartFrame - m_nRenderedFrames;
+			if (nStartOffset >= nFrames) {
+				continue; // for oVoice ----
+			}
+			nDone = static_cast<int32_t>(std::max<int64_t>(0, nStartOffset));
+			oVoice.m_nStartFrame = -1;
+		}
+		while ((nDone < nFrames) && (oVoice.m_nFrame < nSoundFrames)) {
+			const int32_t nTodo = std::min(nFrames - nDone, nSoundFrames - oVoice.m_nFrame);
+			if (bMono) {
+				m_oKernel.m_p0MixMono(oSound.m_aSamples.data() + oVoice.m_nFrame, nTodo, fGainL, fGainR
+									, p0Mix + nDone * s_nMixerChannels);
+			} else {
+				m_oKernel.m_p0MixStereo(oSound.m_aSamples.data() + oVoice.m_nFrame * 2, nTodo, fGainL
+										, p0Mix + nDone * s_nMixerChannels);
+			}
+			oVoice.m_nFrame += nTodo;
+			nDone += nTodo;
+			if (oVoice.m_bLoop && (oVoice.m_nFrame >= nSoundFrames)) {
+				oVoice.m_nFrame = 0;
+			}
+		}
+		if (oVoice.m_nFrame >= nSoundFrames) {
+			// also empty looping sounds finish
+			// kept sorted by the frame the sounds finished at (stable_sort would allocate)
+			const auto itInsert = std::upper_bound(m_aFinished.begin(), m_aFinished.end(), nDone
+												, [](int32_t nFrame, const std::pair<int32_t, int32_t>& oFinished)
+			{
+				return (nFrame < oFinished.first);
+			});
+			m_aFinished.emplace(itInsert, nDone, oVoice.m_nSoundId);
+		}
+	}
+	m_oKernel.m_p0ToInt16(p0Mix, nFrames * s_nMixerChannels, m_aOut.data());
+	m_refSink->write(m_aOut.data(), nFrames);
+	m_nRenderedFrames += nFrames;
+	if (m_aFinished.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	// the finished events are sent in the order the sounds finished
+	for (const auto& oFinished : m_aFinished) {
+		const int32_t nSoundId = oFinished.second;
+		mixerRemoveVoice(nSoundId);
+		AlEvent oAlEvent;
+		oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
+		oAlEvent.m_nBackendDeviceId = s_nMixerDeviceId;
+		oAlEvent.m_nSoundId = nSoundId;
+		sendEvent(std::move(oAlEvent));
+	}
+}
+void MixerBackend::mixerPublishStats() noexcept
+{
+	RawDeviceStats& oRawDeviceStats = m_oRawStats.m_aDevices[s_nMixerDeviceId];
+	oRawDeviceStats.m_bExists = true;
+	oRawDeviceStats.m_nActiveSources = static_cast<int32_t>(m_aVoices.size());
+	oRawDeviceStats.m_nUnusedSources = 0;
+	oRawDeviceStats.m_nBuffers = static_cast<int32_t>(m_aLoadedSounds.size());
+	oRawDeviceStats.m_nBufferBytes = m_nLoadedBytes;
+	oRawDeviceStats.m_nDownmixSavedBytes = m_nDownmixSavedBytes;
+	oRawDeviceStats.m_nEvictedBuffers = 0;
+	publishStats();
+}
+void MixerBackend::mixerPublishVoiceStates(bool bAdvancing) noexcept
+{
+	for (const Voice& oVoice : m_aVoices) {
+		mixerPublishVoiceState(oVoice, false, bAdvancing);
+	}
+}
+void MixerBackend::mixerPublishVoiceState(const Voice& oVoice, bool bRemoved, bool bAdvancing) noexcept
+{
+	PlaybackCapability::SOUND_STATE eState;
+	if (bRemoved) {
+		eState = PlaybackCapability::SOUND_STATE_STOPPED;
+	} else if (oVoice.m_bPaused || (m_bDevicePaused && ! oVoice.m_bStartedWhenDevicePaused)
+				|| isSoundGroupPaused(m_aSoundGroups, oVoice.m_nGroupId)) {
+		eState = PlaybackCapability::SOUND_STATE_PAUSED;
+	} else if ((oVoice.m_nTriggerSlot >= 0) || (oVoice.m_nStartFrame >= 0)) {
+		eState = PlaybackCapability::SOUND_STATE_PENDING;
+	} else {
+		eState = PlaybackCapability::SOUND_STATE_PLAYING;
+	}
+	// the loaded sounds are at the mixer rate
+	const double fFrequency = m_oMixerInit.m_nFrequency;
+	const int32_t nSoundFrames = m_aLoadedSounds[oVoice.m_nLoadedIdx].m_oSound.getTotFrames();
+	publishSoundState(s_nMixerDeviceId, oVoice.m_nSoundId, eState, oVoice.m_nFrame / fFrequency, nSoundFrames / fFrequency
+					, oVoice.m_bLoop, bAdvancing);
+}
+void MixerBackend::mixerSendError(const std::string& sErr, const AlCommand& oCommand) noexcept
+{
+	AlEvent oEv;
+	oEv.m_eType = AL_EVENT_PLAY_ERROR;
+	oEv.m_nBackendDeviceId = oCommand.m_nBackendDeviceId;
+	oEv.m_nSoundId = oCommand.m_nSoundId;
+	oEv.m_nFileId = oCommand.m_nFileId;
+	oEv.m_sError = sErr;
+	sendEvent(std::move(oEv));
+}
+MixerBackend::Voice* MixerBackend::getVoice(int32_t nSoundId) noexcept
+{
+	const auto itFind = std::find_if(m_aVoices.begin(), m_aVoices.end(), [&](const Voice& oVoice)
+	{
+		return (oVoice.m_nSoundId == nSoundId);
+	});
+	if (itFind == m_aVoices.end()) {
+		return nullptr; //------------------------------------------------------
+	}
+	return &(*itFind);
+}
+bool MixerBackend::isProgressing(const Voice& oVoice) const noexcept
+{
+	// A sound started while the device is paused plays anyway (like OpenAlBackend)
+	// A prepared voice waits to be triggered
+	return (oVoice.m_nTriggerSlot < 0) && (! oVoice.m_bPaused) && ((! m_bDevicePaused) || oVoice.m_bStartedWhenDevicePaused)
+			&& ! isSoundGroupPaused(m_aSoundGroups, oVoice.m_nGroupId);
+}
+void MixerBackend::mixerAdvanceVoices() noexcept
+{
+	const int64_t nNowUsec = getAdvanceTimeUsec();
+	m_aFadedOut.clear();
+	for (Voice& oVoice : m_aVoices) {
+		advanceSoundMotion(oVoice.m_oMotion, nNowUsec, oVoice.m_fPosX, oVoice.m_fPosY, oVoice.m_fPosZ);
+		bool bStop;
+		advanceSoundRamp(oVoice.m_oRamp, nNowUsec, oVoice.m_fVolume, bStop);
+		if (bStop) {
+			m_aFadedOut.push_back(oVoice.m_nSoundId);
+		}
+	}
+	for (const int32_t nSoundId : m_aFadedOut) {
+		mixerRemoveVoice(nSoundId);
+		AlEvent oAlEvent;
+		oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
+		oAlEvent.m_nBackendDeviceId = s_nMixerDeviceId;
+		oAlEvent.m_nSoundId = nSoundId;
+		oAlEvent.m_bFadedOut = true;
+		sendEvent(std::move(oAlEvent));
+	}
+}
+int64_t MixerBackend::getAdvanceTimeUsec() const noexcept
+{
+	return m_nRenderedFrames * 1000000 / m_oMixerInit.m_nFrequency;
+}
+int64_t MixerBackend::getRenderedNanosec() const noexcept
+{
+	// split to avoid overflowing
+	const int64_t nFrequency = m_oMixerInit.m_nFrequency;
+	return (m_nRenderedFrames / nFrequency) * 1000000000 + (m_nRenderedFrames % nFrequency) * 1000000000 / nFrequency;
+}
+bool MixerBackend::isSomeVoiceProgressing() const noexcept
+{
+	return std::any_of(m_aVoices.begin(), m_aVoices.end(), [&](const Voice& oVoice)
+	{
+		return isProgressing(oVoice);
+	});
+}
+void MixerBackend::computeGains(const Voice& oVoice, bool bMono, float& fGainL, float& fGainR) const noexcept
+{
+	const double fVolume = clampVolume(oVoice.m_fVolume) * getSoundGroupVolume(m_aSoundGroups, oVoice.m_nGroupId)
+							* m_fListenerVolume;
+	if (! bMono) {
+		fGainL = static_cast<float>(fVolume);
+		fGainR = fGainL;
+		return; //--------------------------------------------------------------
+	}
+	double fX = oVoice.m_fPosX;
+	double fY = oVoice.m_fPosY;
+	double fZ = oVoice.m_fPosZ;
+	if (! oVoice.m_bRelative) {
+		fX -= m_fListenerPosX;
+		fY -= m_fListenerPosY;
+		fZ -= m_fListenerPosZ;
+	}
+	const double fDistance = std::sqrt(fX * fX + fY * fY + fZ * fZ);
+	// OpenAL's default AL_INVERSE_DISTANCE_CLAMPED with reference distance and rolloff 1
+	const double fDistanceGain = 1.0 / std::max(1.0, fDistance);
+	// the right of the listener is (1,0,0): -1 is full left, 1 full right
+	const double fPan = ((fDistance > 0.0) ? fX / fDistance : 0.0);
+	// equal power panning
+	const double fAngle = (fPan + 1.0) * s_fQuarterPi;
+	fGainL = static_cast<float>(fVolume * fDistanceGain * std::cos(fAngle));
+	fGainR = static_cast<float>(fVolume * fDistanceGain * std::sin(fAngle));
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
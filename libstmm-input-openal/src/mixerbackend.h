@@ -0,0 +1,194 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixerbackend.h
+ */
+
+#ifndef STMI_OPENAL_MIXER_BACKEND_H
+#define STMI_OPENAL_MIXER_BACKEND_H
+
+#include "backend.h"
+#include "mixerkernel.h"
+#include "wavdecoder.h"
+#include "openaldevicemanager.h"
+#include "mixersink.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+class OpenAlDeviceManager;
+
+namespace Private
+{
+namespace OpenAl
+{
+
+using std::unique_ptr;
+
+////////////////////////////////////////////////////////////////////////////////
+/** Software mixer backend not needing OpenAL.
+ * Has a single stereo playback device "Mixer" whose output goes to a MixerSink.
+ * Only PCM WAV files and buffers are supported. They are decoded and resampled
+ * to the mixer rate at load time.
+ *
+ * Spatial sounds follow the conventions of PlaybackCapability and mimic OpenAL's
+ * default inverse distance clamped model (reference distance 1, rolloff 1):
+ * the gain is 1 / max(1, distance). Mono sounds are panned with an equal power
+ * law according to the x component of the direction from the listener.
+ * Like OpenAL, stereo sounds are not spatialized.
+ *
+ * In offline mode there is no mixer thread: the output is only rendered by renderOffline().
+ */
+class MixerBackend : public Backend
+{
+public:
+	static unique_ptr<MixerBackend> create(::stmi::OpenAlDeviceManager* p0Owner
+											, const ::stmi::OpenAlDeviceManager::MixerInit& oMixerInit
+											, unique_ptr<MixerSink> refSink) noexcept;
+
+	// Opens the sink and (if not offline) creates the mixer thread
+	std::string start() noexcept override;
+
+	int32_t renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept override;
+
+	~MixerBackend() noexcept;
+
+	// The kernel used (the best for the cpu)
+	const MixerKernel& getKernel() const noexcept { return m_oKernel; }
+protected:
+	MixerBackend(::stmi::OpenAlDeviceManager* p0Owner, const ::stmi::OpenAlDeviceManager::MixerInit& oMixerInit
+				, unique_ptr<MixerSink> refSink, const MixerKernel& oKernel) noexcept;
+private:
+	struct LoadedSound
+	{
+		int32_t m_nFileId;
+		bool m_bDownmixed; // Whether it's the mono down-mix of a stereo sound
+		PcmSound m_oSound;
+	};
+	struct Voice
+	{
+		int32_t m_nSoundId;
+		int32_t m_nLoadedIdx; // Index into m_aLoadedSounds
+		int32_t m_nFrame = 0; // Next frame to be mixed
+		int64_t m_nStartFrame = -1; // The rendered frame a scheduled voice starts at or -1 if started
+		int32_t m_nTriggerSlot = -1; // The trigger slot of a prepared voice or -1 if started
+		bool m_bLoop = false;
+		bool m_bPaused = false;
+		bool m_bStartedWhenDevicePaused = false;
+		bool m_bRelative = false;
+		double m_fPosX = 0.0;
+		double m_fPosY = 0.0;
+		double m_fPosZ = 0.0;
+		double m_fVolume = 1.0;
+		int32_t m_nGroupId = -1;
+		SoundMotion m_oMotion;
+		SoundRamp m_oRamp;
+	};
+private:
+	// In general all methods starting with mixerXXX()
+	// are only executed by the mixer thread (or the offline thread).
+	void mixerThreadRun() noexcept;
+	// Batch preloads are deferred and executed a slice at a time
+	void mixerExecCommands() noexcept;
+	// Executes a command and updates stats
+	void mixerExecRecordedCommand(const AlCommand& oCommand) noexcept;
+	void mixerExecCommand(const AlCommand& oCommand) noexcept;
+	// Returns the index into m_aLoadedSounds or -1 if failed (error event sent)
+	// If bDownmix is true a stereo sound is loaded as mono
+	int32_t mixerLoad(const AlCommand& oCommand, bool bDownmix) noexcept;
+	void mixerPlay(const AlCommand& oCommand) noexcept;
+	// The triggered voices start at the next rendered frame
+	void mixerStartTriggeredVoices() noexcept;
+	// Removes a voice releasing its trigger slot if prepared
+	void mixerRemoveVoice(int32_t nSoundId) noexcept;
+	// Mixes nFrames, writes them to the sink and sends the finished events.
+	void mixerRender(int32_t nFrames) noexcept;
+	// Advances the motions and volume ramps, removes the faded out voices and sends their finished events
+	void mixerAdvanceVoices() noexcept;
+	void mixerPublishStats() noexcept;
+	// Publishes the state of all voices for getSoundState()
+	// bAdvancing tells whether the mixer renders in real time until the next call
+	void mixerPublishVoiceStates(bool bAdvancing) noexcept;
+	void mixerPublishVoiceState(const Voice& oVoice, bool bRemoved, bool bAdvancing) noexcept;
+	void mixerSendError(const std::string& sErr, const AlCommand& oCommand) noexcept;
+
+	Voice* getVoice(int32_t nSoundId) noexcept;
+	bool isProgressing(const Voice& oVoice) const noexcept;
+	bool isSomeVoiceProgressing() const noexcept;
+	// The clock of motions and ramps: the rendered time
+	int64_t getAdvanceTimeUsec() const noexcept;
+	// The device clock: the rendered time
+	int64_t getRenderedNanosec() const noexcept;
+	// Mono sounds: left and right gains, stereo sounds: both equal
+	void computeGains(const Voice& oVoice, bool bMono, float& fGainL, float& fGainR) const noexcept;
+private:
+	const ::stmi::OpenAlDeviceManager::MixerInit m_oMixerInit;
+	const unique_ptr<MixerSink> m_refSink;
+	const MixerKernel& m_oKernel;
+	// The trace ring of the mixer thread
+	TraceRecorder::Ring& m_oMixerTraceRing;
+
+	std::thread m_oMixerThread;
+	// When false tells m_oMixerThread to stop and join
+	std::atomic<bool> m_bIsRunning;
+
+	// The following are only used by m_oMixerThread thread!
+	std::vector<LoadedSound> m_aLoadedSounds;
+	int64_t m_nLoadedBytes;
+	// The size of the down-mixed sounds that are not also loaded in stereo
+	int64_t m_nDownmixSavedBytes;
+	std::vector<Voice> m_aVoices;
+	// The total frames rendered by mixerRender()
+	int64_t m_nRenderedFrames;
+	bool m_bDevicePaused;
+	std::vector<SoundGroup> m_aSoundGroups; // Index: group id
+	double m_fListenerPosX;
+	double m_fListenerPosY;
+	double m_fListenerPosZ;
+	double m_fListenerVolume;
+	// Interleaved stereo
+	std::vector<float> m_aMix;
+	std::vector<int16_t> m_aOut;
+	// Used to avoid reallocating
+	std::vector<AlCommand> m_aReadAlCommands;
+	// Used by mixerRender() to avoid reallocating: (frame the sound finished at, sound id)
+	std::vector<std::pair<int32_t, int32_t>> m_aFinished;
+	// Used by mixerAdvanceVoices() to avoid reallocating
+	std::vector<int32_t> m_aFadedOut;
+	// The initial capacity of the vectors above, they only grow beyond it
+	static constexpr const int32_t s_nReservedFinishedVoices = 64;
+private:
+	MixerBackend() = delete;
+	MixerBackend(const MixerBackend& oSource) = delete;
+	MixerBackend& operator=(const MixerBackend& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_MIXER_BACKEND_H */
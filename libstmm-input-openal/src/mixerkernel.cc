@@ -0,0 +1,251 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixerkernel.cc
+ */
+
+#include "mixerkernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define STMI_MIXER_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+namespace
+{
+
+inline int16_t floatToInt16(float fSample) noexcept
+{
+	const float fClipped = std::min(1.0f, std::max(-1.0f, fSample));
+	return static_cast<int16_t>(std::lrint(fClipped * 32767.0f));
+}
+
+void scalarMixMono(const float* p0Src, int32_t nTotFrames, float fGainL, float fGainR, float* p0Mix) noexcept
+{
+	for (int32_t nFrame = 0; nFrame < nTotFrames; ++nFrame) {
+		const float fSample = p0Src[nFrame];
+		p0Mix[2 * nFrame] += fSample * fGainL;
+		p0Mix[2 * nFrame + 1] += fSample * fGainR;
+	}
+}
+void scalarMixStereo(const float* p0Src, int32_t nTotFrames, float fGain, float* p0Mix) noexcept
+{
+	const int32_t nTotSamples = 2 * nTotFrames;
+	for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+		p0Mix[nIdx] += p0Src[nIdx] * fGain;
+	}
+}
+void scalarToInt16(const float* p0Mix, int32_t nTotSamples, int16_t* p0Out) noexcept
+{
+	for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+		p0Out[nIdx] = floatToInt16(p0Mix[nIdx]);
+	}
+}
+void scalarDownmixToMono(const float* p0Src, int32_t nTotFrames, float* p0Dst) noexcept
+{
+	for (int32_t nFrame = 0; nFrame < nTotFrames; ++nFrame) {
+		p0Dst[nFrame] = (p0Src[2 * nFrame] + p0Src[2 * nFrame + 1]) * 0.5f;
+	}
+}
+
+#ifdef STMI_MIXER_KERNEL_X86
+__attribute__((target("sse2")))
+void sse2MixMono(const float* p0Src, int32_t nTotFrames, float fGainL, float fGainR, float* p0Mix) noexcept
+{
+	const __m128 oGains = _mm_setr_ps(fGainL, fGainR, fGainL, fGainR);
+	int32_t nFrame = 0;
+	for (; nFrame + 4 <= nTotFrames; nFrame += 4) {
+		const __m128 oSrc = _mm_loadu_ps(p0Src + nFrame);
+		// (s0 s0 s1 s1) and (s2 s2 s3 s3)
+		const __m128 oLo = _mm_unpacklo_ps(oSrc, oSrc);
+		const __m128 oHi = _mm_unpackhi_ps(oSrc, oSrc);
+		float* p0Dst = p0Mix + 2 * nFrame;
+		_mm_storeu_ps(p0Dst, _mm_add_ps(_mm_loadu_ps(p0Dst), _mm_mul_ps(oLo, oGains)));
+		_mm_storeu_ps(p0Dst + 4, _mm_add_ps(_mm_loadu_ps(p0Dst + 4), _mm_mul_ps(oHi, oGains)));
+	}
+	scalarMixMono(p0Src + nFrame, nTotFrames - nFrame, fGainL, fGainR, p0Mix + 2 * nFrame);
+}
+__attribute__((target("sse2")))
+void sse2MixStereo(const float* p0Src, int32_t nTotFrames, float fGain, float* p0Mix) noexcept
+{
+	const __m128 oGain = _mm_set1_ps(fGain);
+	const int32_t nTotSamples = 2 * nTotFrames;
+	int32_t nIdx = 0;
+	for (; nIdx + 4 <= nTotSamples; nIdx += 4) {
+		const __m128 oSrc = _mm_loadu_ps(p0Src + nIdx);
+		_mm_storeu_ps(p0Mix + nIdx, _mm_add_ps(_mm_loadu_ps(p0Mix + nIdx), _mm_mul_ps(oSrc, oGain)));
+	}
+	scalarMixStereo(p0Src + nIdx, (nTotSamples - nIdx) / 2, fGain, p0Mix + nIdx);
+}
+__attribute__((target("sse2")))
+void sse2ToInt16(const float* p0Mix, int32_t nTotSamples, int16_t* p0Out) noexcept
+{
+	const __m128 oMax = _mm_set1_ps(1.0f);
+	const __m128 oMin = _mm_set1_ps(-1.0f);
+	const __m128 oScale = _mm_set1_ps(32767.0f);
+	int32_t nIdx = 0;
+	for (; nIdx + 8 <= nTotSamples; nIdx += 8) {
+		const __m128 oA = _mm_mul_ps(_mm_min_ps(oMax, _mm_max_ps(oMin, _mm_loadu_ps(p0Mix + nIdx))), oScale);
+		const __m128 oB = _mm_mul_ps(_mm_min_ps(oMax, _mm_max_ps(oMin, _mm_loadu_ps(p0Mix + nIdx + 4))), oScale);
+		// round to nearest even like lrint
+		const __m128i oPacked = _mm_packs_epi32(_mm_cvtps_epi32(oA), _mm_cvtps_epi32(oB));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p0Out + nIdx), oPacked);
+	}
+	scalarToInt16(p0Mix + nIdx, nTotSamples - nIdx, p0Out + nIdx);
+}
+__attribute__((target("sse2")))
+void sse2DownmixToMono(const float* p0Src, int32_t nTotFrames, float* p0Dst) noexcept
+{
+	const __m128 oHalf = _mm_set1_ps(0.5f);
+	int32_t nFrame = 0;
+	for (; nFrame + 4 <= nTotFrames; nFrame += 4) {
+		const __m128 oA = _mm_loadu_ps(p0Src + 2 * nFrame);
+		const __m128 oB = _mm_loadu_ps(p0Src + 2 * nFrame + 4);
+		const __m128 oLeft = _mm_shuffle_ps(oA, oB, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 oRight = _mm_shuffle_ps(oA, oB, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(p0Dst + nFrame, _mm_mul_ps(_mm_add_ps(oLeft, oRight), oHalf));
+	}
+	scalarDownmixToMono(p0Src + 2 * nFrame, nTotFrames - nFrame, p0Dst + nFrame);
+}
+
+__attribute__((target("avx2")))
+void avx2MixMono(const float* p0Src, int32_t nTotFrames, float fGainL, float fGainR, float* p0Mix) noexcept
+{
+	const __m256 oGains = _mm256_setr_ps(fGainL, fGainR, fGainL, fGainR, fGainL, fGainR, fGainL, fGainR);
+	// duplicates each of 4 samples: (s0 s0 s1 s1 s2 s2 s3 s3)
+	const __m256i oDup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	int32_t nFrame = 0;
+	for (; nFrame + 8 <= nTotFrames; nFrame += 8) {
+		const __m256 oSrc = _mm256_castps128_ps256(_mm_loadu_ps(p0Src + nFrame));
+		const __m256 oSrcHi = _mm256_castps128_ps256(_mm_loadu_ps(p0Src + nFrame + 4));
+		const __m256 oLo = _mm256_permutevar8x32_ps(oSrc, oDup);
+		const __m256 oHi = _mm256_permutevar8x32_ps(oSrcHi, oDup);
+		float* p0Dst = p0Mix + 2 * nFrame;
+		_mm256_storeu_ps(p0Dst, _mm256_add_ps(_mm256_loadu_ps(p0Dst), _mm256_mul_ps(oLo, oGains)));
+		_mm256_storeu_ps(p0Dst + 8, _mm256_add_ps(_mm256_loadu_ps(p0Dst + 8), _mm256_mul_ps(oHi, oGains)));
+	}
+	scalarMixMono(p0Src + nFrame, nTotFrames - nFrame, fGainL, fGainR, p0Mix + 2 * nFrame);
+}
+__attribute__((target("avx2")))
+void avx2MixStereo(const float* p0Src, int32_t nTotFrames, float fGain, float* p0Mix) noexcept
+{
+	const __m256 oGain = _mm256_set1_ps(fGain);
+	const int32_t nTotSamples = 2 * nTotFrames;
+	int32_t nIdx = 0;
+	for (; nIdx + 8 <= nTotSamples; nIdx += 8) {
+		const __m256 oSrc = _mm256_loadu_ps(p0Src + nIdx);
+		_mm256_storeu_ps(p0Mix + nIdx, _mm256_add_ps(_mm256_loadu_ps(p0Mix + nIdx), _mm256_mul_ps(oSrc, oGain)));
+	}
+	scalarMixStereo(p0Src + nIdx, (nTotSamples - nIdx) / 2, fGain, p0Mix + nIdx);
+}
+__attribute__((target("avx2")))
+void avx2ToInt16(const float* p0Mix, int32_t nTotSamples, int16_t* p0Out) noexcept
+{
+	const __m256 oMax = _mm256_set1_ps(1.0f);
+	const __m256 oMin = _mm256_set1_ps(-1.0f);
+	const __m256 oScale = _mm256_set1_ps(32767.0f);
+	int32_t nIdx = 0;
+	for (; nIdx + 16 <= nTotSamples; nIdx += 16) {
+		const __m256 oA = _mm256_mul_ps(_mm256_min_ps(oMax, _mm256_max_ps(oMin, _mm256_loadu_ps(p0Mix + nIdx))), oScale);
+		const __m256 oB = _mm256_mul_ps(_mm256_min_ps(oMax, _mm256_max_ps(oMin, _mm256_loadu_ps(p0Mix + nIdx + 8))), oScale);
+		// packs works within 128 bit lanes: fix the order afterwards
+		const __m256i oPacked = _mm256_packs_epi32(_mm256_cvtps_epi32(oA), _mm256_cvtps_epi32(oB));
+		const __m256i oOrdered = _mm256_permute4x64_epi64(oPacked, 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(p0Out + nIdx), oOrdered);
+	}
+	scalarToInt16(p0Mix + nIdx, nTotSamples - nIdx, p0Out + nIdx);
+}
+__attribute__((target("avx2")))
+void avx2DownmixToMono(const float* p0Src, int32_t nTotFrames, float* p0Dst) noexcept
+{
+	const __m256 oHalf = _mm256_set1_ps(0.5f);
+	int32_t nFrame = 0;
+	for (; nFrame + 8 <= nTotFrames; nFrame += 8) {
+		const __m256 oA = _mm256_loadu_ps(p0Src + 2 * nFrame);
+		const __m256 oB = _mm256_loadu_ps(p0Src + 2 * nFrame + 8);
+		// shuffle works within 128 bit lanes: (L0 L1 L4 L5 | L2 L3 L6 L7)
+		const __m256 oLeft = _mm256_shuffle_ps(oA, oB, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m256 oRight = _mm256_shuffle_ps(oA, oB, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m256 oSum = _mm256_mul_ps(_mm256_add_ps(oLeft, oRight), oHalf);
+		const __m256 oOrdered = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(oSum), 0xD8));
+		_mm256_storeu_ps(p0Dst + nFrame, oOrdered);
+	}
+	scalarDownmixToMono(p0Src + 2 * nFrame, nTotFrames - nFrame, p0Dst + nFrame);
+}
+#endif //STMI_MIXER_KERNEL_X86
+
+const MixerKernel s_oScalarKernel{&scalarMixMono, &scalarMixStereo, &scalarToInt16, &scalarDownmixToMono, "scalar"};
+#ifdef STMI_MIXER_KERNEL_X86
+const MixerKernel s_oSse2Kernel{&sse2MixMono, &sse2MixStereo, &sse2ToInt16, &sse2DownmixToMono, "sse2"};
+const MixerKernel s_oAvx2Kernel{&avx2MixMono, &avx2MixStereo, &avx2ToInt16, &avx2DownmixToMono, "avx2"};
+#endif //STMI_MIXER_KERNEL_X86
+
+} // unnamed namespace
+
+const MixerKernel& MixerKernel::get() noexcept
+{
+	static const MixerKernel& s_oBest = []() -> const MixerKernel&
+	{
+		const MixerKernel* p0Kernel = getAvx2();
+		if (p0Kernel == nullptr) {
+			p0Kernel = getSse2();
+		}
+		if (p0Kernel == nullptr) {
+			p0Kernel = &s_oScalarKernel;
+		}
+		return *p0Kernel;
+	}();
+	return s_oBest;
+}
+const MixerKernel& MixerKernel::getScalar() noexcept
+{
+	return s_oScalarKernel;
+}
+const MixerKernel* MixerKernel::getSse2() noexcept
+{
+	#ifdef STMI_MIXER_KERNEL_X86
+	if (__builtin_cpu_supports("sse2")) {
+		return &s_oSse2Kernel; //-----------------------------------------------
+	}
+	#endif //STMI_MIXER_KERNEL_X86
+	return nullptr;
+}
+const MixerKernel* MixerKernel::getAvx2() noexcept
+{
+	#ifdef STMI_MIXER_KERNEL_X86
+	if (__builtin_cpu_supports("avx2")) {
+		return &s_oAvx2Kernel; //-----------------------------------------------
+	}
+	#endif //STMI_MIXER_KERNEL_X86
+	return nullptr;
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixerkernel.h
+ */
+
+#ifndef STMI_OPENAL_MIXER_KERNEL_H
+#define STMI_OPENAL_MIXER_KERNEL_H
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** The inner loops of the software mixer.
+ * There is a scalar, an SSE2 and an AVX2 implementation. get() returns the best
+ * one supported by the cpu at runtime. All implementations give the same results
+ * up to float rounding.
+ *
+ * The mix buffer is interleaved stereo float, the output interleaved stereo
+ * 16 bit. Source samples are float in the range [-1, 1].
+ */
+struct MixerKernel
+{
+	/** Adds a mono source to the stereo mix buffer.
+	 * @param p0Src The source samples. Cannot be null.
+	 * @param nTotFrames The number of frames.
+	 * @param fGainL The gain of the left channel.
+	 * @param fGainR The gain of the right channel.
+	 * @param p0Mix The stereo mix buffer of at least 2 * nTotFrames floats. Cannot be null.
+	 */
+	void (*m_p0MixMono)(const float* p0Src, int32_t nTotFrames, float fGainL, float fGainR, float* p0Mix) noexcept;
+	/** Adds a stereo source to the stereo mix buffer.
+	 * @param p0Src The interleaved source samples. Cannot be null.
+	 * @param nTotFrames The number of frames.
+	 * @param fGain The gain of both channels.
+	 * @param p0Mix The stereo mix buffer of at least 2 * nTotFrames floats. Cannot be null.
+	 */
+	void (*m_p0MixStereo)(const float* p0Src, int32_t nTotFrames, float fGain, float* p0Mix) noexcept;
+	/** Converts the mix buffer to 16 bit samples clipping values out of [-1, 1].
+	 * @param p0Mix The mix buffer. Cannot be null.
+	 * @param nTotSamples The number of samples (not frames).
+	 * @param p0Out The output. Cannot be null.
+	 */
+	void (*m_p0ToInt16)(const float* p0Mix, int32_t nTotSamples, int16_t* p0Out) noexcept;
+	/** Averages the channels of a stereo source.
+	 * @param p0Src The interleaved source samples. Cannot be null.
+	 * @param nTotFrames The number of frames.
+	 * @param p0Dst The mono output of nTotFrames floats. Can be p0Src. Cannot be null.
+	 */
+	void (*m_p0DownmixToMono)(const float* p0Src, int32_t nTotFrames, float* p0Dst) noexcept;
+	/** The name of the implementation ("scalar", "sse2", "avx2"). */
+	const char* m_p0Name;
+
+	/** The fastest implementation supported by the cpu.
+	 * @return The kernel.
+	 */
+	static const MixerKernel& get() noexcept;
+	/** The scalar implementation.
+	 * @return The kernel.
+	 */
+	static const MixerKernel& getScalar() noexcept;
+	/** The SSE2 implementation.
+	 * @return The kernel or null if not supported by compiler or cpu.
+	 */
+	static const MixerKernel* getSse2() noexcept;
+	/** The AVX2 implementation.
+	 * @return The kernel or null if not supported by compiler or cpu.
+	 */
+	static const MixerKernel* getAvx2() noexcept;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_MIXER_KERNEL_H */
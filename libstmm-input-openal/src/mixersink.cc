@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   mixersink.cc
+ */
+
+#include "mixersink.h"
+
+#include "wavfilewriter.h"
+
+#include <cassert>
+
+namespace stmi
+{
+
+WavMixerSink::WavMixerSink(const std::string& sFilePath) noexcept
+: m_sFilePath(sFilePath)
+, m_nChannels(0)
+, m_refWriter(new Private::OpenAl::WavFileWriter())
+{
+	assert(! sFilePath.empty());
+}
+WavMixerSink::~WavMixerSink() noexcept
+{
+}
+std::string WavMixerSink::open(int32_t nFrequency, int32_t nChannels) noexcept
+{
+	m_nChannels = nChannels;
+	return m_refWriter->open(m_sFilePath, nFrequency, nChannels);
+}
+void WavMixerSink::write(const int16_t* p0Samples, int32_t nTotFrames) noexcept
+{
+	m_refWriter->write(p0Samples, nTotFrames * m_nChannels);
+}
+
+} // namespace stmi
@@ -20,9 +20,10 @@
 
 #include "openalbackend.h"
 
+#include "mixerkernel.h"
 #include "openaldevicemanager.h"
-
-#include <glibmm.h>
+#include "pcmconverter.h"
+#include "pcmencoder.h"
 
 #include <string>
 #include <memory>
@@ -35,6 +36,10 @@
 #include <mutex>
 #include <condition_variable>
 #include <limits>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cmath>
 
 #include <AL/alure.h>
 
@@ -47,26 +52,58 @@ namespace Private
 namespace OpenAl
 {
 
-// Main thread
-static constexpr const int32_t s_nCheckEventsConnMillisec = 200;
-
 // OpenAl thread
 static constexpr const int32_t s_nBaseIntervalMillisec = 10;
 static constexpr const double s_fAlUpdateIntervalSeconds = 0.12;
 static constexpr const double s_fAlCheckDevicesIntervalSeconds = 1.0;
 
-unique_ptr<Backend> Backend::create(::stmi::OpenAlDeviceManager* p0Owner) noexcept
+static const char* const s_p0LoopbackDeviceName = "Loopback";
+
+// The IMA4 block size OpenAL expects without AL_SOFT_block_alignment
+static constexpr const int32_t s_nIma4DefaultBlockFrames = 65;
+// Less header overhead, while the silence padding the last block stays short
+static constexpr const int32_t s_nIma4AlignedBlockFrames = 505;
+
+// The size of the chunks decoded by alure for streamed sounds
+static constexpr const int32_t s_nStreamChunkBytes = 32768;
+// The number of chunks queued to the source of a streamed sound
+static constexpr const int32_t s_nStreamBuffers = 4;
+
+// The maximum number of threads (the OpenAL thread and the preload workers)
+// reading and converting the files of preload batches
+static constexpr const int32_t s_nMaxPreloadThreads = 8;
+
+unique_ptr<OpenAlBackend> OpenAlBackend::create(::stmi::OpenAlDeviceManager* p0Owner) noexcept
+{
+	return std::unique_ptr<OpenAlBackend>(new OpenAlBackend(p0Owner, nullptr, false));
+}
+unique_ptr<OpenAlBackend> OpenAlBackend::createLoopback(::stmi::OpenAlDeviceManager* p0Owner
+														, const ::stmi::OpenAlDeviceManager::LoopbackInit& oLoopbackInit) noexcept
+{
+	return std::unique_ptr<OpenAlBackend>(new OpenAlBackend(p0Owner, &oLoopbackInit, false));
+}
+unique_ptr<OpenAlBackend> OpenAlBackend::createOffline(::stmi::OpenAlDeviceManager* p0Owner
+														, const ::stmi::OpenAlDeviceManager::LoopbackInit& oLoopbackInit) noexcept
 {
-	return std::unique_ptr<Backend>(new Backend(p0Owner));
+	return std::unique_ptr<OpenAlBackend>(new OpenAlBackend(p0Owner, &oLoopbackInit, true));
 }
 
-Backend::Backend(::stmi::OpenAlDeviceManager* p0Owner) noexcept
-: m_p0Owner(p0Owner)
+OpenAlBackend::OpenAlBackend(::stmi::OpenAlDeviceManager* p0Owner
+							, const ::stmi::OpenAlDeviceManager::LoopbackInit* p0LoopbackInit
+							, bool bOffline) noexcept
+: Backend(p0Owner)
+, m_oAlTraceRing(m_oTraceRecorder.addThread(bOffline ? "offline" : "openal"))
+, m_bLoopback(p0LoopbackInit != nullptr)
+, m_bOffline(bOffline)
+, m_oLoopbackInit((p0LoopbackInit != nullptr) ? *p0LoopbackInit : ::stmi::OpenAlDeviceManager::LoopbackInit{})
 {
-	assert(p0Owner != nullptr);
+	assert((! bOffline) || (p0LoopbackInit != nullptr));
+	assert(m_oLoopbackInit.m_nFrequency > 0);
+	assert(m_oLoopbackInit.m_nRenderFrames > 0);
 }
-std::string Backend::openalGetDeviceNames(std::vector<std::string>& aDeviceNames, int32_t& nDefaultIdx) noexcept
+std::string OpenAlBackend::openalGetDeviceNames(std::vector<std::string>& aDeviceNames, int32_t& nDefaultIdx) noexcept
 {
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalGetDeviceNames");
 	ALCsizei nTotNames;
 	ALCchar const ** pDeviceNames = ::alureGetDeviceNames(true, &nTotNames);
 	if (pDeviceNames == nullptr) {
@@ -92,16 +129,32 @@ std::string Backend::openalGetDeviceNames(std::vector<std::string>& aDeviceNames
 	}
 	return "";
 }
-std::string Backend::createThread() noexcept
+std::string OpenAlBackend::start() noexcept
 {
-//std::cout << "Backend::createThread  startin thread" << '\n';
+	startPreloadWorkers();
+	if (m_bOffline) {
+		// no thread: everything happens in this thread
+		const std::string sErr = openalCreateLoopbackDevice();
+		if (! sErr.empty()) {
+			return sErr; //-----------------------------------------------------
+		}
+		addInitialDevice(std::string{s_p0LoopbackDeviceName}, m_nDefaultDeviceId, true);
+		return ""; //-----------------------------------------------------------
+	}
+//std::cout << "OpenAlBackend::start  starting thread" << '\n';
 	m_oAlThread = std::thread([&]()
 	{
 		// creates openal devices
-		std::vector<std::string> aDummyDeviceNames;
-		const std::string sErr = openalCreateAllDevices(false, aDummyDeviceNames, false);
-		if (! sErr.empty()) {
-			m_sInitialAlError = "alureGetDeviceNames() error: " + sErr;
+		std::string sErr;
+		if (m_bLoopback) {
+			sErr = openalCreateLoopbackDevice();
+			m_sInitialAlError = sErr;
+		} else {
+			std::vector<std::string> aDummyDeviceNames;
+			sErr = openalCreateAllDevices(false, aDummyDeviceNames, false);
+			if (! sErr.empty()) {
+				m_sInitialAlError = "alureGetDeviceNames() error: " + sErr;
+			}
 		}
 		// signal main thread to create stmm-input devices and capabilities
 		{
@@ -118,10 +171,10 @@ std::string Backend::createThread() noexcept
 			m_oInitialDevicesCreated.wait(oLock, [&](){ return (m_bInitialDevicesCreated != false); });
 		}
 		//
-//std::cout << "Backend:: openalThread  thread running" << '\n';
+//std::cout << "OpenAlBackend:: openalThread  thread running" << '\n';
 		openalThreadRun();
 		// shut down everything
-//std::cout << "Backend:: openalThread  shutting down" << '\n';
+//std::cout << "OpenAlBackend:: openalThread  shutting down" << '\n';
 		for (AlDevice& oDev : m_aAlDevices) {
 			if (oDev.m_bDeviceRemoved) {
 				continue;
@@ -154,7 +207,7 @@ std::string Backend::createThread() noexcept
 			continue;
 		}
 		auto sCopy = oDev.m_sDeviceName;
-		m_p0Owner->onDeviceAdded(std::move(sCopy), nDeviceId, (nDeviceId == m_nDefaultDeviceId));
+		addInitialDevice(std::move(sCopy), nDeviceId, (nDeviceId == m_nDefaultDeviceId));
 	}
 	// now signal to the thread it can start processing commands, updating, checking devices etc.
 	{
@@ -163,67 +216,28 @@ std::string Backend::createThread() noexcept
 	}
 	m_oInitialDevicesCreated.notify_one();
 
-	m_oCheckEventsConn = Glib::signal_timeout().connect(
-			sigc::mem_fun(*this, &Backend::onCheckEventsTimeout), s_nCheckEventsConnMillisec);
-
-	return "";
+	return attachEventLoop();
 }
-Backend::~Backend() noexcept
+OpenAlBackend::~OpenAlBackend() noexcept
 {
-//std::cout << "Backend:: destructor  start shutdown" << '\n';
+//std::cout << "OpenAlBackend:: destructor  start shutdown" << '\n';
+	stopPreloadWorkers();
+	if (m_bOffline) {
+		for (AlDevice& oDev : m_aAlDevices) {
+			if (oDev.m_bDeviceRemoved) {
+				continue;
+			}
+			openalShutdownDevice(oDev);
+		}
+		return; //--------------------------------------------------------------
+	}
+	detachEventLoop();
 	// Tell m_oAlThread to stop
 	m_bIsRunning = false;
 	m_oAlThread.join();
-//std::cout << "Backend:: destructor  threadjoined" << '\n';
-}
-bool Backend::onCheckEventsTimeout() noexcept
-{
-	assert(m_aReadAlEvents.empty());
-	{
-		std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
-		m_aReadAlEvents = std::move(m_aAlEvents);
-		m_aAlEvents.clear();
-	}
-	if (m_aReadAlEvents.empty()) {
-		return true; //---------------------------------------------------------
-	}
-//std::cout << "Backend::onCheckEventsTimeout() tot AL_EVENTs = " << m_aReadAlEvents.size() << '\n';
-	for (AlEvent& oAlEvent : m_aReadAlEvents) {
-//std::cout << "Backend::onCheckEventsTimeout() oAlEvent.m_nBackendDeviceId = " << oAlEvent.m_nBackendDeviceId << '\n';
-//std::cout << "Backend::onCheckEventsTimeout()         .m_nFileId   = " << oAlEvent.m_nFileId << '\n';
-//std::cout << "Backend::onCheckEventsTimeout()         .m_nSoundId  = " << oAlEvent.m_nSoundId << '\n';
-//std::cout << "Backend::onCheckEventsTimeout()         .m_eType     = " << static_cast<int32_t>(oAlEvent.m_eType) << '\n';
-		switch (oAlEvent.m_eType) {
-		case AL_EVENT_PLAY_FINISHED:
-		{
-			m_p0Owner->onPlayFinished(oAlEvent.m_nBackendDeviceId, oAlEvent.m_nSoundId);
-		} break;
-		case AL_EVENT_DEVICE_ADDED:
-		{
-			m_p0Owner->onDeviceAdded(std::move(oAlEvent.m_sDeviceName), oAlEvent.m_nBackendDeviceId, oAlEvent.m_bDeviceIsDefault);
-		} break;
-		case AL_EVENT_DEVICE_REMOVED:
-		{
-			m_p0Owner->onDeviceRemoved(oAlEvent.m_nBackendDeviceId);
-		} break;
-		case AL_EVENT_DEVICE_CHANGED:
-		{
-			m_p0Owner->onDeviceChanged(oAlEvent.m_nBackendDeviceId, oAlEvent.m_bDeviceIsDefault);
-		} break;
-		case AL_EVENT_PLAY_ERROR:
-		{
-			m_p0Owner->onDeviceError(oAlEvent.m_nBackendDeviceId, oAlEvent.m_nFileId, oAlEvent.m_nSoundId, std::move(oAlEvent.m_sError));
-		} break;
-		default:
-		{
-			assert(false);
-		} break;
-		}
-	}
-	m_aReadAlEvents.clear();
-	return true;
+//std::cout << "OpenAlBackend:: destructor  threadjoined" << '\n';
 }
-void Backend::openalThreadRun() noexcept
+void OpenAlBackend::openalThreadRun() noexcept
 {
 	auto oLastCheckUpdate = std::chrono::steady_clock::now();
 	auto oLastCheckDevices = oLastCheckUpdate + std::chrono::milliseconds(73);
@@ -231,18 +245,23 @@ void Backend::openalThreadRun() noexcept
 	std::unique_lock<std::mutex> oLock(m_oAlCommandMutex);
 	auto oExecCommands = [&]()
 	{
-		m_aReadAlCommands = std::move(m_aAlCommands);
-		m_aAlCommands.clear();
+		takeCommands(m_aReadAlCommands);
 		oLock.unlock();
-		for (auto& oCommand : m_aReadAlCommands) {
-			openalExecCommand(oCommand);
-		}
+		openalExecReadCommands();
 		oLock.lock();
 	};
 
+	// Whether the loopback device rendered samples in the last iteration
+	bool bLoopbackRendering = false;
 	do {
-		m_oAlCommandsNotEmpty.wait_for(oLock, std::chrono::milliseconds(s_nBaseIntervalMillisec)
-										, [&]{ return (! m_aAlCommands.empty()) || ! m_bIsRunning; });
+		// A rendering loopback device doesn't wait: it renders as fast as possible
+		// and the deferred preloads are executed as soon as possible
+		int32_t nWaitMillisec = ((bLoopbackRendering || hasDeferredPreloads()) ? 0 : s_nBaseIntervalMillisec);
+		if (m_nStartWaitMillisec >= 0) {
+			// wake up in time for the next scheduled sound
+			nWaitMillisec = std::min(nWaitMillisec, m_nStartWaitMillisec);
+		}
+		waitForCommands(oLock, std::chrono::milliseconds(nWaitMillisec), [&]{ return ! m_bIsRunning; });
 		if (! m_bIsRunning) {
 			break;
 		}
@@ -252,17 +271,30 @@ void Backend::openalThreadRun() noexcept
 		const bool bDoUpdateSounds = (fDiffUpdate > std::chrono::duration<double>(s_fAlUpdateIntervalSeconds));
 		// each 1000 millisec check device names
 		std::chrono::duration<double> fDiffCheckDevices = oNow - oLastCheckDevices;
-		const bool bDoUpdateDevices = (fDiffCheckDevices > std::chrono::duration<double>(s_fAlCheckDevicesIntervalSeconds));
+		// the loopback device can't be unplugged
+		const bool bDoUpdateDevices = (! m_bLoopback)
+									&& (fDiffCheckDevices > std::chrono::duration<double>(s_fAlCheckDevicesIntervalSeconds));
 
 		do {
 			oExecCommands();
-		} while (! m_aAlCommands.empty());
+		} while (hasCommands());
 
 		bool bIsUnlocked = false;
-		if (bDoUpdateSounds) {
+		if (hasDeferredPreloads()) {
+			// a slice at a time, new commands are checked in between
 			oLock.unlock();
 			bIsUnlocked = true;
-			::alureUpdate();
+			openalExecDeferredPreloads();
+		}
+		if (bDoUpdateSounds) {
+			if (! bIsUnlocked) {
+				oLock.unlock();
+				bIsUnlocked = true;
+			}
+			{
+				TraceSpan oSpan(*this, m_oAlTraceRing, "alureUpdate");
+				::alureUpdate();
+			}
 			oLastCheckUpdate = oNow;
 		}
 		if (bDoUpdateDevices) {
@@ -273,30 +305,98 @@ void Backend::openalThreadRun() noexcept
 			openalCheckDeviceNames();
 			oLastCheckDevices = oNow;
 		}
+		{
+			if (! bIsUnlocked) {
+				oLock.unlock();
+				bIsUnlocked = true;
+			}
+			// the moving sounds and the volume ramps are advanced each iteration
+			openalAdvanceSounds();
+		}
+		if (m_bLoopback) {
+			if (! bIsUnlocked) {
+				oLock.unlock();
+				bIsUnlocked = true;
+			}
+			bLoopbackRendering = openalLoopbackRender();
+		}
+		{
+			if (! bIsUnlocked) {
+				oLock.unlock();
+				bIsUnlocked = true;
+			}
+			openalPublishStats();
+			openalPublishDeviceClocks();
+			// Querying OpenAL for each sound each iteration is too expensive: the readers
+			// extrapolate the offset of a playing sound from the time it was published
+			if (bDoUpdateSounds || m_bSoundStatesChanged) {
+				openalPublishSoundStates();
+			}
+		}
 		if (bIsUnlocked) {
 			oLock.lock();
-			// If while unlocked commands came in, execute them so that
-			// the wait can't miss a notify_one() from the main thread
-			while (! m_aAlCommands.empty()) {
+			// If while unlocked commands came in, execute them now
+			// rather than after the wait
+			while (hasCommands()) {
 				oExecCommands();
 			}
 		}
 	} while (true);
 }
-void Backend::sendCommand(AlCommand&& oAlCommand) noexcept
+void OpenAlBackend::openalExecReadCommands() noexcept
 {
-	{
-		std::lock_guard<std::mutex> oLock(m_oAlCommandMutex);
-		m_aAlCommands.push_back(std::move(oAlCommand));
+	if (! m_aReadAlCommands.empty()) {
+		m_bSoundStatesChanged = true;
+	}
+	for (auto& oCommand : m_aReadAlCommands) {
+		if (deferPreload(oCommand)) {
+			continue;
+		}
+		openalExecRecordedCommand(oCommand);
+	}
+	m_aReadAlCommands.clear();
+	// after the commands, that might have prepared the triggered sounds
+	if (isSomeTriggerPending()) {
+		m_bSoundStatesChanged = true;
+		openalStartTriggeredSounds();
+	}
+}
+void OpenAlBackend::openalExecDeferredPreloads() noexcept
+{
+	takeDeferredPreloads(s_nDeferredPreloadsPerSlice, m_aDeferredPreloadSlice);
+	openalPrepareBatchPreloads();
+	for (auto& oCommand : m_aDeferredPreloadSlice) {
+		openalExecRecordedCommand(oCommand);
 	}
-	m_oAlCommandsNotEmpty.notify_one();
+	m_aDeferredPreloadSlice.clear();
+	m_aPreparedPreloads.clear();
+	m_nNextPreparedPreload = 0;
 }
-void Backend::openalExecCommand(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalExecRecordedCommand(const AlCommand& oCommand) noexcept
 {
+	++m_oRawStats.m_aExecutedCommands[oCommand.m_eType];
+	if (isLatencyEnabled()) {
+		const int64_t nExecStartUsec = getSteadyTimeUsec();
+		openalExecCommand(oCommand);
+		recordCommandLatency(oCommand, nExecStartUsec, getSteadyTimeUsec());
+	} else {
+		openalExecCommand(oCommand);
+	}
+}
+void OpenAlBackend::openalExecCommand(const AlCommand& oCommand) noexcept
+{
+	TraceSpan oSpan(*this, m_oAlTraceRing, getCommandTraceName(oCommand.m_eType));
 	switch (oCommand.m_eType) {
 		case AL_COMMAND_PRELOAD:
 		{
-			openalPreload(oCommand);
+			PreparedPreload* p0Prepared = nullptr;
+			if ((m_nNextPreparedPreload < static_cast<int32_t>(m_aPreparedPreloads.size()))
+					&& (m_aPreparedPreloads[m_nNextPreparedPreload].m_p0Command == &oCommand)) {
+				p0Prepared = &(m_aPreparedPreloads[m_nNextPreparedPreload]);
+				++m_nNextPreparedPreload;
+			}
+			const bool bLoaded = openalPreload(oCommand, p0Prepared);
+			sendPreloadedEvent(oCommand, bLoaded);
 		} break;
 		case AL_COMMAND_PLAY:
 		{
@@ -346,6 +446,34 @@ void Backend::openalExecCommand(const AlCommand& oCommand) noexcept
 		{
 			openalListenerVol(oCommand);
 		} break;
+		case AL_COMMAND_CANCEL_PRELOADS:
+		{
+			cancelDeferredPreloads(oCommand.m_nBackendDeviceId, oCommand.m_nBatchId);
+		} break;
+		case AL_COMMAND_GROUP_VOL:
+		{
+			openalGroupVol(oCommand);
+		} break;
+		case AL_COMMAND_PAUSE_GROUP:
+		{
+			openalPauseGroup(oCommand);
+		} break;
+		case AL_COMMAND_RESUME_GROUP:
+		{
+			openalResumeGroup(oCommand);
+		} break;
+		case AL_COMMAND_STOP_GROUP:
+		{
+			openalStopGroup(oCommand);
+		} break;
+		case AL_COMMAND_SOUND_MOTION:
+		{
+			openalSoundMotion(oCommand);
+		} break;
+		case AL_COMMAND_SOUND_RAMP:
+		{
+			openalSoundRamp(oCommand);
+		} break;
 		default:
 		{
 			assert(false);
@@ -361,7 +489,7 @@ inline double clamp(double fValue) noexcept
 	}
 	return fValue;
 }
-void Backend::openalSendError(const std::string& sErr, const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalSendError(const std::string& sErr, const AlCommand& oCommand) noexcept
 {
 	AlEvent oEv;
 	oEv.m_eType = AL_EVENT_PLAY_ERROR;
@@ -369,34 +497,556 @@ void Backend::openalSendError(const std::string& sErr, const AlCommand& oCommand
 	oEv.m_nSoundId = oCommand.m_nSoundId;
 	oEv.m_nFileId = oCommand.m_nFileId;
 	oEv.m_sError = sErr;
-	std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
-	m_aAlEvents.push_back(std::move(oEv));
+	sendEvent(std::move(oEv));
+}
+namespace
+{
+std::vector<std::pair<int32_t, ALuint>>::iterator findFileBuffer(std::vector<std::pair<int32_t, ALuint>>& aFileToBufferId
+																, int32_t nFileId) noexcept
+{
+	return std::find_if(aFileToBufferId.begin(), aFileToBufferId.end(), [&](const std::pair<int32_t, ALuint>& oPair)
+	{
+		return (oPair.first == nFileId);
+	});
+}
+bool readFileBytes(const std::string& sFileName, std::vector<uint8_t>& aBytes) noexcept
+{
+	std::ifstream oFile(sFileName, std::ios::in | std::ios::binary);
+	if (! oFile.is_open()) {
+		return false; //--------------------------------------------------------
+	}
+	aBytes.assign(std::istreambuf_iterator<char>(oFile), std::istreambuf_iterator<char>());
+	return (! oFile.bad()) && (aBytes.size() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
+}
+} // unnamed namespace
+void OpenAlBackend::openalPrepareBatchPreloads() noexcept
+{
+	m_aPreparedPreloads.clear();
+	m_nNextPreparedPreload = 0;
+	const bool bDecodeOnDemand = isDecodeOnDemand();
+	const bool bNative = isNativeFormatConversion() || (getCompressedSampleFormat() != OpenAlDeviceManager::SAMPLE_FORMAT_PCM16)
+						|| ! getPcmDiskCacheDirectory().empty();
+	for (const AlCommand& oCommand : m_aDeferredPreloadSlice) {
+		if ((oCommand.m_eType != AL_COMMAND_PRELOAD) || (oCommand.m_nBatchId < 0) || (oCommand.m_p0Buffer != nullptr)) {
+			continue;
+		}
+		AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+		if (bDecodeOnDemand) {
+			const auto itFind = std::find_if(m_aEncodedFiles.begin(), m_aEncodedFiles.end()
+											, [&](const std::pair<std::string, std::vector<uint8_t>>& oPair)
+			{
+				return (oPair.first == oCommand.m_sFileName);
+			});
+			if (itFind != m_aEncodedFiles.end()) {
+				continue;
+			}
+		} else if (findFileBuffer(oAlDevice.m_aFileToBufferId, oCommand.m_nFileId) != oAlDevice.m_aFileToBufferId.end()) {
+			continue;
+		}
+		const auto itSame = std::find_if(m_aPreparedPreloads.begin(), m_aPreparedPreloads.end(), [&](const PreparedPreload& oPrepared)
+		{
+			return (oPrepared.m_p0Command->m_sFileName == oCommand.m_sFileName);
+		});
+		if (itSame != m_aPreparedPreloads.end()) {
+			// the same file twice in a batch: the second is already loaded when executed
+			continue;
+		}
+		m_aPreparedPreloads.emplace_back();
+		PreparedPreload& oPrepared = m_aPreparedPreloads.back();
+		oPrepared.m_p0Command = &oCommand;
+		oPrepared.m_bDecodeOnDemand = bDecodeOnDemand;
+		oPrepared.m_bNative = bNative && ! bDecodeOnDemand;
+		if (oPrepared.m_bNative) {
+			oPrepared.m_oTarget = getNativeTarget(oAlDevice);
+		}
+	}
+	const int32_t nTotPrepared = static_cast<int32_t>(m_aPreparedPreloads.size());
+	if (nTotPrepared == 0) {
+		return; //--------------------------------------------------------------
+	}
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalPrepareBatchPreloads");
+	std::unique_lock<std::mutex> oLock(m_oPreloadWorkMutex);
+	m_nTotPreloadsToPrepare = nTotPrepared;
+	m_nNextPreloadToPrepare = 0;
+	m_nPreparedPreloads = 0;
+	if (nTotPrepared > 1) {
+		m_oPreloadWorkAvailable.notify_all();
+	}
+	// This thread works too
+	prepareQueuedPreloads(oLock);
+	m_oPreloadWorkDone.wait(oLock, [&]() { return (m_nPreparedPreloads == m_nTotPreloadsToPrepare); });
+	m_nTotPreloadsToPrepare = 0;
+	m_nNextPreloadToPrepare = 0;
+}
+void OpenAlBackend::startPreloadWorkers() noexcept
+{
+	assert(m_aPreloadWorkers.empty());
+	const int32_t nHardwareThreads = static_cast<int32_t>(std::thread::hardware_concurrency());
+	// the OpenAL thread works too
+	const int32_t nTotWorkers = std::min(std::max(nHardwareThreads, 1), s_nMaxPreloadThreads) - 1;
+	for (int32_t nWorker = 0; nWorker < nTotWorkers; ++nWorker) {
+		m_aPreloadWorkers.emplace_back([this]()
+		{
+			preloadWorkerRun();
+		});
+	}
+}
+void OpenAlBackend::stopPreloadWorkers() noexcept
+{
+	{
+		std::lock_guard<std::mutex> oLock(m_oPreloadWorkMutex);
+		m_bPreloadWorkersStop = true;
+	}
+	m_oPreloadWorkAvailable.notify_all();
+	for (auto& oWorker : m_aPreloadWorkers) {
+		oWorker.join();
+	}
+	m_aPreloadWorkers.clear();
 }
-void Backend::openalPreload(const AlCommand& oCommand) noexcept
+void OpenAlBackend::preloadWorkerRun() noexcept
 {
+	std::unique_lock<std::mutex> oLock(m_oPreloadWorkMutex);
+	while (true) {
+		m_oPreloadWorkAvailable.wait(oLock, [&]()
+		{
+			return m_bPreloadWorkersStop || (m_nNextPreloadToPrepare < m_nTotPreloadsToPrepare);
+		});
+		if (m_bPreloadWorkersStop) {
+			return; //----------------------------------------------------------
+		}
+		prepareQueuedPreloads(oLock);
+	}
+}
+void OpenAlBackend::prepareQueuedPreloads(std::unique_lock<std::mutex>& oLock) noexcept
+{
+	while (m_nNextPreloadToPrepare < m_nTotPreloadsToPrepare) {
+		const int32_t nIdx = m_nNextPreloadToPrepare;
+		++m_nNextPreloadToPrepare;
+		// the OpenAL thread doesn't change m_aPreparedPreloads until all are prepared
+		oLock.unlock();
+		preparePreload(m_aPreparedPreloads[nIdx]);
+		oLock.lock();
+		++m_nPreparedPreloads;
+		if (m_nPreparedPreloads == m_nTotPreloadsToPrepare) {
+			m_oPreloadWorkDone.notify_one();
+		}
+	}
+}
+void OpenAlBackend::preparePreload(PreparedPreload& oPrepared) const noexcept
+{
+	const AlCommand& oCommand = *oPrepared.m_p0Command;
+	const bool bLatency = isLatencyEnabled();
+	oPrepared.m_nDecodeStartUsec = (bLatency ? getSteadyTimeUsec() : -1);
+	if (oPrepared.m_bNative) {
+		// the disk cache is looked up before reading the file
+		oPrepared.m_bNative = prepareNativeSound(oPrepared.m_oTarget, oCommand.m_sFileName, nullptr, 0, false
+												, oPrepared.m_oScratch, oPrepared.m_oData);
+	}
+	if (! oPrepared.m_bNative) {
+		// alure decodes from memory in the OpenAL thread
+		oPrepared.m_bRead = readFileBytes(oCommand.m_sFileName, oPrepared.m_aBytes);
+	}
+	oPrepared.m_nDecodeEndUsec = (bLatency ? getSteadyTimeUsec() : -1);
+}
+bool OpenAlBackend::openalPreload(const AlCommand& oCommand, PreparedPreload* p0Prepared) noexcept
+{
+	if (isDecodeOnDemand()) {
+		// decoded the first time it is played
+		if (oCommand.m_p0Buffer == nullptr) {
+			return openalLoadEncodedFile(oCommand, p0Prepared); //--------------
+		}
+		return true; //---------------------------------------------------------
+	}
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
-	// get or create buffer
-	ALuint nALBuffer;
+	if (findFileBuffer(oAlDevice.m_aFileToBufferId, oCommand.m_nFileId) != oAlDevice.m_aFileToBufferId.end()) {
+		// already loaded
+		return true; //---------------------------------------------------------
+	}
+	// create buffer
+	const ALuint nALBuffer = ((p0Prepared != nullptr)
+							? openalCreatePreparedBuffer(oCommand, oAlDevice, *p0Prepared)
+							: openalCreateBuffer(oCommand, oAlDevice));
+	if (nALBuffer == AL_NONE) {
+		return false; //--------------------------------------------------------
+	}
+	openalAddBuffer(oAlDevice, oCommand.m_nFileId, nALBuffer, false);
+	return true;
+}
+ALuint OpenAlBackend::openalGetPlayBuffer(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept
+{
 	auto& aFileToBufferId = oAlDevice.m_aFileToBufferId;
-	if (oCommand.m_p0Buffer == nullptr) {
-		nALBuffer = ::alureCreateBufferFromFile(oCommand.m_sFileName.c_str());
-		if (nALBuffer == AL_FALSE) {
+	const auto itFind = findFileBuffer(aFileToBufferId, oCommand.m_nFileId);
+	if (oCommand.m_bMonoDownmix && isPositional(oCommand)) {
+		auto& aFileToMonoBufferId = oAlDevice.m_aFileToMonoBufferId;
+		const auto itFindMono = findFileBuffer(aFileToMonoBufferId, oCommand.m_nFileId);
+		if (itFindMono != aFileToMonoBufferId.end()) {
+			return itFindMono->second; //---------------------------------------
+		}
+		if (itFind != aFileToBufferId.end()) {
+			ALint nChannels = 0;
+			::alGetBufferi(itFind->second, AL_CHANNELS, &nChannels);
+			if (nChannels == 1) {
+				// nothing to down-mix
+				return itFind->second; //---------------------------------------
+			}
+		}
+		bool bDownmixed = false;
+		const int64_t nDecodeStartUsec = (isLatencyEnabled() ? getSteadyTimeUsec() : -1);
+		const ALuint nALBuffer = openalCreateNativeBuffer(oCommand, oAlDevice, true, bDownmixed);
+		if (nALBuffer != AL_NONE) {
+			recordDecodeLatency(nDecodeStartUsec, getSteadyTimeUsec());
+			openalAddBuffer(oAlDevice, oCommand.m_nFileId, nALBuffer, bDownmixed);
+			return nALBuffer; //------------------------------------------------
+		}
+		// not a PCM WAV: play it like alure decodes it
+	}
+	if (itFind != aFileToBufferId.end()) {
+		return itFind->second; //-----------------------------------------------
+	}
+	// first time this file is played
+	const ALuint nALBuffer = openalCreateBuffer(oCommand, oAlDevice);
+	if (nALBuffer == AL_NONE) {
+		return AL_NONE; //------------------------------------------------------
+	}
+	openalAddBuffer(oAlDevice, oCommand.m_nFileId, nALBuffer, false);
+	return nALBuffer;
+}
+ALuint OpenAlBackend::openalCreateBuffer(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept
+{
+	const int64_t nDecodeStartUsec = (isLatencyEnabled() ? getSteadyTimeUsec() : -1);
+	ALuint nALBuffer = AL_NONE;
+	if (isNativeFormatConversion() || (getCompressedSampleFormat() != OpenAlDeviceManager::SAMPLE_FORMAT_PCM16)
+			|| ((oCommand.m_p0Buffer == nullptr) && ! getPcmDiskCacheDirectory().empty())) {
+		bool bDownmixed;
+		nALBuffer = openalCreateNativeBuffer(oCommand, oAlDevice, false, bDownmixed);
+	}
+	if (nALBuffer == AL_NONE) {
+		const uint8_t* p0Bytes;
+		int32_t nSize;
+		if (getSoundBytes(oCommand, p0Bytes, nSize)) {
+			nALBuffer = ::alureCreateBufferFromMemory(static_cast<ALubyte*>(const_cast<uint8_t*>(p0Bytes))
+													, static_cast<ALsizei>(nSize));
+		} else {
+//std::cout << "OpenAlBackend::openalCreateBuffer   alureCreateBufferFromFile = " << oCommand.m_sFileName << '\n';
+			nALBuffer = ::alureCreateBufferFromFile(oCommand.m_sFileName.c_str());
+		}
+		if (nALBuffer == AL_NONE) {
 			openalSendError(::alureGetErrorString(), oCommand);
-			return; //------------------------------------------------------
+			return AL_NONE; //--------------------------------------------------
 		}
+	}
+	recordDecodeLatency(nDecodeStartUsec, getSteadyTimeUsec());
+	return nALBuffer;
+}
+ALuint OpenAlBackend::openalCreatePreparedBuffer(const AlCommand& oCommand, AlDevice& oAlDevice, PreparedPreload& oPrepared) noexcept
+{
+	ALuint nALBuffer = AL_NONE;
+	if (oPrepared.m_bNative) {
+		nALBuffer = openalUploadBuffer(oPrepared.m_oData);
+		oPrepared.m_oScratch.m_oMapping.release();
+	} else if (oPrepared.m_bRead) {
+		nALBuffer = ::alureCreateBufferFromMemory(static_cast<ALubyte*>(oPrepared.m_aBytes.data())
+												, static_cast<ALsizei>(oPrepared.m_aBytes.size()));
+	}
+	if (nALBuffer == AL_NONE) {
+		// let the serial path decode it again and report the error
+		return openalCreateBuffer(oCommand, oAlDevice); //----------------------
+	}
+	recordDecodeLatency(oPrepared.m_nDecodeStartUsec, oPrepared.m_nDecodeEndUsec);
+	return nALBuffer;
+}
+bool OpenAlBackend::openalLoadEncodedFile(const AlCommand& oCommand, PreparedPreload* p0Prepared) noexcept
+{
+	const std::string& sFileName = oCommand.m_sFileName;
+	const auto itFind = std::find_if(m_aEncodedFiles.begin(), m_aEncodedFiles.end()
+									, [&](const std::pair<std::string, std::vector<uint8_t>>& oPair)
+	{
+		return (oPair.first == sFileName);
+	});
+	if (itFind != m_aEncodedFiles.end()) {
+		// preloaded by another device
+		return true; //---------------------------------------------------------
+	}
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalLoadEncodedFile");
+	std::vector<uint8_t> aBytes;
+	if ((p0Prepared != nullptr) && p0Prepared->m_bRead) {
+		aBytes = std::move(p0Prepared->m_aBytes);
+	} else if (! readFileBytes(sFileName, aBytes)) {
+		openalSendError("Could not read file " + sFileName, oCommand);
+		return false; //--------------------------------------------------------
+	}
+	m_nEncodedBytes += static_cast<int64_t>(aBytes.size());
+	m_aEncodedFiles.emplace_back(sFileName, std::move(aBytes));
+	return true;
+}
+bool OpenAlBackend::getSoundBytes(const AlCommand& oCommand, const uint8_t*& p0Bytes, int32_t& nSize) const noexcept
+{
+	if (oCommand.m_p0Buffer != nullptr) {
+		p0Bytes = oCommand.m_p0Buffer;
+		nSize = oCommand.m_nBufferSize;
+		return true; //---------------------------------------------------------
+	}
+	const auto itFind = std::find_if(m_aEncodedFiles.begin(), m_aEncodedFiles.end()
+									, [&](const std::pair<std::string, std::vector<uint8_t>>& oPair)
+	{
+		return (oPair.first == oCommand.m_sFileName);
+	});
+	if (itFind == m_aEncodedFiles.end()) {
+		return false; //--------------------------------------------------------
+	}
+	p0Bytes = itFind->second.data();
+	nSize = static_cast<int32_t>(itFind->second.size());
+	return true;
+}
+bool OpenAlBackend::openalShouldStream(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept
+{
+	const int32_t nThreshold = getStreamingThreshold();
+	if ((nThreshold < 0) || m_bOffline) {
+		// the offline backend detects finished sources itself, without alureUpdate()
+		return false; //--------------------------------------------------------
+	}
+	if ((oCommand.m_nStartClockNanosec >= 0) || (oCommand.m_nTriggerSlot >= 0)) {
+		// scheduled and prepared sounds are started with alSourcePlay(v), not by alure
+		return false; //--------------------------------------------------------
+	}
+	if ((findFileBuffer(oAlDevice.m_aFileToBufferId, oCommand.m_nFileId) != oAlDevice.m_aFileToBufferId.end())
+			|| (findFileBuffer(oAlDevice.m_aFileToMonoBufferId, oCommand.m_nFileId) != oAlDevice.m_aFileToMonoBufferId.end())) {
+		return false; //--------------------------------------------------------
+	}
+	const uint8_t* p0Bytes;
+	int32_t nSize;
+	if (getSoundBytes(oCommand, p0Bytes, nSize)) {
+		return (nSize >= nThreshold); //----------------------------------------
+	}
+	std::ifstream oFile(oCommand.m_sFileName, std::ios::in | std::ios::binary | std::ios::ate);
+	if (! oFile.is_open()) {
+		// let alure report the error
+		return false; //--------------------------------------------------------
+	}
+	return (static_cast<int64_t>(oFile.tellg()) >= nThreshold);
+}
+alureStream* OpenAlBackend::openalCreateStream(const AlCommand& oCommand) noexcept
+{
+	const int64_t nDecodeStartUsec = (isLatencyEnabled() ? getSteadyTimeUsec() : -1);
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalCreateStream");
+	const uint8_t* p0Bytes;
+	int32_t nSize;
+	alureStream* p0Stream;
+	if (getSoundBytes(oCommand, p0Bytes, nSize)) {
+		// buffers must stay valid while played and encoded files are never removed
+		p0Stream = ::alureCreateStreamFromStaticMemory(static_cast<const ALubyte*>(p0Bytes), static_cast<ALuint>(nSize)
+														, s_nStreamChunkBytes, 0, nullptr);
 	} else {
-		nALBuffer = ::alureCreateBufferFromMemory(static_cast<ALubyte*>(const_cast<uint8_t*>(oCommand.m_p0Buffer))
-												, static_cast<ALsizei>(oCommand.m_nBufferSize));
+		p0Stream = ::alureCreateStreamFromFile(oCommand.m_sFileName.c_str(), s_nStreamChunkBytes, 0, nullptr);
+	}
+	if (p0Stream == nullptr) {
+		openalSendError(::alureGetErrorString(), oCommand);
+		return nullptr; //------------------------------------------------------
+	}
+	recordDecodeLatency(nDecodeStartUsec, getSteadyTimeUsec());
+	return p0Stream;
+}
+void OpenAlBackend::openalDestroyStream(ActiveSound& oActiveSound) noexcept
+{
+	if (oActiveSound.m_p0Stream == nullptr) {
+		return; //--------------------------------------------------------------
+	}
+	// the source must have been stopped and its buffers unqueued
+	::alureDestroyStream(oActiveSound.m_p0Stream, 0, nullptr);
+	oActiveSound.m_p0Stream = nullptr;
+}
+void OpenAlBackend::openalEvictBuffers(AlDevice& oAlDevice, ALuint nKeepALBuffer) noexcept
+{
+	BufferBudget& oBufferBudget = oAlDevice.m_oBufferBudget;
+	oBufferBudget.setLimits(getDecodedBufferBudgetBuffers(), getDecodedBufferBudgetBytes());
+	const auto& aActiveSounds = oAlDevice.m_aActiveSounds;
+	auto isInUse = [&](uint32_t nALBuffer) -> bool
+	{
+		if (nALBuffer == nKeepALBuffer) {
+			return true;
+		}
+		return std::any_of(aActiveSounds.begin(), aActiveSounds.end(), [&](const ActiveSound& oActiveSound)
+		{
+			return (oActiveSound.m_nALBuffer == nALBuffer);
+		});
+	};
+	auto& aFileToBufferId = oAlDevice.m_aFileToBufferId;
+	auto& aFileToMonoBufferId = oAlDevice.m_aFileToMonoBufferId;
+	auto isBuffer = [](ALuint nALBuffer)
+	{
+		return [nALBuffer](const std::pair<int32_t, ALuint>& oPair)
+		{
+			return (oPair.second == nALBuffer);
+		};
+	};
+	while (true) {
+		const ALuint nALBuffer = oBufferBudget.getEvictable(isInUse);
 		if (nALBuffer == AL_NONE) {
-			openalSendError(::alureGetErrorString(), oCommand);
-			return; //------------------------------------------------------
+			break;
 		}
+		ALint nSize = 0;
+		::alGetBufferi(nALBuffer, AL_SIZE, &nSize);
+		const auto itFind = std::find_if(aFileToBufferId.begin(), aFileToBufferId.end(), isBuffer(nALBuffer));
+		if (itFind != aFileToBufferId.end()) {
+			const auto itFindMono = findFileBuffer(aFileToMonoBufferId, itFind->first);
+			if (itFindMono != aFileToMonoBufferId.end()) {
+				// the mono version is left alone
+				ALint nMonoSize = 0;
+				::alGetBufferi(itFindMono->second, AL_SIZE, &nMonoSize);
+				oAlDevice.m_nDownmixSavedBytes += nMonoSize;
+			}
+			aFileToBufferId.erase(itFind);
+		} else {
+			const auto itFindMono = std::find_if(aFileToMonoBufferId.begin(), aFileToMonoBufferId.end(), isBuffer(nALBuffer));
+			assert(itFindMono != aFileToMonoBufferId.end());
+			if (findFileBuffer(aFileToBufferId, itFindMono->first) == aFileToBufferId.end()) {
+				oAlDevice.m_nDownmixSavedBytes -= nSize;
+			}
+			aFileToMonoBufferId.erase(itFindMono);
+		}
+		oAlDevice.m_nBufferBytes -= nSize;
+		oBufferBudget.remove(nALBuffer);
+		::alDeleteBuffers(1, &nALBuffer);
+		++oAlDevice.m_nEvictedBuffers;
+	}
+}
+ALuint OpenAlBackend::openalCreateNativeBuffer(const AlCommand& oCommand, const AlDevice& oAlDevice
+												, bool bDownmix, bool& bDownmixed) noexcept
+{
+	bDownmixed = false;
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalNativeConversion");
+	const uint8_t* p0Bytes;
+	int32_t nSize;
+	if (! getSoundBytes(oCommand, p0Bytes, nSize)) {
+		p0Bytes = nullptr;
+		nSize = 0;
+	}
+	PcmDiskCache::Data oData;
+	// buffers are not cached
+	const std::string sFileName = ((oCommand.m_p0Buffer == nullptr) ? oCommand.m_sFileName : std::string{});
+	if (! prepareNativeSound(getNativeTarget(oAlDevice), sFileName, p0Bytes, nSize, bDownmix
+							, m_oNativeScratch, oData)) {
+		// not a PCM WAV: let alure decode it (and report errors)
+		return AL_NONE; //------------------------------------------------------
+	}
+	const ALuint nALBuffer = openalUploadBuffer(oData);
+	m_oNativeScratch.m_oMapping.release();
+	if (nALBuffer != AL_NONE) {
+		bDownmixed = oData.m_bDownmixed;
 	}
-	aFileToBufferId.emplace_back(oCommand.m_nFileId, nALBuffer);
+	return nALBuffer;
 }
-void Backend::openalPlay(const AlCommand& oCommand) noexcept
+bool OpenAlBackend::prepareNativeSound(const NativeTarget& oTarget, const std::string& sFileName
+										, const uint8_t* p0Bytes, int32_t nSize, bool bDownmix
+										, NativeScratch& oScratch, PcmDiskCache::Data& oData) noexcept
 {
-//std::cout << "Backend::openalPlay   oCommand.m_nBackendDeviceId = " << oCommand.m_nBackendDeviceId << '\n';
+	oScratch.m_oMapping.release();
+	PcmDiskCache::Key oKey;
+	const bool bUseCache = (! oTarget.m_sCacheDirectory.empty()) && (! sFileName.empty())
+							&& PcmDiskCache::getFileKey(sFileName, oKey);
+	if (bUseCache) {
+		oKey.m_nOptions = (bDownmix ? 1 : 0) | (oTarget.m_nSampleFormat << 1) | (oTarget.m_nBlockFrames << 8);
+		oKey.m_nTargetFrequency = oTarget.m_nFrequency;
+		if (PcmDiskCache::lookup(oTarget.m_sCacheDirectory, oKey, oScratch.m_oMapping)) {
+			oData = oScratch.m_oMapping.getData();
+			return true; //-----------------------------------------------------
+		}
+	}
+	PcmSound& oSound = oScratch.m_oSound;
+	const std::string sErr = ((p0Bytes != nullptr)
+							? WavDecoder::decode(p0Bytes, nSize, oSound)
+							: WavDecoder::decodeFile(sFileName, oSound));
+	if (! sErr.empty()) {
+		return false; //--------------------------------------------------------
+	}
+	bool bDownmixed = false;
+	if (bDownmix && (oSound.m_nChannels == 2)) {
+		// OpenAL doesn't spatialize multi-channel buffers
+		// down-mix before resampling: half the work
+		PcmConverter::downmixToMono(oSound);
+		bDownmixed = true;
+	}
+	if (oTarget.m_nFrequency > 0) {
+		// OpenAL would otherwise resample each time the sound is mixed
+		PcmConverter::resample(oSound, oTarget.m_nFrequency);
+	}
+	encodeNativeSound(oTarget, oScratch, oData);
+	oData.m_bDownmixed = bDownmixed;
+	if (bUseCache) {
+		// the cache is just an optimization: if it can't be written the sound is decoded next time
+		PcmDiskCache::store(oTarget.m_sCacheDirectory, oKey, oData);
+	}
+	return true;
+}
+int32_t OpenAlBackend::getNativeSampleFormat(const AlDevice& oAlDevice, int32_t& nBlockFrames) const noexcept
+{
+	nBlockFrames = 0;
+	const int32_t nFormat = getCompressedSampleFormat();
+	if ((nFormat == OpenAlDeviceManager::SAMPLE_FORMAT_IMA4) && oAlDevice.m_bIma4) {
+		nBlockFrames = (oAlDevice.m_bBlockAlignment ? s_nIma4AlignedBlockFrames : s_nIma4DefaultBlockFrames);
+		return nFormat; //------------------------------------------------------
+	}
+	if ((nFormat == OpenAlDeviceManager::SAMPLE_FORMAT_MULAW) && oAlDevice.m_bMulaw) {
+		return nFormat; //------------------------------------------------------
+	}
+	return OpenAlDeviceManager::SAMPLE_FORMAT_PCM16;
+}
+OpenAlBackend::NativeTarget OpenAlBackend::getNativeTarget(const AlDevice& oAlDevice) const noexcept
+{
+	NativeTarget oTarget;
+	oTarget.m_nFrequency = (isNativeFormatConversion() ? oAlDevice.m_nFrequency : 0);
+	oTarget.m_nSampleFormat = getNativeSampleFormat(oAlDevice, oTarget.m_nBlockFrames);
+	oTarget.m_sCacheDirectory = getPcmDiskCacheDirectory();
+	return oTarget;
+}
+void OpenAlBackend::encodeNativeSound(const NativeTarget& oTarget, NativeScratch& oScratch, PcmDiskCache::Data& oData) noexcept
+{
+	const PcmSound& oSound = oScratch.m_oSound;
+	const bool bStereo = (oSound.m_nChannels == 2);
+	oData.m_nFrequency = oSound.m_nFrequency;
+	oData.m_nBlockFrames = oTarget.m_nBlockFrames;
+	const int32_t nFormat = oTarget.m_nSampleFormat;
+	if (nFormat == OpenAlDeviceManager::SAMPLE_FORMAT_IMA4) {
+		PcmEncoder::encodeIma4(oSound, oData.m_nBlockFrames, oScratch.m_aEncoded);
+		oData.m_nFormat = (bStereo ? AL_FORMAT_STEREO_IMA4 : AL_FORMAT_MONO_IMA4);
+		oData.m_p0Data = oScratch.m_aEncoded.data();
+		oData.m_nDataSize = static_cast<int32_t>(oScratch.m_aEncoded.size());
+	} else if (nFormat == OpenAlDeviceManager::SAMPLE_FORMAT_MULAW) {
+		PcmEncoder::encodeMulaw(oSound, oScratch.m_aEncoded);
+		oData.m_nFormat = (bStereo ? AL_FORMAT_STEREO_MULAW_EXT : AL_FORMAT_MONO_MULAW_EXT);
+		oData.m_p0Data = oScratch.m_aEncoded.data();
+		oData.m_nDataSize = static_cast<int32_t>(oScratch.m_aEncoded.size());
+	} else {
+		const int32_t nTotSamples = static_cast<int32_t>(oSound.m_aSamples.size());
+		oScratch.m_aSamples.resize(nTotSamples);
+		MixerKernel::get().m_p0ToInt16(oSound.m_aSamples.data(), nTotSamples, oScratch.m_aSamples.data());
+		oData.m_nFormat = (bStereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16);
+		oData.m_p0Data = reinterpret_cast<const uint8_t*>(oScratch.m_aSamples.data());
+		oData.m_nDataSize = static_cast<int32_t>(nTotSamples * sizeof(int16_t));
+	}
+}
+ALuint OpenAlBackend::openalUploadBuffer(const PcmDiskCache::Data& oData) noexcept
+{
+	::alGetError();
+	ALuint nALBuffer = AL_NONE;
+	::alGenBuffers(1, &nALBuffer);
+	if (::alGetError() != AL_NO_ERROR) {
+		return AL_NONE; //------------------------------------------------------
+	}
+	if ((oData.m_nBlockFrames > 0) && (oData.m_nBlockFrames != s_nIma4DefaultBlockFrames)) {
+		::alBufferi(nALBuffer, AL_UNPACK_BLOCK_ALIGNMENT_SOFT, oData.m_nBlockFrames);
+	}
+	::alBufferData(nALBuffer, static_cast<ALenum>(oData.m_nFormat), oData.m_p0Data, static_cast<ALsizei>(oData.m_nDataSize)
+					, static_cast<ALsizei>(oData.m_nFrequency));
+	if (::alGetError() != AL_NO_ERROR) {
+		::alDeleteBuffers(1, &nALBuffer);
+		return AL_NONE; //------------------------------------------------------
+	}
+	return nALBuffer;
+}
+void OpenAlBackend::openalPlay(const AlCommand& oCommand) noexcept
+{
+//std::cout << "OpenAlBackend::openalPlay   oCommand.m_nBackendDeviceId = " << oCommand.m_nBackendDeviceId << '\n';
 	{
 		// No idea why this is needed but when playing the same sound (file) on two different
 		// devices alGetError returns AL_INVALID_NAME for the scond play
@@ -405,40 +1055,25 @@ void Backend::openalPlay(const AlCommand& oCommand) noexcept
 		//const ALenum nErr =
 		::alGetError(); // reset error so that alureCreateBufferFromFile doesn't fail
 		//if (nErr != AL_NO_ERROR) {
-		//	std::cout << "Backend::openalPlay   lingering error: " << nErr << '\n';
+		//	std::cout << "OpenAlBackend::openalPlay   lingering error: " << nErr << '\n';
 		//}
 	}
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
-	// get or create buffer
-	ALuint nALBuffer;
-	{
-	auto& aFileToBufferId = oAlDevice.m_aFileToBufferId;
-	const auto itFind = std::find_if(aFileToBufferId.begin(), aFileToBufferId.end(), [&](const std::pair<int32_t, ALuint>& oPair)
-	{
-		return (oPair.first == oCommand.m_nFileId);
-	});
-	if (itFind == aFileToBufferId.end()) {
-		// first time this file is played
-		// create AL buffer
-		if (oCommand.m_p0Buffer == nullptr) {
-//std::cout << "Backend::openalPlay   alureCreateBufferFromFile = " << oCommand.m_sFileName << '\n';
-			nALBuffer = ::alureCreateBufferFromFile(oCommand.m_sFileName.c_str());
-			if (nALBuffer == AL_NONE) {
-				openalSendError(::alureGetErrorString(), oCommand);
-				return; //------------------------------------------------------
-			}
-		} else {
-			nALBuffer = ::alureCreateBufferFromMemory(static_cast<ALubyte*>(const_cast<uint8_t*>(oCommand.m_p0Buffer))
-													, static_cast<ALsizei>(oCommand.m_nBufferSize));
-			if (nALBuffer == AL_NONE) {
-				openalSendError(::alureGetErrorString(), oCommand);
-				return; //------------------------------------------------------
-			}
+	alureStream* p0Stream = nullptr;
+	ALuint nALBuffer = AL_NONE;
+	if (openalShouldStream(oCommand, oAlDevice)) {
+		p0Stream = openalCreateStream(oCommand);
+		if (p0Stream == nullptr) {
+			return; //----------------------------------------------------------
 		}
-		aFileToBufferId.emplace_back(oCommand.m_nFileId, nALBuffer);
 	} else {
-		nALBuffer = itFind->second;
-	}
+		// get or create buffer
+		nALBuffer = openalGetPlayBuffer(oCommand, oAlDevice);
+		if (nALBuffer == AL_NONE) {
+			releaseTriggerSlot(oCommand.m_nTriggerSlot);
+			return; //----------------------------------------------------------
+		}
+		oAlDevice.m_oBufferBudget.touch(nALBuffer);
 	}
 	// get or create source
 	ALuint nSourceId;
@@ -460,7 +1095,7 @@ void Backend::openalPlay(const AlCommand& oCommand) noexcept
 		if (nErr != AL_NO_ERROR) {
 			//openalSendError(::alureGetErrorString(), oCommand);
 			//return; //----------------------------------------------------------
-			std::cout << "Backend::openalPlay   alGenSources error: " << nErr << '\n';
+			std::cout << "OpenAlBackend::openalPlay   alGenSources error: " << nErr << '\n';
 		}
 	} else {
 		nSourceId = aUnusedSourceIds.back();
@@ -476,47 +1111,67 @@ void Backend::openalPlay(const AlCommand& oCommand) noexcept
 		}
 		return fVolume;
 	}(oCommand.m_fVolume);
-	::alSourcef(nSourceId, AL_GAIN, fVolume);
-	::alSourcei(nSourceId, AL_LOOPING, (oCommand.m_bLoop ? AL_TRUE : AL_FALSE));
+	::alSourcef(nSourceId, AL_GAIN, fVolume * getSoundGroupVolume(oAlDevice.m_aSoundGroups, oCommand.m_nGroupId));
+	// alure loops streams itself
+	::alSourcei(nSourceId, AL_LOOPING, ((oCommand.m_bLoop && (p0Stream == nullptr)) ? AL_TRUE : AL_FALSE));
 	::alSourcei(nSourceId, AL_SOURCE_RELATIVE, (oCommand.m_bRelative ? AL_TRUE : AL_FALSE));
 	::alSource3f(nSourceId, AL_POSITION, clamp(oCommand.m_fPosX), clamp(oCommand.m_fPosY), clamp(oCommand.m_fPosZ));
-	::alSourcei(nSourceId, AL_BUFFER, nALBuffer);
-	{
+	if (p0Stream == nullptr) {
+		::alSourcei(nSourceId, AL_BUFFER, nALBuffer);
 		const ALenum nErr = ::alGetError();
 		if (nErr != AL_NO_ERROR) {
-			std::cout << "Backend::openalPlay   assigning buffer to source error: " << nErr << '\n';
+			std::cout << "OpenAlBackend::openalPlay   assigning buffer to source error: " << nErr << '\n';
 		}
 	}
 
 	ActiveSound oActiveSound;
 	oActiveSound.m_nSoundId = oCommand.m_nSoundId;
 	oActiveSound.m_nALSourceId = nSourceId;
+	oActiveSound.m_nALBuffer = nALBuffer;
+	oActiveSound.m_p0Stream = p0Stream;
+	oActiveSound.m_bLoop = oCommand.m_bLoop;
 	oActiveSound.m_bPaused = false;
 	oActiveSound.m_bStartedWhenDevicePaused = oAlDevice.m_bDevicePaused;
+	if (p0Stream == nullptr) {
+		oActiveSound.m_fLengthSec = openalGetBufferLengthSec(oAlDevice, nALBuffer);
+	}
+	oActiveSound.m_nGroupId = oCommand.m_nGroupId;
+	oActiveSound.m_fVolume = fVolume;
+	oActiveSound.m_fPosX = oCommand.m_fPosX;
+	oActiveSound.m_fPosY = oCommand.m_fPosY;
+	oActiveSound.m_fPosZ = oCommand.m_fPosZ;
 	aActiveSounds.emplace_back(std::move(oActiveSound));
 	}
 
 	// prepare the finished event
-	AlEvent& oAlEvent = getSoundFinishedAlEvent(oCommand);
-	//#ifndef NDEBUG
-	const ALboolean bRet = ::alurePlaySource(nSourceId, openalSoundFinishedCallback, &oAlEvent);
-	if (bRet == AL_FALSE) {
-		std::cout << "Backend::openalPlay   alurePlaySource error: " << ::alureGetErrorString() << '\n';
+	ToFinishAlEvent& oToFinishAlEvent = getSoundFinishedAlEvent(oCommand);
+	ActiveSound& oNewActiveSound = oAlDevice.m_aActiveSounds.back();
+	oNewActiveSound.m_p0ToFinishAlEvent = &oToFinishAlEvent;
+	if ((oCommand.m_nStartClockNanosec >= 0) || (oCommand.m_nTriggerSlot >= 0)) {
+		// started by openalStartDueSounds() or openalStartTriggeredSounds()
+		oNewActiveSound.m_nStartClockNanosec = oCommand.m_nStartClockNanosec;
+		oNewActiveSound.m_nTriggerSlot = oCommand.m_nTriggerSlot;
+		oNewActiveSound.m_bCheckFinished = true;
+		return; //--------------------------------------------------------------
+	}
+	openalPlaySource(oNewActiveSound);
+	if (isSoundGroupPaused(oAlDevice.m_aSoundGroups, oCommand.m_nGroupId)) {
+		::alurePauseSource(nSourceId);
 	}
 	//{
 	//	const ALenum nErr = ::alGetError();
 	//	if (nErr != AL_NO_ERROR) {
-	//		std::cout << "Backend::openalPlay   alurePlaySource error: " << nErr << '\n';
+	//		std::cout << "OpenAlBackend::openalPlay   alurePlaySource error: " << nErr << '\n';
 	//	}
 	//}
 }
-Backend::AlDevice& Backend::getActiveDevice(int32_t nDeviceId) noexcept
+OpenAlBackend::AlDevice& OpenAlBackend::getActiveDevice(int32_t nDeviceId) noexcept
 {
 	assert(nDeviceId >= 0);
 	assert(nDeviceId < static_cast<int32_t>(m_aAlDevices.size()));
 	AlDevice& oAlDevice = m_aAlDevices[nDeviceId];
 	ALCcontext* p0Context = oAlDevice.m_pContext;
-	::alcMakeContextCurrent(p0Context);
+	openalMakeContextCurrent(p0Context);
 	//#ifndef NDEBUG
 	//const auto nErr = ::alcGetError(oAlDevice.m_pDevice);
 	//if (nErr != ALC_NO_ERROR) {
@@ -525,7 +1180,13 @@ Backend::AlDevice& Backend::getActiveDevice(int32_t nDeviceId) noexcept
 	//#endif //NDEBUG
 	return oAlDevice;
 }
-std::vector<Backend::ActiveSound>::iterator Backend::getActiveSoundIt(int32_t nSoundId, AlDevice& oAlDevice) noexcept
+int32_t OpenAlBackend::getDeviceId(const AlDevice& oAlDevice) const noexcept
+{
+	const int32_t nDeviceId = static_cast<int32_t>(std::distance(m_aAlDevices.data(), &oAlDevice));
+	assert((nDeviceId >= 0) && (nDeviceId < static_cast<int32_t>(m_aAlDevices.size())));
+	return nDeviceId;
+}
+std::vector<OpenAlBackend::ActiveSound>::iterator OpenAlBackend::getActiveSoundIt(int32_t nSoundId, AlDevice& oAlDevice) noexcept
 {
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
 	const auto itFind = std::find_if(aActiveSounds.begin(), aActiveSounds.end(), [&](const ActiveSound& oActiveSound)
@@ -534,7 +1195,7 @@ std::vector<Backend::ActiveSound>::iterator Backend::getActiveSoundIt(int32_t nS
 	});
 	return itFind;
 }
-Backend::ActiveSound* Backend::getActiveSound(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept
+OpenAlBackend::ActiveSound* OpenAlBackend::getActiveSound(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept
 {
 	auto itFind = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
@@ -543,7 +1204,7 @@ Backend::ActiveSound* Backend::getActiveSound(const AlCommand& oCommand, AlDevic
 	}
 	return &(*itFind);
 }
-void Backend::openalPause(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalPause(const AlCommand& oCommand) noexcept
 {
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	ActiveSound* p0ActiveSound = getActiveSound(oCommand, oAlDevice);
@@ -554,12 +1215,13 @@ void Backend::openalPause(const AlCommand& oCommand) noexcept
 	if (oActiveSound.m_bPaused) {
 		return; //--------------------------------------------------------------
 	}
+	const bool bWasAudible = isSoundAudible(oAlDevice, oActiveSound);
 	oActiveSound.m_bPaused = true;
-	if ((! oAlDevice.m_bDevicePaused) || oActiveSound.m_bStartedWhenDevicePaused) {
+	if (bWasAudible) {
 		::alurePauseSource(oActiveSound.m_nALSourceId);
 	}
 }
-void Backend::openalResume(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalResume(const AlCommand& oCommand) noexcept
 {
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	ActiveSound* p0ActiveSound = getActiveSound(oCommand, oAlDevice);
@@ -571,13 +1233,15 @@ void Backend::openalResume(const AlCommand& oCommand) noexcept
 		return; //--------------------------------------------------------------
 	}
 	oActiveSound.m_bPaused = false;
-	if ((! oAlDevice.m_bDevicePaused) || oActiveSound.m_bStartedWhenDevicePaused) {
-		::alureResumeSource(oActiveSound.m_nALSourceId);
+	if (isSoundAudible(oAlDevice, oActiveSound)) {
+		openalResumeSource(oActiveSound);
 	}
 }
-void Backend::removeActiveSound(std::vector<ActiveSound>& aActiveSounds, std::vector<ActiveSound>::iterator itActiveSound) noexcept
+void OpenAlBackend::removeActiveSound(std::vector<ActiveSound>& aActiveSounds, std::vector<ActiveSound>::iterator itActiveSound) noexcept
 {
 	//oAlDevice.m_aActiveSounds.erase(itActiveSound);
+	// a prepared sound might be removed before being triggered
+	releaseTriggerSlot(itActiveSound->m_nTriggerSlot);
 	const int32_t nTotIdxs = static_cast<int32_t>(aActiveSounds.size());
 	const int32_t nIdx = std::distance(aActiveSounds.begin(), itActiveSound);
 	if (nIdx < nTotIdxs - 1) {
@@ -592,17 +1256,15 @@ nSourceIdCheck
 ) noexcept
 {
 //std::cout << "openalSoundFinishedCallback" << '\n';
-	Backend::AlEvent& oAlEvent = *(static_cast<Backend::AlEvent*>(p0AlEvent));
+	OpenAlBackend::ToFinishAlEvent& oToFinishAlEvent = *(static_cast<OpenAlBackend::ToFinishAlEvent*>(p0AlEvent));
+	Backend::AlEvent& oAlEvent = oToFinishAlEvent.m_oAlEvent;
 	const int64_t nDeviceId = oAlEvent.m_nBackendDeviceId;
 	const int32_t nSoundId = oAlEvent.m_nSoundId;
-	Backend* p0This = oAlEvent.m_p0Backend;
+	OpenAlBackend* p0This = oToFinishAlEvent.m_p0Backend;
 	// send finished event
-	{
-		std::lock_guard<std::mutex> oLock(p0This->m_oAlEventMutex);
-		p0This->m_aAlEvents.push_back(std::move(oAlEvent));
-	}
+	p0This->sendEvent(std::move(oAlEvent));
 	//
-	Backend::AlDevice& oAlDevice = p0This->m_aAlDevices[nDeviceId];
+	OpenAlBackend::AlDevice& oAlDevice = p0This->m_aAlDevices[nDeviceId];
 	// remove from active sounds
 	auto itFind = p0This->getActiveSoundIt(nSoundId, oAlDevice);
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
@@ -613,15 +1275,17 @@ nSourceIdCheck
 
 	// detach buffer from source
 	::alSourcei(nSourceId, AL_BUFFER, 0);
+	p0This->openalDestroyStream(oActiveSound);
 	// recycle source
 	auto& aUnusedSourceIds = oAlDevice.m_aUnusedSourceIds;
 	aUnusedSourceIds.push_back(nSourceId);
 	// recycle moved from event
 	oAlEvent.m_eType = Backend::AL_EVENT_INVALID;
 	//
+	p0This->publishSoundRemoved(nDeviceId, nSoundId, true);
 	p0This->removeActiveSound(aActiveSounds, itFind);
 }
-void Backend::openalStop(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalStop(const AlCommand& oCommand) noexcept
 {
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	auto itActiveSound = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
@@ -630,22 +1294,30 @@ void Backend::openalStop(const AlCommand& oCommand) noexcept
 		// already stopped
 		return; //--------------------------------------------------------------
 	}
+	openalStopActiveSound(oAlDevice, itActiveSound);
+}
+void OpenAlBackend::openalStopActiveSound(AlDevice& oAlDevice, std::vector<ActiveSound>::iterator itActiveSound) noexcept
+{
 	auto& oActiveSound = *itActiveSound;
 
 	const ALuint nSourceId = oActiveSound.m_nALSourceId;
 	::alureStopSource(nSourceId, AL_FALSE);
+	// the finished callback won't be called
+	recycleToFinishAlEvent(oActiveSound);
 
 	// detach buffer from source
 	::alSourcei(nSourceId, AL_BUFFER, 0);
+	openalDestroyStream(oActiveSound);
 	// recycle source
 	auto& aUnusedSourceIds = oAlDevice.m_aUnusedSourceIds;
 	aUnusedSourceIds.push_back(nSourceId);
 
-	removeActiveSound(aActiveSounds, itActiveSound);
+	publishSoundRemoved(getDeviceId(oAlDevice), oActiveSound.m_nSoundId, false);
+	removeActiveSound(oAlDevice.m_aActiveSounds, itActiveSound);
 }
-void Backend::openalPauseDevice(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalPauseDevice(const AlCommand& oCommand) noexcept
 {
-//std::cout << "Backend::openalPauseDevice" << '\n';
+//std::cout << "OpenAlBackend::openalPauseDevice" << '\n';
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	if (oAlDevice.m_bDevicePaused) {
 		// already paused
@@ -653,15 +1325,15 @@ void Backend::openalPauseDevice(const AlCommand& oCommand) noexcept
 	}
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
 	for (auto& oActiveSound : aActiveSounds) {
-		if (! oActiveSound.m_bPaused) {
+		if (isSoundAudible(oAlDevice, oActiveSound)) {
 			::alurePauseSource(oActiveSound.m_nALSourceId);
 		}
 	}
 	oAlDevice.m_bDevicePaused = true;
 }
-void Backend::openalResumeDevice(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalResumeDevice(const AlCommand& oCommand) noexcept
 {
-//std::cout << "Backend::openalResumeDevice" << '\n';
+//std::cout << "OpenAlBackend::openalResumeDevice" << '\n';
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	if (! oAlDevice.m_bDevicePaused) {
 		// not paused
@@ -671,7 +1343,9 @@ void Backend::openalResumeDevice(const AlCommand& oCommand) noexcept
 	for (auto& oActiveSound : aActiveSounds) {
 		if (! oActiveSound.m_bPaused) {
 			if (! oActiveSound.m_bStartedWhenDevicePaused) {
-				::alureResumeSource(oActiveSound.m_nALSourceId);
+				if (! isSoundGroupPaused(oAlDevice.m_aSoundGroups, oActiveSound.m_nGroupId)) {
+					openalResumeSource(oActiveSound);
+				}
 			} else {
 				oActiveSound.m_bStartedWhenDevicePaused = false;
 			}
@@ -679,28 +1353,41 @@ void Backend::openalResumeDevice(const AlCommand& oCommand) noexcept
 	}
 	oAlDevice.m_bDevicePaused = false;
 }
-void Backend::openalStopAll(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalStopAll(const AlCommand& oCommand) noexcept
 {
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
 	while (! aActiveSounds.empty()) {
-		ActiveSound& oActiveSound = aActiveSounds[0];
-		//
-		const ALuint nSourceId = oActiveSound.m_nALSourceId;
-		::alureStopSource(nSourceId, AL_FALSE);
-
-		// detach buffer from source
-		::alSourcei(nSourceId, AL_BUFFER, 0);
-		// recycle source
-		auto& aUnusedSourceIds = oAlDevice.m_aUnusedSourceIds;
-		aUnusedSourceIds.push_back(nSourceId);
+		openalStopActiveSound(oAlDevice, aActiveSounds.begin());
+	}
+}
+void OpenAlBackend::openalSoundPos(const AlCommand& oCommand) noexcept
+{
+//std::cout << "OpenAlBackend::openalSoundPos   oCommand.m_nBackendDeviceId = " << oCommand.m_nBackendDeviceId << '\n';
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	auto itActiveSound = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
+	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
+	if (itActiveSound == aActiveSounds.end()) {
+		// already stopped
+		return; //--------------------------------------------------------------
+	}
+	auto& oActiveSound = *itActiveSound;
 
-		removeActiveSound(aActiveSounds, aActiveSounds.begin());
+	const ALuint nSourceId = oActiveSound.m_nALSourceId;
+	oActiveSound.m_fPosX = oCommand.m_fPosX;
+	oActiveSound.m_fPosY = oCommand.m_fPosY;
+	oActiveSound.m_fPosZ = oCommand.m_fPosZ;
+	::alSource3f(nSourceId, AL_POSITION, clamp(oCommand.m_fPosX), clamp(oCommand.m_fPosY), clamp(oCommand.m_fPosZ));
+//std::cout << "OpenAlBackend::openalSoundPos   oCommand.m_fPosX = " << oCommand.m_fPosX << '\n';
+//std::cout << "OpenAlBackend::openalSoundPos   oCommand.m_bRelative = " << oCommand.m_bRelative << '\n';
+	::alSourcei(nSourceId, AL_SOURCE_RELATIVE, (oCommand.m_bRelative ? AL_TRUE : AL_FALSE));
+	if (oActiveSound.m_oMotion.m_bMoving) {
+		oActiveSound.m_oMotion = SoundMotion{};
+		::alSource3f(nSourceId, AL_VELOCITY, 0.0f, 0.0f, 0.0f);
 	}
 }
-void Backend::openalSoundPos(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalSoundMotion(const AlCommand& oCommand) noexcept
 {
-//std::cout << "Backend::openalSoundPos   oCommand.m_nBackendDeviceId = " << oCommand.m_nBackendDeviceId << '\n';
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	auto itActiveSound = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
 	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
@@ -711,12 +1398,220 @@ void Backend::openalSoundPos(const AlCommand& oCommand) noexcept
 	auto& oActiveSound = *itActiveSound;
 
 	const ALuint nSourceId = oActiveSound.m_nALSourceId;
+	oActiveSound.m_fPosX = oCommand.m_fPosX;
+	oActiveSound.m_fPosY = oCommand.m_fPosY;
+	oActiveSound.m_fPosZ = oCommand.m_fPosZ;
+	startSoundMotion(oActiveSound.m_oMotion, oCommand, getAdvanceTimeUsec());
 	::alSource3f(nSourceId, AL_POSITION, clamp(oCommand.m_fPosX), clamp(oCommand.m_fPosY), clamp(oCommand.m_fPosZ));
-//std::cout << "Backend::openalSoundPos   oCommand.m_fPosX = " << oCommand.m_fPosX << '\n';
-//std::cout << "Backend::openalSoundPos   oCommand.m_bRelative = " << oCommand.m_bRelative << '\n';
+	::alSource3f(nSourceId, AL_VELOCITY, clamp(oCommand.m_fVelX), clamp(oCommand.m_fVelY), clamp(oCommand.m_fVelZ));
 	::alSourcei(nSourceId, AL_SOURCE_RELATIVE, (oCommand.m_bRelative ? AL_TRUE : AL_FALSE));
 }
-void Backend::openalSoundVol(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalAdvanceSounds() noexcept
+{
+	m_nStartWaitMillisec = -1;
+	for (AlDevice& oAlDevice : m_aAlDevices) {
+		if (oAlDevice.m_bDeviceRemoved) {
+			continue; // for oAlDevice ----
+		}
+		const bool bSomeAdvancing = std::any_of(oAlDevice.m_aActiveSounds.begin(), oAlDevice.m_aActiveSounds.end()
+												, [&](const ActiveSound& oActiveSound)
+		{
+			return oActiveSound.m_oMotion.m_bMoving || oActiveSound.m_oRamp.m_bRamping;
+		});
+		// the scheduled sounds aren't played by alure
+		const bool bSomeNotAlure = std::any_of(oAlDevice.m_aActiveSounds.begin(), oAlDevice.m_aActiveSounds.end()
+												, [&](const ActiveSound& oActiveSound)
+		{
+			return oActiveSound.m_bCheckFinished;
+		});
+		if (bSomeAdvancing || bSomeNotAlure) {
+			openalMakeContextCurrent(oAlDevice.m_pContext);
+		}
+		if (bSomeNotAlure) {
+			openalStartDueSounds(oAlDevice);
+			openalCheckFinishedSources(oAlDevice);
+		}
+		if (bSomeAdvancing) {
+			openalAdvanceDeviceSounds(oAlDevice);
+		}
+	}
+}
+void OpenAlBackend::openalAdvanceDeviceSounds(AlDevice& oAlDevice) noexcept
+{
+	const int64_t nNowUsec = getAdvanceTimeUsec();
+	openalDeferUpdates(oAlDevice);
+	for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		const ALuint nSourceId = oActiveSound.m_nALSourceId;
+		SoundMotion& oMotion = oActiveSound.m_oMotion;
+		if (advanceSoundMotion(oMotion, nNowUsec, oActiveSound.m_fPosX, oActiveSound.m_fPosY, oActiveSound.m_fPosZ)) {
+			::alSource3f(nSourceId, AL_POSITION, clamp(oActiveSound.m_fPosX), clamp(oActiveSound.m_fPosY), clamp(oActiveSound.m_fPosZ));
+			if (! oMotion.m_bMoving) {
+				// arrived
+				::alSource3f(nSourceId, AL_VELOCITY, 0.0f, 0.0f, 0.0f);
+			}
+		}
+		bool bStop;
+		if (advanceSoundRamp(oActiveSound.m_oRamp, nNowUsec, oActiveSound.m_fVolume, bStop)) {
+			::alSourcef(nSourceId, AL_GAIN, oActiveSound.m_fVolume * getSoundGroupVolume(oAlDevice.m_aSoundGroups, oActiveSound.m_nGroupId));
+			if (bStop) {
+				m_aFadedOutSoundIds.push_back(oActiveSound.m_nSoundId);
+			}
+		}
+	}
+	openalProcessUpdates(oAlDevice);
+	if (m_aFadedOutSoundIds.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	const int32_t nDeviceId = static_cast<int32_t>(std::distance(m_aAlDevices.data(), &oAlDevice));
+	for (const int32_t nSoundId : m_aFadedOutSoundIds) {
+		openalStopActiveSound(oAlDevice, getActiveSoundIt(nSoundId, oAlDevice));
+		AlEvent oAlEvent;
+		oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
+		oAlEvent.m_nBackendDeviceId = nDeviceId;
+		oAlEvent.m_nSoundId = nSoundId;
+		oAlEvent.m_bFadedOut = true;
+		sendEvent(std::move(oAlEvent));
+	}
+	m_aFadedOutSoundIds.clear();
+}
+void OpenAlBackend::openalStartDueSounds(AlDevice& oAlDevice) noexcept
+{
+	const int64_t nNowNanosec = openalGetDeviceClockNanosec(oAlDevice);
+	const bool bStartDelay = (oAlDevice.m_p0PlayAtTimev != nullptr);
+	for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		const int64_t nStartNanosec = oActiveSound.m_nStartClockNanosec;
+		if (nStartNanosec < 0) {
+			continue; // for oActiveSound ----
+		}
+		if ((nStartNanosec > nNowNanosec) && ! bStartDelay) {
+			const int32_t nWaitMillisec = static_cast<int32_t>(std::min<int64_t>((nStartNanosec - nNowNanosec) / 1000000
+																				, s_nBaseIntervalMillisec));
+			if ((m_nStartWaitMillisec < 0) || (nWaitMillisec < m_nStartWaitMillisec)) {
+				m_nStartWaitMillisec = nWaitMillisec;
+			}
+			continue; // for oActiveSound ----
+		}
+		oActiveSound.m_nStartClockNanosec = -1;
+		m_bSoundStatesChanged = true;
+		if (! isSoundAudible(oAlDevice, oActiveSound)) {
+			// starts when resumed
+			continue; // for oActiveSound ----
+		}
+		m_aStartingSources.emplace_back(nStartNanosec, oActiveSound.m_nALSourceId);
+	}
+	if (m_aStartingSources.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	if (bStartDelay) {
+		// OpenAL starts each group of sources with the same start time at the exact sample
+		std::sort(m_aStartingSources.begin(), m_aStartingSources.end());
+		auto itStarting = m_aStartingSources.begin();
+		while (itStarting != m_aStartingSources.end()) {
+			const int64_t nStartNanosec = itStarting->first;
+			m_aStartingSourceIds.clear();
+			while ((itStarting != m_aStartingSources.end()) && (itStarting->first == nStartNanosec)) {
+				m_aStartingSourceIds.push_back(itStarting->second);
+				++itStarting;
+			}
+			oAlDevice.m_p0PlayAtTimev(static_cast<ALsizei>(m_aStartingSourceIds.size()), m_aStartingSourceIds.data()
+									, static_cast<ALint64SOFT>(nStartNanosec));
+		}
+	} else {
+		// the sources of a single call start in the same mix
+		m_aStartingSourceIds.clear();
+		for (const auto& oStarting : m_aStartingSources) {
+			m_aStartingSourceIds.push_back(oStarting.second);
+		}
+		::alSourcePlayv(static_cast<ALsizei>(m_aStartingSourceIds.size()), m_aStartingSourceIds.data());
+	}
+	m_aStartingSources.clear();
+	m_aStartingSourceIds.clear();
+}
+int64_t OpenAlBackend::openalGetDeviceClockNanosec(const AlDevice& oAlDevice) const noexcept
+{
+	if (m_bLoopback) {
+		// split to avoid overflowing
+		const int64_t nFrequency = m_oLoopbackInit.m_nFrequency;
+		return (m_nLoopbackRenderedFrames / nFrequency) * 1000000000 + (m_nLoopbackRenderedFrames % nFrequency) * 1000000000 / nFrequency; //--
+	}
+	if (oAlDevice.m_p0GetInteger64v != nullptr) {
+		ALCint64SOFT nClockNanosec = 0;
+		oAlDevice.m_p0GetInteger64v(oAlDevice.m_pDevice, ALC_DEVICE_CLOCK_SOFT, 1, &nClockNanosec);
+		return static_cast<int64_t>(nClockNanosec); //--------------------------
+	}
+	return getSteadyTimeUsec() * 1000;
+}
+int32_t OpenAlBackend::getFramesToNextStart(const AlDevice& oAlDevice, int32_t nMaxFrames) const noexcept
+{
+	assert(m_bLoopback);
+	assert(nMaxFrames > 0);
+	const int64_t nFrequency = m_oLoopbackInit.m_nFrequency;
+	int64_t nFrames = nMaxFrames;
+	for (const auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		if (oActiveSound.m_nStartClockNanosec < 0) {
+			continue; // for oActiveSound ----
+		}
+		// the first frame whose time is not before the start
+		const int64_t nStartFrame = static_cast<int64_t>(std::ceil(static_cast<double>(oActiveSound.m_nStartClockNanosec)
+																	* nFrequency / 1000000000.0));
+		nFrames = std::min(nFrames, nStartFrame - m_nLoopbackRenderedFrames);
+	}
+	// due sounds are started before rendering
+	return static_cast<int32_t>(std::max<int64_t>(1, nFrames));
+}
+void OpenAlBackend::openalStartTriggeredSounds() noexcept
+{
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalStartTriggeredSounds");
+	for (AlDevice& oAlDevice : m_aAlDevices) {
+		if (oAlDevice.m_bDeviceRemoved) {
+			continue; // for oAlDevice ----
+		}
+		bool bContextCurrent = false;
+		for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+			if ((oActiveSound.m_nTriggerSlot < 0) || ! takeTrigger(oActiveSound.m_nTriggerSlot)) {
+				continue; // for oActiveSound ----
+			}
+			oActiveSound.m_nTriggerSlot = -1;
+			if (! isSoundAudible(oAlDevice, oActiveSound)) {
+				// starts when resumed
+				continue; // for oActiveSound ----
+			}
+			if (! bContextCurrent) {
+				openalMakeContextCurrent(oAlDevice.m_pContext);
+				bContextCurrent = true;
+			}
+			::alSourcePlay(oActiveSound.m_nALSourceId);
+		}
+	}
+}
+void OpenAlBackend::openalResumeSource(const ActiveSound& oActiveSound) noexcept
+{
+	if ((oActiveSound.m_nStartClockNanosec >= 0) || (oActiveSound.m_nTriggerSlot >= 0)) {
+		// started by openalStartDueSounds() or openalStartTriggeredSounds()
+		return; //--------------------------------------------------------------
+	}
+	::alureResumeSource(oActiveSound.m_nALSourceId);
+}
+void OpenAlBackend::openalSoundRamp(const AlCommand& oCommand) noexcept
+{
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	auto itActiveSound = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
+	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
+	if (itActiveSound == aActiveSounds.end()) {
+		// already stopped
+		return; //--------------------------------------------------------------
+	}
+	auto& oActiveSound = *itActiveSound;
+	startSoundRamp(oActiveSound.m_oRamp, oActiveSound.m_fVolume, oCommand, getAdvanceTimeUsec());
+}
+int64_t OpenAlBackend::getAdvanceTimeUsec() const noexcept
+{
+	if (m_bOffline) {
+		return m_nLoopbackRenderedFrames * 1000000 / m_oLoopbackInit.m_nFrequency; //--
+	}
+	return getSteadyTimeUsec();
+}
+void OpenAlBackend::openalSoundVol(const AlCommand& oCommand) noexcept
 {
 	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
 	auto itActiveSound = getActiveSoundIt(oCommand.m_nSoundId, oAlDevice);
@@ -737,17 +1632,19 @@ void Backend::openalSoundVol(const AlCommand& oCommand) noexcept
 		}
 		return fVolume;
 	}(oCommand.m_fVolume);
-	::alSourcef(nSourceId, AL_GAIN, fVolume);
+	oActiveSound.m_fVolume = fVolume;
+	oActiveSound.m_oRamp = SoundRamp{};
+	::alSourcef(nSourceId, AL_GAIN, fVolume * getSoundGroupVolume(oAlDevice.m_aSoundGroups, oActiveSound.m_nGroupId));
 }
-void Backend::openalListenerPos(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalListenerPos(const AlCommand& oCommand) noexcept
 {
 	// sets device context
 	getActiveDevice(oCommand.m_nBackendDeviceId);
 
 	::alListener3f(AL_POSITION, clamp(oCommand.m_fPosX), clamp(oCommand.m_fPosY), clamp(oCommand.m_fPosZ));
-//std::cout << "Backend::openalListenerPos  oCommand.m_fPosX =" << oCommand.m_fPosX << '\n';
+//std::cout << "OpenAlBackend::openalListenerPos  oCommand.m_fPosX =" << oCommand.m_fPosX << '\n';
 }
-void Backend::openalListenerVol(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalListenerVol(const AlCommand& oCommand) noexcept
 {
 	// sets device context
 	getActiveDevice(oCommand.m_nBackendDeviceId);
@@ -763,7 +1660,91 @@ void Backend::openalListenerVol(const AlCommand& oCommand) noexcept
 	}(oCommand.m_fVolume);
 	::alListenerf(AL_GAIN, fVolume);
 }
-	//void Backend::openalListenerDir(const AlCommand& oCommand) noexcept
+void OpenAlBackend::openalGroupVol(const AlCommand& oCommand) noexcept
+{
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	const double fVolume = [](double fVolume)
+	{
+		if (fVolume < 0.0) {
+			return 0.0;
+		} else if (fVolume > 1.0) {
+			return 1.0;
+		}
+		return fVolume;
+	}(oCommand.m_fVolume);
+	SoundGroup& oSoundGroup = getSoundGroup(oAlDevice.m_aSoundGroups, oCommand.m_nGroupId);
+	oSoundGroup.m_fVolume = fVolume;
+	openalDeferUpdates(oAlDevice);
+	for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		if (oActiveSound.m_nGroupId == oCommand.m_nGroupId) {
+			::alSourcef(oActiveSound.m_nALSourceId, AL_GAIN, oActiveSound.m_fVolume * fVolume);
+		}
+	}
+	openalProcessUpdates(oAlDevice);
+}
+void OpenAlBackend::openalPauseGroup(const AlCommand& oCommand) noexcept
+{
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	SoundGroup& oSoundGroup = getSoundGroup(oAlDevice.m_aSoundGroups, oCommand.m_nGroupId);
+	if (oSoundGroup.m_bPaused) {
+		// already paused
+		return; //--------------------------------------------------------------
+	}
+	openalDeferUpdates(oAlDevice);
+	for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		if ((oActiveSound.m_nGroupId == oCommand.m_nGroupId) && isSoundAudible(oAlDevice, oActiveSound)) {
+			::alurePauseSource(oActiveSound.m_nALSourceId);
+		}
+	}
+	openalProcessUpdates(oAlDevice);
+	oSoundGroup.m_bPaused = true;
+}
+void OpenAlBackend::openalResumeGroup(const AlCommand& oCommand) noexcept
+{
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	SoundGroup& oSoundGroup = getSoundGroup(oAlDevice.m_aSoundGroups, oCommand.m_nGroupId);
+	if (! oSoundGroup.m_bPaused) {
+		// not paused
+		return; //--------------------------------------------------------------
+	}
+	oSoundGroup.m_bPaused = false;
+	openalDeferUpdates(oAlDevice);
+	for (auto& oActiveSound : oAlDevice.m_aActiveSounds) {
+		if ((oActiveSound.m_nGroupId == oCommand.m_nGroupId) && isSoundAudible(oAlDevice, oActiveSound)) {
+			openalResumeSource(oActiveSound);
+		}
+	}
+	openalProcessUpdates(oAlDevice);
+}
+void OpenAlBackend::openalStopGroup(const AlCommand& oCommand) noexcept
+{
+	AlDevice& oAlDevice = getActiveDevice(oCommand.m_nBackendDeviceId);
+	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
+	openalDeferUpdates(oAlDevice);
+	auto itActiveSound = aActiveSounds.begin();
+	while (itActiveSound != aActiveSounds.end()) {
+		if (itActiveSound->m_nGroupId == oCommand.m_nGroupId) {
+			// the last sound is moved to itActiveSound
+			openalStopActiveSound(oAlDevice, itActiveSound);
+		} else {
+			++itActiveSound;
+		}
+	}
+	openalProcessUpdates(oAlDevice);
+}
+void OpenAlBackend::openalDeferUpdates(AlDevice& oAlDevice) noexcept
+{
+	if (oAlDevice.m_p0DeferUpdates != nullptr) {
+		oAlDevice.m_p0DeferUpdates();
+	}
+}
+void OpenAlBackend::openalProcessUpdates(AlDevice& oAlDevice) noexcept
+{
+	if (oAlDevice.m_p0ProcessUpdates != nullptr) {
+		oAlDevice.m_p0ProcessUpdates();
+	}
+}
+	//void OpenAlBackend::openalListenerDir(const AlCommand& oCommand) noexcept
 	//{
 	//	// sets device context
 	//	getActiveDevice(oCommand.m_nBackendDeviceId);
@@ -779,36 +1760,47 @@ void Backend::openalListenerVol(const AlCommand& oCommand) noexcept
 	//	//const std::array<ALfloat, 3> aDir{fDirX, fDirY, fDirZ};
 	//	::alListenerfv(AL_ORIENTATION, aDir.data());
 	//}
-Backend::AlEvent& Backend::getOrCreateAlEvent() noexcept
+OpenAlBackend::ToFinishAlEvent& OpenAlBackend::getOrCreateAlEvent() noexcept
 {
-	auto itFind = std::find_if(m_aToFinishAlEvents.begin(), m_aToFinishAlEvents.end(), [&](AlEvent& oAlEvent)
+	auto itFind = std::find_if(m_aToFinishAlEvents.begin(), m_aToFinishAlEvents.end(), [&](ToFinishAlEvent& oToFinishAlEvent)
 	{
-		return (oAlEvent.m_eType == AL_EVENT_INVALID);
+		return (oToFinishAlEvent.m_oAlEvent.m_eType == AL_EVENT_INVALID);
 	});
-	AlEvent* p0AlEvent = [&]()
+	ToFinishAlEvent* p0ToFinishAlEvent = [&]()
 	{
 		if (itFind == m_aToFinishAlEvents.end()) {
 			m_aToFinishAlEvents.emplace_back();
-			AlEvent& oAlEvent = m_aToFinishAlEvents.back();
-			return &oAlEvent;
+			ToFinishAlEvent& oToFinishAlEvent = m_aToFinishAlEvents.back();
+			return &oToFinishAlEvent;
 		} else {
-			AlEvent& oAlEvent = *itFind;
-			return &oAlEvent;
+			ToFinishAlEvent& oToFinishAlEvent = *itFind;
+			return &oToFinishAlEvent;
 		}
 	}();
-	p0AlEvent->m_p0Backend = this;
-	return *p0AlEvent;
+	p0ToFinishAlEvent->m_p0Backend = this;
+	return *p0ToFinishAlEvent;
+}
+void OpenAlBackend::recycleToFinishAlEvent(ActiveSound& oActiveSound) noexcept
+{
+	if (oActiveSound.m_p0ToFinishAlEvent == nullptr) {
+		return; //--------------------------------------------------------------
+	}
+	oActiveSound.m_p0ToFinishAlEvent->m_oAlEvent.m_eType = AL_EVENT_INVALID;
+	oActiveSound.m_p0ToFinishAlEvent = nullptr;
 }
-Backend::AlEvent& Backend::getSoundFinishedAlEvent(const AlCommand& oCommand) noexcept
+OpenAlBackend::ToFinishAlEvent& OpenAlBackend::getSoundFinishedAlEvent(const AlCommand& oCommand) noexcept
 {
-	AlEvent& oAlEvent = getOrCreateAlEvent();
+	ToFinishAlEvent& oToFinishAlEvent = getOrCreateAlEvent();
+	AlEvent& oAlEvent = oToFinishAlEvent.m_oAlEvent;
 	oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
 	oAlEvent.m_nBackendDeviceId = oCommand.m_nBackendDeviceId;
 	oAlEvent.m_nSoundId = oCommand.m_nSoundId;
-	return oAlEvent;
+	// might be recycled
+	oAlEvent.m_nSentTimeUsec = -1;
+	return oToFinishAlEvent;
 }
 
-Backend::AlDevice& Backend::getOrCreateAlDevice(int32_t& nDeviceId) noexcept
+OpenAlBackend::AlDevice& OpenAlBackend::getOrCreateAlDevice(int32_t& nDeviceId) noexcept
 {
 	auto itFind = std::find_if(m_aAlDevices.begin(), m_aAlDevices.end(), [&](AlDevice& oAlDevice)
 	{
@@ -826,30 +1818,58 @@ Backend::AlDevice& Backend::getOrCreateAlDevice(int32_t& nDeviceId) noexcept
 		return oAlDevice;
 	}
 }
-int32_t Backend::openalCreateDevice(const std::string& sDeviceName) noexcept
+int32_t OpenAlBackend::openalCreateDevice(const std::string& sDeviceName) noexcept
 {
 	int32_t nDeviceId;
 	AlDevice& oDev = getOrCreateAlDevice(nDeviceId);
 	oDev.m_sDeviceName = sDeviceName;
 	oDev.m_pContext = ::alcGetCurrentContext();
 	oDev.m_pDevice = ::alcGetContextsDevice(oDev.m_pContext);
+	ALCint nFrequency = 0;
+	::alcGetIntegerv(oDev.m_pDevice, ALC_FREQUENCY, 1, &nFrequency);
+	oDev.m_nFrequency = nFrequency;
+	oDev.m_bMulaw = (::alIsExtensionPresent("AL_EXT_MULAW") == AL_TRUE);
+	oDev.m_bIma4 = (::alIsExtensionPresent("AL_EXT_IMA4") == AL_TRUE);
+	oDev.m_bBlockAlignment = (::alIsExtensionPresent("AL_SOFT_block_alignment") == AL_TRUE);
+	if (::alIsExtensionPresent("AL_SOFT_deferred_updates") == AL_TRUE) {
+		oDev.m_p0DeferUpdates = reinterpret_cast<LPALDEFERUPDATESSOFT>(::alGetProcAddress("alDeferUpdatesSOFT"));
+		oDev.m_p0ProcessUpdates = reinterpret_cast<LPALPROCESSUPDATESSOFT>(::alGetProcAddress("alProcessUpdatesSOFT"));
+		if ((oDev.m_p0DeferUpdates == nullptr) || (oDev.m_p0ProcessUpdates == nullptr)) {
+			oDev.m_p0DeferUpdates = nullptr;
+			oDev.m_p0ProcessUpdates = nullptr;
+		}
+	} else {
+		oDev.m_p0DeferUpdates = nullptr;
+		oDev.m_p0ProcessUpdates = nullptr;
+	}
+	if (::alcIsExtensionPresent(oDev.m_pDevice, "ALC_SOFT_device_clock") == ALC_TRUE) {
+		oDev.m_p0GetInteger64v = reinterpret_cast<LPALCGETINTEGER64VSOFT>(
+										::alcGetProcAddress(oDev.m_pDevice, "alcGetInteger64vSOFT"));
+	} else {
+		oDev.m_p0GetInteger64v = nullptr;
+	}
+	// The loopback device starts the scheduled sounds between renders
+	if ((oDev.m_p0GetInteger64v != nullptr) && (! m_bLoopback)
+			&& (::alIsExtensionPresent("AL_SOFT_source_start_delay") == AL_TRUE)) {
+		oDev.m_p0PlayAtTimev = reinterpret_cast<LPALSOURCEPLAYATTIMEVSOFT>(::alGetProcAddress("alSourcePlayAtTimevSOFT"));
+	} else {
+		oDev.m_p0PlayAtTimev = nullptr;
+	}
+	publishDeviceClock(nDeviceId, openalGetDeviceClockNanosec(oDev), ! m_bLoopback);
 	return nDeviceId;
 }
-void Backend::sendDeviceAddedAlEvent(int32_t nDeviceId, const std::string& sDeviceName) noexcept
+void OpenAlBackend::sendDeviceAddedAlEvent(int32_t nDeviceId, const std::string& sDeviceName) noexcept
 {
 	AlEvent oAlEvent;
 	oAlEvent.m_eType = AL_EVENT_DEVICE_ADDED;
 	oAlEvent.m_sDeviceName = sDeviceName;
 	oAlEvent.m_nBackendDeviceId = nDeviceId;
 	oAlEvent.m_bDeviceIsDefault = (nDeviceId == m_nDefaultDeviceId);
-	{
-		std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
-		m_aAlEvents.push_back(std::move(oAlEvent));
-	}
+	sendEvent(std::move(oAlEvent));
 }
-std::string Backend::openalCreateAllDevices(bool bUseDeviceNames, std::vector<std::string>& aDeviceNames, bool bSendEvent) noexcept
+std::string OpenAlBackend::openalCreateAllDevices(bool bUseDeviceNames, std::vector<std::string>& aDeviceNames, bool bSendEvent) noexcept
 {
-//std::cout << "Backend::openalCreateAllDevices bSendEvent=" << bSendEvent << '\n';
+//std::cout << "OpenAlBackend::openalCreateAllDevices bSendEvent=" << bSendEvent << '\n';
 	m_nTotAlDevices = 0;
 	int32_t nDefaultIdx;
 	if (! bUseDeviceNames) {
@@ -882,29 +1902,23 @@ std::string Backend::openalCreateAllDevices(bool bUseDeviceNames, std::vector<st
 	}
 	return "";
 }
-void Backend::sendDeviceChangedAlEvent(int32_t nDeviceId) noexcept
+void OpenAlBackend::sendDeviceChangedAlEvent(int32_t nDeviceId) noexcept
 {
 	AlEvent oAlEvent;
 	oAlEvent.m_eType = AL_EVENT_DEVICE_CHANGED;
 	oAlEvent.m_nBackendDeviceId = nDeviceId;
-	{
-		std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
-		m_aAlEvents.push_back(std::move(oAlEvent));
-	}
+	sendEvent(std::move(oAlEvent));
 }
-void Backend::sendDeviceRemovedAlEvent(int32_t nDeviceId) noexcept
+void OpenAlBackend::sendDeviceRemovedAlEvent(int32_t nDeviceId) noexcept
 {
 	AlEvent oAlEvent;
 	oAlEvent.m_eType = AL_EVENT_DEVICE_REMOVED;
 	oAlEvent.m_nBackendDeviceId = nDeviceId;
-	{
-		std::lock_guard<std::mutex> oLock(m_oAlEventMutex);
-		m_aAlEvents.push_back(std::move(oAlEvent));
-	}
+	sendEvent(std::move(oAlEvent));
 }
-void Backend::openalRemoveAllDevices() noexcept
+void OpenAlBackend::openalRemoveAllDevices() noexcept
 {
-//std::cout << "Backend::openalRemoveAllDevices" << '\n';
+//std::cout << "OpenAlBackend::openalRemoveAllDevices" << '\n';
 	const int32_t nTotOldIdxs = static_cast<int32_t>(m_aAlDevices.size());
 	for (int32_t nDeviceId = 0; nDeviceId < nTotOldIdxs; ++nDeviceId) {
 		AlDevice& oAlDevice = m_aAlDevices[nDeviceId];
@@ -913,21 +1927,24 @@ void Backend::openalRemoveAllDevices() noexcept
 		}
 		sendDeviceRemovedAlEvent(nDeviceId);
 		openalShutdownDevice(oAlDevice);
+		// the id might be reused by a new device
+		cancelDeferredPreloads(nDeviceId, -1);
 	}
 }
-void Backend::openalCheckDeviceNames() noexcept
+void OpenAlBackend::openalCheckDeviceNames() noexcept
 {
-//std::cout << "Backend::openalCheckDeviceNames  m_nTotAlDevices=" << m_nTotAlDevices << '\n';
+//std::cout << "OpenAlBackend::openalCheckDeviceNames  m_nTotAlDevices=" << m_nTotAlDevices << '\n';
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalCheckDeviceNames");
 	std::vector<std::string> aDeviceNames;
 	int32_t nDefaultIdx;
 	openalGetDeviceNames(aDeviceNames, nDefaultIdx);
 
 	const int32_t nTotNewIdxs = static_cast<int32_t>(aDeviceNames.size());
 
-//std::cout << "Backend::openalCheckDeviceNames  nTotNewIdxs=" << nTotNewIdxs << '\n';
-//std::cout << "Backend::openalCheckDeviceNames  m_nTotAlDevices=" << m_nTotAlDevices << '\n';
+//std::cout << "OpenAlBackend::openalCheckDeviceNames  nTotNewIdxs=" << nTotNewIdxs << '\n';
+//std::cout << "OpenAlBackend::openalCheckDeviceNames  m_nTotAlDevices=" << m_nTotAlDevices << '\n';
 //for (auto& sDevName : aDeviceNames) {
-//std::cout << "Backend::openalCheckDeviceNames  new name= " << sDevName << '\n';
+//std::cout << "OpenAlBackend::openalCheckDeviceNames  new name= " << sDevName << '\n';
 //}
 	if (nTotNewIdxs != m_nTotAlDevices) {
 		// When a new device is added or removed all the names get screwed up.
@@ -936,6 +1953,7 @@ void Backend::openalCheckDeviceNames() noexcept
 		// we have to remove all old devices and recreate all new devices from the new names.
 		openalRemoveAllDevices();
 		openalCreateAllDevices(true, aDeviceNames, true);
+		++m_oRawStats.m_nDeviceRecreations;
 	} else {
 		// check whether the names have changed
 		bool bAtLeastOneChanged = false;
@@ -943,7 +1961,7 @@ void Backend::openalCheckDeviceNames() noexcept
 			if (oAlDevice.m_bDeviceRemoved) {
 				continue;
 			}
-//std::cout << "Backend::openalCheckDeviceNames  old oAlDevice.m_sDeviceName=" << oAlDevice.m_sDeviceName << '\n';
+//std::cout << "OpenAlBackend::openalCheckDeviceNames  old oAlDevice.m_sDeviceName=" << oAlDevice.m_sDeviceName << '\n';
 			const auto itFind = std::find(aDeviceNames.begin(), aDeviceNames.end(), oAlDevice.m_sDeviceName);
 			if (itFind == aDeviceNames.end()) {
 //std::cout << "              -> not found" << '\n';
@@ -954,25 +1972,357 @@ void Backend::openalCheckDeviceNames() noexcept
 		if (bAtLeastOneChanged) {
 			openalRemoveAllDevices();
 			openalCreateAllDevices(true, aDeviceNames, true);
+			++m_oRawStats.m_nDeviceRecreations;
 		} else {
 			// do nothing: if a device is added and removed quickly it might
 			// detect it!
 		}
 	}
 }
-void Backend::openalShutdownDevice(AlDevice& oDev) noexcept
+std::string OpenAlBackend::openalCreateLoopbackDevice() noexcept
 {
-//std::cout << "Backend::openalShutdownDevice  name=" << oDev.m_sDeviceName << " " << oDev.m_bDeviceRemoved << '\n';
-	#ifndef NDEBUG
-	ALboolean bRet =
-	#endif //NDEBUG
-	::alcMakeContextCurrent(oDev.m_pContext);
-	assert(bRet == AL_TRUE);
+	if (::alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback") == ALC_FALSE) {
+		return "OpenAL extension ALC_SOFT_loopback not supported"; //-----------
+	}
+	auto p0LoopbackOpenDevice = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(
+										::alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+	auto p0IsRenderFormatSupported = reinterpret_cast<LPALCISRENDERFORMATSUPPORTEDSOFT>(
+										::alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT"));
+	m_p0AlcRenderSamples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(::alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+	if ((p0LoopbackOpenDevice == nullptr) || (p0IsRenderFormatSupported == nullptr) || (m_p0AlcRenderSamples == nullptr)) {
+		return "OpenAL extension ALC_SOFT_loopback functions not found"; //-----
+	}
+	if (m_bOffline) {
+		if (::alcIsExtensionPresent(nullptr, "ALC_EXT_thread_local_context") == ALC_FALSE) {
+			return "OpenAL extension ALC_EXT_thread_local_context not supported"; //
+		}
+		m_p0AlcSetThreadContext = reinterpret_cast<PFNALCSETTHREADCONTEXTPROC>(
+										::alcGetProcAddress(nullptr, "alcSetThreadContext"));
+		if (m_p0AlcSetThreadContext == nullptr) {
+			return "OpenAL function alcSetThreadContext not found"; //----------
+		}
+	}
+	ALCdevice* p0Device = p0LoopbackOpenDevice(nullptr);
+	if (p0Device == nullptr) {
+		return "alcLoopbackOpenDeviceSOFT() failed"; //-------------------------
+	}
+	const int32_t nTotChannels = (m_oLoopbackInit.m_bStereo ? 2 : 1);
+	const ALCint nChannels = (m_oLoopbackInit.m_bStereo ? ALC_STEREO_SOFT : ALC_MONO_SOFT);
+	const ALCsizei nFrequency = static_cast<ALCsizei>(m_oLoopbackInit.m_nFrequency);
+	if (p0IsRenderFormatSupported(p0Device, nFrequency, nChannels, ALC_SHORT_SOFT) == ALC_FALSE) {
+		::alcCloseDevice(p0Device);
+		return "Loopback render format not supported"; //-----------------------
+	}
+	const ALCint aAttrs[] = {ALC_FORMAT_CHANNELS_SOFT, nChannels, ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT
+							, ALC_FREQUENCY, nFrequency, 0};
+	ALCcontext* p0Context = ::alcCreateContext(p0Device, aAttrs);
+	if (p0Context == nullptr) {
+		::alcCloseDevice(p0Device);
+		return "alcCreateContext() failed for loopback device"; //--------------
+	}
+	if (! m_oLoopbackInit.m_sWavFilePath.empty()) {
+		const std::string sErr = m_oLoopbackWav.open(m_oLoopbackInit.m_sWavFilePath, m_oLoopbackInit.m_nFrequency, nTotChannels);
+		if (! sErr.empty()) {
+			::alcDestroyContext(p0Context);
+			::alcCloseDevice(p0Device);
+			return sErr; //-----------------------------------------------------
+		}
+	}
+	openalMakeContextCurrent(p0Context);
+	m_aLoopbackSamples.resize(m_oLoopbackInit.m_nRenderFrames * nTotChannels);
+	// openalCreateDevice uses the current context
+	const int32_t nDeviceId = openalCreateDevice(s_p0LoopbackDeviceName);
+	m_nDefaultDeviceId = nDeviceId;
+	m_nTotAlDevices = 1;
+	return "";
+}
+bool OpenAlBackend::openalLoopbackRender() noexcept
+{
+	assert(m_nDefaultDeviceId >= 0);
+	TraceSpan oSpan(*this, m_oAlTraceRing, "openalLoopbackRender");
+	AlDevice& oAlDevice = m_aAlDevices[m_nDefaultDeviceId];
+	if (oAlDevice.m_bDeviceRemoved) {
+		return false; //--------------------------------------------------------
+	}
+	// Rendering silence would just burn the cpu
+	if (! isSomeSoundPlaying(oAlDevice)) {
+		return false; //--------------------------------------------------------
+	}
+	// the next scheduled sound is started in the next iteration by openalAdvanceSounds()
+	openalLoopbackRenderFrames(oAlDevice, getFramesToNextStart(oAlDevice, m_oLoopbackInit.m_nRenderFrames));
+	// the rendered samples might have finished some sounds:
+	// since time is not real time alureUpdate must be called each time
+	::alureUpdate();
+	return true;
+}
+void OpenAlBackend::openalLoopbackRenderFrames(AlDevice& oAlDevice, int32_t nFrames) noexcept
+{
+	assert((nFrames > 0) && (nFrames <= m_oLoopbackInit.m_nRenderFrames));
+	m_p0AlcRenderSamples(oAlDevice.m_pDevice, m_aLoopbackSamples.data(), static_cast<ALCsizei>(nFrames));
+	m_nLoopbackRenderedFrames += nFrames;
+	const int32_t nTotChannels = (m_oLoopbackInit.m_bStereo ? 2 : 1);
+	m_oLoopbackWav.write(m_aLoopbackSamples.data(), nFrames * nTotChannels);
+}
+bool OpenAlBackend::isSomeSoundPlaying(const AlDevice& oAlDevice) const noexcept
+{
+	return std::any_of(oAlDevice.m_aActiveSounds.begin(), oAlDevice.m_aActiveSounds.end()
+						, [&](const ActiveSound& oActiveSound)
+	{
+		// a prepared sound doesn't play until triggered
+		return (oActiveSound.m_nTriggerSlot < 0) && isSoundAudible(oAlDevice, oActiveSound);
+	});
+}
+bool OpenAlBackend::isSoundAudible(const AlDevice& oAlDevice, const ActiveSound& oActiveSound) noexcept
+{
+	return (! oActiveSound.m_bPaused) && ((! oAlDevice.m_bDevicePaused) || oActiveSound.m_bStartedWhenDevicePaused)
+			&& ! isSoundGroupPaused(oAlDevice.m_aSoundGroups, oActiveSound.m_nGroupId);
+}
+void OpenAlBackend::openalMakeContextCurrent(ALCcontext* p0Context) noexcept
+{
+	if (m_bOffline) {
+		m_p0AlcSetThreadContext(p0Context);
+	} else {
+		::alcMakeContextCurrent(p0Context);
+	}
+}
+void OpenAlBackend::openalPlaySource(ActiveSound& oActiveSound) noexcept
+{
+	const ALuint nSourceId = oActiveSound.m_nALSourceId;
+	ToFinishAlEvent* p0ToFinishAlEvent = oActiveSound.m_p0ToFinishAlEvent;
+	assert(p0ToFinishAlEvent != nullptr);
+	if (m_bOffline) {
+		// alureUpdate() is process wide: it could call the finished callback
+		// of this backend from the thread of another offline backend.
+		// openalCheckFinishedSources() is used instead
+		oActiveSound.m_bCheckFinished = true;
+		::alSourcePlay(nSourceId);
+		return; //--------------------------------------------------------------
+	}
+	assert((! m_bOffline) || (oActiveSound.m_p0Stream == nullptr));
+	const ALboolean bRet = ((oActiveSound.m_p0Stream == nullptr)
+							? ::alurePlaySource(nSourceId, openalSoundFinishedCallback, p0ToFinishAlEvent)
+							: ::alurePlaySourceStream(nSourceId, oActiveSound.m_p0Stream, s_nStreamBuffers
+													, (oActiveSound.m_bLoop ? -1 : 0), openalSoundFinishedCallback, p0ToFinishAlEvent));
+	if (bRet == AL_FALSE) {
+		std::cout << "OpenAlBackend::openalPlay   alurePlaySource error: " << ::alureGetErrorString() << '\n';
+	}
+}
+void OpenAlBackend::openalCheckFinishedSources(AlDevice& oAlDevice) noexcept
+{
+	auto& aActiveSounds = oAlDevice.m_aActiveSounds;
+	// the callback removes the sound from aActiveSounds
+	std::size_t nIdx = 0;
+	while (nIdx < aActiveSounds.size()) {
+		const ActiveSound& oActiveSound = aActiveSounds[nIdx];
+		// a scheduled sound not started yet is in the AL_INITIAL state
+		ALint nState = AL_PLAYING;
+		if (oActiveSound.m_bCheckFinished) {
+			::alGetSourcei(oActiveSound.m_nALSourceId, AL_SOURCE_STATE, &nState);
+		}
+		if (nState == AL_STOPPED) {
+			openalSoundFinishedCallback(oActiveSound.m_p0ToFinishAlEvent, oActiveSound.m_nALSourceId);
+		} else {
+			++nIdx;
+		}
+	}
+}
+int32_t OpenAlBackend::renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept
+{
+	if (! m_bOffline) {
+		return -1; //-----------------------------------------------------------
+	}
+	assert(nMillisec >= 0);
+	if (isDispatchingEvents()) {
+		// called by a listener: the chunk being dispatched isn't finished
+		return 0; //------------------------------------------------------------
+	}
+	assert(m_nDefaultDeviceId >= 0);
+	AlDevice& oAlDevice = m_aAlDevices[m_nDefaultDeviceId];
+	auto oExecCommands = [&]()
+	{
+		takeCommands(m_aReadAlCommands);
+		openalExecReadCommands();
+		// offline there's no hurry: the timeline is the same as if preloads weren't deferred
+		while (hasDeferredPreloads()) {
+			openalExecDeferredPreloads();
+		}
+	};
+	const int64_t nFrequency = m_oLoopbackInit.m_nFrequency;
+	const int64_t nTotFrames = nMillisec * nFrequency / 1000;
+	int64_t nRenderedFrames = 0;
+	oExecCommands();
+	while (nRenderedFrames < nTotFrames) {
+		if (bStopWhenIdle && ! isSomeSoundPlaying(oAlDevice)) {
+			break;
+		}
+		openalMakeContextCurrent(oAlDevice.m_pContext);
+		openalStartDueSounds(oAlDevice);
+		// the chunk ends where the next scheduled sound starts so that it's sample accurate
+		const int32_t nFrames = getFramesToNextStart(oAlDevice
+									, static_cast<int32_t>(std::min<int64_t>(m_oLoopbackInit.m_nRenderFrames, nTotFrames - nRenderedFrames)));
+		{
+			TraceSpan oSpan(*this, m_oAlTraceRing, "openalLoopbackRender");
+			openalLoopbackRenderFrames(oAlDevice, nFrames);
+			openalCheckFinishedSources(oAlDevice);
+			openalAdvanceDeviceSounds(oAlDevice);
+		}
+		nRenderedFrames += nFrames;
+		openalPublishStats();
+		openalPublishDeviceClocks();
+		openalPublishSoundStates();
+		// the listeners of the finished events might play new sounds
+		dispatchEvents();
+		oExecCommands();
+	}
+	return static_cast<int32_t>(nRenderedFrames * 1000 / nFrequency);
+}
+void OpenAlBackend::openalAddBuffer(AlDevice& oAlDevice, int32_t nFileId, ALuint nALBuffer, bool bMono) noexcept
+{
+	ALint nSize = 0;
+	::alGetBufferi(nALBuffer, AL_SIZE, &nSize);
+	oAlDevice.m_nBufferBytes += nSize;
+	auto& aFileToBufferId = oAlDevice.m_aFileToBufferId;
+	auto& aFileToMonoBufferId = oAlDevice.m_aFileToMonoBufferId;
+	if (bMono) {
+		aFileToMonoBufferId.emplace_back(nFileId, nALBuffer);
+		if (findFileBuffer(aFileToBufferId, nFileId) == aFileToBufferId.end()) {
+			// the stereo version would be twice as big
+			oAlDevice.m_nDownmixSavedBytes += nSize;
+		}
+	} else {
+		aFileToBufferId.emplace_back(nFileId, nALBuffer);
+		const auto itFindMono = findFileBuffer(aFileToMonoBufferId, nFileId);
+		if (itFindMono != aFileToMonoBufferId.end()) {
+			// the stereo version is needed too
+			ALint nMonoSize = 0;
+			::alGetBufferi(itFindMono->second, AL_SIZE, &nMonoSize);
+			oAlDevice.m_nDownmixSavedBytes -= nMonoSize;
+		}
+	}
+	oAlDevice.m_oBufferBudget.add(nALBuffer, nSize);
+	openalEvictBuffers(oAlDevice, nALBuffer);
+}
+void OpenAlBackend::openalPublishStats() noexcept
+{
+	const int32_t nTotDevices = std::min(static_cast<int32_t>(m_aAlDevices.size()), SndStatsCapability::s_nMaxStatsDevices);
+	for (int32_t nDeviceId = 0; nDeviceId < SndStatsCapability::s_nMaxStatsDevices; ++nDeviceId) {
+		RawDeviceStats& oRawDeviceStats = m_oRawStats.m_aDevices[nDeviceId];
+		if ((nDeviceId >= nTotDevices) || m_aAlDevices[nDeviceId].m_bDeviceRemoved) {
+			oRawDeviceStats = RawDeviceStats{};
+			continue;
+		}
+		const AlDevice& oAlDevice = m_aAlDevices[nDeviceId];
+		oRawDeviceStats.m_bExists = true;
+		oRawDeviceStats.m_nActiveSources = static_cast<int32_t>(oAlDevice.m_aActiveSounds.size());
+		oRawDeviceStats.m_nUnusedSources = static_cast<int32_t>(oAlDevice.m_aUnusedSourceIds.size());
+		oRawDeviceStats.m_nBuffers = static_cast<int32_t>(oAlDevice.m_aFileToBufferId.size() + oAlDevice.m_aFileToMonoBufferId.size());
+		oRawDeviceStats.m_nBufferBytes = oAlDevice.m_nBufferBytes;
+		oRawDeviceStats.m_nDownmixSavedBytes = oAlDevice.m_nDownmixSavedBytes;
+		oRawDeviceStats.m_nEvictedBuffers = oAlDevice.m_nEvictedBuffers;
+	}
+	m_oRawStats.m_nEncodedBytes = m_nEncodedBytes;
+	publishStats();
+}
+void OpenAlBackend::openalPublishDeviceClocks() noexcept
+{
+	const int32_t nTotDevices = static_cast<int32_t>(m_aAlDevices.size());
+	for (int32_t nDeviceId = 0; nDeviceId < nTotDevices; ++nDeviceId) {
+		const AlDevice& oAlDevice = m_aAlDevices[nDeviceId];
+		if (oAlDevice.m_bDeviceRemoved) {
+			continue; // for nDeviceId ----
+		}
+		// the loopback device only advances when rendering
+		publishDeviceClock(nDeviceId, openalGetDeviceClockNanosec(oAlDevice), ! m_bLoopback);
+	}
+}
+void OpenAlBackend::openalPublishSoundStates() noexcept
+{
+	m_bSoundStatesChanged = false;
+	// the loopback device only advances when rendering
+	const bool bAdvancing = ! m_bLoopback;
+	const int32_t nTotDevices = static_cast<int32_t>(m_aAlDevices.size());
+	for (int32_t nDeviceId = 0; nDeviceId < nTotDevices; ++nDeviceId) {
+		const AlDevice& oAlDevice = m_aAlDevices[nDeviceId];
+		if (oAlDevice.m_bDeviceRemoved || oAlDevice.m_aActiveSounds.empty()) {
+			continue; // for nDeviceId ----
+		}
+		openalMakeContextCurrent(oAlDevice.m_pContext);
+		for (const ActiveSound& oActiveSound : oAlDevice.m_aActiveSounds) {
+			const bool bAudible = isSoundAudible(oAlDevice, oActiveSound);
+			if ((oActiveSound.m_nStartClockNanosec >= 0) || (oActiveSound.m_nTriggerSlot >= 0)) {
+				// not handed to OpenAL yet
+				publishSoundState(nDeviceId, oActiveSound.m_nSoundId
+								, (bAudible ? PlaybackCapability::SOUND_STATE_PENDING : PlaybackCapability::SOUND_STATE_PAUSED)
+								, 0.0, oActiveSound.m_fLengthSec, oActiveSound.m_bLoop, false);
+				continue; // for oActiveSound ----
+			}
+			ALint nState = AL_INITIAL;
+			::alGetSourcei(oActiveSound.m_nALSourceId, AL_SOURCE_STATE, &nState);
+			// a stopped source is removed by the finished callback at the next alureUpdate()
+			PlaybackCapability::SOUND_STATE eState;
+			if (nState == AL_PLAYING) {
+				eState = PlaybackCapability::SOUND_STATE_PLAYING;
+			} else if (nState == AL_PAUSED) {
+				eState = PlaybackCapability::SOUND_STATE_PAUSED;
+			} else if (nState == AL_STOPPED) {
+				eState = PlaybackCapability::SOUND_STATE_STOPPED;
+			} else {
+				eState = (bAudible ? PlaybackCapability::SOUND_STATE_PENDING : PlaybackCapability::SOUND_STATE_PAUSED);
+			}
+			// the offset of a stream is relative to the queued buffers
+			double fOffsetSec = -1.0;
+			if (oActiveSound.m_p0Stream == nullptr) {
+				ALfloat fSecOffset = 0.0f;
+				::alGetSourcef(oActiveSound.m_nALSourceId, AL_SEC_OFFSET, &fSecOffset);
+				fOffsetSec = ((eState == PlaybackCapability::SOUND_STATE_STOPPED) ? oActiveSound.m_fLengthSec : fSecOffset);
+			}
+			publishSoundState(nDeviceId, oActiveSound.m_nSoundId, eState, fOffsetSec, oActiveSound.m_fLengthSec
+							, oActiveSound.m_bLoop, bAdvancing);
+		}
+	}
+}
+double OpenAlBackend::openalGetBufferLengthSec(const AlDevice& oAlDevice, ALuint nALBuffer) const noexcept
+{
+	ALint nSize = 0;
+	ALint nChannels = 0;
+	ALint nBits = 0;
+	ALint nFrequency = 0;
+	::alGetBufferi(nALBuffer, AL_SIZE, &nSize);
+	::alGetBufferi(nALBuffer, AL_CHANNELS, &nChannels);
+	::alGetBufferi(nALBuffer, AL_BITS, &nBits);
+	::alGetBufferi(nALBuffer, AL_FREQUENCY, &nFrequency);
+	if ((nSize <= 0) || (nChannels <= 0) || (nBits <= 0) || (nFrequency <= 0)) {
+		return -1.0; //---------------------------------------------------------
+	}
+	int64_t nFrames;
+	if ((nBits == 4) && oAlDevice.m_bBlockAlignment) {
+		// IMA4: blocks of nBlockFrames frames with a 4 bytes header per channel
+		ALint nBlockFrames = 0;
+		::alGetBufferi(nALBuffer, AL_UNPACK_BLOCK_ALIGNMENT_SOFT, &nBlockFrames);
+		if (nBlockFrames <= 0) {
+			return -1.0; //-----------------------------------------------------
+		}
+		const int64_t nBlockBytes = int64_t{nChannels} * (4 + (nBlockFrames - 1) / 2);
+		nFrames = (nSize / nBlockBytes) * nBlockFrames;
+	} else {
+		nFrames = int64_t{nSize} * 8 / (nChannels * nBits);
+	}
+	return static_cast<double>(nFrames) / nFrequency;
+}
+void OpenAlBackend::openalShutdownDevice(AlDevice& oDev) noexcept
+{
+//std::cout << "OpenAlBackend::openalShutdownDevice  name=" << oDev.m_sDeviceName << " " << oDev.m_bDeviceRemoved << '\n';
+	openalMakeContextCurrent(oDev.m_pContext);
 
 	// sources must be unbuffered to remove buffers
-	for (const ActiveSound& oActiveSound : oDev.m_aActiveSounds) {
+	const int32_t nDeviceId = getDeviceId(oDev);
+	for (ActiveSound& oActiveSound : oDev.m_aActiveSounds) {
+		releaseTriggerSlot(oActiveSound.m_nTriggerSlot);
+		publishSoundRemoved(nDeviceId, oActiveSound.m_nSoundId, false);
 		::alureStopSource(oActiveSound.m_nALSourceId, AL_FALSE);
+		recycleToFinishAlEvent(oActiveSound);
 		::alSourcei(oActiveSound.m_nALSourceId, AL_BUFFER, 0);
+		openalDestroyStream(oActiveSound);
 	}
 	// after shutdown source ids are no longer valid
 	oDev.m_aUnusedSourceIds.clear();
@@ -982,15 +2332,31 @@ void Backend::openalShutdownDevice(AlDevice& oDev) noexcept
 	for (const auto& oPair : oDev.m_aFileToBufferId) {
 		::alDeleteBuffers(1, &oPair.second);
 	}
+	for (const auto& oPair : oDev.m_aFileToMonoBufferId) {
+		::alDeleteBuffers(1, &oPair.second);
+	}
 	oDev.m_aFileToBufferId.clear();
+	oDev.m_aFileToMonoBufferId.clear();
+	oDev.m_nBufferBytes = 0;
+	oDev.m_nDownmixSavedBytes = 0;
+	oDev.m_oBufferBudget.clear();
+	oDev.m_nEvictedBuffers = 0;
 	oDev.m_bDevicePaused = false;
+	oDev.m_aSoundGroups.clear();
 	oDev.m_bDeviceRemoved = true;
 	//
-	#ifndef NDEBUG
-	bRet =
-	#endif //NDEBUG
-	::alureShutdownDevice();
-	assert(bRet == AL_TRUE);
+	if (m_bOffline) {
+		// alureShutdownDevice() would reset the process wide current context
+		openalMakeContextCurrent(nullptr);
+		::alcDestroyContext(oDev.m_pContext);
+		::alcCloseDevice(oDev.m_pDevice);
+	} else {
+		#ifndef NDEBUG
+		const ALboolean bRet =
+		#endif //NDEBUG
+		::alureShutdownDevice();
+		assert(bRet == AL_TRUE);
+	}
 
 	--m_nTotAlDevices;
 }
@@ -21,7 +21,12 @@
 #ifndef STMI_OPENAL_BACKEND_H
 #define STMI_OPENAL_BACKEND_H
 
-#include <sigc++/connection.h>
+#include "backend.h"
+#include "bufferbudget.h"
+#include "pcmdiskcache.h"
+#include "wavdecoder.h"
+#include "wavfilewriter.h"
+#include "openaldevicemanager.h"
 
 #include <memory>
 #include <string>
@@ -32,11 +37,17 @@
 #include <utility>
 #include <mutex>
 #include <condition_variable>
+#include <cassert>
 
 #include <AL/alure.h>
+#include <AL/alext.h>
 
 #include <stdint.h>
 
+#ifndef AL_SOFT_source_start_delay
+typedef void (AL_APIENTRY *LPALSOURCEPLAYATTIMEVSOFT)(ALsizei n, const ALuint* sources, ALint64SOFT start_time);
+#endif
+
 namespace stmi
 {
 
@@ -55,112 +66,203 @@ void openalSoundFinishedCallback(void *p0AlEvent, ALuint nSourceId) noexcept;
 
 
 ////////////////////////////////////////////////////////////////////////////////
-class Backend //: public sigc::trackable
+class OpenAlBackend : public Backend //, public sigc::trackable
 {
 public:
 	// returns backend
-	static unique_ptr<Backend> create(::stmi::OpenAlDeviceManager* p0Owner) noexcept;
+	static unique_ptr<OpenAlBackend> create(::stmi::OpenAlDeviceManager* p0Owner) noexcept;
+	// returns backend with a single ALC_SOFT_loopback device
+	static unique_ptr<OpenAlBackend> createLoopback(::stmi::OpenAlDeviceManager* p0Owner
+													, const ::stmi::OpenAlDeviceManager::LoopbackInit& oLoopbackInit) noexcept;
+	// returns backend with a single ALC_SOFT_loopback device rendered by renderOffline()
+	static unique_ptr<OpenAlBackend> createOffline(::stmi::OpenAlDeviceManager* p0Owner
+													, const ::stmi::OpenAlDeviceManager::LoopbackInit& oLoopbackInit) noexcept;
 
-	// return empty if ok error otherwise
-	// This has to be called when the OpenAlDeviceManager is ready to receive callbacks
-	std::string createThread() noexcept;
+	// Creates the OpenAL thread (in offline mode just the loopback device)
+	std::string start() noexcept override;
 
-	#ifdef STMI_TESTING_IFACE
-	virtual
-	#endif
-	~Backend() noexcept;
+	int32_t renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept override;
 
-	enum AL_COMMAND_TYPE
-	{
-		AL_COMMAND_FIRST           = 0
-		, AL_COMMAND_PRELOAD       = 0
-		, AL_COMMAND_PLAY          = 1
-		, AL_COMMAND_PAUSE         = 2
-		, AL_COMMAND_RESUME        = 3
-		, AL_COMMAND_STOP          = 4
-		, AL_COMMAND_PAUSE_DEVICE  = 5
-		, AL_COMMAND_RESUME_DEVICE = 6
-		, AL_COMMAND_STOP_ALL      = 7
-		, AL_COMMAND_SOUND_POS     = 8
-		, AL_COMMAND_SOUND_VOL     = 9
-		, AL_COMMAND_LISTENER_POS  = 10
-		, AL_COMMAND_LISTENER_VOL  = 11
-		, AL_COMMAND_LAST          = 11
-	};
-	struct AlCommand
-	{
-		int32_t m_nBackendDeviceId;
-		AL_COMMAND_TYPE m_eType;
-		int32_t m_nSoundId = -1;
-		int32_t m_nFileId = -1;
-		std::string m_sFileName;
-		const uint8_t* m_p0Buffer = nullptr;
-		int32_t m_nBufferSize = 0;
-		bool m_bLoop = false; /*< Whether sound is looping */
-		bool m_bRelative = false; /*< Whether relative to listener. Default is false. */
-		double m_fPosX = 0; /*< Used for setting the x position or x direction */
-		double m_fPosY = 0; /*< Used for setting the y position or x direction */
-		double m_fPosZ = 0; /*< Used for setting the z position or x direction */
-		double m_fVolume = 1.0; /*< The volume. Default is 1.0. */
-	};
+	~OpenAlBackend() noexcept;
 
-	enum AL_EVENT_TYPE
-	{
-		AL_EVENT_INVALID          = -1
-		, AL_EVENT_FIRST          = 0
-		, AL_EVENT_PLAY_FINISHED  = 0
-		, AL_EVENT_DEVICE_ADDED   = 1
-		, AL_EVENT_DEVICE_REMOVED = 2
-		, AL_EVENT_DEVICE_CHANGED = 3 /**< Either the device has become default or no longer is default. */
-		, AL_EVENT_PLAY_ERROR     = 4
-		, AL_EVENT_LAST           = 4
-	};
-	struct AlEvent
+	// The size of the pool of finished events (in offline mode, for testing)
+	int32_t getTotToFinishAlEvents() const noexcept
 	{
-		std::string m_sDeviceName;
-		AL_EVENT_TYPE m_eType = AL_EVENT_INVALID;
-		bool m_bDeviceIsDefault = false;
-		std::string m_sError;
-		int32_t m_nBackendDeviceId = -1;
-		int32_t m_nSoundId = -1;
-		int32_t m_nFileId = -1;
-	private:
-		friend class Backend;
-		friend void Private::OpenAl::openalSoundFinishedCallback(void *p0AlEvent, ALuint /*nSourceId*/) noexcept;
-		Backend* m_p0Backend = nullptr;
-	};
-
-	//ConcurrentQueue<AlCommand, true>& getAlCommandQueue() noexcept { return m_oAlCommandQueue; }
-
-	void sendCommand(AlCommand&& oAlCommand) noexcept;
+		assert(m_bOffline);
+		return static_cast<int32_t>(m_aToFinishAlEvents.size());
+	}
 protected:
-	explicit Backend(::stmi::OpenAlDeviceManager* p0Owner) noexcept;
+	// If p0LoopbackInit is not null the backend is in loopback mode
+	// If bOffline is true p0LoopbackInit cannot be null
+	OpenAlBackend(::stmi::OpenAlDeviceManager* p0Owner, const ::stmi::OpenAlDeviceManager::LoopbackInit* p0LoopbackInit
+				, bool bOffline) noexcept;
 
 private:
+	struct ToFinishAlEvent;
 	struct ActiveSound
 	{
 		int32_t m_nSoundId;
 		ALuint m_nALSourceId;
+		ALuint m_nALBuffer = AL_NONE; // AL_NONE if streamed
+		alureStream* m_p0Stream = nullptr; // Not null if streamed
+		bool m_bLoop = false;
 		bool m_bPaused = false;
 		bool m_bStartedWhenDevicePaused = false;
+		double m_fLengthSec = -1.0; // The length of the buffer or -1 if streamed
+		int32_t m_nGroupId = -1;
+		double m_fVolume = 1.0; // The volume of the sound without the group volume
+		double m_fPosX = 0.0;
+		double m_fPosY = 0.0;
+		double m_fPosZ = 0.0;
+		SoundMotion m_oMotion;
+		SoundRamp m_oRamp;
+		// The device clock time the sound starts at or -1 if started (see openalStartDueSounds())
+		int64_t m_nStartClockNanosec = -1;
+		// The trigger slot of a prepared sound or -1 if started (see openalStartTriggeredSounds())
+		int32_t m_nTriggerSlot = -1;
+		// The argument of openalSoundFinishedCallback. If the sound is stopped
+		// the callback isn't called and openalStopActiveSound() recycles it
+		ToFinishAlEvent* m_p0ToFinishAlEvent = nullptr;
+		// Whether the source isn't played by alure (offline mode, scheduled and prepared sounds):
+		// openalCheckFinishedSources() calls openalSoundFinishedCallback
+		bool m_bCheckFinished = false;
 	};
 	struct AlDevice
 	{
 		std::string m_sDeviceName;
 		ALCdevice* m_pDevice = nullptr;
 		ALCcontext* m_pContext = nullptr;
+		int32_t m_nFrequency = 0; // The ALC_FREQUENCY of the context or 0 if unknown
+		bool m_bMulaw = false; // Whether AL_EXT_MULAW is supported
+		bool m_bIma4 = false; // Whether AL_EXT_IMA4 is supported
+		bool m_bBlockAlignment = false; // Whether AL_SOFT_block_alignment is supported
 		std::vector<std::pair<int32_t, ALuint>> m_aFileToBufferId;
+		// The mono down-mixes of stereo files played positionally
+		std::vector<std::pair<int32_t, ALuint>> m_aFileToMonoBufferId;
+		int64_t m_nBufferBytes = 0; // The total size of the buffers in m_aFileToBufferId and m_aFileToMonoBufferId
+		// The total size of the buffers in m_aFileToMonoBufferId whose file is not in m_aFileToBufferId
+		int64_t m_nDownmixSavedBytes = 0;
+		// The buffers of m_aFileToBufferId and m_aFileToMonoBufferId in least recently played order
+		BufferBudget m_oBufferBudget;
+		int64_t m_nEvictedBuffers = 0;
 		std::vector<ActiveSound> m_aActiveSounds;
 		std::vector<ALuint> m_aUnusedSourceIds;
 		bool m_bDevicePaused = false;
 		bool m_bDeviceRemoved = false;
+		std::vector<SoundGroup> m_aSoundGroups; // Index: group id
+		// Not null if AL_SOFT_deferred_updates is supported
+		LPALDEFERUPDATESSOFT m_p0DeferUpdates = nullptr;
+		LPALPROCESSUPDATESSOFT m_p0ProcessUpdates = nullptr;
+		// Not null if ALC_SOFT_device_clock is supported
+		LPALCGETINTEGER64VSOFT m_p0GetInteger64v = nullptr;
+		// Not null if AL_SOFT_source_start_delay (and ALC_SOFT_device_clock) is supported
+		LPALSOURCEPLAYATTIMEVSOFT m_p0PlayAtTimev = nullptr;
+	};
+	struct ToFinishAlEvent
+	{
+		AlEvent m_oAlEvent;
+		OpenAlBackend* m_p0Backend = nullptr;
+	};
+	// What sounds are converted to for a device
+	struct NativeTarget
+	{
+		int32_t m_nFrequency = 0; // The frequency to resample to or 0 if not resampled
+		int32_t m_nSampleFormat = OpenAlDeviceManager::SAMPLE_FORMAT_PCM16;
+		int32_t m_nBlockFrames = 0; // The IMA4 block size or 0
+		std::string m_sCacheDirectory; // The PCM disk cache directory or empty if disabled
+	};
+	// The buffers used to convert a sound, one instance per thread
+	struct NativeScratch
+	{
+		PcmSound m_oSound;
+		std::vector<int16_t> m_aSamples;
+		std::vector<uint8_t> m_aEncoded;
+		PcmDiskCache::Mapping m_oMapping;
+	};
+	// A preload of a batch prepared by a preload worker (or the OpenAL thread)
+	struct PreparedPreload
+	{
+		const AlCommand* m_p0Command = nullptr;
+		NativeTarget m_oTarget;
+		bool m_bDecodeOnDemand = false;
+		// Whether the file was read into m_aBytes
+		bool m_bRead = false;
+		std::vector<uint8_t> m_aBytes;
+		// Whether the sound was converted into m_oData
+		bool m_bNative = false;
+		NativeScratch m_oScratch;
+		PcmDiskCache::Data m_oData;
+		int64_t m_nDecodeStartUsec = -1;
+		int64_t m_nDecodeEndUsec = -1;
 	};
 private:
 	// In general all methods starting with openalXXX()
 	// are only executed by the OpenAL thread.
 	void openalThreadRun() noexcept;
+	// Executes m_aReadAlCommands, batch preloads are deferred
+	void openalExecReadCommands() noexcept;
+	// Executes a slice of the deferred preloads
+	void openalExecDeferredPreloads() noexcept;
+	// Executes a command and updates stats
+	void openalExecRecordedCommand(const AlCommand& oCommand) noexcept;
 	void openalExecCommand(const AlCommand& oCommand) noexcept;
-	void openalPreload(const AlCommand& oCommand) noexcept;
+	// Reads and converts the files of the batch preloads of m_aDeferredPreloadSlice
+	// in parallel (with the preload workers) into m_aPreparedPreloads
+	void openalPrepareBatchPreloads() noexcept;
+	// Starts the preload workers, called once by start()
+	void startPreloadWorkers() noexcept;
+	// Stops and joins the preload workers
+	void stopPreloadWorkers() noexcept;
+	// Preload worker thread: waits for queued preloads until stopped
+	void preloadWorkerRun() noexcept;
+	// Preload worker or OpenAL thread: prepares the queued preloads until none is left
+	// oLock is the lock of m_oPreloadWorkMutex, locked when called
+	void prepareQueuedPreloads(std::unique_lock<std::mutex>& oLock) noexcept;
+	// Preload worker or OpenAL thread
+	void preparePreload(PreparedPreload& oPrepared) const noexcept;
+	// Returns false if failed (error event sent)
+	// p0Prepared is null if the preload wasn't prepared by openalPrepareBatchPreloads()
+	bool openalPreload(const AlCommand& oCommand, PreparedPreload* p0Prepared) noexcept;
+	// Returns the existing or newly created buffer for a play command
+	// or AL_NONE if failed (error event sent)
+	ALuint openalGetPlayBuffer(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept;
+	// Returns AL_NONE if failed (error event sent)
+	ALuint openalCreateBuffer(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept;
+	// Returns AL_NONE if failed (error event sent)
+	ALuint openalCreatePreparedBuffer(const AlCommand& oCommand, AlDevice& oAlDevice, PreparedPreload& oPrepared) noexcept;
+	// Reads the file into m_aEncodedFiles if not already there
+	// p0Prepared is either null or contains the bytes of the file
+	// Returns false if failed (error event sent)
+	bool openalLoadEncodedFile(const AlCommand& oCommand, PreparedPreload* p0Prepared) noexcept;
+	// The bytes of the buffer or the file kept encoded in memory
+	// Returns false if the file has to be read from disk
+	bool getSoundBytes(const AlCommand& oCommand, const uint8_t*& p0Bytes, int32_t& nSize) const noexcept;
+	// Whether a play command should be streamed rather than decoded into a buffer
+	bool openalShouldStream(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept;
+	// Returns null if failed (error event sent)
+	alureStream* openalCreateStream(const AlCommand& oCommand) noexcept;
+	void openalDestroyStream(ActiveSound& oActiveSound) noexcept;
+	// Deletes the least recently played buffers (except nKeepALBuffer) until within the budget
+	void openalEvictBuffers(AlDevice& oAlDevice, ALuint nKeepALBuffer) noexcept;
+	// Returns AL_NONE if the sound isn't a PCM WAV (alure has to load it)
+	// bDownmixed is set to whether a stereo sound was down-mixed because of bDownmix
+	ALuint openalCreateNativeBuffer(const AlCommand& oCommand, const AlDevice& oAlDevice
+									, bool bDownmix, bool& bDownmixed) noexcept;
+	// The OpenAlDeviceManager::SAMPLE_FORMAT sounds are encoded to on the device
+	// nBlockFrames is set to the IMA4 block size or 0
+	int32_t getNativeSampleFormat(const AlDevice& oAlDevice, int32_t& nBlockFrames) const noexcept;
+	NativeTarget getNativeTarget(const AlDevice& oAlDevice) const noexcept;
+	// Any thread: decodes a PCM WAV and converts it or maps it from the disk cache
+	// If p0Bytes is null the file is read. The cache is only used if sFileName is not empty.
+	// oData points into oScratch. Returns false if the sound isn't a PCM WAV.
+	static bool prepareNativeSound(const NativeTarget& oTarget, const std::string& sFileName
+									, const uint8_t* p0Bytes, int32_t nSize, bool bDownmix
+									, NativeScratch& oScratch, PcmDiskCache::Data& oData) noexcept;
+	// Any thread: encodes oScratch.m_oSound to the sample format of the target
+	// oData points to oScratch.m_aEncoded or oScratch.m_aSamples
+	static void encodeNativeSound(const NativeTarget& oTarget, NativeScratch& oScratch, PcmDiskCache::Data& oData) noexcept;
+	// Returns AL_NONE if failed
+	ALuint openalUploadBuffer(const PcmDiskCache::Data& oData) noexcept;
 	void openalPlay(const AlCommand& oCommand) noexcept;
 	void openalPause(const AlCommand& oCommand) noexcept;
 	void openalResume(const AlCommand& oCommand) noexcept;
@@ -173,6 +275,41 @@ private:
 	void openalListenerPos(const AlCommand& oCommand) noexcept;
 	//void openalListenerDir(const AlCommand& oCommand) noexcept;
 	void openalListenerVol(const AlCommand& oCommand) noexcept;
+	void openalGroupVol(const AlCommand& oCommand) noexcept;
+	void openalPauseGroup(const AlCommand& oCommand) noexcept;
+	void openalResumeGroup(const AlCommand& oCommand) noexcept;
+	void openalStopGroup(const AlCommand& oCommand) noexcept;
+	void openalSoundMotion(const AlCommand& oCommand) noexcept;
+	void openalSoundRamp(const AlCommand& oCommand) noexcept;
+	// Advances the motions and volume ramps of the sounds of all devices
+	void openalAdvanceSounds() noexcept;
+	// Also stops the faded out sounds
+	void openalAdvanceDeviceSounds(AlDevice& oAlDevice) noexcept;
+	// The clock of motions and ramps: the rendered time if offline, the steady time otherwise
+	int64_t getAdvanceTimeUsec() const noexcept;
+	// Starts the scheduled sounds whose time has come in the same mix
+	// or, if AL_SOFT_source_start_delay is supported, hands all of them to OpenAL
+	// Updates m_nStartWaitMillisec
+	void openalStartDueSounds(AlDevice& oAlDevice) noexcept;
+	// The rendered time if loopback, ALC_DEVICE_CLOCK_SOFT if supported, the steady time otherwise
+	int64_t openalGetDeviceClockNanosec(const AlDevice& oAlDevice) const noexcept;
+	// Loopback: the frames (at most nMaxFrames) that can be rendered before the next scheduled sound starts
+	int32_t getFramesToNextStart(const AlDevice& oAlDevice, int32_t nMaxFrames) const noexcept;
+	void openalPublishDeviceClocks() noexcept;
+	// Publishes the state and offset of the sounds of all devices for getSoundState()
+	void openalPublishSoundStates() noexcept;
+	// The length in seconds of the samples of a buffer or -1 if not known
+	double openalGetBufferLengthSec(const AlDevice& oAlDevice, ALuint nALBuffer) const noexcept;
+	// Starts the prepared sounds that were triggered
+	void openalStartTriggeredSounds() noexcept;
+	// Resumes the source unless the sound hasn't started yet
+	void openalResumeSource(const ActiveSound& oActiveSound) noexcept;
+	// Stops the source and removes the sound from the active sounds
+	void openalStopActiveSound(AlDevice& oAlDevice, std::vector<ActiveSound>::iterator itActiveSound) noexcept;
+	// The changes to the sources between the two calls are applied at once
+	// if AL_SOFT_deferred_updates is supported
+	void openalDeferUpdates(AlDevice& oAlDevice) noexcept;
+	void openalProcessUpdates(AlDevice& oAlDevice) noexcept;
 
 	std::string openalGetDeviceNames(std::vector<std::string>& aDeviceNames, int32_t& nDefaultIdx) noexcept;
 	// return device is or -1 if failed
@@ -180,15 +317,36 @@ private:
 	std::string openalCreateAllDevices(bool bUseDeviceNames, std::vector<std::string>& aDeviceNames, bool bSendEvent) noexcept;
 	void openalRemoveAllDevices() noexcept;
 	void openalShutdownDevice(AlDevice& oDev) noexcept;
+	std::string openalCreateLoopbackDevice() noexcept;
+	// returns whether samples were rendered
+	bool openalLoopbackRender() noexcept;
+	void openalLoopbackRenderFrames(AlDevice& oAlDevice, int32_t nFrames) noexcept;
+	// Whether some started sound is audible
+	bool isSomeSoundPlaying(const AlDevice& oAlDevice) const noexcept;
+	// Whether the sound is neither paused nor paused by its device or group
+	static bool isSoundAudible(const AlDevice& oAlDevice, const ActiveSound& oActiveSound) noexcept;
+	void openalMakeContextCurrent(ALCcontext* p0Context) noexcept;
+	// The finished event must be set
+	void openalPlaySource(ActiveSound& oActiveSound) noexcept;
+	// Calls the finished callback of the sources not played by alure that have stopped
+	void openalCheckFinishedSources(AlDevice& oAlDevice) noexcept;
+	// Adds to m_aFileToMonoBufferId if bMono is true, to m_aFileToBufferId otherwise
+	void openalAddBuffer(AlDevice& oAlDevice, int32_t nFileId, ALuint nALBuffer, bool bMono) noexcept;
+	void openalPublishStats() noexcept;
 
 	AlDevice& getActiveDevice(int32_t nDeviceId) noexcept;
+	// The index of the device in m_aAlDevices
+	int32_t getDeviceId(const AlDevice& oAlDevice) const noexcept;
 	std::vector<ActiveSound>::iterator getActiveSoundIt(int32_t nSoundId, AlDevice& oAlDevice) noexcept;
 	// returns null if sound was removed in the mean time
 	ActiveSound* getActiveSound(const AlCommand& oCommand, AlDevice& oAlDevice) noexcept;
 	void removeActiveSound(std::vector<ActiveSound>& aActiveSounds, std::vector<ActiveSound>::iterator itActiveSound) noexcept;
 	AlDevice& getOrCreateAlDevice(int32_t& nDeviceId) noexcept;
-	AlEvent& getOrCreateAlEvent() noexcept;
-	AlEvent& getSoundFinishedAlEvent(const AlCommand& oCommand) noexcept;
+	ToFinishAlEvent& getOrCreateAlEvent() noexcept;
+	ToFinishAlEvent& getSoundFinishedAlEvent(const AlCommand& oCommand) noexcept;
+	// The sound is stopped without calling openalSoundFinishedCallback:
+	// its finished event can be reused
+	void recycleToFinishAlEvent(ActiveSound& oActiveSound) noexcept;
 	void sendDeviceChangedAlEvent(int32_t nDeviceId) noexcept;
 	void sendDeviceRemovedAlEvent(int32_t nDeviceId) noexcept;
 	void sendDeviceAddedAlEvent(int32_t nDeviceId, const std::string& sDeviceName) noexcept;
@@ -199,11 +357,7 @@ private:
 
 	friend void Private::OpenAl::openalSoundFinishedCallback(void *p0AlEvent, ALuint /*nSourceId*/) noexcept;
 
-	bool onCheckEventsTimeout() noexcept;
-
 private:
-	OpenAlDeviceManager* m_p0Owner;
-
 	std::thread m_oAlThread;
 
 	// Set by m_oAlThread when it has initially filled the m_aDeviceNames field,
@@ -217,19 +371,12 @@ private:
 	std::atomic<bool> m_bInitialDevicesCreated = ATOMIC_VAR_INIT(false);
 	std::condition_variable m_oInitialDevicesCreated;
 
+	// The trace ring of m_oAlThread
+	TraceRecorder::Ring& m_oAlTraceRing;
+
 	// When false tells m_oAlThread to stop and join
 	std::atomic<bool> m_bIsRunning = ATOMIC_VAR_INIT(true);
 
-	std::mutex m_oAlCommandMutex;
-	std::condition_variable m_oAlCommandsNotEmpty;
-
-	std::mutex m_oAlEventMutex;
-
-	// only accessed under m_oAlCommandMutex
-	std::vector<AlCommand> m_aAlCommands;
-	// only accessed under m_oAlEventMutex
-	std::vector<AlEvent> m_aAlEvents;
-
 	// The m_aAlDevices field is only for the m_oAlThread except
 	// when m_bInitialDevicesReady is set to true and m_bInitialDevicesCreated is still false
 	// during initialization handshake.
@@ -251,21 +398,76 @@ private:
 
 	// When a sound is played an entry is created (or recycled in this deque)
 	// and it's address is passed to the finished event callback
-	// where the entry will be put (moved) into m_aAlEvents queue and
-	// set to AL_EVENT_INVALID to be recycled
+	// where the event will be sent (moved) to the main thread and
+	// set to AL_EVENT_INVALID to be recycled. A stopped sound's entry
+	// is recycled by recycleToFinishAlEvent().
 	// Only used by m_oAlThread thread!
-	std::deque<AlEvent> m_aToFinishAlEvents;
-
-	sigc::connection m_oCheckEventsConn;
+	std::deque<ToFinishAlEvent> m_aToFinishAlEvents;
+
+	// Whether the only device is an ALC_SOFT_loopback device rendered by m_oAlThread
+	// while at least one sound is playing.
+	const bool m_bLoopback;
+	// Whether there is no OpenAL thread and the loopback device is only rendered
+	// by renderOffline(). The context is bound to the thread that created the backend
+	// with alcSetThreadContext() so that offline backends in different threads don't interfere.
+	const bool m_bOffline;
+	const ::stmi::OpenAlDeviceManager::LoopbackInit m_oLoopbackInit;
+	PFNALCSETTHREADCONTEXTPROC m_p0AlcSetThreadContext = nullptr;
+	// The following are only used by m_oAlThread thread!
+	LPALCRENDERSAMPLESSOFT m_p0AlcRenderSamples = nullptr;
+	std::vector<int16_t> m_aLoopbackSamples;
+	// Not open if output is discarded
+	WavFileWriter m_oLoopbackWav;
 
-	// Used by the main thread to avoid reallocating at each timeout
-	std::vector<AlEvent> m_aReadAlEvents;
 	// Used by openAL thread to avoid reallocating
 	std::vector<AlCommand> m_aReadAlCommands;
+	// The deferred preloads being executed
+	std::vector<AlCommand> m_aDeferredPreloadSlice;
+	NativeScratch m_oNativeScratch;
+	// The prepared batch preloads of m_aDeferredPreloadSlice, in the same order
+	// A deque because the elements can't be moved
+	std::deque<PreparedPreload> m_aPreparedPreloads;
+	// The next element of m_aPreparedPreloads to be executed
+	int32_t m_nNextPreparedPreload = 0;
+	// The threads that help the OpenAL thread prepare the batch preloads,
+	// started by start() and stopped by the destructor
+	std::vector<std::thread> m_aPreloadWorkers;
+	std::mutex m_oPreloadWorkMutex;
+	// Signals the workers that preloads were queued or that they must stop
+	std::condition_variable m_oPreloadWorkAvailable;
+	// Signals the OpenAL thread that all the queued preloads were prepared
+	std::condition_variable m_oPreloadWorkDone;
+	// The queue: the elements of m_aPreparedPreloads from m_nNextPreloadToPrepare
+	// to m_nTotPreloadsToPrepare (excluded) are waiting to be prepared
+	// only accessed under m_oPreloadWorkMutex
+	int32_t m_nTotPreloadsToPrepare = 0;
+	// only accessed under m_oPreloadWorkMutex
+	int32_t m_nNextPreloadToPrepare = 0;
+	// The number of queued preloads prepared so far
+	// only accessed under m_oPreloadWorkMutex
+	int32_t m_nPreparedPreloads = 0;
+	// only accessed under m_oPreloadWorkMutex
+	bool m_bPreloadWorkersStop = false;
+	// The files preloaded with decode on demand, shared by all devices
+	// Only used by m_oAlThread thread!
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> m_aEncodedFiles;
+	int64_t m_nEncodedBytes = 0;
+	// Loopback only: the total frames rendered by openalLoopbackRenderFrames()
+	int64_t m_nLoopbackRenderedFrames = 0;
+	// Used by openalAdvanceDeviceSounds() to avoid reallocating
+	std::vector<int32_t> m_aFadedOutSoundIds;
+	// Whether commands or scheduled starts might have changed the sound states since
+	// the last openalPublishSoundStates(). Otherwise they are only published each update.
+	bool m_bSoundStatesChanged = false;
+	// The time until the next scheduled sound has to be started by m_oAlThread or -1 if none
+	int32_t m_nStartWaitMillisec = -1;
+	// Used by openalStartDueSounds() to avoid reallocating (start time, source id)
+	std::vector<std::pair<int64_t, ALuint>> m_aStartingSources;
+	std::vector<ALuint> m_aStartingSourceIds;
 private:
-	Backend() = delete;
-	Backend(const Backend& oSource) = delete;
-	Backend& operator=(const Backend& oSource) = delete;
+	OpenAlBackend() = delete;
+	OpenAlBackend(const OpenAlBackend& oSource) = delete;
+	OpenAlBackend& operator=(const OpenAlBackend& oSource) = delete;
 };
 
 } // namespace OpenAl
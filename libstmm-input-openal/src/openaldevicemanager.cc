@@ -22,9 +22,14 @@
 
 #include "playbackdevice.h"
 #include "openalbackend.h"
+#include "mixerbackend.h"
+#include "soundbank.h"
+#include "glibeventloopadapter.h"
 
 #include <stmm-input-au/playbackcapability.h>
+#include <stmm-input-au/sndfinishedbatchevent.h>
 #include <stmm-input-au/sndfinishedevent.h>
+#include <stmm-input-au/sndpreloadedevent.h>
 
 #include <stmm-input-ev/devicemgmtevent.h>
 #include <stmm-input-ev/stddevicemanager.h>
@@ -54,6 +59,8 @@ namespace stmi
 
 ////////////////////////////////////////////////////////////////////////////////
 using Private::OpenAl::Backend;
+using Private::OpenAl::OpenAlBackend;
+using Private::OpenAl::MixerBackend;
 using Private::OpenAl::PlaybackDevice;
 using Private::OpenAl::OpenAlListenerExtraData;
 
@@ -86,7 +93,14 @@ static bool execCmd(const char* sCmd, std::string& sResult, std::string& sError)
 }
 #endif //STMM_SNAP_PACKAGING
 
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::create(const std::string& sAppName
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	return create(sAppName, std::unique_ptr<EventLoopAdapter>(new GlibEventLoopAdapter())
+				, bEnableEventClasses, aEnDisableEventClasses);
+}
 std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::create(const std::string& /*sAppName*/
+																					, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
 																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
 {
 	#ifdef STMM_SNAP_PACKAGING
@@ -106,39 +120,304 @@ std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::cre
 	}
 	#endif //STMM_SNAP_PACKAGING
 	shared_ptr<OpenAlDeviceManager> refInstance(new OpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses));
-	auto refBackend = Backend::create(refInstance.get());
-	Backend* p0Backend = refBackend.get();
+	auto refBackend = OpenAlBackend::create(refInstance.get());
 	assert(refBackend);
+	refBackend->setEventLoopAdapter(std::move(refEventLoopAdapter));
 //std::cout << "OpenAlDeviceManager::create ok backend" << '\n';
-	auto refSndMgmtImpl = std::make_shared<SndMgmtImpl>(refInstance.get());
-	refInstance->init(std::move(refBackend), std::move(refSndMgmtImpl));
-
-	std::string sError = p0Backend->createThread();
+	std::string sError = refInstance->init(std::move(refBackend));
 	if (! sError.empty()) {
 //std::cout << "OpenAlDeviceManager::create error backend" << '\n';
 		return std::make_pair(shared_ptr<OpenAlDeviceManager>{}, std::move(sError)); //--------
 	}
 	return std::make_pair(refInstance, "");
 }
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::createLoopback(const LoopbackInit& oLoopbackInit
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	return createLoopback(oLoopbackInit, std::unique_ptr<EventLoopAdapter>(new GlibEventLoopAdapter())
+						, bEnableEventClasses, aEnDisableEventClasses);
+}
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::createLoopback(const LoopbackInit& oLoopbackInit
+																					, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	assert(oLoopbackInit.m_nFrequency > 0);
+	assert(oLoopbackInit.m_nRenderFrames > 0);
+	shared_ptr<OpenAlDeviceManager> refInstance(new OpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses));
+	auto refBackend = OpenAlBackend::createLoopback(refInstance.get(), oLoopbackInit);
+	assert(refBackend);
+	refBackend->setEventLoopAdapter(std::move(refEventLoopAdapter));
+	std::string sError = refInstance->init(std::move(refBackend));
+	if (! sError.empty()) {
+		return std::make_pair(shared_ptr<OpenAlDeviceManager>{}, std::move(sError)); //--------
+	}
+	return std::make_pair(refInstance, "");
+}
+
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::createOffline(const LoopbackInit& oLoopbackInit
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	assert(oLoopbackInit.m_nFrequency > 0);
+	assert(oLoopbackInit.m_nRenderFrames > 0);
+	shared_ptr<OpenAlDeviceManager> refInstance(new OpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses));
+	auto refBackend = OpenAlBackend::createOffline(refInstance.get(), oLoopbackInit);
+	assert(refBackend);
+	std::string sError = refInstance->init(std::move(refBackend));
+	if (! sError.empty()) {
+		return std::make_pair(shared_ptr<OpenAlDeviceManager>{}, std::move(sError)); //--------
+	}
+	return std::make_pair(refInstance, "");
+}
+
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::createMixer(const MixerInit& oMixerInit
+																					, std::unique_ptr<MixerSink> refSink
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	// offline mixers send the events while rendering
+	std::unique_ptr<EventLoopAdapter> refEventLoopAdapter;
+	if (! oMixerInit.m_bOffline) {
+		refEventLoopAdapter.reset(new GlibEventLoopAdapter());
+	}
+	return createMixer(oMixerInit, std::move(refSink), std::move(refEventLoopAdapter), bEnableEventClasses, aEnDisableEventClasses);
+}
+std::pair<shared_ptr<OpenAlDeviceManager>, std::string> OpenAlDeviceManager::createMixer(const MixerInit& oMixerInit
+																					, std::unique_ptr<MixerSink> refSink
+																					, std::unique_ptr<EventLoopAdapter> refEventLoopAdapter
+																					, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+{
+	assert(oMixerInit.m_nFrequency > 0);
+	assert(oMixerInit.m_nPeriodFrames > 0);
+	assert(refSink);
+	shared_ptr<OpenAlDeviceManager> refInstance(new OpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses));
+	auto refBackend = MixerBackend::create(refInstance.get(), oMixerInit, std::move(refSink));
+	assert(refBackend);
+	refBackend->setEventLoopAdapter(std::move(refEventLoopAdapter));
+	std::string sError = refInstance->init(std::move(refBackend));
+	if (! sError.empty()) {
+		return std::make_pair(shared_ptr<OpenAlDeviceManager>{}, std::move(sError)); //--------
+	}
+	return std::make_pair(refInstance, "");
+}
 
 OpenAlDeviceManager::OpenAlDeviceManager(bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
 : StdDeviceManager({Capability::Class{typeid(PlaybackCapability)}}
-					, {Event::Class{typeid(DeviceMgmtEvent)}, Event::Class{typeid(SndFinishedEvent)}}
+					, {Event::Class{typeid(DeviceMgmtEvent)}, Event::Class{typeid(SndFinishedEvent)}
+						, Event::Class{typeid(SndPreloadedEvent)}, Event::Class{typeid(SndFinishedBatchEvent)}}
 					, bEnableEventClasses, aEnDisableEventClasses)
 , m_nDefaultBackendDeviceId(-1)
 , m_nFinishingNestedDepth(0)
 , m_nClassIdxSndFinishedEvent(getEventClassIndex(Event::Class{typeid(SndFinishedEvent)}))
+, m_nClassIdxSndPreloadedEvent(getEventClassIndex(Event::Class{typeid(SndPreloadedEvent)}))
+, m_nClassIdxSndFinishedBatchEvent(getEventClassIndex(Event::Class{typeid(SndFinishedBatchEvent)}))
+, m_bSndFinishedBatching(false)
+, m_nEventsDispatchDepth(0)
+, m_eMonoDownmixPolicy(MONO_DOWNMIX_POLICY_KEEP_STEREO)
+, m_nTotFileMonoDownmixPolicies(0)
 {
 //std::cout << "OpenAlDeviceManager::OpenAlDeviceManager " << reinterpret_cast<int64_t>(this) << '\n';
 }
 
-void OpenAlDeviceManager::init(std::unique_ptr<Private::OpenAl::Backend>&& refBackend, shared_ptr<SndMgmtImpl>&& refSndMgmtImpl) noexcept
+std::string OpenAlDeviceManager::init(std::unique_ptr<Private::OpenAl::Backend>&& refBackend) noexcept
 {
 	assert(refBackend);
 	m_refBackend = std::move(refBackend);
-	m_refSndMgmtImpl = std::move(refSndMgmtImpl);
+	m_refSndMgmtImpl = std::make_shared<SndMgmtImpl>(this);
+	m_refSndStatsImpl = std::make_shared<SndStatsImpl>(this);
+	return m_refBackend->start();
 }
 
+int32_t OpenAlDeviceManager::renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept
+{
+	assert(nMillisec >= 0);
+	return m_refBackend->renderOffline(nMillisec, bStopWhenIdle);
+}
+void OpenAlDeviceManager::setEventLoopAdapter(std::unique_ptr<EventLoopAdapter> refAdapter) noexcept
+{
+	m_refBackend->setEventLoopAdapter(std::move(refAdapter));
+}
+int32_t OpenAlDeviceManager::getEventFD() const noexcept
+{
+	return m_refBackend->getEventFD();
+}
+void OpenAlDeviceManager::dispatchPending() noexcept
+{
+	m_refBackend->dispatchEvents();
+}
+void OpenAlDeviceManager::setLatencyStatsEnabled(bool bEnabled) noexcept
+{
+	m_refBackend->getLatencyRecorder().setEnabled(bEnabled);
+}
+bool OpenAlDeviceManager::isLatencyStatsEnabled() const noexcept
+{
+	return m_refBackend->getLatencyRecorder().isEnabled();
+}
+OpenAlDeviceManager::LatencyStats OpenAlDeviceManager::getLatencyStats() const noexcept
+{
+	return m_refBackend->getLatencyRecorder().getStats();
+}
+void OpenAlDeviceManager::resetLatencyStats() noexcept
+{
+	m_refBackend->getLatencyRecorder().reset();
+}
+void OpenAlDeviceManager::setTraceEnabled(bool bEnabled) noexcept
+{
+	m_refBackend->getTraceRecorder().setEnabled(bEnabled);
+}
+bool OpenAlDeviceManager::isTraceEnabled() const noexcept
+{
+	return m_refBackend->getTraceRecorder().isEnabled();
+}
+std::string OpenAlDeviceManager::writeTrace(const std::string& sFilePath) const noexcept
+{
+	return m_refBackend->getTraceRecorder().write(sFilePath);
+}
+void OpenAlDeviceManager::setTraceExitFilePath(const std::string& sFilePath) noexcept
+{
+	m_refBackend->setTraceExitFilePath(sFilePath);
+}
+void OpenAlDeviceManager::setNativeFormatConversion(bool bEnabled) noexcept
+{
+	m_refBackend->setNativeFormatConversion(bEnabled);
+}
+bool OpenAlDeviceManager::isNativeFormatConversion() const noexcept
+{
+	return m_refBackend->isNativeFormatConversion();
+}
+void OpenAlDeviceManager::setCompressedSampleFormat(SAMPLE_FORMAT eFormat) noexcept
+{
+	m_refBackend->setCompressedSampleFormat(static_cast<int32_t>(eFormat));
+}
+OpenAlDeviceManager::SAMPLE_FORMAT OpenAlDeviceManager::getCompressedSampleFormat() const noexcept
+{
+	return static_cast<SAMPLE_FORMAT>(m_refBackend->getCompressedSampleFormat());
+}
+void OpenAlDeviceManager::setDecodeOnDemand(bool bEnabled) noexcept
+{
+	m_refBackend->setDecodeOnDemand(bEnabled);
+}
+bool OpenAlDeviceManager::isDecodeOnDemand() const noexcept
+{
+	return m_refBackend->isDecodeOnDemand();
+}
+void OpenAlDeviceManager::setDecodedBufferBudget(int32_t nMaxBuffers, int64_t nMaxBytes) noexcept
+{
+	assert(nMaxBuffers >= -1);
+	assert(nMaxBytes >= -1);
+	m_refBackend->setDecodedBufferBudget(nMaxBuffers, nMaxBytes);
+}
+int32_t OpenAlDeviceManager::getDecodedBufferBudgetBuffers() const noexcept
+{
+	return m_refBackend->getDecodedBufferBudgetBuffers();
+}
+int64_t OpenAlDeviceManager::getDecodedBufferBudgetBytes() const noexcept
+{
+	return m_refBackend->getDecodedBufferBudgetBytes();
+}
+void OpenAlDeviceManager::setStreamingThreshold(int32_t nMinEncodedBytes) noexcept
+{
+	assert(nMinEncodedBytes >= -1);
+	m_refBackend->setStreamingThreshold(nMinEncodedBytes);
+}
+int32_t OpenAlDeviceManager::getStreamingThreshold() const noexcept
+{
+	return m_refBackend->getStreamingThreshold();
+}
+void OpenAlDeviceManager::setPcmDiskCacheDirectory(const std::string& sDirectory) noexcept
+{
+	m_refBackend->setPcmDiskCacheDirectory(sDirectory);
+}
+std::string OpenAlDeviceManager::getPcmDiskCacheDirectory() const noexcept
+{
+	return m_refBackend->getPcmDiskCacheDirectory();
+}
+void OpenAlDeviceManager::setThreadSafePlayback(bool bEnabled) noexcept
+{
+	m_refBackend->setThreadSafePlayback(bEnabled);
+}
+bool OpenAlDeviceManager::isThreadSafePlayback() const noexcept
+{
+	return m_refBackend->isThreadSafePlayback();
+}
+bool OpenAlDeviceManager::setRealTimeListener(const shared_ptr<SndRealTimeListener>& refListener) noexcept
+{
+	return m_refBackend->setRealTimeListener(refListener);
+}
+void OpenAlDeviceManager::setSndFinishedBatching(bool bEnabled) noexcept
+{
+	if (m_bSndFinishedBatching == bEnabled) {
+		return; //--------------------------------------------------------------
+	}
+	if (! bEnabled) {
+		// don't lose the sounds collected so far
+		sendSndFinishedBatches();
+	}
+	m_bSndFinishedBatching = bEnabled;
+}
+shared_ptr<Private::OpenAl::SoundBank> OpenAlDeviceManager::openSoundBank(const std::string& sBankPath, std::string& sError) noexcept
+{
+	const auto itFind = std::find_if(m_aSoundBanks.begin(), m_aSoundBanks.end()
+									, [&](const shared_ptr<Private::OpenAl::SoundBank>& refSoundBank)
+	{
+		return refSoundBank->getPath() == sBankPath;
+	});
+	if (itFind != m_aSoundBanks.end()) {
+		return *itFind; //------------------------------------------------------
+	}
+	auto refSoundBank = std::make_shared<Private::OpenAl::SoundBank>();
+	sError = refSoundBank->open(sBankPath);
+	if (! sError.empty()) {
+		return shared_ptr<Private::OpenAl::SoundBank>{}; //---------------------
+	}
+	m_aSoundBanks.push_back(refSoundBank);
+	return refSoundBank;
+}
+void OpenAlDeviceManager::setMonoDownmixPolicy(MONO_DOWNMIX_POLICY ePolicy) noexcept
+{
+	m_eMonoDownmixPolicy.store(ePolicy, std::memory_order_relaxed);
+}
+void OpenAlDeviceManager::setFileMonoDownmixPolicy(const std::string& sFileName, MONO_DOWNMIX_POLICY ePolicy) noexcept
+{
+	assert(! sFileName.empty());
+	std::lock_guard<std::mutex> oLock(m_oFileMonoDownmixPoliciesMutex);
+	auto itFind = std::find_if(m_aFileMonoDownmixPolicies.begin(), m_aFileMonoDownmixPolicies.end()
+								, [&](const std::pair<std::string, MONO_DOWNMIX_POLICY>& oPair)
+	{
+		return (oPair.first == sFileName);
+	});
+	if (itFind == m_aFileMonoDownmixPolicies.end()) {
+		m_aFileMonoDownmixPolicies.emplace_back(sFileName, ePolicy);
+		m_nTotFileMonoDownmixPolicies.store(static_cast<int32_t>(m_aFileMonoDownmixPolicies.size()), std::memory_order_relaxed);
+	} else {
+		itFind->second = ePolicy;
+	}
+}
+void OpenAlDeviceManager::resetFileMonoDownmixPolicy(const std::string& sFileName) noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oFileMonoDownmixPoliciesMutex);
+	m_aFileMonoDownmixPolicies.erase(std::remove_if(m_aFileMonoDownmixPolicies.begin(), m_aFileMonoDownmixPolicies.end()
+								, [&](const std::pair<std::string, MONO_DOWNMIX_POLICY>& oPair)
+	{
+		return (oPair.first == sFileName);
+	}), m_aFileMonoDownmixPolicies.end());
+	m_nTotFileMonoDownmixPolicies.store(static_cast<int32_t>(m_aFileMonoDownmixPolicies.size()), std::memory_order_relaxed);
+}
+OpenAlDeviceManager::MONO_DOWNMIX_POLICY OpenAlDeviceManager::getFileMonoDownmixPolicy(const std::string& sFileName) const noexcept
+{
+	// A policy set concurrently might or might not be seen
+	if (sFileName.empty() || (m_nTotFileMonoDownmixPolicies.load(std::memory_order_relaxed) == 0)) {
+		return getMonoDownmixPolicy(); //---------------------------------------
+	}
+	std::lock_guard<std::mutex> oLock(m_oFileMonoDownmixPoliciesMutex);
+	auto itFind = std::find_if(m_aFileMonoDownmixPolicies.begin(), m_aFileMonoDownmixPolicies.end()
+								, [&](const std::pair<std::string, MONO_DOWNMIX_POLICY>& oPair)
+	{
+		return (oPair.first == sFileName);
+	});
+	if (itFind == m_aFileMonoDownmixPolicies.end()) {
+		return getMonoDownmixPolicy(); //---------------------------------------
+	}
+	return itFind->second;
+}
 void OpenAlDeviceManager::enableEventClass(const Event::Class& oEventClass) noexcept
 {
 	StdDeviceManager::enableEventClass(oEventClass);
@@ -148,22 +427,28 @@ std::vector<Capability::Class> OpenAlDeviceManager::getCapabilityClasses() const
 {
 	auto aCapaClasses = StdDeviceManager::getCapabilityClasses();
 	aCapaClasses.push_back(SndMgmtCapability::getClass());
+	aCapaClasses.push_back(SndStatsCapability::getClass());
 	return aCapaClasses;
 }
 shared_ptr<Capability> OpenAlDeviceManager::getCapability(const Capability::Class& oClass) const noexcept
 {
-	if (oClass != typeid(SndMgmtCapability)) {
-		return StdDeviceManager::getCapability(oClass);
+	if (oClass == typeid(SndMgmtCapability)) {
+		return m_refSndMgmtImpl;
+	}
+	if (oClass == typeid(SndStatsCapability)) {
+		return m_refSndStatsImpl;
 	}
-	return m_refSndMgmtImpl;
+	return StdDeviceManager::getCapability(oClass);
 }
 shared_ptr<Capability> OpenAlDeviceManager::getCapability(int32_t nCapabilityId) const noexcept
 {
-	const auto nSndMgmtCapaId = m_refSndMgmtImpl->getId();
-	if (nCapabilityId != nSndMgmtCapaId) {
-		return StdDeviceManager::getCapability(nCapabilityId);
+	if (nCapabilityId == m_refSndMgmtImpl->getId()) {
+		return m_refSndMgmtImpl;
 	}
-	return m_refSndMgmtImpl;
+	if (nCapabilityId == m_refSndStatsImpl->getId()) {
+		return m_refSndStatsImpl;
+	}
+	return StdDeviceManager::getCapability(nCapabilityId);
 }
 
 shared_ptr<DeviceManager> OpenAlDeviceManager::SndMgmtImpl::getDeviceManager() const noexcept
@@ -189,6 +474,16 @@ bool OpenAlDeviceManager::SndMgmtImpl::supportsSpatialSounds() const noexcept
 {
 	return true;
 }
+shared_ptr<DeviceManager> OpenAlDeviceManager::SndStatsImpl::getDeviceManager() const noexcept
+{
+	shared_ptr<ChildDeviceManager> refChildThis = std::const_pointer_cast<ChildDeviceManager>(m_p1Owner->shared_from_this());
+	shared_ptr<OpenAlDeviceManager> refThis = std::static_pointer_cast<OpenAlDeviceManager>(refChildThis);
+	return refThis;
+}
+SndStatsCapability::Stats OpenAlDeviceManager::SndStatsImpl::getStats() const noexcept
+{
+	return m_p1Owner->m_refBackend->getStats();
+}
 void OpenAlDeviceManager::onDeviceAdded(std::string&& sName, int32_t nBackendDeviceId, bool bIsDefault) noexcept
 {
 //std::cout << "OpenAlDeviceManager::onDeviceAdded " << reinterpret_cast<int64_t>(this) << '\n';
@@ -214,6 +509,7 @@ void OpenAlDeviceManager::onDeviceAdded(std::string&& sName, int32_t nBackendDev
 	}
 	assert(! m_aPlaybackDevices[nBackendDeviceId]);
 	m_aPlaybackDevices[nBackendDeviceId] = refNewDevice;
+	m_refBackend->setStatsDeviceId(nBackendDeviceId, refNewDevice->getDeviceId());
 	if (bIsDefault) {
 		m_nDefaultBackendDeviceId = nBackendDeviceId;
 	}
@@ -234,6 +530,7 @@ void OpenAlDeviceManager::onDeviceRemoved(int32_t nBackendDeviceId) noexcept
 	assert(refPlaybackDevice);
 	//
 	finishDeviceSounds(refPlaybackDevice);
+	refPlaybackDevice->abortPreloadBatches();
 	refPlaybackDevice->removingDevice();
 
 //std::cout << "OpenAlDeviceManager::onDeviceRemoved id=" << refPlaybackDevice->Device::getId() << "  dev id=" << refPlaybackDevice->getDeviceId() << '\n';
@@ -244,6 +541,7 @@ void OpenAlDeviceManager::onDeviceRemoved(int32_t nBackendDeviceId) noexcept
 	StdDeviceManager::removeDevice(refPlaybackDevice);
 	assert(bRemoved);
 	m_aPlaybackDevices[nBackendDeviceId].reset();
+	m_refBackend->setStatsDeviceId(nBackendDeviceId, -1);
 	if (nBackendDeviceId == m_nDefaultBackendDeviceId) {
 		m_nDefaultBackendDeviceId = -1;
 	}
@@ -267,21 +565,54 @@ void OpenAlDeviceManager::onDeviceChanged(int32_t nBackendDeviceId, bool bIsDefa
 
 	sendDeviceMgmtToListeners(DeviceMgmtEvent::DEVICE_MGMT_CHANGED, refPlaybackDevice);
 }
-void OpenAlDeviceManager::onPlayFinished(int32_t nBackendDeviceId, int32_t nSoundId) noexcept
+void OpenAlDeviceManager::onEventsDispatchBegin() noexcept
+{
+	++m_nEventsDispatchDepth;
+}
+void OpenAlDeviceManager::onEventsDispatchEnd() noexcept
+{
+	assert(m_nEventsDispatchDepth > 0);
+	--m_nEventsDispatchDepth;
+	if (m_nEventsDispatchDepth == 0) {
+		sendSndFinishedBatches();
+	}
+}
+void OpenAlDeviceManager::sendSndFinishedBatches() noexcept
+{
+	// copy because listeners might remove devices
+	const auto aPlaybackDevices = m_aPlaybackDevices;
+	for (auto& refPlaybackDevice : aPlaybackDevices) {
+		if (! refPlaybackDevice) {
+			// removed device
+			continue;
+		}
+		refPlaybackDevice->sendSndFinishedBatchToListeners();
+	}
+}
+void OpenAlDeviceManager::onPlayFinished(int32_t nBackendDeviceId, int32_t nSoundId, bool bFadedOut, int64_t nFinishedTimeUsec) noexcept
 {
 	assert((nBackendDeviceId >= 0) && (nBackendDeviceId < static_cast<int32_t>(m_aPlaybackDevices.size())));
 	shared_ptr<PlaybackDevice>& refPlaybackDevice = m_aPlaybackDevices[nBackendDeviceId];
 	assert(refPlaybackDevice);
 
-	refPlaybackDevice->onSoundFinished(nSoundId);
+	refPlaybackDevice->onSoundFinished(nSoundId, bFadedOut, nFinishedTimeUsec);
 }
-void OpenAlDeviceManager::onDeviceError(int32_t nBackendDeviceId, int32_t nFileId, int32_t nSoundId, std::string&& sError) noexcept
+void OpenAlDeviceManager::onDeviceError(int32_t nBackendDeviceId, int32_t nFileId, int32_t nSoundId, int64_t nFinishedTimeUsec
+										, std::string&& sError) noexcept
 {
 	assert((nBackendDeviceId >= 0) && (nBackendDeviceId < static_cast<int32_t>(m_aPlaybackDevices.size())));
 	shared_ptr<PlaybackDevice>& refPlaybackDevice = m_aPlaybackDevices[nBackendDeviceId];
 	assert(refPlaybackDevice);
 
-	refPlaybackDevice->onDeviceError(nSoundId, nFileId, std::move(sError));
+	refPlaybackDevice->onDeviceError(nSoundId, nFileId, nFinishedTimeUsec, std::move(sError));
+}
+void OpenAlDeviceManager::onPreloaded(int32_t nBackendDeviceId, int32_t nBatchId, int32_t nFileId, bool bLoaded) noexcept
+{
+	assert((nBackendDeviceId >= 0) && (nBackendDeviceId < static_cast<int32_t>(m_aPlaybackDevices.size())));
+	shared_ptr<PlaybackDevice>& refPlaybackDevice = m_aPlaybackDevices[nBackendDeviceId];
+	assert(refPlaybackDevice);
+
+	refPlaybackDevice->onPreloaded(nBatchId, nFileId, bLoaded);
 }
 bool OpenAlDeviceManager::addAccessor(const shared_ptr<Accessor>& /*refAccessor*/) noexcept
 {
@@ -301,6 +632,10 @@ void OpenAlDeviceManager::finalizeListener(ListenerData& oListenerData) noexcept
 	++m_nFinishingNestedDepth;
 	const int64_t nEventTimeUsec = DeviceManager::getNowTimeMicroseconds();
 	for (auto& refPlaybackDevice : m_aPlaybackDevices) {
+		if (! refPlaybackDevice) {
+			// removed device
+			continue;
+		}
 		refPlaybackDevice->finalizeListener(oListenerData, nEventTimeUsec);
 	}
 	--m_nFinishingNestedDepth;
@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmconverter.cc
+ */
+
+#include "pcmconverter.h"
+
+#include "mixerkernel.h"
+
+#include <cassert>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+void PcmConverter::resample(PcmSound& oSound, int32_t nFrequency) noexcept
+{
+	assert(nFrequency > 0);
+	assert(oSound.m_nFrequency > 0);
+	if (oSound.m_nFrequency == nFrequency) {
+		return; //--------------------------------------------------------------
+	}
+	const int32_t nChannels = oSound.m_nChannels;
+	const int32_t nSrcFrames = oSound.getTotFrames();
+	const int64_t nDstFrames = static_cast<int64_t>(nSrcFrames) * nFrequency / oSound.m_nFrequency;
+	std::vector<float> aDst(nDstFrames * nChannels);
+	const double fStep = static_cast<double>(oSound.m_nFrequency) / nFrequency;
+	const float* p0Src = oSound.m_aSamples.data();
+	for (int64_t nDstFrame = 0; nDstFrame < nDstFrames; ++nDstFrame) {
+		const double fSrcPos = nDstFrame * fStep;
+		const int32_t nSrcFrame = static_cast<int32_t>(fSrcPos);
+		const float fFrac = static_cast<float>(fSrcPos - nSrcFrame);
+		const int32_t nNextFrame = ((nSrcFrame + 1 < nSrcFrames) ? nSrcFrame + 1 : nSrcFrame);
+		for (int32_t nChannel = 0; nChannel < nChannels; ++nChannel) {
+			const float fCur = p0Src[nSrcFrame * nChannels + nChannel];
+			const float fNext = p0Src[nNextFrame * nChannels + nChannel];
+			aDst[nDstFrame * nChannels + nChannel] = fCur + (fNext - fCur) * fFrac;
+		}
+	}
+	oSound.m_aSamples.swap(aDst);
+	oSound.m_nFrequency = nFrequency;
+}
+void PcmConverter::downmixToMono(PcmSound& oSound) noexcept
+{
+	if (oSound.m_nChannels != 2) {
+		return; //--------------------------------------------------------------
+	}
+	const int32_t nTotFrames = oSound.getTotFrames();
+	float* p0Samples = oSound.m_aSamples.data();
+	MixerKernel::get().m_p0DownmixToMono(p0Samples, nTotFrames, p0Samples);
+	oSound.m_aSamples.resize(nTotFrames);
+	oSound.m_nChannels = 1;
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
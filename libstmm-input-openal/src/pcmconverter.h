@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmconverter.h
+ */
+
+#ifndef STMI_OPENAL_PCM_CONVERTER_H
+#define STMI_OPENAL_PCM_CONVERTER_H
+
+#include "wavdecoder.h"
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Conversions of decoded sounds done once at load time.
+ */
+class PcmConverter
+{
+public:
+	/** Converts the sample rate with linear interpolation.
+	 * Does nothing if the sound already has the requested rate.
+	 * @param oSound The sound to convert.
+	 * @param nFrequency The new sample rate. Must be positive.
+	 */
+	static void resample(PcmSound& oSound, int32_t nFrequency) noexcept;
+	/** Converts a stereo sound to mono averaging the channels.
+	 * Does nothing if the sound is already mono.
+	 * @param oSound The sound to convert.
+	 */
+	static void downmixToMono(PcmSound& oSound) noexcept;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_PCM_CONVERTER_H */
@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmdiskcache.cc
+ */
+
+#include "pcmdiskcache.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+namespace
+{
+
+constexpr const char s_aMagic[8] = {'S', 'T', 'M', 'I', 'P', 'C', 'M', '\0'};
+constexpr uint32_t s_nByteOrder = 0x01020304;
+constexpr uint32_t s_nVersion = 1;
+// The alignment of the sample data in the file
+constexpr uint32_t s_nDataAlign = 64;
+
+// Written as is: the cache is only read by the same architecture
+struct FileHeader
+{
+	char m_aMagic[8];
+	uint32_t m_nByteOrder;
+	uint32_t m_nVersion;
+	int64_t m_nFileSize;
+	int64_t m_nFileMtimeNsec;
+	int32_t m_nOptions;
+	int32_t m_nTargetFrequency;
+	int32_t m_nFormat;
+	int32_t m_nFrequency;
+	int32_t m_nBlockFrames;
+	int32_t m_nDownmixed;
+	uint32_t m_nPathSize;
+	uint32_t m_nDataOffset;
+	int64_t m_nDataSize;
+};
+static_assert(sizeof(FileHeader) == 72, "Unexpected padding");
+
+uint64_t fnv1a(uint64_t nHash, const void* p0Data, std::size_t nSize) noexcept
+{
+	const uint8_t* p0Bytes = static_cast<const uint8_t*>(p0Data);
+	for (std::size_t nIdx = 0; nIdx < nSize; ++nIdx) {
+		nHash ^= p0Bytes[nIdx];
+		nHash *= 0x100000001b3ULL;
+	}
+	return nHash;
+}
+
+bool writeAll(int nFD, const void* p0Data, std::size_t nSize) noexcept
+{
+	const uint8_t* p0Bytes = static_cast<const uint8_t*>(p0Data);
+	while (nSize > 0) {
+		const ssize_t nWritten = ::write(nFD, p0Bytes, nSize);
+		if (nWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false; //----------------------------------------------------
+		}
+		p0Bytes += nWritten;
+		nSize -= static_cast<std::size_t>(nWritten);
+	}
+	return true;
+}
+
+} // unnamed namespace
+
+PcmDiskCache::Mapping::~Mapping() noexcept
+{
+	release();
+}
+void PcmDiskCache::Mapping::release() noexcept
+{
+	if (m_p0Mapped != nullptr) {
+		::munmap(m_p0Mapped, m_nMappedSize);
+		m_p0Mapped = nullptr;
+		m_nMappedSize = 0;
+	}
+	m_oData = Data{};
+}
+
+bool PcmDiskCache::getFileKey(const std::string& sFilePath, Key& oKey) noexcept
+{
+	struct stat oStat;
+	if (::stat(sFilePath.c_str(), &oStat) != 0) {
+		return false; //--------------------------------------------------------
+	}
+	oKey.m_sFilePath = sFilePath;
+	oKey.m_nFileSize = static_cast<int64_t>(oStat.st_size);
+	oKey.m_nFileMtimeNsec = static_cast<int64_t>(oStat.st_mtim.tv_sec) * 1000000000 + oStat.st_mtim.tv_nsec;
+	return true;
+}
+std::string PcmDiskCache::getEntryPath(const std::string& sDirectory, const Key& oKey) noexcept
+{
+	assert(! sDirectory.empty());
+	uint64_t nHash = 0xcbf29ce484222325ULL;
+	nHash = fnv1a(nHash, oKey.m_sFilePath.data(), oKey.m_sFilePath.size());
+	nHash = fnv1a(nHash, &oKey.m_nFileSize, sizeof(oKey.m_nFileSize));
+	nHash = fnv1a(nHash, &oKey.m_nFileMtimeNsec, sizeof(oKey.m_nFileMtimeNsec));
+	nHash = fnv1a(nHash, &oKey.m_nOptions, sizeof(oKey.m_nOptions));
+	nHash = fnv1a(nHash, &oKey.m_nTargetFrequency, sizeof(oKey.m_nTargetFrequency));
+	char aName[32];
+	std::snprintf(aName, sizeof(aName), "%016llx.pcm", static_cast<unsigned long long>(nHash));
+	return sDirectory + "/" + aName;
+}
+bool PcmDiskCache::lookup(const std::string& sDirectory, const Key& oKey, Mapping& oMapping) noexcept
+{
+	oMapping.release();
+	const std::string sEntryPath = getEntryPath(sDirectory, oKey);
+	const int nFD = ::open(sEntryPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (nFD < 0) {
+		return false; //--------------------------------------------------------
+	}
+	struct stat oStat;
+	const bool bStat = (::fstat(nFD, &oStat) == 0);
+	const std::size_t nMappedSize = (bStat ? static_cast<std::size_t>(oStat.st_size) : 0);
+	void* p0Mapped = ((nMappedSize >= sizeof(FileHeader))
+					? ::mmap(nullptr, nMappedSize, PROT_READ, MAP_SHARED, nFD, 0)
+					: MAP_FAILED);
+	// the mapping stays valid
+	::close(nFD);
+	if (p0Mapped == MAP_FAILED) {
+		return false; //--------------------------------------------------------
+	}
+	oMapping.m_p0Mapped = p0Mapped;
+	oMapping.m_nMappedSize = nMappedSize;
+	const uint8_t* p0Bytes = static_cast<const uint8_t*>(p0Mapped);
+	FileHeader oHeader;
+	std::memcpy(&oHeader, p0Bytes, sizeof(FileHeader));
+	const bool bValid = (std::memcmp(oHeader.m_aMagic, s_aMagic, sizeof(s_aMagic)) == 0)
+						&& (oHeader.m_nByteOrder == s_nByteOrder) && (oHeader.m_nVersion == s_nVersion)
+						&& (oHeader.m_nFileSize == oKey.m_nFileSize) && (oHeader.m_nFileMtimeNsec == oKey.m_nFileMtimeNsec)
+						&& (oHeader.m_nOptions == oKey.m_nOptions) && (oHeader.m_nTargetFrequency == oKey.m_nTargetFrequency)
+						&& (oHeader.m_nPathSize == oKey.m_sFilePath.size())
+						&& (sizeof(FileHeader) + oHeader.m_nPathSize <= oHeader.m_nDataOffset)
+						&& (oHeader.m_nDataSize >= 0) && (oHeader.m_nDataSize <= 0x7FFFFFFF)
+						&& (oHeader.m_nDataOffset + static_cast<uint64_t>(oHeader.m_nDataSize) <= nMappedSize)
+						// hash collision
+						&& (std::memcmp(p0Bytes + sizeof(FileHeader), oKey.m_sFilePath.data(), oHeader.m_nPathSize) == 0);
+	if (! bValid) {
+		oMapping.release();
+		return false; //--------------------------------------------------------
+	}
+	Data& oData = oMapping.m_oData;
+	oData.m_nFormat = oHeader.m_nFormat;
+	oData.m_nFrequency = oHeader.m_nFrequency;
+	oData.m_nBlockFrames = oHeader.m_nBlockFrames;
+	oData.m_bDownmixed = (oHeader.m_nDownmixed != 0);
+	oData.m_p0Data = p0Bytes + oHeader.m_nDataOffset;
+	oData.m_nDataSize = static_cast<int32_t>(oHeader.m_nDataSize);
+	return true;
+}
+std::string PcmDiskCache::store(const std::string& sDirectory, const Key& oKey, const Data& oData) noexcept
+{
+	if ((::mkdir(sDirectory.c_str(), 0755) != 0) && (errno != EEXIST)) {
+		return "Could not create directory " + sDirectory; //-------------------
+	}
+	FileHeader oHeader;
+	std::memset(&oHeader, 0, sizeof(FileHeader));
+	std::memcpy(oHeader.m_aMagic, s_aMagic, sizeof(s_aMagic));
+	oHeader.m_nByteOrder = s_nByteOrder;
+	oHeader.m_nVersion = s_nVersion;
+	oHeader.m_nFileSize = oKey.m_nFileSize;
+	oHeader.m_nFileMtimeNsec = oKey.m_nFileMtimeNsec;
+	oHeader.m_nOptions = oKey.m_nOptions;
+	oHeader.m_nTargetFrequency = oKey.m_nTargetFrequency;
+	oHeader.m_nFormat = oData.m_nFormat;
+	oHeader.m_nFrequency = oData.m_nFrequency;
+	oHeader.m_nBlockFrames = oData.m_nBlockFrames;
+	oHeader.m_nDownmixed = (oData.m_bDownmixed ? 1 : 0);
+	oHeader.m_nPathSize = static_cast<uint32_t>(oKey.m_sFilePath.size());
+	const uint32_t nUnaligned = static_cast<uint32_t>(sizeof(FileHeader)) + oHeader.m_nPathSize;
+	oHeader.m_nDataOffset = (nUnaligned + s_nDataAlign - 1) / s_nDataAlign * s_nDataAlign;
+	oHeader.m_nDataSize = oData.m_nDataSize;
+
+	const std::string sEntryPath = getEntryPath(sDirectory, oKey);
+	const std::string sTempPath = sEntryPath + "." + std::to_string(::getpid()) + ".tmp";
+	const int nFD = ::open(sTempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (nFD < 0) {
+		return "Could not create file " + sTempPath; //-------------------------
+	}
+	const std::vector<uint8_t> aPadding(oHeader.m_nDataOffset - nUnaligned, 0);
+	const bool bWritten = writeAll(nFD, &oHeader, sizeof(FileHeader))
+						&& writeAll(nFD, oKey.m_sFilePath.data(), oKey.m_sFilePath.size())
+						&& writeAll(nFD, aPadding.data(), aPadding.size())
+						&& writeAll(nFD, oData.m_p0Data, static_cast<std::size_t>(oData.m_nDataSize));
+	const bool bClosed = (::close(nFD) == 0);
+	if (! (bWritten && bClosed)) {
+		::unlink(sTempPath.c_str());
+		return "Could not write file " + sTempPath; //--------------------------
+	}
+	if (::rename(sTempPath.c_str(), sEntryPath.c_str()) != 0) {
+		::unlink(sTempPath.c_str());
+		return "Could not rename file " + sTempPath; //-------------------------
+	}
+	return "";
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmdiskcache.h
+ */
+
+#ifndef STMI_OPENAL_PCM_DISK_CACHE_H
+#define STMI_OPENAL_PCM_DISK_CACHE_H
+
+#include <string>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Persistent cache of decoded and converted sounds.
+ * Each entry is a file in the cache directory whose name is a hash of the key.
+ * The file starts with a header followed by the sample data, aligned so that
+ * the data can be passed to alBufferData() straight from the mapped file.
+ *
+ * An entry is only valid as long as the size and the modification time of the
+ * sound file are the same as when it was stored and the options it was
+ * converted with are the same.
+ */
+class PcmDiskCache
+{
+public:
+	/** Identifies a sound file and how it was converted. */
+	struct Key
+	{
+		std::string m_sFilePath; /**< The sound file path. */
+		int64_t m_nFileSize = -1; /**< The size of the sound file. */
+		int64_t m_nFileMtimeNsec = -1; /**< The modification time of the sound file in nanoseconds. */
+		int32_t m_nOptions = 0; /**< The conversion options (caller defined). */
+		int32_t m_nTargetFrequency = 0; /**< The frequency the sound was resampled to or 0. */
+	};
+	/** The cached data. */
+	struct Data
+	{
+		int32_t m_nFormat = 0; /**< The AL buffer format. */
+		int32_t m_nFrequency = 0; /**< The frequency. */
+		int32_t m_nBlockFrames = 0; /**< The AL_UNPACK_BLOCK_ALIGNMENT_SOFT or 0. */
+		bool m_bDownmixed = false; /**< Whether the sound was down-mixed to mono. */
+		const uint8_t* m_p0Data = nullptr; /**< The samples. */
+		int32_t m_nDataSize = 0; /**< The size of the samples. */
+	};
+	/** A mapped cache entry.
+	 * The data is valid until the object is destroyed or reused.
+	 */
+	class Mapping
+	{
+	public:
+		Mapping() noexcept = default;
+		~Mapping() noexcept;
+		const Data& getData() const noexcept { return m_oData; }
+		/** Unmaps the file.
+		 */
+		void release() noexcept;
+	private:
+		friend class PcmDiskCache;
+		void* m_p0Mapped = nullptr;
+		std::size_t m_nMappedSize = 0;
+		Data m_oData;
+	private:
+		Mapping(const Mapping& oSource) = delete;
+		Mapping& operator=(const Mapping& oSource) = delete;
+	};
+
+	/** Fills the file part of a key.
+	 * @param sFilePath The sound file path.
+	 * @param oKey The key. The options are not changed.
+	 * @return Whether the file exists.
+	 */
+	static bool getFileKey(const std::string& sFilePath, Key& oKey) noexcept;
+	/** The path of the cache file of a key.
+	 * @param sDirectory The cache directory. Cannot be empty.
+	 * @param oKey The key.
+	 * @return The path.
+	 */
+	static std::string getEntryPath(const std::string& sDirectory, const Key& oKey) noexcept;
+	/** Maps a cache entry.
+	 * @param sDirectory The cache directory. Cannot be empty.
+	 * @param oKey The key.
+	 * @param oMapping The mapping.
+	 * @return Whether a valid entry was found.
+	 */
+	static bool lookup(const std::string& sDirectory, const Key& oKey, Mapping& oMapping) noexcept;
+	/** Stores a cache entry.
+	 * The entry is written to a temporary file that is then renamed, so that
+	 * other processes never map a partially written entry.
+	 * @param sDirectory The cache directory. Cannot be empty. Is created if it doesn't exist.
+	 * @param oKey The key.
+	 * @param oData The data.
+	 * @return The error or empty if successful.
+	 */
+	static std::string store(const std::string& sDirectory, const Key& oKey, const Data& oData) noexcept;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_PCM_DISK_CACHE_H */
@@ -0,0 +1,181 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmencoder.cc
+ */
+
+#include "pcmencoder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+namespace
+{
+
+const int8_t s_aIma4IndexTable[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+const int16_t s_aIma4StepTable[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+inline int32_t floatToInt16(float fSample) noexcept
+{
+	const float fClipped = std::min(1.0f, std::max(-1.0f, fSample));
+	return static_cast<int32_t>(std::lrint(fClipped * 32767.0f));
+}
+
+uint8_t int16ToMulaw(int32_t nSample) noexcept
+{
+	constexpr int32_t nBias = 0x84;
+	constexpr int32_t nClip = 32635;
+	const int32_t nSign = ((nSample < 0) ? 0x80 : 0);
+	int32_t nMagnitude = ((nSample < 0) ? -nSample : nSample);
+	nMagnitude = std::min(nMagnitude, nClip) + nBias;
+	int32_t nExponent = 7;
+	for (int32_t nMask = 0x4000; ((nMagnitude & nMask) == 0) && (nExponent > 0); nMask >>= 1) {
+		--nExponent;
+	}
+	const int32_t nMantissa = (nMagnitude >> (nExponent + 3)) & 0x0F;
+	return static_cast<uint8_t>(~(nSign | (nExponent << 4) | nMantissa));
+}
+
+struct Ima4State
+{
+	int32_t m_nPredictor = 0;
+	int32_t m_nStepIdx = 0;
+};
+// Returns the 4 bit code and updates the state as the decoder will
+uint8_t encodeIma4Sample(Ima4State& oState, int32_t nSample) noexcept
+{
+	const int32_t nStep = s_aIma4StepTable[oState.m_nStepIdx];
+	int32_t nDiff = nSample - oState.m_nPredictor;
+	uint8_t nCode = 0;
+	if (nDiff < 0) {
+		nCode = 8;
+		nDiff = -nDiff;
+	}
+	// the same rounding the decoder applies
+	int32_t nDelta = nStep >> 3;
+	if (nDiff >= nStep) {
+		nCode |= 4;
+		nDiff -= nStep;
+		nDelta += nStep;
+	}
+	if (nDiff >= (nStep >> 1)) {
+		nCode |= 2;
+		nDiff -= (nStep >> 1);
+		nDelta += (nStep >> 1);
+	}
+	if (nDiff >= (nStep >> 2)) {
+		nCode |= 1;
+		nDelta += (nStep >> 2);
+	}
+	oState.m_nPredictor += (((nCode & 8) != 0) ? -nDelta : nDelta);
+	oState.m_nPredictor = std::min(32767, std::max(-32768, oState.m_nPredictor));
+	oState.m_nStepIdx = std::min(88, std::max(0, oState.m_nStepIdx + s_aIma4IndexTable[nCode]));
+	return nCode;
+}
+
+} // unnamed namespace
+
+const int8_t* PcmEncoder::getIma4IndexTable() noexcept
+{
+	return s_aIma4IndexTable;
+}
+const int16_t* PcmEncoder::getIma4StepTable() noexcept
+{
+	return s_aIma4StepTable;
+}
+
+void PcmEncoder::encodeMulaw(const PcmSound& oSound, std::vector<uint8_t>& aData) noexcept
+{
+	const int32_t nTotSamples = static_cast<int32_t>(oSound.m_aSamples.size());
+	aData.resize(nTotSamples);
+	for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+		aData[nIdx] = int16ToMulaw(floatToInt16(oSound.m_aSamples[nIdx]));
+	}
+}
+
+void PcmEncoder::encodeIma4(const PcmSound& oSound, int32_t nBlockFrames, std::vector<uint8_t>& aData) noexcept
+{
+	const int32_t nChannels = oSound.m_nChannels;
+	assert((nChannels == 1) || (nChannels == 2));
+	assert((nBlockFrames > 1) && (((nBlockFrames - 1) % 8) == 0));
+	const int32_t nTotFrames = oSound.getTotFrames();
+	const int32_t nTotBlocks = (nTotFrames + nBlockFrames - 1) / nBlockFrames;
+	const int32_t nBlockBytes = getIma4BlockBytes(nChannels, nBlockFrames);
+	aData.assign(nTotBlocks * nBlockBytes, 0);
+	const float* p0Samples = oSound.m_aSamples.data();
+	// Padding frames are silent
+	auto getSample = [&](int32_t nFrame, int32_t nChannel) -> int32_t
+	{
+		return ((nFrame < nTotFrames) ? floatToInt16(p0Samples[nFrame * nChannels + nChannel]) : 0);
+	};
+	Ima4State aStates[2];
+	for (int32_t nBlock = 0; nBlock < nTotBlocks; ++nBlock) {
+		uint8_t* p0Block = aData.data() + nBlock * nBlockBytes;
+		const int32_t nFirstFrame = nBlock * nBlockFrames;
+		// header: the first frame is stored uncompressed
+		for (int32_t nChannel = 0; nChannel < nChannels; ++nChannel) {
+			Ima4State& oState = aStates[nChannel];
+			oState.m_nPredictor = getSample(nFirstFrame, nChannel);
+			uint8_t* p0Header = p0Block + 4 * nChannel;
+			p0Header[0] = static_cast<uint8_t>(oState.m_nPredictor & 0xFF);
+			p0Header[1] = static_cast<uint8_t>((oState.m_nPredictor >> 8) & 0xFF);
+			p0Header[2] = static_cast<uint8_t>(oState.m_nStepIdx);
+			p0Header[3] = 0;
+		}
+		uint8_t* p0Data = p0Block + 4 * nChannels;
+		// groups of 8 frames, for each channel 4 bytes
+		for (int32_t nGroupFrame = nFirstFrame + 1; nGroupFrame < nFirstFrame + nBlockFrames; nGroupFrame += 8) {
+			for (int32_t nChannel = 0; nChannel < nChannels; ++nChannel) {
+				Ima4State& oState = aStates[nChannel];
+				for (int32_t nByte = 0; nByte < 4; ++nByte) {
+					const int32_t nFrame = nGroupFrame + 2 * nByte;
+					const uint8_t nLow = encodeIma4Sample(oState, getSample(nFrame, nChannel));
+					const uint8_t nHigh = encodeIma4Sample(oState, getSample(nFrame + 1, nChannel));
+					*p0Data = static_cast<uint8_t>(nLow | (nHigh << 4));
+					++p0Data;
+				}
+			}
+		}
+	}
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
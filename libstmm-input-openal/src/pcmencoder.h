@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   pcmencoder.h
+ */
+
+#ifndef STMI_OPENAL_PCM_ENCODER_H
+#define STMI_OPENAL_PCM_ENCODER_H
+
+#include "wavdecoder.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Encoders of the compressed sample formats OpenAL Soft can mix from.
+ * The formats are decoded by OpenAL while mixing, so that the buffers take
+ * less memory at a small mixing cost.
+ */
+class PcmEncoder
+{
+public:
+	/** Encodes to 8 bit G.711 μ-law (AL_EXT_MULAW).
+	 * Halves the size of 16 bit samples.
+	 * @param oSound The sound. Must have at least one channel.
+	 * @param aData The encoded interleaved samples.
+	 */
+	static void encodeMulaw(const PcmSound& oSound, std::vector<uint8_t>& aData) noexcept;
+	/** Encodes to IMA ADPCM blocks (AL_EXT_IMA4).
+	 * The block layout is the one of WAV IMA ADPCM (Microsoft): for each channel
+	 * a 4 byte header (first sample and step index) followed by groups of
+	 * 4 bytes per channel, each containing 8 samples (low nibble first).
+	 * The last block is padded with silence.
+	 * Reduces the size of 16 bit samples about four times.
+	 * @param oSound The sound. Must have one or two channels.
+	 * @param nBlockFrames The frames per block. Must be 1 + a positive multiple of 8.
+	 *                     OpenAL's default is 65, other values need AL_SOFT_block_alignment.
+	 * @param aData The encoded blocks.
+	 */
+	static void encodeIma4(const PcmSound& oSound, int32_t nBlockFrames, std::vector<uint8_t>& aData) noexcept;
+	/** The size of an IMA4 block.
+	 * @param nChannels The number of channels.
+	 * @param nBlockFrames The frames per block.
+	 * @return The size in bytes.
+	 */
+	static int32_t getIma4BlockBytes(int32_t nChannels, int32_t nBlockFrames) noexcept
+	{
+		return nChannels * (4 + (nBlockFrames - 1) / 2);
+	}
+	/** The IMA ADPCM step index table.
+	 * @return The adjustment of the step index for each 4 bit code.
+	 */
+	static const int8_t* getIma4IndexTable() noexcept;
+	/** The IMA ADPCM step size table.
+	 * @return The 89 step sizes.
+	 */
+	static const int16_t* getIma4StepTable() noexcept;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_PCM_ENCODER_H */
@@ -20,8 +20,9 @@
 
 #include "playbackdevice.h"
 
-#include "openalbackend.h"
+#include "backend.h"
 #include "openallistenerextradata.h"
+#include "soundbank.h"
 
 #include <stmm-input-base/basicdevicemanager.h>
 #include <stmm-input-base/basicdevice.h>
@@ -36,6 +37,7 @@
 #include <cassert>
 #include <iostream>
 #include <iterator>
+#include <limits>
 
 namespace stmi { class Device; }
 
@@ -47,8 +49,10 @@ namespace Private
 namespace OpenAl
 {
 
-static int32_t s_nFileId = 0;
-static int32_t s_nSoundId = 0;
+// Shared by all the devices, incremented by any thread
+static std::atomic<int32_t> s_nFileId{0};
+static std::atomic<int32_t> s_nSoundId{0};
+static std::atomic<int32_t> s_nBatchId{0};
 
 PlaybackDevice::PlaybackDevice(const std::string& sName, const shared_ptr<OpenAlDeviceManager>& refDeviceManager
 								, Backend& oBackend, int32_t nBackendDeviceId, bool bIsDefault) noexcept
@@ -56,6 +60,8 @@ PlaybackDevice::PlaybackDevice(const std::string& sName, const shared_ptr<OpenAl
 , m_oBackend(oBackend)
 , m_nBackendDeviceId(nBackendDeviceId)
 , m_bIsDefault(bIsDefault)
+, m_bRemoved(false)
+, m_nTotSoundGroups(0)
 {
 }
 shared_ptr<Device> PlaybackDevice::getDevice() const noexcept
@@ -95,7 +101,25 @@ std::vector<Capability::Class> PlaybackDevice::getCapabilityClasses() const noex
 }
 void PlaybackDevice::removingDevice() noexcept
 {
-	resetOwnerDeviceManager();
+	m_bRemoved.store(true, std::memory_order_release);
+	if (! m_oBackend.isThreadSafePlayback()) {
+		// otherwise other threads might be calling getOwnerDeviceManager()
+		resetOwnerDeviceManager();
+	}
+}
+shared_ptr<OpenAlDeviceManager> PlaybackDevice::getOwner() const noexcept
+{
+	if (m_bRemoved.load(std::memory_order_acquire)) {
+		return shared_ptr<OpenAlDeviceManager>{}; //----------------------------
+	}
+	return getOwnerDeviceManager();
+}
+std::unique_lock<std::mutex> PlaybackDevice::lockIfThreadSafe(std::mutex& oMutex) const noexcept
+{
+	if (m_oBackend.isThreadSafePlayback()) {
+		return std::unique_lock<std::mutex>(oMutex); //-------------------------
+	}
+	return std::unique_lock<std::mutex>(oMutex, std::defer_lock);
 }
 
 void PlaybackDevice::setIsDefault(bool bIsDefault) noexcept
@@ -103,12 +127,58 @@ void PlaybackDevice::setIsDefault(bool bIsDefault) noexcept
 	m_bIsDefault = bIsDefault;
 }
 
-int32_t PlaybackDevice::preloadSound(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize) noexcept
+int32_t PlaybackDevice::findFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t& nBufferSize) const noexcept
+{
+	if (p0Buffer == nullptr) {
+		const int32_t nIdx = m_aFileNameToIds.findIf([&](const FileNameToId& oFileNameToId)
+		{
+			return oFileNameToId.m_sFileName == sFileName;
+		});
+		return ((nIdx < 0) ? -1 : m_aFileNameToIds[nIdx].m_nFileId); //--------
+	}
+	const int32_t nIdx = m_aBufferToIds.findIf([&](const BufferToId& oBufferToId)
+	{
+		return oBufferToId.m_p0Buffer == p0Buffer;
+	});
+	if (nIdx < 0) {
+		return -1; //-----------------------------------------------------------
+	}
+	const BufferToId& oBufferToId = m_aBufferToIds[nIdx];
+	nBufferSize = oBufferToId.m_nBufferSize;
+	return oBufferToId.m_nFileId;
+}
+int32_t PlaybackDevice::getOrAddFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t& nBufferSize
+										, bool& bAdded) noexcept
+{
+	bAdded = false;
+	int32_t nFileId = findFileId(sFileName, p0Buffer, nBufferSize);
+	if (nFileId >= 0) {
+		return nFileId; //------------------------------------------------------
+	}
+	auto oLock = lockIfThreadSafe(m_oAddFileIdMutex);
+	if (oLock.owns_lock()) {
+		// another thread might have added it in the meantime
+		nFileId = findFileId(sFileName, p0Buffer, nBufferSize);
+		if (nFileId >= 0) {
+			return nFileId; //--------------------------------------------------
+		}
+	}
+	bAdded = true;
+	return addFileId(sFileName, p0Buffer, nBufferSize);
+}
+int32_t PlaybackDevice::addFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize) noexcept
+{
+	const int32_t nFileId = s_nFileId.fetch_add(1, std::memory_order_relaxed);
+	if (p0Buffer == nullptr) {
+		m_aFileNameToIds.push_back(FileNameToId{sFileName, nFileId});
+	} else {
+		m_aBufferToIds.push_back(BufferToId{p0Buffer, nBufferSize, nFileId});
+	}
+	return nFileId;
+}
+void PlaybackDevice::sendPreloadCommand(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize
+										, int32_t nFileId, int32_t nBatchId, PRELOAD_PRIORITY ePriority) noexcept
 {
-	const int32_t nFileId = s_nFileId;
-	++s_nFileId;
-	m_aFileNameToIds.push_back(FileNameToId{sFileName, nFileId});
-
 	Backend::AlCommand oAlCommand;
 	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
 	oAlCommand.m_eType = Backend::AL_COMMAND_PRELOAD;
@@ -126,48 +196,161 @@ int32_t PlaybackDevice::preloadSound(const std::string& sFileName, uint8_t const
 	//oAlCommand.m_fPosX = fX;
 	//oAlCommand.m_fPosY = fY;
 	//oAlCommand.m_fPosZ = fZ;
+	oAlCommand.m_nBatchId = nBatchId;
+	oAlCommand.m_nPriority = static_cast<int32_t>(ePriority);
 
 	m_oBackend.sendCommand(std::move(oAlCommand));
-	return nFileId;
 }
 int32_t PlaybackDevice::preloadSound(const std::string& sFileName) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return -1; //-----------------------------------------------------------
 	}
-	const auto itFind = std::find_if(m_aFileNameToIds.begin(), m_aFileNameToIds.end(), [&](const FileNameToId& oFileNameToId)
-	{
-		return oFileNameToId.m_sFileName == sFileName;
-	});
-	if (itFind != m_aFileNameToIds.end()) {
-		return itFind->m_nFileId; //--------------------------------------------
+	int32_t nBufferSize = 0;
+	bool bAdded;
+	const int32_t nFileId = getOrAddFileId(sFileName, nullptr, nBufferSize, bAdded);
+	if (bAdded) {
+		sendPreloadCommand(sFileName, nullptr, 0, nFileId, -1, PRELOAD_PRIORITY_NORMAL);
 	}
-	return preloadSound(sFileName, nullptr, 0);
+	return nFileId;
 }
 int32_t PlaybackDevice::preloadSound(uint8_t const* p0Buffer, int32_t nBufferSize) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return -1; //-----------------------------------------------------------
 	}
-	const auto itFind = std::find_if(m_aBufferToIds.begin(), m_aBufferToIds.end(), [&](const BufferToId& oBufferToId)
+	bool bAdded;
+	const int32_t nFileId = getOrAddFileId("", p0Buffer, nBufferSize, bAdded);
+	if (bAdded) {
+		sendPreloadCommand("", p0Buffer, nBufferSize, nFileId, -1, PRELOAD_PRIORITY_NORMAL);
+	}
+	return nFileId;
+}
+PlaybackCapability::PreloadBatch PlaybackDevice::preloadSounds(const std::vector<std::string>& aFileNames
+																, PRELOAD_PRIORITY ePriority) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || aFileNames.empty()) {
+		return PreloadBatch{}; //-----------------------------------------------
+	}
+	OpenAlDeviceManager* p0Owner = refOwner.get();
+
+	const int32_t nBatchId = s_nBatchId.fetch_add(1, std::memory_order_relaxed);
+	PreloadBatch oBatch;
+	oBatch.m_nBatchId = nBatchId;
+	oBatch.m_aFileIds.reserve(aFileNames.size());
 	{
-		return oBufferToId.m_p0Buffer == p0Buffer;
+		// Before the commands are sent so that the batch is found by onPreloaded()
+		auto oLock = lockIfThreadSafe(m_oPreloadsMutex);
+		m_aPendingBatches.push_back(PendingBatch{nBatchId, p0Owner->getUniqueTimeStamp()
+												, static_cast<int32_t>(aFileNames.size()), 0});
+	}
+	for (const auto& sFileName : aFileNames) {
+		assert(! sFileName.empty());
+		int32_t nBufferSize = 0;
+		bool bAdded;
+		const int32_t nFileId = getOrAddFileId(sFileName, nullptr, nBufferSize, bAdded);
+		// Sent even if already loaded: the backend reports when it is ready
+		sendPreloadCommand(sFileName, nullptr, 0, nFileId, nBatchId, ePriority);
+		oBatch.m_aFileIds.push_back(nFileId);
+	}
+	return oBatch;
+}
+bool PlaybackDevice::cancelPreloadBatch(int32_t nBatchId) noexcept
+{
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return false; //--------------------------------------------------------
+	}
+	{
+		auto oLock = lockIfThreadSafe(m_oPreloadsMutex);
+		const auto itFind = std::find_if(m_aPendingBatches.begin(), m_aPendingBatches.end(), [&](const PendingBatch& oPendingBatch)
+		{
+			return oPendingBatch.m_nBatchId == nBatchId;
+		});
+		if (itFind == m_aPendingBatches.end()) {
+			return false; //----------------------------------------------------
+		}
+		// no SndPreloadedEvent is sent for cancelled batches
+		m_aPendingBatches.erase(itFind);
+	}
+
+	Backend::AlCommand oAlCommand;
+	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
+	oAlCommand.m_eType = Backend::AL_COMMAND_CANCEL_PRELOADS;
+	oAlCommand.m_nBatchId = nBatchId;
+
+	m_oBackend.sendCommand(std::move(oAlCommand));
+
+	return true;
+}
+std::vector<PlaybackCapability::BankEntry> PlaybackDevice::preloadBank(const std::string& sBankPath) noexcept
+{
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return std::vector<BankEntry>{}; //-------------------------------------
+	}
+	// Held while the bank is opened so that it is only preloaded once
+	auto oPreloadsLock = lockIfThreadSafe(m_oPreloadsMutex);
+	const auto itFind = std::find_if(m_aPreloadedBanks.begin(), m_aPreloadedBanks.end(), [&](const PreloadedBank& oPreloadedBank)
+	{
+		return oPreloadedBank.m_sBankPath == sBankPath;
 	});
-	if (itFind != m_aBufferToIds.end()) {
-		return itFind->m_nFileId; //--------------------------------------------
+	if (itFind != m_aPreloadedBanks.end()) {
+		return itFind->m_aEntries; //-------------------------------------------
+	}
+	std::string sError;
+	// The bank stays mapped as long as the device manager exists
+	const auto refSoundBank = refOwner->openSoundBank(sBankPath, sError);
+	if (! refSoundBank) {
+		// The empty result tells the caller the bank couldn't be opened
+		return std::vector<BankEntry>{}; //-------------------------------------
+	}
+	const int32_t nTotEntries = refSoundBank->getTotEntries();
+	std::vector<BankEntry> aEntries;
+	aEntries.reserve(nTotEntries);
+	for (int32_t nIdx = 0; nIdx < nTotEntries; ++nIdx) {
+		uint8_t const* p0EntryData = refSoundBank->getEntryData(nIdx);
+		const int32_t nEntrySize = refSoundBank->getEntrySize(nIdx);
+		int32_t nFileId;
+		{
+			// The entries point into the mapping, no need to look for duplicates
+			auto oLock = lockIfThreadSafe(m_oAddFileIdMutex);
+			nFileId = addFileId("", p0EntryData, nEntrySize);
+		}
+		sendPreloadCommand("", p0EntryData, nEntrySize, nFileId, -1, PRELOAD_PRIORITY_NORMAL);
+		aEntries.push_back(BankEntry{refSoundBank->getEntryName(nIdx), nFileId});
 	}
-	return preloadSound("", p0Buffer, nBufferSize);
+	m_aPreloadedBanks.push_back(PreloadedBank{sBankPath, aEntries});
+	return aEntries;
 }
-int32_t PlaybackDevice::playSound(OpenAlDeviceManager* p0Owner
+int32_t PlaybackDevice::playSound(OpenAlDeviceManager* p0Owner, int32_t nGroupId
 							, const std::string& sFileName, const uint8_t* p0Buffer, int32_t nBufferSize, int32_t nFileId
-							, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ) noexcept
+							, int64_t nStartClockNanosec, bool bPrepared
+							, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ
+							, std::vector<Backend::AlCommand>* p0Commands) noexcept
 {
-	const int32_t nSoundId = s_nSoundId;
-	++s_nSoundId;
-	m_aActiveSoundIds.push_back(nSoundId);
-	m_aActiveSoundStarts.push_back(p0Owner->getUniqueTimeStamp());
+	const int32_t nSoundId = s_nSoundId.fetch_add(1, std::memory_order_relaxed);
+	int32_t nTriggerSlot = -1;
+	if (bPrepared) {
+		// the slot is owned by the sound id so that a stale id can't trigger another sound
+		nTriggerSlot = m_oBackend.reserveTriggerSlot(nSoundId);
+		if (nTriggerSlot < 0) {
+			// too many prepared sounds
+			return -1; //-------------------------------------------------------
+		}
+	}
+	// Only the main thread can get a time stamp, the sounds played by the
+	// other threads are reported to all the listeners
+	const uint64_t nStartedTimeStamp = (m_oBackend.isMainThread() ? p0Owner->getUniqueTimeStamp()
+																: std::numeric_limits<uint64_t>::max());
+	{
+		ActiveSoundShard& oShard = getActiveSoundShard(nSoundId);
+		auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+		oShard.m_aActiveSounds.push_back(ActiveSound{nSoundId, nStartedTimeStamp, nGroupId, bPrepared});
+	}
 
 	Backend::AlCommand oAlCommand;
 	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
@@ -186,101 +369,217 @@ int32_t PlaybackDevice::playSound(OpenAlDeviceManager* p0Owner
 	oAlCommand.m_fPosX = fX;
 	oAlCommand.m_fPosY = fY;
 	oAlCommand.m_fPosZ = fZ;
+	oAlCommand.m_bMonoDownmix = (p0Owner->getFileMonoDownmixPolicy(sFileName) == OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	oAlCommand.m_nGroupId = nGroupId;
+	oAlCommand.m_nStartClockNanosec = nStartClockNanosec;
+	oAlCommand.m_nTriggerSlot = nTriggerSlot;
 
-	m_oBackend.sendCommand(std::move(oAlCommand));
-
+	if (p0Commands != nullptr) {
+		p0Commands->push_back(std::move(oAlCommand));
+	} else {
+		m_oBackend.sendCommand(std::move(oAlCommand));
+	}
 	return nSoundId;
 }
 PlaybackCapability::SoundData PlaybackDevice::playSound(const std::string& sFileName, double fVolume, bool bLoop
 														, bool bRelative, double fX, double fY, double fZ) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
-	if (!refOwner) {
+	return playSoundInGroup(-1, sFileName, fVolume, bLoop, bRelative, fX, fY, fZ);
+}
+PlaybackCapability::SoundData PlaybackDevice::playSound(const uint8_t* p0Buffer, int32_t nBufferSize, double fVolume, bool bLoop
+														, bool bRelative, double fX, double fY, double fZ) noexcept
+{
+	return playSoundInGroup(-1, p0Buffer, nBufferSize, fVolume, bLoop, bRelative, fX, fY, fZ);
+}
+int32_t PlaybackDevice::playSound(int32_t nFileId, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ) noexcept
+{
+	return playSoundInGroup(-1, nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+}
+PlaybackCapability::SoundData PlaybackDevice::playSoundInGroup(int32_t nGroupId, const std::string& sFileName, double fVolume, bool bLoop
+																, bool bRelative, double fX, double fY, double fZ) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || ! isValidGroupOrNone(nGroupId)) {
 		return PlaybackCapability::SoundData{}; //------------------------------
 	}
 	//
 	OpenAlDeviceManager* p0Owner = refOwner.get();
 
-	const auto itFind = std::find_if(m_aFileNameToIds.begin(), m_aFileNameToIds.end(), [&](const FileNameToId& oFileNameToId)
-	{
-		return oFileNameToId.m_sFileName == sFileName;
-	});
-	int32_t nFileId;
-	if (itFind == m_aFileNameToIds.end()) {
-		nFileId = s_nFileId;
-		++s_nFileId;
-		m_aFileNameToIds.push_back(FileNameToId{sFileName, nFileId});
-	} else {
-		nFileId = itFind->m_nFileId;
-	}
+	int32_t nBufferSize = 0;
+	bool bAdded;
+	const int32_t nFileId = getOrAddFileId(sFileName, nullptr, nBufferSize, bAdded);
 
-	const int32_t nSoundId = playSound(p0Owner, sFileName, nullptr, 0, nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+	const int32_t nSoundId = playSound(p0Owner, nGroupId, sFileName, nullptr, 0, nFileId, -1, false, fVolume, bLoop, bRelative, fX, fY, fZ
+										, nullptr);
 	return SoundData{nSoundId, nFileId};
 }
-PlaybackCapability::SoundData PlaybackDevice::playSound(const uint8_t* p0Buffer, int32_t nBufferSize, double fVolume, bool bLoop
-														, bool bRelative, double fX, double fY, double fZ) noexcept
+PlaybackCapability::SoundData PlaybackDevice::playSoundInGroup(int32_t nGroupId, const uint8_t* p0Buffer, int32_t nBufferSize
+																, double fVolume, bool bLoop
+																, bool bRelative, double fX, double fY, double fZ) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
-	if (!refOwner) {
+	auto refOwner = getOwner();
+	if ((!refOwner) || ! isValidGroupOrNone(nGroupId)) {
 		return PlaybackCapability::SoundData{}; //------------------------------
 	}
 	//
 	OpenAlDeviceManager* p0Owner = refOwner.get();
 
-	const auto itFind = std::find_if(m_aBufferToIds.begin(), m_aBufferToIds.end(), [&](const BufferToId& oBufferToId)
-	{
-		return oBufferToId.m_p0Buffer == p0Buffer;
-	});
-	int32_t nFileId;
-	if (itFind == m_aBufferToIds.end()) {
-		nFileId = s_nFileId;
-		++s_nFileId;
-		m_aBufferToIds.push_back(BufferToId{p0Buffer, nBufferSize, nFileId});
-	} else {
-		nFileId = itFind->m_nFileId;
-		nBufferSize = itFind->m_nBufferSize;
-	}
+	bool bAdded;
+	// if already known nBufferSize is set to the size passed the first time
+	const int32_t nFileId = getOrAddFileId("", p0Buffer, nBufferSize, bAdded);
 
-	const int32_t nSoundId = playSound(p0Owner, "", p0Buffer, nBufferSize, nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+	const int32_t nSoundId = playSound(p0Owner, nGroupId, "", p0Buffer, nBufferSize, nFileId, -1, false, fVolume, bLoop, bRelative, fX, fY, fZ
+										, nullptr);
 	return SoundData{nSoundId, nFileId};
 }
-int32_t PlaybackDevice::playSound(int32_t nFileId, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ) noexcept
+int32_t PlaybackDevice::playSoundInGroup(int32_t nGroupId, int32_t nFileId, double fVolume, bool bLoop
+										, bool bRelative, double fX, double fY, double fZ) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
+	if ((!refOwner) || ! isValidGroupOrNone(nGroupId)) {
+		return -1; //-----------------------------------------------------------
+	}
+	//
+	OpenAlDeviceManager* p0Owner = refOwner.get();
+	return playFileId(p0Owner, nGroupId, nFileId, -1, false, fVolume, bLoop, bRelative, fX, fY, fZ, nullptr);
+}
+int64_t PlaybackDevice::getDeviceClockNanosec() noexcept
+{
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return -1; //-----------------------------------------------------------
 	}
+	return m_oBackend.getDeviceClockNanosec(m_nBackendDeviceId);
+}
+int32_t PlaybackDevice::playSoundAt(int32_t nFileId, int64_t nDeviceClockNanosec, double fVolume, bool bLoop
+									, bool bRelative, double fX, double fY, double fZ) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nDeviceClockNanosec < 0)) {
+		return -1; //-----------------------------------------------------------
+	}
 	//
 	OpenAlDeviceManager* p0Owner = refOwner.get();
-
-	const auto itFindName = std::find_if(m_aFileNameToIds.begin(), m_aFileNameToIds.end(), [&](const FileNameToId& oFileNameToId)
+	return playFileId(p0Owner, -1, nFileId, nDeviceClockNanosec, false, fVolume, bLoop, bRelative, fX, fY, fZ, nullptr);
+}
+std::vector<int32_t> PlaybackDevice::playSoundsTogether(const std::vector<SyncedSound>& aSounds, int64_t nDeviceClockNanosec) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || aSounds.empty() || (nDeviceClockNanosec < 0)) {
+		return std::vector<int32_t>{}; //---------------------------------------
+	}
+	// either all or none
+	for (const SyncedSound& oSound : aSounds) {
+		if ((! isKnownFileId(oSound.m_nFileId)) || ! isValidGroupOrNone(oSound.m_nGroupId)) {
+			return std::vector<int32_t>{}; //-----------------------------------
+		}
+	}
+	//
+	OpenAlDeviceManager* p0Owner = refOwner.get();
+	std::vector<int32_t> aSoundIds;
+	aSoundIds.reserve(aSounds.size());
+	std::vector<Backend::AlCommand> aAlCommands;
+	aAlCommands.reserve(aSounds.size());
+	for (const SyncedSound& oSound : aSounds) {
+		aSoundIds.push_back(playFileId(p0Owner, oSound.m_nGroupId, oSound.m_nFileId, nDeviceClockNanosec, false
+										, oSound.m_fVolume, oSound.m_bLoop, oSound.m_bRelative, oSound.m_fX, oSound.m_fY, oSound.m_fZ
+										, &aAlCommands));
+	}
+	// the backend executes the play commands in the same iteration
+	m_oBackend.sendCommands(std::move(aAlCommands));
+	return aSoundIds;
+}
+int32_t PlaybackDevice::prepareSound(int32_t nFileId, double fVolume, bool bLoop
+									, bool bRelative, double fX, double fY, double fZ) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || ! isKnownFileId(nFileId)) {
+		return -1; //-----------------------------------------------------------
+	}
+	OpenAlDeviceManager* p0Owner = refOwner.get();
+	return playFileId(p0Owner, -1, nFileId, -1, true, fVolume, bLoop, bRelative, fX, fY, fZ, nullptr);
+}
+bool PlaybackDevice::triggerSound(int32_t nSoundId) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nSoundId < 0)) {
+		return false; //--------------------------------------------------------
+	}
+	// lock-free, no command is sent, the backend thread releases the slot
+	return m_oBackend.trigger(nSoundId);
+}
+PlaybackCapability::SoundState PlaybackDevice::getSoundState(int32_t nSoundId) noexcept
+{
+	SoundState oState;
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return oState; //-------------------------------------------------------
+	}
+	const bool bActive = isActiveSound(nSoundId);
+	const bool bPublished = m_oBackend.getSoundState(m_nBackendDeviceId, nSoundId, oState);
+	if (! bPublished) {
+		if (bActive) {
+			// the backend hasn't executed the play command yet
+			oState.m_eState = SOUND_STATE_PENDING;
+		}
+		return oState; //-------------------------------------------------------
+	}
+	if (! bActive) {
+		// stopped or finished event delivered, the backend might not know yet
+		oState.m_eState = SOUND_STATE_STOPPED;
+	}
+	return oState;
+}
+int32_t PlaybackDevice::playFileId(OpenAlDeviceManager* p0Owner, int32_t nGroupId, int32_t nFileId
+									, int64_t nStartClockNanosec, bool bPrepared
+									, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ
+									, std::vector<Backend::AlCommand>* p0Commands) noexcept
+{
+	const int32_t nNameIdx = m_aFileNameToIds.findIf([&](const FileNameToId& oFileNameToId)
 	{
 		return oFileNameToId.m_nFileId == nFileId;
 	});
-	if (itFindName == m_aFileNameToIds.end()) {
+	if (nNameIdx < 0) {
 
-		const auto itFind = std::find_if(m_aBufferToIds.begin(), m_aBufferToIds.end(), [&](const BufferToId& oBufferToId)
+		const int32_t nBufferIdx = m_aBufferToIds.findIf([&](const BufferToId& oBufferToId)
 		{
 			return oBufferToId.m_nFileId == nFileId;
 		});
-		if (itFind == m_aBufferToIds.end()) {
+		if (nBufferIdx < 0) {
 			return -1; //-------------------------------------------------------
 		}
-		return playSound(p0Owner, "", itFind->m_p0Buffer, itFind->m_nBufferSize, nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+		const BufferToId& oBufferToId = m_aBufferToIds[nBufferIdx];
+		return playSound(p0Owner, nGroupId, "", oBufferToId.m_p0Buffer, oBufferToId.m_nBufferSize, nFileId, nStartClockNanosec, bPrepared
+						, fVolume, bLoop, bRelative, fX, fY, fZ, p0Commands);
 	} else {
-		return playSound(p0Owner, itFindName->m_sFileName, nullptr, 0, nFileId, fVolume, bLoop, bRelative, fX, fY, fZ);
+		return playSound(p0Owner, nGroupId, m_aFileNameToIds[nNameIdx].m_sFileName, nullptr, 0, nFileId, nStartClockNanosec, bPrepared
+						, fVolume, bLoop, bRelative, fX, fY, fZ, p0Commands);
 	}
 }
+bool PlaybackDevice::isKnownFileId(int32_t nFileId) const noexcept
+{
+	return (m_aFileNameToIds.findIf([&](const FileNameToId& oFileNameToId)
+			{
+				return oFileNameToId.m_nFileId == nFileId;
+			}) >= 0)
+			|| (m_aBufferToIds.findIf([&](const BufferToId& oBufferToId)
+			{
+				return oBufferToId.m_nFileId == nFileId;
+			}) >= 0);
+}
+bool PlaybackDevice::isValidGroupOrNone(int32_t nGroupId) const noexcept
+{
+	return (nGroupId >= -1) && (nGroupId < m_nTotSoundGroups.load(std::memory_order_acquire));
+}
 
 bool PlaybackDevice::setSoundPos(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	if (itFind == m_aActiveSoundIds.end()) {
+	if (! isActiveSound(nSoundId)) {
 		return false; //--------------------------------------------------------
 	}
 
@@ -296,15 +595,59 @@ bool PlaybackDevice::setSoundPos(int32_t nSoundId, bool bRelative, double fX, do
 	m_oBackend.sendCommand(std::move(oAlCommand));
 	return true;
 }
+bool PlaybackDevice::setSoundMotion(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+									, double fVelX, double fVelY, double fVelZ) noexcept
+{
+	return sendMotionCommand(nSoundId, bRelative, fX, fY, fZ, fVelX, fVelY, fVelZ, -1);
+}
+bool PlaybackDevice::setSoundMotionTo(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+									, double fTargetX, double fTargetY, double fTargetZ, int32_t nArrivalMillisec) noexcept
+{
+	if (nArrivalMillisec <= 0) {
+		// the velocity would be infinite
+		return false; //--------------------------------------------------------
+	}
+	const double fSeconds = nArrivalMillisec / 1000.0;
+	return sendMotionCommand(nSoundId, bRelative, fX, fY, fZ
+							, (fTargetX - fX) / fSeconds, (fTargetY - fY) / fSeconds, (fTargetZ - fZ) / fSeconds
+							, nArrivalMillisec);
+}
+bool PlaybackDevice::sendMotionCommand(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+										, double fVelX, double fVelY, double fVelZ, int32_t nMotionMillisec) noexcept
+{
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return false; //--------------------------------------------------------
+	}
+
+	if (! isActiveSound(nSoundId)) {
+		return false; //--------------------------------------------------------
+	}
+
+	Backend::AlCommand oAlCommand;
+	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
+	oAlCommand.m_eType = Backend::AL_COMMAND_SOUND_MOTION;
+	oAlCommand.m_nSoundId = nSoundId;
+	oAlCommand.m_bRelative = bRelative;
+	oAlCommand.m_fPosX = fX;
+	oAlCommand.m_fPosY = fY;
+	oAlCommand.m_fPosZ = fZ;
+	oAlCommand.m_fVelX = fVelX;
+	oAlCommand.m_fVelY = fVelY;
+	oAlCommand.m_fVelZ = fVelZ;
+	oAlCommand.m_nDurationMillisec = nMotionMillisec;
+
+	m_oBackend.sendCommand(std::move(oAlCommand));
+	return true;
+}
 bool PlaybackDevice::setSoundVol(int32_t nSoundId, double fVolume) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	if (itFind == m_aActiveSoundIds.end()) {
+	if (! isActiveSound(nSoundId)) {
 		return false; //--------------------------------------------------------
 	}
 
@@ -318,9 +661,137 @@ bool PlaybackDevice::setSoundVol(int32_t nSoundId, double fVolume) noexcept
 	return true;
 }
 
+int32_t PlaybackDevice::getSoundGroup(const std::string& sGroupName) noexcept
+{
+	assert(! sGroupName.empty());
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return -1; //-----------------------------------------------------------
+	}
+	const auto itFind = std::find_if(m_aSoundGroups.begin(), m_aSoundGroups.end(), [&](const SoundGroup& oSoundGroup)
+	{
+		return oSoundGroup.m_sGroupName == sGroupName;
+	});
+	if (itFind != m_aSoundGroups.end()) {
+		return static_cast<int32_t>(std::distance(m_aSoundGroups.begin(), itFind)); //--
+	}
+	// the backend creates its groups lazily
+	m_aSoundGroups.push_back(SoundGroup{sGroupName, false});
+	const int32_t nTotSoundGroups = static_cast<int32_t>(m_aSoundGroups.size());
+	m_nTotSoundGroups.store(nTotSoundGroups, std::memory_order_release);
+	return nTotSoundGroups - 1;
+}
+void PlaybackDevice::sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE eType, int32_t nGroupId, double fVolume) noexcept
+{
+	Backend::AlCommand oAlCommand;
+	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
+	oAlCommand.m_eType = static_cast<Backend::AL_COMMAND_TYPE>(eType);
+	oAlCommand.m_nGroupId = nGroupId;
+	oAlCommand.m_fVolume = fVolume;
+
+	m_oBackend.sendCommand(std::move(oAlCommand));
+}
+bool PlaybackDevice::setGroupVol(int32_t nGroupId, double fVolume) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nGroupId < 0) || ! isValidGroupOrNone(nGroupId)) {
+		return false; //--------------------------------------------------------
+	}
+	sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE_GROUP_VOL, nGroupId, fVolume);
+	return true;
+}
+bool PlaybackDevice::pauseGroup(int32_t nGroupId) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nGroupId < 0) || ! isValidGroupOrNone(nGroupId)) {
+		return false; //--------------------------------------------------------
+	}
+	SoundGroup& oSoundGroup = m_aSoundGroups[nGroupId];
+	if (oSoundGroup.m_bPaused) {
+		return false; //--------------------------------------------------------
+	}
+	oSoundGroup.m_bPaused = true;
+	sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE_PAUSE_GROUP, nGroupId, 1.0);
+	return true;
+}
+bool PlaybackDevice::resumeGroup(int32_t nGroupId) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nGroupId < 0) || ! isValidGroupOrNone(nGroupId)) {
+		return false; //--------------------------------------------------------
+	}
+	SoundGroup& oSoundGroup = m_aSoundGroups[nGroupId];
+	if (! oSoundGroup.m_bPaused) {
+		return false; //--------------------------------------------------------
+	}
+	oSoundGroup.m_bPaused = false;
+	sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE_RESUME_GROUP, nGroupId, 1.0);
+	return true;
+}
+bool PlaybackDevice::stopGroup(int32_t nGroupId) noexcept
+{
+	auto refOwner = getOwner();
+	if ((!refOwner) || (nGroupId < 0) || ! isValidGroupOrNone(nGroupId)) {
+		return false; //--------------------------------------------------------
+	}
+	// no SndFinishedEvent is sent for stopped sounds
+	for (ActiveSoundShard& oShard : m_aActiveSoundShards) {
+		auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+		auto& aActiveSounds = oShard.m_aActiveSounds;
+		aActiveSounds.erase(std::remove_if(aActiveSounds.begin(), aActiveSounds.end(), [&](const ActiveSound& oActiveSound)
+		{
+			if (oActiveSound.m_nGroupId != nGroupId) {
+				return false; //------------------------------------------------
+			}
+			if (oActiveSound.m_bPrepared) {
+				m_oBackend.cancelTrigger(oActiveSound.m_nSoundId);
+			}
+			return true;
+		}), aActiveSounds.end());
+	}
+	sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE_STOP_GROUP, nGroupId, 1.0);
+	return true;
+}
+
+bool PlaybackDevice::rampSoundVol(int32_t nSoundId, double fTargetVolume, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept
+{
+	return sendRampCommand(nSoundId, fTargetVolume, nDurationMillisec, eCurve, false);
+}
+bool PlaybackDevice::fadeOutAndStop(int32_t nSoundId, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept
+{
+	// the sound stays active until the backend sends the finished event
+	return sendRampCommand(nSoundId, 0.0, nDurationMillisec, eCurve, true);
+}
+bool PlaybackDevice::sendRampCommand(int32_t nSoundId, double fTargetVolume, int32_t nDurationMillisec, RAMP_CURVE eCurve
+									, bool bStopAtEnd) noexcept
+{
+	assert(nDurationMillisec >= 0);
+	assert((eCurve >= RAMP_CURVE_FIRST) && (eCurve <= RAMP_CURVE_LAST));
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return false; //--------------------------------------------------------
+	}
+
+	if (! isActiveSound(nSoundId)) {
+		return false; //--------------------------------------------------------
+	}
+
+	Backend::AlCommand oAlCommand;
+	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
+	oAlCommand.m_eType = Backend::AL_COMMAND_SOUND_RAMP;
+	oAlCommand.m_nSoundId = nSoundId;
+	oAlCommand.m_fVolume = fTargetVolume;
+	oAlCommand.m_nDurationMillisec = nDurationMillisec;
+	oAlCommand.m_nCurve = static_cast<int32_t>(eCurve);
+	oAlCommand.m_bStopAtEnd = bStopAtEnd;
+
+	m_oBackend.sendCommand(std::move(oAlCommand));
+	return true;
+}
+
 bool PlaybackDevice::setListenerPos(double fX, double fY, double fZ) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
@@ -338,7 +809,7 @@ bool PlaybackDevice::setListenerPos(double fX, double fY, double fZ) noexcept
 }
 bool PlaybackDevice::setListenerVol(double fVolume) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
@@ -355,13 +826,12 @@ bool PlaybackDevice::setListenerVol(double fVolume) noexcept
 //
 bool PlaybackDevice::pauseSound(int32_t nSoundId) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	if (itFind == m_aActiveSoundIds.end()) {
+	if (! isActiveSound(nSoundId)) {
 		return false; //--------------------------------------------------------
 	}
 
@@ -376,13 +846,12 @@ bool PlaybackDevice::pauseSound(int32_t nSoundId) noexcept
 }
 bool PlaybackDevice::resumeSound(int32_t nSoundId) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	if (itFind == m_aActiveSoundIds.end()) {
+	if (! isActiveSound(nSoundId)) {
 		return false; //--------------------------------------------------------
 	}
 
@@ -397,15 +866,18 @@ bool PlaybackDevice::resumeSound(int32_t nSoundId) noexcept
 }
 bool PlaybackDevice::stopSound(int32_t nSoundId) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	if (itFind == m_aActiveSoundIds.end()) {
+	// no SndFinishedEvent is sent for stopped sounds
+	// Only one of the threads stopping the same sound removes it and sends the command
+	if (! removeActiveSound(nSoundId)) {
 		return false; //--------------------------------------------------------
 	}
+	// if prepared it can't be triggered anymore
+	m_oBackend.cancelTrigger(nSoundId);
 
 	Backend::AlCommand oAlCommand;
 	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
@@ -419,7 +891,7 @@ bool PlaybackDevice::stopSound(int32_t nSoundId) noexcept
 
 bool PlaybackDevice::pauseDevice() noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
@@ -434,7 +906,7 @@ bool PlaybackDevice::pauseDevice() noexcept
 }
 bool PlaybackDevice::resumeDevice() noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
@@ -449,11 +921,22 @@ bool PlaybackDevice::resumeDevice() noexcept
 }
 void PlaybackDevice::stopAllSounds() noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return; //--------------------------------------------------------------
 	}
 
+	// no SndFinishedEvent is sent for stopped sounds
+	for (ActiveSoundShard& oShard : m_aActiveSoundShards) {
+		auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+		for (const ActiveSound& oActiveSound : oShard.m_aActiveSounds) {
+			if (oActiveSound.m_bPrepared) {
+				m_oBackend.cancelTrigger(oActiveSound.m_nSoundId);
+			}
+		}
+		oShard.m_aActiveSounds.clear();
+	}
+
 	Backend::AlCommand oAlCommand;
 	oAlCommand.m_nBackendDeviceId = m_nBackendDeviceId;
 	oAlCommand.m_eType = Backend::AL_COMMAND_STOP_ALL;
@@ -463,60 +946,101 @@ void PlaybackDevice::stopAllSounds() noexcept
 
 bool PlaybackDevice::isDefaultDevice() noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return false; //--------------------------------------------------------
 	}
 	return m_bIsDefault;
 }
 
-void PlaybackDevice::onSoundFinished(int32_t nSoundId) noexcept
+void PlaybackDevice::onSoundFinished(int32_t nSoundId, bool bFadedOut, int64_t nFinishedTimeUsec) noexcept
 {
-	sendSndFinishedEventToListeners(nSoundId, SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+	sendSndFinishedEventToListeners(nSoundId, (bFadedOut ? SndFinishedEvent::FINISHED_TYPE_FADED_OUT
+															: SndFinishedEvent::FINISHED_TYPE_COMPLETED)
+									, nFinishedTimeUsec);
 }
-void PlaybackDevice::onDeviceError(int32_t nSoundId, int32_t nFileId, std::string&& sError) noexcept
+void PlaybackDevice::onDeviceError(int32_t nSoundId, int32_t nFileId, int64_t nFinishedTimeUsec, std::string&& sError) noexcept
 {
-	const auto itFindName = std::find_if(m_aFileNameToIds.begin(), m_aFileNameToIds.end(), [&](const FileNameToId& oFileNameToId)
+	const bool bIsPreload = (nSoundId < 0);
+	const int32_t nNameIdx = m_aFileNameToIds.findIf([&](const FileNameToId& oFileNameToId)
 	{
 		return oFileNameToId.m_nFileId == nFileId;
 	});
-	if (itFindName == m_aFileNameToIds.end()) {
+	if (nNameIdx < 0) {
 
-		const auto itFind = std::find_if(m_aBufferToIds.begin(), m_aBufferToIds.end(), [&](const BufferToId& oBufferToId)
+		const int32_t nBufferIdx = m_aBufferToIds.findIf([&](const BufferToId& oBufferToId)
 		{
 			return oBufferToId.m_nFileId == nFileId;
 		});
-		if (itFind == m_aBufferToIds.end()) {
+		if (nBufferIdx < 0) {
 			return; //----------------------------------------------------------
 		}
-		std::cout << "Sound file buffer error (adr: " << reinterpret_cast<int64_t>(itFind->m_p0Buffer) << ")" << '\n';
+		std::cout << "Sound file buffer error (adr: " << reinterpret_cast<int64_t>(m_aBufferToIds[nBufferIdx].m_p0Buffer) << ")" << '\n';
 	} else {
-		std::cout << "Sound file path error (" << itFindName->m_sFileName << ")" << '\n';
+		std::cout << "Sound file path error (" << m_aFileNameToIds[nNameIdx].m_sFileName << ")" << '\n';
 	}
 	std::cout << " -> " << sError << '\n';
 
-	sendSndFinishedEventToListeners(nSoundId, SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND);
+	if (bIsPreload) {
+		// no sound was started
+		return; //--------------------------------------------------------------
+	}
+	sendSndFinishedEventToListeners(nSoundId, SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND, nFinishedTimeUsec);
 }
-void PlaybackDevice::sendSndFinishedEventToListeners(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType) noexcept
+void PlaybackDevice::onPreloaded(int32_t nBatchId, int32_t nFileId, bool bLoaded) noexcept
 {
-	const auto itFind = std::find(m_aActiveSoundIds.begin(), m_aActiveSoundIds.end(), nSoundId);
-	assert(itFind != m_aActiveSoundIds.end());
-	const int32_t nIdx = static_cast<int32_t>(std::distance(m_aActiveSoundIds.begin(), itFind));
-	const uint64_t nSoundStartedTimeStamp = m_aActiveSoundStarts[nIdx];
-	// remove
-	const int32_t nTotSounds = static_cast<int32_t>(m_aActiveSoundIds.size());
-	if (nIdx < nTotSounds - 1) {
-		m_aActiveSoundIds[nIdx] = m_aActiveSoundIds[nTotSounds - 1];
-		m_aActiveSoundStarts[nIdx] = m_aActiveSoundStarts[nTotSounds - 1];
+	PendingBatch oPendingBatch;
+	{
+		auto oLock = lockIfThreadSafe(m_oPreloadsMutex);
+		const auto itFind = std::find_if(m_aPendingBatches.begin(), m_aPendingBatches.end(), [&](const PendingBatch& oBatch)
+		{
+			return oBatch.m_nBatchId == nBatchId;
+		});
+		if (itFind == m_aPendingBatches.end()) {
+			// aborted
+			return; //----------------------------------------------------------
+		}
+		if (! bLoaded) {
+			++itFind->m_nTotFailed;
+		}
+		--itFind->m_nTotPending;
+		// copy because listeners (called without the lock) might start new batches
+		oPendingBatch = *itFind;
+		if (oPendingBatch.m_nTotPending == 0) {
+			m_aPendingBatches.erase(itFind);
+		}
 	}
-	m_aActiveSoundIds.pop_back();
-	m_aActiveSoundStarts.pop_back();
-	//
-	auto refOwner = getOwnerDeviceManager();
+	sendSndPreloadedEventToListeners(oPendingBatch.m_nStartedTimeStamp
+									, (bLoaded ? SndPreloadedEvent::PRELOADED_TYPE_FILE_LOADED : SndPreloadedEvent::PRELOADED_TYPE_FILE_FAILED)
+									, nBatchId, nFileId, oPendingBatch.m_nTotFailed);
+	if (oPendingBatch.m_nTotPending == 0) {
+		sendSndPreloadedEventToListeners(oPendingBatch.m_nStartedTimeStamp, SndPreloadedEvent::PRELOADED_TYPE_BATCH_COMPLETED
+										, nBatchId, -1, oPendingBatch.m_nTotFailed);
+	}
+}
+void PlaybackDevice::abortPreloadBatches() noexcept
+{
+	std::vector< PendingBatch > aPendingBatches;
+	{
+		auto oLock = lockIfThreadSafe(m_oPreloadsMutex);
+		aPendingBatches.swap(m_aPendingBatches);
+	}
+	for (const auto& oPendingBatch : aPendingBatches) {
+		sendSndPreloadedEventToListeners(oPendingBatch.m_nStartedTimeStamp, SndPreloadedEvent::PRELOADED_TYPE_BATCH_ABORTED
+										, oPendingBatch.m_nBatchId, -1, oPendingBatch.m_nTotFailed);
+	}
+}
+void PlaybackDevice::sendSndPreloadedEventToListeners(uint64_t nBatchStartedTimeStamp, SndPreloadedEvent::PRELOADED_TYPE ePreloadedType
+													, int32_t nBatchId, int32_t nFileId, int32_t nTotFailed) noexcept
+{
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return; //--------------------------------------------------------------
 	}
 	OpenAlDeviceManager* p0Owner = refOwner.get();
+	if (!p0Owner->isEventClassEnabled(Event::Class{typeid(SndPreloadedEvent)})) {
+		return; //--------------------------------------------------------------
+	}
 
 	auto refListeners = p0Owner->getListeners();
 	shared_ptr<PlaybackDevice> refPlaybackDevice = shared_from_this();
@@ -524,6 +1048,102 @@ void PlaybackDevice::sendSndFinishedEventToListeners(int32_t nSoundId, SndFinish
 
 	shared_ptr<Event> refEvent;
 	const int64_t nEventTimeUsec = DeviceManager::getNowTimeMicroseconds();
+	for (auto& p0ListenerData : *refListeners) {
+		if (nBatchStartedTimeStamp < p0ListenerData->getAddedTimeStamp()) {
+			// The listener was added after the batch was started
+			continue;
+		}
+		if (!refEvent) {
+			refEvent = std::make_shared<SndPreloadedEvent>(nEventTimeUsec, refCapability, ePreloadedType
+															, nBatchId, nFileId, nTotFailed);
+		}
+		p0ListenerData->handleEventCallIf(p0Owner->m_nClassIdxSndPreloadedEvent, refEvent);
+	}
+}
+bool PlaybackDevice::isActiveSound(int32_t nSoundId) noexcept
+{
+	if (nSoundId < 0) {
+		return false; //--------------------------------------------------------
+	}
+	ActiveSoundShard& oShard = getActiveSoundShard(nSoundId);
+	auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+	const auto& aActiveSounds = oShard.m_aActiveSounds;
+	return std::any_of(aActiveSounds.begin(), aActiveSounds.end(), [&](const ActiveSound& oActiveSound)
+	{
+		return oActiveSound.m_nSoundId == nSoundId;
+	});
+}
+std::vector<PlaybackDevice::ActiveSound> PlaybackDevice::getActiveSounds() noexcept
+{
+	std::vector<ActiveSound> aActiveSounds;
+	for (ActiveSoundShard& oShard : m_aActiveSoundShards) {
+		auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+		aActiveSounds.insert(aActiveSounds.end(), oShard.m_aActiveSounds.begin(), oShard.m_aActiveSounds.end());
+	}
+	// The shards (and removals) shuffle the sounds. The ids are increasing in the order
+	// the sounds were played, unlike the time stamps of sounds played by other threads
+	std::sort(aActiveSounds.begin(), aActiveSounds.end(), [](const ActiveSound& oS1, const ActiveSound& oS2)
+	{
+		return (oS1.m_nSoundId < oS2.m_nSoundId);
+	});
+	return aActiveSounds;
+}
+bool PlaybackDevice::removeActiveSound(int32_t nSoundId, uint64_t& nSoundStartedTimeStamp) noexcept
+{
+	if (nSoundId < 0) {
+		return false; //--------------------------------------------------------
+	}
+	ActiveSoundShard& oShard = getActiveSoundShard(nSoundId);
+	auto oLock = lockIfThreadSafe(oShard.m_oMutex);
+	auto& aActiveSounds = oShard.m_aActiveSounds;
+	const auto itFind = std::find_if(aActiveSounds.begin(), aActiveSounds.end(), [&](const ActiveSound& oActiveSound)
+	{
+		return oActiveSound.m_nSoundId == nSoundId;
+	});
+	if (itFind == aActiveSounds.end()) {
+		return false; //--------------------------------------------------------
+	}
+	nSoundStartedTimeStamp = itFind->m_nStartedTimeStamp;
+	// remove, the last one is moved to its place
+	*itFind = aActiveSounds.back();
+	aActiveSounds.pop_back();
+	return true;
+}
+bool PlaybackDevice::removeActiveSound(int32_t nSoundId) noexcept
+{
+	uint64_t nSoundStartedTimeStamp;
+	return removeActiveSound(nSoundId, nSoundStartedTimeStamp);
+}
+void PlaybackDevice::sendSndFinishedEventToListeners(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType
+													, int64_t nFinishedTimeUsec) noexcept
+{
+	uint64_t nSoundStartedTimeStamp;
+	if (! removeActiveSound(nSoundId, nSoundStartedTimeStamp)) {
+		// the sound was stopped while the backend was finishing it
+		return; //--------------------------------------------------------------
+	}
+	//
+	auto refOwner = getOwner();
+	if (!refOwner) {
+		return; //--------------------------------------------------------------
+	}
+	OpenAlDeviceManager* p0Owner = refOwner.get();
+	if (p0Owner->m_bSndFinishedBatching) {
+		m_aBatchedFinishedSounds.push_back(FinishedSound{{nSoundId, eFinishedType, nFinishedTimeUsec}, nSoundStartedTimeStamp});
+		if (p0Owner->m_nEventsDispatchDepth == 0) {
+			// not called while dispatching the backend events
+			sendSndFinishedBatchToListeners();
+		}
+		return; //--------------------------------------------------------------
+	}
+
+	auto refListeners = p0Owner->getListeners();
+	shared_ptr<PlaybackDevice> refPlaybackDevice = shared_from_this();
+	shared_ptr<PlaybackCapability> refCapability = refPlaybackDevice;
+
+	shared_ptr<Event> refEvent;
+	// the backend already read the clock when it queued the event
+	const int64_t nEventTimeUsec = ((nFinishedTimeUsec >= 0) ? nFinishedTimeUsec : DeviceManager::getNowTimeMicroseconds());
 	for (auto& p0ListenerData : *refListeners) {
 		sendSndFinishedEventToListener(*p0ListenerData, nEventTimeUsec, nSoundStartedTimeStamp
 										, eFinishedType, nSoundId
@@ -549,14 +1169,83 @@ void PlaybackDevice::sendSndFinishedEventToListener(const OpenAlDeviceManager::L
 	oListenerData.handleEventCallIf(nClassIdxSoundFinishedEvent, refEvent);
 		// no need to reset because KeyEvent cannot be modified.
 }
+void PlaybackDevice::sendSndFinishedBatchToListeners() noexcept
+{
+	if (m_aBatchedFinishedSounds.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	// the listeners might finish other sounds
+	std::vector<FinishedSound> aFinishedSounds;
+	aFinishedSounds.swap(m_aBatchedFinishedSounds);
+	//
+	auto refOwner = getOwner();
+	if (refOwner) {
+		OpenAlDeviceManager* p0Owner = refOwner.get();
+
+		auto refListeners = p0Owner->getListeners();
+		shared_ptr<PlaybackDevice> refPlaybackDevice = shared_from_this();
+		shared_ptr<PlaybackCapability> refCapability = refPlaybackDevice;
+
+		shared_ptr<Event> refEvent;
+		const int64_t nEventTimeUsec = DeviceManager::getNowTimeMicroseconds();
+		for (auto& p0ListenerData : *refListeners) {
+			sendSndFinishedBatchToListener(*p0ListenerData, nEventTimeUsec, aFinishedSounds
+											, refCapability, p0Owner->m_nClassIdxSndFinishedBatchEvent, refEvent);
+		}
+	}
+	if (m_aBatchedFinishedSounds.empty()) {
+		// keep the capacity for the next dispatch
+		aFinishedSounds.clear();
+		aFinishedSounds.swap(m_aBatchedFinishedSounds);
+	}
+}
+void PlaybackDevice::sendSndFinishedBatchToListener(const OpenAlDeviceManager::ListenerData& oListenerData
+													, int64_t nEventTimeUsec, const std::vector<FinishedSound>& aFinishedSounds
+													, const shared_ptr<PlaybackCapability>& refCapability
+													, int32_t nClassIdxSndFinishedBatchEvent
+													, shared_ptr<Event>& refAllEvent) noexcept
+{
+	const auto nAddTimeStamp = oListenerData.getAddedTimeStamp();
+	const bool bAll = std::all_of(aFinishedSounds.begin(), aFinishedSounds.end(), [&](const FinishedSound& oFinishedSound)
+	{
+		return (oFinishedSound.m_nStartedTimeStamp >= nAddTimeStamp);
+	});
+	if (bAll && refAllEvent) {
+		oListenerData.handleEventCallIf(nClassIdxSndFinishedBatchEvent, refAllEvent);
+		return; //--------------------------------------------------------------
+	}
+	std::vector<SndFinishedBatchEvent::Entry> aEntries;
+	aEntries.reserve(aFinishedSounds.size());
+	for (const FinishedSound& oFinishedSound : aFinishedSounds) {
+		if (oFinishedSound.m_nStartedTimeStamp < nAddTimeStamp) {
+			// The listener was added after the sound was played
+			continue; // for ------------
+		}
+		aEntries.push_back(oFinishedSound.m_oEntry);
+	}
+	if (aEntries.empty()) {
+		return; //--------------------------------------------------------------
+	}
+	shared_ptr<Event> refEvent = std::make_shared<SndFinishedBatchEvent>(nEventTimeUsec, refCapability, std::move(aEntries));
+	if (bAll) {
+		refAllEvent = refEvent;
+	}
+	oListenerData.handleEventCallIf(nClassIdxSndFinishedBatchEvent, refEvent);
+}
 void PlaybackDevice::finishDeviceSounds() noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return;
 	}
 	OpenAlDeviceManager* p0Owner = refOwner.get();
-	if (!p0Owner->isEventClassEnabled(Event::Class{typeid(SndFinishedEvent)})) {
+	const bool bBatching = p0Owner->m_bSndFinishedBatching;
+	if (bBatching) {
+		// the sounds that finished before the device was removed come first
+		sendSndFinishedBatchToListeners();
+	}
+	if (!p0Owner->isEventClassEnabled(bBatching ? Event::Class{typeid(SndFinishedBatchEvent)}
+												: Event::Class{typeid(SndFinishedEvent)})) {
 		return; //--------------------------------------------------------------
 	}
 
@@ -567,12 +1256,31 @@ void PlaybackDevice::finishDeviceSounds() noexcept
 
 	const int64_t nEventTimeUsec = DeviceManager::getNowTimeMicroseconds();
 
-	auto aActiveSoundIds = m_aActiveSoundIds;
-	auto aActiveSoundStarts = m_aActiveSoundStarts;
-	const int32_t nTotSoundIds = static_cast<int32_t>(aActiveSoundIds.size());
-	for (int32_t nIdx = 0; nIdx < nTotSoundIds; ++nIdx) {
-		const int32_t nSoundId = aActiveSoundIds[nIdx];
-		const auto nSoundStarted = aActiveSoundStarts[nIdx];
+	const auto aActiveSounds = getActiveSounds();
+	if (bBatching) {
+		std::vector<FinishedSound> aFinishedSounds;
+		for (auto& p0ListenerData : *refListeners) {
+			OpenAlListenerExtraData* p0ExtraData = nullptr;
+			p0ListenerData->getExtraData(p0ExtraData);
+			aFinishedSounds.clear();
+			for (const ActiveSound& oActiveSound : aActiveSounds) {
+				const int32_t nSoundId = oActiveSound.m_nSoundId;
+				if (p0ExtraData->isSoundFinished(nSoundId)) {
+					continue; // for oActiveSound ------------
+				}
+				p0ExtraData->setSoundFinished(nSoundId);
+				aFinishedSounds.push_back(FinishedSound{{nSoundId, SndFinishedEvent::FINISHED_TYPE_ABORTED, nEventTimeUsec}
+														, oActiveSound.m_nStartedTimeStamp});
+			}
+			shared_ptr<Event> refEvent;
+			sendSndFinishedBatchToListener(*p0ListenerData, nEventTimeUsec, aFinishedSounds
+											, refCapability, p0Owner->m_nClassIdxSndFinishedBatchEvent, refEvent);
+		}
+		return; //--------------------------------------------------------------
+	}
+	for (const ActiveSound& oActiveSound : aActiveSounds) {
+		const int32_t nSoundId = oActiveSound.m_nSoundId;
+		const auto nSoundStarted = oActiveSound.m_nStartedTimeStamp;
 
 		shared_ptr<Event> refEvent;
 		for (auto& p0ListenerData : *refListeners) {
@@ -584,19 +1292,25 @@ void PlaybackDevice::finishDeviceSounds() noexcept
 			p0ExtraData->setSoundFinished(nSoundId);
 
 			sendSndFinishedEventToListener(*p0ListenerData, nEventTimeUsec, nSoundStarted
-											, SndFinishedEvent::FINISHED_TYPE_LISTENER_REMOVED
+											, SndFinishedEvent::FINISHED_TYPE_ABORTED
 											, nSoundId, refCapability, p0Owner->m_nClassIdxSndFinishedEvent, refEvent);
 		}
 	}
 }
 void PlaybackDevice::finalizeListener(OpenAlDeviceManager::ListenerData& oListenerData, int64_t nEventTimeUsec) noexcept
 {
-	auto refOwner = getOwnerDeviceManager();
+	auto refOwner = getOwner();
 	if (!refOwner) {
 		return;
 	}
 	OpenAlDeviceManager* p0Owner = refOwner.get();
-	if (!p0Owner->isEventClassEnabled(Event::Class{typeid(SndFinishedEvent)})) {
+	const bool bBatching = p0Owner->m_bSndFinishedBatching;
+	if (bBatching) {
+		// the sounds that finished before the listener was removed come first
+		sendSndFinishedBatchToListeners();
+	}
+	if (!p0Owner->isEventClassEnabled(bBatching ? Event::Class{typeid(SndFinishedBatchEvent)}
+												: Event::Class{typeid(SndFinishedEvent)})) {
 		return; //--------------------------------------------------------------
 	}
 
@@ -606,12 +1320,26 @@ void PlaybackDevice::finalizeListener(OpenAlDeviceManager::ListenerData& oListen
 	OpenAlListenerExtraData* p0ExtraData = nullptr;
 	oListenerData.getExtraData(p0ExtraData);
 
-	auto aActiveSoundIds = m_aActiveSoundIds;
-	auto aActiveSoundStarts = m_aActiveSoundStarts;
-	const int32_t nTotSoundIds = static_cast<int32_t>(aActiveSoundIds.size());
-	for (int32_t nIdx = 0; nIdx < nTotSoundIds; ++nIdx) {
-		const int32_t nSoundId = aActiveSoundIds[nIdx];
-		const auto nSoundStarted = aActiveSoundStarts[nIdx];
+	const auto aActiveSounds = getActiveSounds();
+	if (bBatching) {
+		std::vector<FinishedSound> aFinishedSounds;
+		for (const ActiveSound& oActiveSound : aActiveSounds) {
+			const int32_t nSoundId = oActiveSound.m_nSoundId;
+			if (p0ExtraData->isSoundFinished(nSoundId)) {
+				continue; // for ------------
+			}
+			p0ExtraData->setSoundFinished(nSoundId);
+			aFinishedSounds.push_back(FinishedSound{{nSoundId, SndFinishedEvent::FINISHED_TYPE_LISTENER_REMOVED, nEventTimeUsec}
+													, oActiveSound.m_nStartedTimeStamp});
+		}
+		shared_ptr<Event> refEvent;
+		sendSndFinishedBatchToListener(oListenerData, nEventTimeUsec, aFinishedSounds
+										, refCapability, p0Owner->m_nClassIdxSndFinishedBatchEvent, refEvent);
+		return; //--------------------------------------------------------------
+	}
+	for (const ActiveSound& oActiveSound : aActiveSounds) {
+		const int32_t nSoundId = oActiveSound.m_nSoundId;
+		const auto nSoundStarted = oActiveSound.m_nStartedTimeStamp;
 		//
 		if (p0ExtraData->isSoundFinished(nSoundId)) {
 			continue; // for ------------
@@ -620,7 +1348,7 @@ void PlaybackDevice::finalizeListener(OpenAlDeviceManager::ListenerData& oListen
 		//
 		shared_ptr<Event> refEvent;
 		sendSndFinishedEventToListener(oListenerData, nEventTimeUsec, nSoundStarted
-										, SndFinishedEvent::FINISHED_TYPE_ABORTED
+										, SndFinishedEvent::FINISHED_TYPE_LISTENER_REMOVED
 										, nSoundId, refCapability, p0Owner->m_nClassIdxSndFinishedEvent, refEvent);
 	}
 }
@@ -23,22 +23,29 @@
 
 #include "openaldevicemanager.h"
 
+#include "appendlist.h"
+#include "backend.h"
 #include "recycler.h"
 
 #include <stmm-input-au/playbackcapability.h>
+#include <stmm-input-au/sndfinishedbatchevent.h>
 #include <stmm-input-au/sndfinishedevent.h>
+#include <stmm-input-au/sndpreloadedevent.h>
 
 #include <stmm-input-base/basicdevice.h>
 #include <stmm-input/capability.h>
 #include <stmm-input/device.h>
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include <cassert>
 #include <cstdint>
 
 namespace stmi { class Event; }
-namespace stmi { namespace Private { namespace OpenAl { class Backend; } } }
 
 namespace stmi
 {
@@ -74,15 +81,44 @@ public:
 
 	int32_t preloadSound(const std::string& sFileName) noexcept override;
 	int32_t preloadSound(uint8_t const* p0Buffer, int32_t nBufferSize) noexcept override;
+	PreloadBatch preloadSounds(const std::vector<std::string>& aFileNames, PRELOAD_PRIORITY ePriority) noexcept override;
+	bool cancelPreloadBatch(int32_t nBatchId) noexcept override;
+	std::vector<BankEntry> preloadBank(const std::string& sBankPath) noexcept override;
 	SoundData playSound(const std::string& sFileName, double fVolume, bool bLoop
 						, bool bRelative, double fX, double fY, double fZ) noexcept override;
 	SoundData playSound(const uint8_t* p0Buffer, int32_t nBufferSize, double fVolume, bool bLoop
 						, bool bRelative, double fX, double fY, double fZ) noexcept override;
 	int32_t playSound(int32_t nFileId, double fVolume, bool bLoop
 					, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	SoundData playSoundInGroup(int32_t nGroupId, const std::string& sFileName, double fVolume, bool bLoop
+								, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	SoundData playSoundInGroup(int32_t nGroupId, const uint8_t* p0Buffer, int32_t nBufferSize, double fVolume, bool bLoop
+								, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	int32_t playSoundInGroup(int32_t nGroupId, int32_t nFileId, double fVolume, bool bLoop
+							, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	int64_t getDeviceClockNanosec() noexcept override;
+	int32_t playSoundAt(int32_t nFileId, int64_t nDeviceClockNanosec, double fVolume, bool bLoop
+						, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	std::vector<int32_t> playSoundsTogether(const std::vector<SyncedSound>& aSounds, int64_t nDeviceClockNanosec) noexcept override;
+	int32_t prepareSound(int32_t nFileId, double fVolume, bool bLoop
+						, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	bool triggerSound(int32_t nSoundId) noexcept override;
+	SoundState getSoundState(int32_t nSoundId) noexcept override;
 
 	bool setSoundPos(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ) noexcept override;
+	bool setSoundMotion(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+						, double fVelX, double fVelY, double fVelZ) noexcept override;
+	bool setSoundMotionTo(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+						, double fTargetX, double fTargetY, double fTargetZ, int32_t nArrivalMillisec) noexcept override;
 	bool setSoundVol(int32_t nSoundId, double fVolume) noexcept override;
+	bool rampSoundVol(int32_t nSoundId, double fTargetVolume, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept override;
+	bool fadeOutAndStop(int32_t nSoundId, int32_t nDurationMillisec, RAMP_CURVE eCurve) noexcept override;
+
+	int32_t getSoundGroup(const std::string& sGroupName) noexcept override;
+	bool setGroupVol(int32_t nGroupId, double fVolume) noexcept override;
+	bool pauseGroup(int32_t nGroupId) noexcept override;
+	bool resumeGroup(int32_t nGroupId) noexcept override;
+	bool stopGroup(int32_t nGroupId) noexcept override;
 
 	bool setListenerPos(double fX, double fY, double fZ) noexcept override;
 	bool setListenerVol(double fVolume) noexcept override;
@@ -98,21 +134,77 @@ public:
 	bool isDefaultDevice() noexcept override;
 
 private:
-	int32_t preloadSound(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize) noexcept;
-	int32_t playSound(OpenAlDeviceManager* p0Owner
+	// The owner or null if the device was removed
+	shared_ptr<OpenAlDeviceManager> getOwner() const noexcept;
+	// Locks oMutex only in thread-safe mode (see OpenAlDeviceManager::setThreadSafePlayback())
+	std::unique_lock<std::mutex> lockIfThreadSafe(std::mutex& oMutex) const noexcept;
+	// Lock-free: the file id of a file name (if p0Buffer is null) or of a buffer, -1 if not known.
+	// If found, the buffer size is set to the one of the buffer when it was added.
+	int32_t findFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t& nBufferSize) const noexcept;
+	// The file id of a file name (if p0Buffer is null) or of a buffer. If not known a new one
+	// is added and bAdded set to true.
+	int32_t getOrAddFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t& nBufferSize, bool& bAdded) noexcept;
+	// Adds a file name (if p0Buffer is null) or a buffer with a new file id.
+	// In thread-safe mode must be called with m_oAddFileIdMutex locked.
+	int32_t addFileId(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize) noexcept;
+	void sendPreloadCommand(const std::string& sFileName, uint8_t const* p0Buffer, int32_t nBufferSize
+							, int32_t nFileId, int32_t nBatchId, PRELOAD_PRIORITY ePriority) noexcept;
+	// nStartClockNanosec is the device clock time the sound starts at or -1 if immediately
+	// If bPrepared is true the sound waits for triggerSound(), returns -1 if no trigger slot is free
+	// If p0Commands is not null the play command is added to it rather than sent
+	int32_t playSound(OpenAlDeviceManager* p0Owner, int32_t nGroupId
 				, const std::string& sFileName, const uint8_t* p0Buffer, int32_t nBufferSize, int32_t nFileId
-				, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ) noexcept;
+				, int64_t nStartClockNanosec, bool bPrepared
+				, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ
+				, std::vector<Backend::AlCommand>* p0Commands) noexcept;
+	// Returns -1 if the file id is not known
+	int32_t playFileId(OpenAlDeviceManager* p0Owner, int32_t nGroupId, int32_t nFileId
+						, int64_t nStartClockNanosec, bool bPrepared
+						, double fVolume, bool bLoop, bool bRelative, double fX, double fY, double fZ
+						, std::vector<Backend::AlCommand>* p0Commands) noexcept;
+	// Whether nFileId was returned by a preload or play method
+	bool isKnownFileId(int32_t nFileId) const noexcept;
+	// Whether nGroupId is -1 (no group) or an existing group
+	bool isValidGroupOrNone(int32_t nGroupId) const noexcept;
+	bool sendMotionCommand(int32_t nSoundId, bool bRelative, double fX, double fY, double fZ
+							, double fVelX, double fVelY, double fVelZ, int32_t nMotionMillisec) noexcept;
+	bool sendRampCommand(int32_t nSoundId, double fTargetVolume, int32_t nDurationMillisec, RAMP_CURVE eCurve
+						, bool bStopAtEnd) noexcept;
+	void sendGroupCommand(OpenAlDeviceManager::COMMAND_TYPE eType, int32_t nGroupId, double fVolume) noexcept;
 	//
 	friend class stmi::OpenAlDeviceManager;
 	void finishDeviceSounds() noexcept;
 	void finalizeListener(OpenAlDeviceManager::ListenerData& oListenerData, int64_t nEventTimeUsec) noexcept;
 	void removingDevice() noexcept;
 	//
-	void onSoundFinished(int32_t nSoundId) noexcept;
+	void onSoundFinished(int32_t nSoundId, bool bFadedOut, int64_t nFinishedTimeUsec) noexcept;
 
-	void onDeviceError(int32_t nSoundId, int32_t nFileId, std::string&& sError) noexcept;
+	void onDeviceError(int32_t nSoundId, int32_t nFileId, int64_t nFinishedTimeUsec, std::string&& sError) noexcept;
 
-	void sendSndFinishedEventToListeners(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType) noexcept;
+	void onPreloaded(int32_t nBatchId, int32_t nFileId, bool bLoaded) noexcept;
+	void abortPreloadBatches() noexcept;
+	void sendSndPreloadedEventToListeners(uint64_t nBatchStartedTimeStamp, SndPreloadedEvent::PRELOADED_TYPE ePreloadedType
+										, int32_t nBatchId, int32_t nFileId, int32_t nTotFailed) noexcept;
+
+	struct ActiveSound
+	{
+		int32_t m_nSoundId = -1;
+		uint64_t m_nStartedTimeStamp = 0; // Timestamp the sound was played
+		int32_t m_nGroupId = -1; // The group id or -1
+		bool m_bPrepared = false; // Whether played by prepareSound()
+	};
+	// Whether the sound was played and not finished or stopped yet
+	bool isActiveSound(int32_t nSoundId) noexcept;
+	// A copy of the active sounds in the order they were played
+	std::vector<ActiveSound> getActiveSounds() noexcept;
+	// Returns false if the sound is not active
+	bool removeActiveSound(int32_t nSoundId, uint64_t& nSoundStartedTimeStamp) noexcept;
+	bool removeActiveSound(int32_t nSoundId) noexcept;
+
+	// nFinishedTimeUsec is the time the backend queued the event, used as event time
+	// (and batch entry time) so that the clock isn't read again, or -1 if unknown.
+	void sendSndFinishedEventToListeners(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType
+										, int64_t nFinishedTimeUsec) noexcept;
 
 	void sendSndFinishedEventToListener(const OpenAlDeviceManager::ListenerData& oListenerData
 										, int64_t nEventTimeUsec, uint64_t nSoundStartedTimeStamp
@@ -121,6 +213,21 @@ private:
 										, int32_t nClassIdxSoundFinishedEvent
 										, shared_ptr<Event>& refEvent) noexcept;
 
+	struct FinishedSound
+	{
+		SndFinishedBatchEvent::Entry m_oEntry;
+		uint64_t m_nStartedTimeStamp = 0; // Timestamp the sound was played
+	};
+	// Sends the sounds collected in batch mode (see OpenAlDeviceManager::setSndFinishedBatching())
+	void sendSndFinishedBatchToListeners() noexcept;
+	// Sends the sounds played after the listener was added, if any.
+	// refAllEvent is set when all the sounds are sent and can be shared with other listeners.
+	void sendSndFinishedBatchToListener(const OpenAlDeviceManager::ListenerData& oListenerData
+										, int64_t nEventTimeUsec, const std::vector<FinishedSound>& aFinishedSounds
+										, const shared_ptr<PlaybackCapability>& refCapability
+										, int32_t nClassIdxSndFinishedBatchEvent
+										, shared_ptr<Event>& refAllEvent) noexcept;
+
 private:
 	//
 	class ReSndFinishedEvent :public SndFinishedEvent
@@ -145,24 +252,69 @@ private:
 private:
 	Backend& m_oBackend;
 	int32_t m_nBackendDeviceId;
-	bool m_bIsDefault;
+	std::atomic<bool> m_bIsDefault;
+	// In thread-safe mode the owner isn't reset when removed
+	std::atomic<bool> m_bRemoved;
 
 	struct FileNameToId
 	{
 		std::string m_sFileName;
 		int32_t m_nFileId = -1;
 	};
-	std::vector< FileNameToId > m_aFileNameToIds;
+	// Read without locks by any thread
+	AppendList< FileNameToId > m_aFileNameToIds;
 	struct BufferToId
 	{
 		const uint8_t* m_p0Buffer = nullptr;
 		int32_t m_nBufferSize = 0;
 		int32_t m_nFileId = -1;
 	};
-	std::vector< BufferToId > m_aBufferToIds;
+	// Read without locks by any thread
+	AppendList< BufferToId > m_aBufferToIds;
+	// In thread-safe mode serializes the additions to m_aFileNameToIds and m_aBufferToIds
+	std::mutex m_oAddFileIdMutex;
+	// In thread-safe mode guards m_aPreloadedBanks and m_aPendingBatches
+	std::mutex m_oPreloadsMutex;
+	struct PreloadedBank
+	{
+		std::string m_sBankPath;
+		std::vector<BankEntry> m_aEntries;
+	};
+	std::vector< PreloadedBank > m_aPreloadedBanks;
+	struct PendingBatch
+	{
+		int32_t m_nBatchId = -1;
+		uint64_t m_nStartedTimeStamp = 0; // Timestamp preloadSounds() was called
+		int32_t m_nTotPending = 0; // The files not yet loaded or failed
+		int32_t m_nTotFailed = 0;
+	};
+	std::vector< PendingBatch > m_aPendingBatches;
+	struct SoundGroup
+	{
+		std::string m_sGroupName;
+		bool m_bPaused = false;
+	};
+	std::vector< SoundGroup > m_aSoundGroups; // Index: group id
+	// The size of m_aSoundGroups, read by any thread
+	std::atomic<int32_t> m_nTotSoundGroups;
+
+	// The active sounds are split so that the threads playing and
+	// stopping different sounds rarely lock the same mutex
+	struct ActiveSoundShard
+	{
+		std::mutex m_oMutex; // Only locked in thread-safe mode
+		std::vector< ActiveSound > m_aActiveSounds;
+	};
+	static constexpr int32_t s_nTotActiveSoundShards = 16;
+	ActiveSoundShard& getActiveSoundShard(int32_t nSoundId) noexcept
+	{
+		assert(nSoundId >= 0);
+		return m_aActiveSoundShards[nSoundId % s_nTotActiveSoundShards];
+	}
+	std::array< ActiveSoundShard, s_nTotActiveSoundShards > m_aActiveSoundShards; // Index: nSoundId % s_nTotActiveSoundShards
 
-	std::vector< int32_t > m_aActiveSoundIds; // Value: The sound id
-	std::vector< uint64_t > m_aActiveSoundStarts; // Value: Timestamp the sound was played,   Size: m_aActiveSoundIds.size()
+	// In batch mode the sounds finished during the current dispatch of the backend events
+	std::vector< FinishedSound > m_aBatchedFinishedSounds;
 
 private:
 	PlaybackDevice(const PlaybackDevice& oSource) = delete;
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   seqlock.h
+ */
+
+#ifndef STMI_OPENAL_SEQ_LOCK_H
+#define STMI_OPENAL_SEQ_LOCK_H
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <cstring>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Single writer, multiple readers sequence lock.
+ * The writer never blocks, readers retry if the writer was writing in the meantime.
+ * The value is stored in atomic words so that concurrent access is not a data race.
+ */
+template <class T>
+class SeqLock final
+{
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+	SeqLock() noexcept
+	: m_nSeq(0)
+	{
+		store(T{});
+	}
+	/** Publishes a new value.
+	 * Must always be called by the same thread.
+	 * @param oValue The value.
+	 */
+	void store(const T& oValue) noexcept
+	{
+		const uint64_t nSeq = m_nSeq.load(std::memory_order_relaxed);
+		m_nSeq.store(nSeq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::array<uint64_t, s_nTotWords> aWords{};
+		std::memcpy(aWords.data(), &oValue, sizeof(T));
+		for (int32_t nIdx = 0; nIdx < s_nTotWords; ++nIdx) {
+			m_aWords[nIdx].store(aWords[nIdx], std::memory_order_relaxed);
+		}
+		m_nSeq.store(nSeq + 2, std::memory_order_release);
+	}
+	/** Reads a consistent copy of the last published value.
+	 * Can be called by any thread.
+	 * @return The value.
+	 */
+	T load() const noexcept
+	{
+		std::array<uint64_t, s_nTotWords> aWords;
+		uint64_t nSeqBefore;
+		uint64_t nSeqAfter;
+		do {
+			nSeqBefore = m_nSeq.load(std::memory_order_acquire);
+			if ((nSeqBefore & 1) != 0) {
+				// writer is writing
+				std::this_thread::yield();
+				nSeqAfter = nSeqBefore + 1;
+				continue;
+			}
+			for (int32_t nIdx = 0; nIdx < s_nTotWords; ++nIdx) {
+				aWords[nIdx] = m_aWords[nIdx].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			nSeqAfter = m_nSeq.load(std::memory_order_relaxed);
+		} while (nSeqBefore != nSeqAfter);
+		T oValue;
+		std::memcpy(&oValue, aWords.data(), sizeof(T));
+		return oValue;
+	}
+private:
+	static constexpr int32_t s_nTotWords = static_cast<int32_t>((sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+	std::atomic<uint64_t> m_nSeq;
+	std::array<std::atomic<uint64_t>, s_nTotWords> m_aWords;
+private:
+	SeqLock(const SeqLock& oSource) = delete;
+	SeqLock& operator=(const SeqLock& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_SEQ_LOCK_H */
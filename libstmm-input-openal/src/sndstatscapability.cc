@@ -0,0 +1,36 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   sndstatscapability.cc
+ */
+
+#include "sndstatscapability.h"
+
+namespace stmi
+{
+
+const char* const SndStatsCapability::s_sClassId = "stmi::SndStats";
+Capability::RegisterClass<SndStatsCapability> SndStatsCapability::s_oInstall(s_sClassId);
+
+constexpr int32_t SndStatsCapability::s_nMaxStatsDevices;
+
+SndStatsCapability::SndStatsCapability() noexcept
+: DeviceManagerCapability(s_oInstall.getCapabilityClass())
+{
+}
+
+} // namespace stmi
@@ -0,0 +1,362 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   soundbank.cc
+ */
+
+#include "soundbank.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+namespace
+{
+
+constexpr const char s_aMagic[8] = {'S', 'T', 'M', 'I', 'B', 'A', 'N', 'K'};
+constexpr uint32_t s_nVersion = 1;
+// The alignment of the payloads in the file
+constexpr uint64_t s_nDataAlign = 64;
+
+// Header layout (all little-endian)
+//   0  char[8]  magic
+//   8  uint32   version
+//  12  uint32   number of entries
+//  16  uint32   number of index slots (power of 2)
+//  20  uint32   reserved
+//  24  uint64   offset of the entry table
+//  32  uint64   offset of the hash index
+//  40  uint64   offset of the names
+//  48  uint64   size of the names
+//  56  uint64   size of the bank file
+constexpr std::size_t s_nHeaderSize = 64;
+// Entry layout
+//   0  uint64   hash of the name
+//   8  uint32   offset of the name (relative to the names)
+//  12  uint32   size of the name
+//  16  uint64   offset of the payload
+//  24  uint64   size of the payload
+constexpr std::size_t s_nEntrySize = 32;
+// Index slot: uint32 entry index + 1, 0 if empty
+constexpr std::size_t s_nSlotSize = 4;
+
+uint64_t hashName(const std::string& sName) noexcept
+{
+	uint64_t nHash = 0xcbf29ce484222325ULL;
+	for (const char c : sName) {
+		nHash ^= static_cast<uint8_t>(c);
+		nHash *= 0x100000001b3ULL;
+	}
+	return nHash;
+}
+
+uint32_t getU32(const uint8_t* p0Bytes) noexcept
+{
+	return static_cast<uint32_t>(p0Bytes[0]) | (static_cast<uint32_t>(p0Bytes[1]) << 8)
+			| (static_cast<uint32_t>(p0Bytes[2]) << 16) | (static_cast<uint32_t>(p0Bytes[3]) << 24);
+}
+uint64_t getU64(const uint8_t* p0Bytes) noexcept
+{
+	return static_cast<uint64_t>(getU32(p0Bytes)) | (static_cast<uint64_t>(getU32(p0Bytes + 4)) << 32);
+}
+void putU32(uint8_t* p0Bytes, uint32_t nValue) noexcept
+{
+	p0Bytes[0] = static_cast<uint8_t>(nValue);
+	p0Bytes[1] = static_cast<uint8_t>(nValue >> 8);
+	p0Bytes[2] = static_cast<uint8_t>(nValue >> 16);
+	p0Bytes[3] = static_cast<uint8_t>(nValue >> 24);
+}
+void putU64(uint8_t* p0Bytes, uint64_t nValue) noexcept
+{
+	putU32(p0Bytes, static_cast<uint32_t>(nValue));
+	putU32(p0Bytes + 4, static_cast<uint32_t>(nValue >> 32));
+}
+
+uint64_t alignUp(uint64_t nOffset) noexcept
+{
+	return (nOffset + s_nDataAlign - 1) / s_nDataAlign * s_nDataAlign;
+}
+
+bool writeAll(int nFD, const void* p0Data, std::size_t nSize) noexcept
+{
+	const uint8_t* p0Bytes = static_cast<const uint8_t*>(p0Data);
+	while (nSize > 0) {
+		const ssize_t nWritten = ::write(nFD, p0Bytes, nSize);
+		if (nWritten < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false; //----------------------------------------------------
+		}
+		p0Bytes += nWritten;
+		nSize -= static_cast<std::size_t>(nWritten);
+	}
+	return true;
+}
+
+} // unnamed namespace
+
+SoundBank::~SoundBank() noexcept
+{
+	close();
+}
+void SoundBank::close() noexcept
+{
+	if (m_p0Mapped != nullptr) {
+		::munmap(m_p0Mapped, m_nMappedSize);
+		m_p0Mapped = nullptr;
+		m_nMappedSize = 0;
+	}
+	m_sPath.clear();
+	m_nTotEntries = 0;
+	m_nIndexSlots = 0;
+	m_p0Entries = nullptr;
+	m_p0Index = nullptr;
+	m_p0Names = nullptr;
+}
+std::string SoundBank::open(const std::string& sBankPath) noexcept
+{
+	assert(! sBankPath.empty());
+	close();
+	const int nFD = ::open(sBankPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (nFD < 0) {
+		return "Could not open sound bank " + sBankPath; //---------------------
+	}
+	struct stat oStat;
+	const bool bStat = (::fstat(nFD, &oStat) == 0);
+	const std::size_t nMappedSize = (bStat ? static_cast<std::size_t>(oStat.st_size) : 0);
+	void* p0Mapped = ((nMappedSize >= s_nHeaderSize)
+					? ::mmap(nullptr, nMappedSize, PROT_READ, MAP_SHARED, nFD, 0)
+					: MAP_FAILED);
+	// the mapping stays valid
+	::close(nFD);
+	if (p0Mapped == MAP_FAILED) {
+		return "Could not map sound bank " + sBankPath; //----------------------
+	}
+	m_p0Mapped = p0Mapped;
+	m_nMappedSize = nMappedSize;
+	const uint8_t* p0Bytes = static_cast<const uint8_t*>(p0Mapped);
+	const uint64_t nSize = nMappedSize;
+
+	const uint32_t nTotEntries = getU32(p0Bytes + 12);
+	const uint32_t nIndexSlots = getU32(p0Bytes + 16);
+	const uint64_t nEntriesOffset = getU64(p0Bytes + 24);
+	const uint64_t nIndexOffset = getU64(p0Bytes + 32);
+	const uint64_t nNamesOffset = getU64(p0Bytes + 40);
+	const uint64_t nNamesSize = getU64(p0Bytes + 48);
+	// The offsets are checked against the size before they are multiplied or
+	// added so that they can't overflow
+	bool bValid = (std::memcmp(p0Bytes, s_aMagic, sizeof(s_aMagic)) == 0)
+				&& (getU32(p0Bytes + 8) == s_nVersion) && (getU64(p0Bytes + 56) == nSize)
+				&& (nTotEntries <= static_cast<uint32_t>(std::numeric_limits<int32_t>::max()))
+				&& (nIndexSlots > nTotEntries) && ((nIndexSlots & (nIndexSlots - 1)) == 0)
+				&& (nEntriesOffset <= nSize) && (nTotEntries <= (nSize - nEntriesOffset) / s_nEntrySize)
+				&& (nIndexOffset <= nSize) && (nIndexSlots <= (nSize - nIndexOffset) / s_nSlotSize)
+				&& (nNamesOffset <= nSize) && (nNamesSize <= nSize - nNamesOffset);
+	for (uint32_t nIdx = 0; bValid && (nIdx < nTotEntries); ++nIdx) {
+		const uint8_t* p0Entry = p0Bytes + nEntriesOffset + nIdx * s_nEntrySize;
+		const uint64_t nNameOffset = getU32(p0Entry + 8);
+		const uint64_t nNameSize = getU32(p0Entry + 12);
+		const uint64_t nDataOffset = getU64(p0Entry + 16);
+		const uint64_t nDataSize = getU64(p0Entry + 24);
+		bValid = (nNameOffset + nNameSize <= nNamesSize)
+				&& (nDataOffset <= nSize) && (nDataSize <= nSize - nDataOffset)
+				&& (nDataSize <= static_cast<uint64_t>(std::numeric_limits<int32_t>::max()))
+				&& ((nDataOffset % s_nDataAlign) == 0);
+	}
+	for (uint32_t nSlot = 0; bValid && (nSlot < nIndexSlots); ++nSlot) {
+		bValid = (getU32(p0Bytes + nIndexOffset + nSlot * s_nSlotSize) <= nTotEntries);
+	}
+	if (! bValid) {
+		close();
+		return "Invalid sound bank " + sBankPath; //----------------------------
+	}
+	m_sPath = sBankPath;
+	m_nTotEntries = static_cast<int32_t>(nTotEntries);
+	m_nIndexSlots = nIndexSlots;
+	m_p0Entries = p0Bytes + nEntriesOffset;
+	m_p0Index = p0Bytes + nIndexOffset;
+	m_p0Names = p0Bytes + nNamesOffset;
+	return "";
+}
+const uint8_t* SoundBank::getEntryRecord(int32_t nIdx) const noexcept
+{
+	assert((nIdx >= 0) && (nIdx < m_nTotEntries));
+	return m_p0Entries + static_cast<std::size_t>(nIdx) * s_nEntrySize;
+}
+std::string SoundBank::getEntryName(int32_t nIdx) const noexcept
+{
+	const uint8_t* p0Entry = getEntryRecord(nIdx);
+	return std::string(reinterpret_cast<const char*>(m_p0Names + getU32(p0Entry + 8)), getU32(p0Entry + 12));
+}
+const uint8_t* SoundBank::getEntryData(int32_t nIdx) const noexcept
+{
+	const uint8_t* p0Entry = getEntryRecord(nIdx);
+	return static_cast<const uint8_t*>(m_p0Mapped) + getU64(p0Entry + 16);
+}
+int32_t SoundBank::getEntrySize(int32_t nIdx) const noexcept
+{
+	const uint8_t* p0Entry = getEntryRecord(nIdx);
+	return static_cast<int32_t>(getU64(p0Entry + 24));
+}
+int32_t SoundBank::findEntry(const std::string& sName) const noexcept
+{
+	if (m_nIndexSlots == 0) {
+		return -1; //-----------------------------------------------------------
+	}
+	const uint64_t nHash = hashName(sName);
+	const uint32_t nMask = m_nIndexSlots - 1;
+	uint32_t nSlot = static_cast<uint32_t>(nHash) & nMask;
+	// there is always at least one empty slot
+	for (uint32_t nProbe = 0; nProbe < m_nIndexSlots; ++nProbe) {
+		const uint32_t nValue = getU32(m_p0Index + nSlot * s_nSlotSize);
+		if (nValue == 0) {
+			break; //-----------------------------------------------------------
+		}
+		const int32_t nIdx = static_cast<int32_t>(nValue - 1);
+		const uint8_t* p0Entry = getEntryRecord(nIdx);
+		if ((getU64(p0Entry) == nHash) && (getU32(p0Entry + 12) == sName.size())
+				&& (std::memcmp(m_p0Names + getU32(p0Entry + 8), sName.data(), sName.size()) == 0)) {
+			return nIdx; //-----------------------------------------------------
+		}
+		nSlot = (nSlot + 1) & nMask;
+	}
+	return -1;
+}
+
+std::string SoundBank::write(const std::string& sBankPath
+							, const std::vector<std::pair<std::string, std::vector<uint8_t>>>& aEntries) noexcept
+{
+	assert(! sBankPath.empty());
+	const uint32_t nTotEntries = static_cast<uint32_t>(aEntries.size());
+	uint32_t nIndexSlots = 1;
+	// load factor at most 0.5
+	while (nIndexSlots < 2 * nTotEntries + 1) {
+		nIndexSlots *= 2;
+	}
+	const uint64_t nEntriesOffset = s_nHeaderSize;
+	const uint64_t nIndexOffset = nEntriesOffset + nTotEntries * s_nEntrySize;
+	const uint64_t nNamesOffset = nIndexOffset + nIndexSlots * s_nSlotSize;
+	uint64_t nNamesSize = 0;
+	for (const auto& oEntry : aEntries) {
+		nNamesSize += oEntry.first.size();
+	}
+	if (nNamesSize > std::numeric_limits<uint32_t>::max()) {
+		return "Names too long"; //---------------------------------------------
+	}
+	// header, entries, index and names
+	std::vector<uint8_t> aHead(nNamesOffset + nNamesSize, 0);
+	std::string sNames;
+	uint64_t nDataOffset = alignUp(aHead.size());
+	for (uint32_t nIdx = 0; nIdx < nTotEntries; ++nIdx) {
+		const std::string& sName = aEntries[nIdx].first;
+		const std::vector<uint8_t>& aData = aEntries[nIdx].second;
+		if (sName.empty()) {
+			return "Empty entry name"; //---------------------------------------
+		}
+		if (aData.size() > static_cast<std::size_t>(std::numeric_limits<int32_t>::max())) {
+			return "Entry too big: " + sName; //--------------------------------
+		}
+		const uint64_t nHash = hashName(sName);
+		uint8_t* p0Entry = aHead.data() + nEntriesOffset + nIdx * s_nEntrySize;
+		putU64(p0Entry, nHash);
+		putU32(p0Entry + 8, static_cast<uint32_t>(sNames.size()));
+		putU32(p0Entry + 12, static_cast<uint32_t>(sName.size()));
+		putU64(p0Entry + 16, nDataOffset);
+		putU64(p0Entry + 24, aData.size());
+		sNames.append(sName);
+		nDataOffset = alignUp(nDataOffset + aData.size());
+
+		const uint32_t nMask = nIndexSlots - 1;
+		uint32_t nSlot = static_cast<uint32_t>(nHash) & nMask;
+		while (true) {
+			uint8_t* p0Slot = aHead.data() + nIndexOffset + nSlot * s_nSlotSize;
+			const uint32_t nValue = getU32(p0Slot);
+			if (nValue == 0) {
+				putU32(p0Slot, nIdx + 1);
+				break; //-------------------------------------------------------
+			}
+			if (aEntries[nValue - 1].first == sName) {
+				return "Duplicate entry name: " + sName; //---------------------
+			}
+			nSlot = (nSlot + 1) & nMask;
+		}
+	}
+	std::memcpy(aHead.data() + nNamesOffset, sNames.data(), sNames.size());
+	// the last payload is not padded
+	const uint64_t nBankSize = ((nTotEntries == 0) ? aHead.size()
+								: getU64(aHead.data() + nEntriesOffset + (nTotEntries - 1) * s_nEntrySize + 16)
+									+ aEntries.back().second.size());
+	std::memcpy(aHead.data(), s_aMagic, sizeof(s_aMagic));
+	putU32(aHead.data() + 8, s_nVersion);
+	putU32(aHead.data() + 12, nTotEntries);
+	putU32(aHead.data() + 16, nIndexSlots);
+	putU64(aHead.data() + 24, nEntriesOffset);
+	putU64(aHead.data() + 32, nIndexOffset);
+	putU64(aHead.data() + 40, nNamesOffset);
+	putU64(aHead.data() + 48, nNamesSize);
+	putU64(aHead.data() + 56, nBankSize);
+
+	const std::string sTempPath = sBankPath + "." + std::to_string(::getpid()) + ".tmp";
+	const int nFD = ::open(sTempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (nFD < 0) {
+		return "Could not create file " + sTempPath; //-------------------------
+	}
+	const std::vector<uint8_t> aPadding(s_nDataAlign, 0);
+	bool bWritten = writeAll(nFD, aHead.data(), aHead.size());
+	uint64_t nWritten = aHead.size();
+	for (const auto& oEntry : aEntries) {
+		if (! bWritten) {
+			break;
+		}
+		const std::vector<uint8_t>& aData = oEntry.second;
+		bWritten = writeAll(nFD, aPadding.data(), alignUp(nWritten) - nWritten)
+					&& writeAll(nFD, aData.data(), aData.size());
+		nWritten = alignUp(nWritten) + aData.size();
+	}
+	const bool bClosed = (::close(nFD) == 0);
+	if (! (bWritten && bClosed)) {
+		::unlink(sTempPath.c_str());
+		return "Could not write file " + sTempPath; //--------------------------
+	}
+	assert(nWritten == nBankSize);
+	if (::rename(sTempPath.c_str(), sBankPath.c_str()) != 0) {
+		::unlink(sTempPath.c_str());
+		return "Could not rename file " + sTempPath; //-------------------------
+	}
+	return "";
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   soundbank.h
+ */
+
+#ifndef STMI_OPENAL_SOUND_BANK_H
+#define STMI_OPENAL_SOUND_BANK_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Sound bank archive.
+ * A single file containing many sounds, so that they can be loaded with
+ * one open and one mmap instead of one open/stat/read per sound.
+ *
+ * The file starts with a header, followed by the entry table, a hash index
+ * of the entry names (open addressing with linear probing), the names and
+ * the payloads. Each payload is the image of a sound file (WAV, OGG, ...)
+ * and is aligned to 64 bytes. All numbers are stored little-endian.
+ */
+class SoundBank
+{
+public:
+	SoundBank() noexcept = default;
+	~SoundBank() noexcept;
+
+	/** Maps a bank file.
+	 * A previously opened bank is closed first.
+	 * @param sBankPath The path of the bank. Cannot be empty.
+	 * @return The error or empty if successful.
+	 */
+	std::string open(const std::string& sBankPath) noexcept;
+	/** Unmaps the bank.
+	 * The entry data pointers are invalidated.
+	 */
+	void close() noexcept;
+	/** The path of the opened bank.
+	 * @return The path or empty if not opened.
+	 */
+	const std::string& getPath() const noexcept { return m_sPath; }
+	/** The number of entries.
+	 * @return The number of entries.
+	 */
+	int32_t getTotEntries() const noexcept { return m_nTotEntries; }
+	/** The name of an entry.
+	 * @param nIdx The index of the entry. Must be &gt;= 0 and &lt; getTotEntries().
+	 * @return The name.
+	 */
+	std::string getEntryName(int32_t nIdx) const noexcept;
+	/** The payload of an entry.
+	 * The pointer is valid as long as the bank is opened.
+	 * @param nIdx The index of the entry. Must be &gt;= 0 and &lt; getTotEntries().
+	 * @return The payload. Is aligned to 64 bytes.
+	 */
+	const uint8_t* getEntryData(int32_t nIdx) const noexcept;
+	/** The payload size of an entry.
+	 * @param nIdx The index of the entry. Must be &gt;= 0 and &lt; getTotEntries().
+	 * @return The size in bytes.
+	 */
+	int32_t getEntrySize(int32_t nIdx) const noexcept;
+	/** Looks up an entry by name through the hash index.
+	 * @param sName The name.
+	 * @return The index of the entry or -1 if not found.
+	 */
+	int32_t findEntry(const std::string& sName) const noexcept;
+
+	/** Writes a bank file.
+	 * The file is written to a temporary file that is then renamed.
+	 * @param sBankPath The path of the bank. Cannot be empty.
+	 * @param aEntries The names and payloads. Names must be unique and not empty.
+	 * @return The error or empty if successful.
+	 */
+	static std::string write(const std::string& sBankPath
+							, const std::vector<std::pair<std::string, std::vector<uint8_t>>>& aEntries) noexcept;
+private:
+	const uint8_t* getEntryRecord(int32_t nIdx) const noexcept;
+private:
+	std::string m_sPath;
+	void* m_p0Mapped = nullptr;
+	std::size_t m_nMappedSize = 0;
+	int32_t m_nTotEntries = 0;
+	uint32_t m_nIndexSlots = 0;
+	const uint8_t* m_p0Entries = nullptr;
+	const uint8_t* m_p0Index = nullptr;
+	const uint8_t* m_p0Names = nullptr;
+private:
+	SoundBank(const SoundBank& oSource) = delete;
+	SoundBank& operator=(const SoundBank& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_SOUND_BANK_H */
@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   tracerecorder.cc
+ */
+
+#include "tracerecorder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+constexpr int32_t TraceRecorder::Ring::s_nRingSize;
+
+TraceRecorder::Ring::Ring(const std::string& sThreadName) noexcept
+: m_sThreadName(sThreadName)
+, m_nTotAdded(0)
+{
+	clear();
+}
+void TraceRecorder::Ring::addSpan(const char* p0Name, int64_t nBeginUsec, int64_t nEndUsec) noexcept
+{
+	assert(p0Name != nullptr);
+	const uint64_t nTotAdded = m_nTotAdded.load(std::memory_order_relaxed);
+	AtomicSpan& oSpan = m_aSpans[nTotAdded % s_nRingSize];
+	oSpan.m_p0Name.store(p0Name, std::memory_order_relaxed);
+	oSpan.m_nBeginUsec.store(nBeginUsec, std::memory_order_relaxed);
+	oSpan.m_nDurationUsec.store(nEndUsec - nBeginUsec, std::memory_order_relaxed);
+	m_nTotAdded.store(nTotAdded + 1, std::memory_order_release);
+}
+void TraceRecorder::Ring::getSpans(std::vector<Span>& aSpans) const noexcept
+{
+	aSpans.clear();
+	const uint64_t nTotAddedBefore = m_nTotAdded.load(std::memory_order_acquire);
+	const uint64_t nFirst = ((nTotAddedBefore > s_nRingSize) ? nTotAddedBefore - s_nRingSize : 0);
+	for (uint64_t nIdx = nFirst; nIdx < nTotAddedBefore; ++nIdx) {
+		const AtomicSpan& oSpan = m_aSpans[nIdx % s_nRingSize];
+		aSpans.push_back(Span{oSpan.m_p0Name.load(std::memory_order_relaxed)
+							, oSpan.m_nBeginUsec.load(std::memory_order_relaxed)
+							, oSpan.m_nDurationUsec.load(std::memory_order_relaxed)});
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t nTotAddedAfter = m_nTotAdded.load(std::memory_order_relaxed);
+	// The writer might have overwritten the oldest spans while they were read
+	// (including the one it is writing to right now)
+	const uint64_t nFirstValid = ((nTotAddedAfter >= s_nRingSize) ? nTotAddedAfter - s_nRingSize + 1 : 0);
+	if (nFirstValid > nFirst) {
+		const uint64_t nTotInvalid = std::min<uint64_t>(nFirstValid - nFirst, aSpans.size());
+		aSpans.erase(aSpans.begin(), aSpans.begin() + nTotInvalid);
+	}
+	// a null name means a slot cleared while being read
+	aSpans.erase(std::remove_if(aSpans.begin(), aSpans.end(), [](const Span& oSpan)
+			{
+				return (oSpan.m_p0Name == nullptr);
+			}), aSpans.end());
+}
+void TraceRecorder::Ring::clear() noexcept
+{
+	for (AtomicSpan& oSpan : m_aSpans) {
+		oSpan.m_p0Name.store(nullptr, std::memory_order_relaxed);
+		oSpan.m_nBeginUsec.store(0, std::memory_order_relaxed);
+		oSpan.m_nDurationUsec.store(0, std::memory_order_relaxed);
+	}
+}
+
+TraceRecorder::TraceRecorder() noexcept
+: m_bEnabled(false)
+{
+}
+TraceRecorder::Ring& TraceRecorder::addThread(const std::string& sThreadName) noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oRingsMutex);
+	m_aRings.emplace_back(new Ring(sThreadName));
+	return *m_aRings.back();
+}
+void TraceRecorder::write(std::ostream& oOut) const noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oRingsMutex);
+	oOut << "{\"traceEvents\":[";
+	bool bFirst = true;
+	auto oSeparator = [&]()
+	{
+		if (bFirst) {
+			bFirst = false;
+			oOut << '\n';
+		} else {
+			oOut << ",\n";
+		}
+	};
+	std::vector<Ring::Span> aSpans;
+	const int32_t nTotRings = static_cast<int32_t>(m_aRings.size());
+	for (int32_t nRingIdx = 0; nRingIdx < nTotRings; ++nRingIdx) {
+		const Ring& oRing = *m_aRings[nRingIdx];
+		const int32_t nTid = nRingIdx + 1;
+		oSeparator();
+		oOut << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << nTid
+				<< ",\"args\":{\"name\":\"" << oRing.m_sThreadName << "\"}}";
+		oRing.getSpans(aSpans);
+		for (const Ring::Span& oSpan : aSpans) {
+			oSeparator();
+			oOut << "{\"name\":\"" << oSpan.m_p0Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << nTid
+					<< ",\"ts\":" << oSpan.m_nBeginUsec << ",\"dur\":" << oSpan.m_nDurationUsec << "}";
+		}
+	}
+	oOut << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+std::string TraceRecorder::write(const std::string& sFilePath) const noexcept
+{
+	assert(! sFilePath.empty());
+	std::ofstream oFile(sFilePath, std::ios::out | std::ios::trunc);
+	if (! oFile.is_open()) {
+		return "Could not create trace file " + sFilePath; //-------------------
+	}
+	write(oFile);
+	oFile.close();
+	if (oFile.fail()) {
+		return "Error writing trace file " + sFilePath; //----------------------
+	}
+	return "";
+}
+void TraceRecorder::clear() noexcept
+{
+	std::lock_guard<std::mutex> oLock(m_oRingsMutex);
+	for (auto& refRing : m_aRings) {
+		refRing->clear();
+	}
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   tracerecorder.h
+ */
+
+#ifndef STMI_OPENAL_TRACE_RECORDER_H
+#define STMI_OPENAL_TRACE_RECORDER_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Records begin/end spans into per-thread ring buffers.
+ * Each thread that wants to record spans gets its own Ring with addThread().
+ * A ring has a single writer (its thread) and is never blocked by readers:
+ * when full the oldest spans are overwritten.
+ * The spans can be written in the Chrome trace JSON format (which can be
+ * opened by chrome://tracing and Perfetto) from any thread.
+ */
+class TraceRecorder
+{
+public:
+	TraceRecorder() noexcept;
+
+	void setEnabled(bool bEnabled) noexcept { m_bEnabled.store(bEnabled, std::memory_order_relaxed); }
+	bool isEnabled() const noexcept { return m_bEnabled.load(std::memory_order_relaxed); }
+
+	class Ring
+	{
+	public:
+		/** Adds a span.
+		 * Must only be called by the thread owning the ring.
+		 * @param p0Name The name. Must be a string literal (or at least outlive the recorder)
+		 * not needing JSON escaping.
+		 * @param nBeginUsec The start time in microseconds.
+		 * @param nEndUsec The end time in microseconds.
+		 */
+		void addSpan(const char* p0Name, int64_t nBeginUsec, int64_t nEndUsec) noexcept;
+	private:
+		friend class TraceRecorder;
+		explicit Ring(const std::string& sThreadName) noexcept;
+		struct Span
+		{
+			const char* m_p0Name;
+			int64_t m_nBeginUsec;
+			int64_t m_nDurationUsec;
+		};
+		// Returns the spans still in the ring, oldest first
+		void getSpans(std::vector<Span>& aSpans) const noexcept;
+		void clear() noexcept;
+	private:
+		struct AtomicSpan
+		{
+			std::atomic<const char*> m_p0Name;
+			std::atomic<int64_t> m_nBeginUsec;
+			std::atomic<int64_t> m_nDurationUsec;
+		};
+		static constexpr int32_t s_nRingSize = 8192;
+		const std::string m_sThreadName;
+		// The total number of spans ever added
+		std::atomic<uint64_t> m_nTotAdded;
+		std::array<AtomicSpan, s_nRingSize> m_aSpans;
+	private:
+		Ring() = delete;
+		Ring(const Ring& oSource) = delete;
+		Ring& operator=(const Ring& oSource) = delete;
+	};
+	/** Creates the ring of a thread.
+	 * Can be called from any thread.
+	 * @param sThreadName The thread name shown in the trace. Must not need JSON escaping.
+	 * @return The ring, valid as long as the recorder.
+	 */
+	Ring& addThread(const std::string& sThreadName) noexcept;
+	/** Writes the spans currently in the rings as Chrome trace JSON.
+	 * Can be called from any thread.
+	 * @param oOut The stream.
+	 */
+	void write(std::ostream& oOut) const noexcept;
+	/** Writes the spans to a file.
+	 * @param sFilePath The file path. Cannot be empty.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	std::string write(const std::string& sFilePath) const noexcept;
+	/** Removes all the spans.
+	 * Spans being added concurrently might not be removed.
+	 */
+	void clear() noexcept;
+private:
+	std::atomic<bool> m_bEnabled;
+	mutable std::mutex m_oRingsMutex;
+	// only accessed under m_oRingsMutex (the rings themselves are not)
+	std::vector<std::unique_ptr<Ring>> m_aRings;
+private:
+	TraceRecorder(const TraceRecorder& oSource) = delete;
+	TraceRecorder& operator=(const TraceRecorder& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_TRACE_RECORDER_H */
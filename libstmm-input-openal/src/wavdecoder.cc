@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   wavdecoder.cc
+ */
+
+#include "wavdecoder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+namespace
+{
+uint32_t readUInt32(const uint8_t* p0Data) noexcept
+{
+	// little endian
+	return static_cast<uint32_t>(p0Data[0]) | (static_cast<uint32_t>(p0Data[1]) << 8)
+			| (static_cast<uint32_t>(p0Data[2]) << 16) | (static_cast<uint32_t>(p0Data[3]) << 24);
+}
+uint16_t readUInt16(const uint8_t* p0Data) noexcept
+{
+	// little endian
+	return static_cast<uint16_t>(p0Data[0] | (p0Data[1] << 8));
+}
+} // unnamed namespace
+
+std::string WavDecoder::decode(const uint8_t* p0Data, int32_t nSize, PcmSound& oSound) noexcept
+{
+	assert(p0Data != nullptr);
+	if ((nSize < 12) || (std::memcmp(p0Data, "RIFF", 4) != 0) || (std::memcmp(p0Data + 8, "WAVE", 4) != 0)) {
+		return "Not a RIFF WAVE file"; //---------------------------------------
+	}
+	int32_t nChannels = 0;
+	int32_t nFrequency = 0;
+	int32_t nBitsPerSample = 0;
+	int32_t nPos = 12;
+	while (nPos + 8 <= nSize) {
+		const uint8_t* p0Chunk = p0Data + nPos;
+		const int64_t nChunkSize = readUInt32(p0Chunk + 4);
+		const int32_t nChunkDataPos = nPos + 8;
+		const int32_t nAvailable = static_cast<int32_t>(std::min<int64_t>(nChunkSize, nSize - nChunkDataPos));
+		if (std::memcmp(p0Chunk, "fmt ", 4) == 0) {
+			if (nAvailable < 16) {
+				return "WAVE fmt chunk too short"; //---------------------------
+			}
+			const uint16_t nFormat = readUInt16(p0Chunk + 8);
+			nChannels = readUInt16(p0Chunk + 10);
+			nFrequency = static_cast<int32_t>(readUInt32(p0Chunk + 12));
+			nBitsPerSample = readUInt16(p0Chunk + 22);
+			if (nFormat != 1) {
+				return "Only PCM WAVE files supported"; //----------------------
+			}
+			if ((nChannels < 1) || (nChannels > 2)) {
+				return "Only mono and stereo WAVE files supported"; //----------
+			}
+			if ((nBitsPerSample != 8) && (nBitsPerSample != 16)) {
+				return "Only 8 and 16 bit WAVE files supported"; //-------------
+			}
+			if (nFrequency <= 0) {
+				return "Invalid WAVE sample rate"; //---------------------------
+			}
+		} else if (std::memcmp(p0Chunk, "data", 4) == 0) {
+			if (nChannels == 0) {
+				return "WAVE data chunk before fmt chunk"; //-------------------
+			}
+			const int32_t nBytesPerSample = nBitsPerSample / 8;
+			const int32_t nTotSamples = (nAvailable / (nBytesPerSample * nChannels)) * nChannels;
+			oSound.m_nFrequency = nFrequency;
+			oSound.m_nChannels = nChannels;
+			oSound.m_aSamples.resize(nTotSamples);
+			const uint8_t* p0Samples = p0Data + nChunkDataPos;
+			if (nBytesPerSample == 1) {
+				// 8 bit samples are unsigned
+				for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+					oSound.m_aSamples[nIdx] = (static_cast<int32_t>(p0Samples[nIdx]) - 128) / 128.0f;
+				}
+			} else {
+				for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+					const int16_t nSample = static_cast<int16_t>(readUInt16(p0Samples + 2 * nIdx));
+					oSound.m_aSamples[nIdx] = nSample / 32768.0f;
+				}
+			}
+			return ""; //-------------------------------------------------------
+		}
+		// chunks are word aligned
+		nPos = static_cast<int32_t>(std::min<int64_t>(nSize, nChunkDataPos + nChunkSize + (nChunkSize & 1)));
+	}
+	return "WAVE data chunk not found";
+}
+std::string WavDecoder::decodeFile(const std::string& sFilePath, PcmSound& oSound) noexcept
+{
+	std::ifstream oFile(sFilePath, std::ios::in | std::ios::binary);
+	if (! oFile.is_open()) {
+		return "Could not open file " + sFilePath; //---------------------------
+	}
+	const std::vector<uint8_t> aData{std::istreambuf_iterator<char>(oFile), std::istreambuf_iterator<char>()};
+	if (oFile.bad()) {
+		return "Could not read file " + sFilePath; //---------------------------
+	}
+	return decode(aData.data(), static_cast<int32_t>(aData.size()), oSound);
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   wavdecoder.h
+ */
+
+#ifndef STMI_OPENAL_WAV_DECODER_H
+#define STMI_OPENAL_WAV_DECODER_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+/** Decoded PCM samples. */
+struct PcmSound
+{
+	int32_t m_nFrequency = 0; /**< The sample rate in Hz. */
+	int32_t m_nChannels = 0; /**< The number of interleaved channels (1 or 2). */
+	std::vector<float> m_aSamples; /**< The interleaved samples in the range [-1, 1]. */
+	int32_t getTotFrames() const noexcept
+	{
+		return (m_nChannels == 0) ? 0 : static_cast<int32_t>(m_aSamples.size()) / m_nChannels;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/** Decodes RIFF WAVE files with 8 or 16 bit PCM mono or stereo samples.
+ * Used by the backends that can't use alure.
+ */
+class WavDecoder
+{
+public:
+	/** Decodes a memory buffer.
+	 * @param p0Data The WAV file content. Cannot be null.
+	 * @param nSize The size in bytes.
+	 * @param oSound The decoded sound.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	static std::string decode(const uint8_t* p0Data, int32_t nSize, PcmSound& oSound) noexcept;
+	/** Decodes a file.
+	 * @param sFilePath The file path.
+	 * @param oSound The decoded sound.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	static std::string decodeFile(const std::string& sFilePath, PcmSound& oSound) noexcept;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_WAV_DECODER_H */
@@ -0,0 +1,126 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   wavfilewriter.cc
+ */
+
+#include "wavfilewriter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+static constexpr const int32_t s_nWavHeaderBytes = 44;
+static constexpr const int32_t s_nRiffSizePos = 4;
+static constexpr const int32_t s_nDataSizePos = 40;
+
+WavFileWriter::WavFileWriter() noexcept
+: m_nDataBytes(0)
+{
+}
+WavFileWriter::~WavFileWriter() noexcept
+{
+	close();
+}
+std::string WavFileWriter::open(const std::string& sFilePath, int32_t nFrequency, int32_t nChannels) noexcept
+{
+	assert(! sFilePath.empty());
+	assert(nFrequency > 0);
+	assert(nChannels > 0);
+	assert(! isOpen());
+	m_oFile.open(sFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (! m_oFile.is_open()) {
+		return "Could not create file " + sFilePath; //-------------------------
+	}
+	m_nDataBytes = 0;
+	const uint16_t nBytesPerFrame = static_cast<uint16_t>(nChannels * sizeof(int16_t));
+	m_oFile.write("RIFF", 4);
+	writeUInt32(0); // patched by close()
+	m_oFile.write("WAVE", 4);
+	m_oFile.write("fmt ", 4);
+	writeUInt32(16); // fmt chunk size
+	writeUInt16(1); // PCM
+	writeUInt16(static_cast<uint16_t>(nChannels));
+	writeUInt32(static_cast<uint32_t>(nFrequency));
+	writeUInt32(static_cast<uint32_t>(nFrequency) * nBytesPerFrame); // bytes per second
+	writeUInt16(nBytesPerFrame);
+	writeUInt16(16); // bits per sample
+	m_oFile.write("data", 4);
+	writeUInt32(0); // patched by close()
+	if (! m_oFile.good()) {
+		m_oFile.close();
+		return "Could not write to file " + sFilePath; //-----------------------
+	}
+	return "";
+}
+void WavFileWriter::write(const int16_t* p0Samples, int32_t nTotSamples) noexcept
+{
+	assert(p0Samples != nullptr);
+	assert(nTotSamples >= 0);
+	if (! isOpen()) {
+		return; //--------------------------------------------------------------
+	}
+	// convert to little endian in one buffer to write it at once
+	m_aBytes.resize(nTotSamples * 2);
+	for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+		const uint16_t nValue = static_cast<uint16_t>(p0Samples[nIdx]);
+		m_aBytes[2 * nIdx] = static_cast<char>(nValue & 0xFF);
+		m_aBytes[2 * nIdx + 1] = static_cast<char>((nValue >> 8) & 0xFF);
+	}
+	m_oFile.write(m_aBytes.data(), m_aBytes.size());
+	m_nDataBytes += nTotSamples * static_cast<int64_t>(sizeof(int16_t));
+}
+void WavFileWriter::close() noexcept
+{
+	if (! isOpen()) {
+		return; //--------------------------------------------------------------
+	}
+	// the sizes are 32 bit, a longer file is truncated (for the readers)
+	const uint32_t nDataBytes = static_cast<uint32_t>(std::min<int64_t>(m_nDataBytes
+													, std::numeric_limits<uint32_t>::max() - s_nWavHeaderBytes));
+	m_oFile.seekp(s_nRiffSizePos);
+	writeUInt32(nDataBytes + s_nWavHeaderBytes - 8);
+	m_oFile.seekp(s_nDataSizePos);
+	writeUInt32(nDataBytes);
+	m_oFile.close();
+}
+void WavFileWriter::writeUInt32(uint32_t nValue) noexcept
+{
+	// little endian
+	const char aBytes[4] = {static_cast<char>(nValue & 0xFF), static_cast<char>((nValue >> 8) & 0xFF)
+							, static_cast<char>((nValue >> 16) & 0xFF), static_cast<char>((nValue >> 24) & 0xFF)};
+	m_oFile.write(aBytes, 4);
+}
+void WavFileWriter::writeUInt16(uint16_t nValue) noexcept
+{
+	// little endian
+	const char aBytes[2] = {static_cast<char>(nValue & 0xFF), static_cast<char>((nValue >> 8) & 0xFF)};
+	m_oFile.write(aBytes, 2);
+}
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
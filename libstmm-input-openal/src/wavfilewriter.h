@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   wavfilewriter.h
+ */
+
+#ifndef STMI_OPENAL_WAV_FILE_WRITER_H
+#define STMI_OPENAL_WAV_FILE_WRITER_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace Private
+{
+namespace OpenAl
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/** Writes 16 bit PCM samples to a RIFF WAVE file.
+ * The sizes in the header are only correct after close() (or destruction).
+ */
+class WavFileWriter
+{
+public:
+	WavFileWriter() noexcept;
+	~WavFileWriter() noexcept;
+
+	/** Creates the file and writes the header.
+	 * @param sFilePath The file path. Cannot be empty.
+	 * @param nFrequency The sample rate in Hz. Must be positive.
+	 * @param nChannels The number of interleaved channels. Must be positive.
+	 * @return Empty string if successful, the error otherwise.
+	 */
+	std::string open(const std::string& sFilePath, int32_t nFrequency, int32_t nChannels) noexcept;
+	/** Whether the file is open.
+	 * @return Whether open() was successful and close() wasn't called yet.
+	 */
+	bool isOpen() const noexcept { return m_oFile.is_open(); }
+	/** Appends interleaved samples.
+	 * @param p0Samples The samples. Cannot be null.
+	 * @param nTotSamples The number of samples (not frames).
+	 */
+	void write(const int16_t* p0Samples, int32_t nTotSamples) noexcept;
+	/** Fixes the header and closes the file.
+	 * Does nothing if not open.
+	 */
+	void close() noexcept;
+	/** The number of bytes of sample data written so far.
+	 * @return The bytes.
+	 */
+	int64_t getDataBytes() const noexcept { return m_nDataBytes; }
+private:
+	void writeUInt32(uint32_t nValue) noexcept;
+	void writeUInt16(uint16_t nValue) noexcept;
+private:
+	std::ofstream m_oFile;
+	int64_t m_nDataBytes;
+	// Used to avoid reallocating
+	std::vector<char> m_aBytes;
+private:
+	WavFileWriter(const WavFileWriter& oSource) = delete;
+	WavFileWriter& operator=(const WavFileWriter& oSource) = delete;
+};
+
+} // namespace OpenAl
+} // namespace Private
+
+} // namespace stmi
+
+#endif /* STMI_OPENAL_WAV_FILE_WRITER_H */
@@ -0,0 +1,592 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   fakeopenalbackend.cc
+ */
+
+#include "fakeopenalbackend.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <tuple>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+FakeOpenAlBackend::FakeOpenAlBackend(::stmi::OpenAlDeviceManager* p0Owner) noexcept
+: Backend(p0Owner)
+, m_bStarted(false)
+, m_nNowMillisec(0)
+, m_nCommandQueueWaitMillisec(0)
+, m_nDefaultDeviceId(-1)
+{
+}
+std::string FakeOpenAlBackend::start() noexcept
+{
+	assert(! m_bStarted);
+	if (! m_sStartError.empty()) {
+		return m_sStartError; //------------------------------------------------
+	}
+	m_bStarted = true;
+	const int32_t nTotDevices = static_cast<int32_t>(m_aDevices.size());
+	for (int32_t nBackendDeviceId = 0; nBackendDeviceId < nTotDevices; ++nBackendDeviceId) {
+		std::string sName = m_aDevices[nBackendDeviceId].m_sName;
+		addInitialDevice(std::move(sName), nBackendDeviceId, (nBackendDeviceId == m_nDefaultDeviceId));
+		publishDeviceClock(nBackendDeviceId, m_nNowMillisec * 1000000, true);
+	}
+	return "";
+}
+int32_t FakeOpenAlBackend::simulateDeviceAdded(const std::string& sName, bool bIsDefault) noexcept
+{
+	// reuse the slot of a removed device like the OpenAL backend does
+	const auto itFind = std::find_if(m_aDevices.begin(), m_aDevices.end(), [&](const FakeDevice& oDevice)
+	{
+		return oDevice.m_bRemoved;
+	});
+	int32_t nBackendDeviceId;
+	if (itFind == m_aDevices.end()) {
+		nBackendDeviceId = static_cast<int32_t>(m_aDevices.size());
+		m_aDevices.emplace_back();
+	} else {
+		nBackendDeviceId = static_cast<int32_t>(std::distance(m_aDevices.begin(), itFind));
+		*itFind = FakeDevice{};
+	}
+	m_aDevices[nBackendDeviceId].m_sName = sName;
+	if (bIsDefault) {
+		m_nDefaultDeviceId = nBackendDeviceId;
+	}
+	if (m_bStarted) {
+		publishDeviceClock(nBackendDeviceId, m_nNowMillisec * 1000000, true);
+		sendDeviceAddedEvent(nBackendDeviceId);
+	}
+	return nBackendDeviceId;
+}
+void FakeOpenAlBackend::sendDeviceAddedEvent(int32_t nBackendDeviceId) noexcept
+{
+	AlEvent oAlEvent;
+	oAlEvent.m_eType = AL_EVENT_DEVICE_ADDED;
+	oAlEvent.m_nBackendDeviceId = nBackendDeviceId;
+	oAlEvent.m_sDeviceName = m_aDevices[nBackendDeviceId].m_sName;
+	oAlEvent.m_bDeviceIsDefault = (nBackendDeviceId == m_nDefaultDeviceId);
+	sendEvent(std::move(oAlEvent));
+}
+void FakeOpenAlBackend::simulateDeviceRemoved(int32_t nBackendDeviceId) noexcept
+{
+	assert((nBackendDeviceId >= 0) && (nBackendDeviceId < static_cast<int32_t>(m_aDevices.size())));
+	FakeDevice& oDevice = m_aDevices[nBackendDeviceId];
+	assert(! oDevice.m_bRemoved);
+	oDevice.m_bRemoved = true;
+	for (const FakeSound& oSound : oDevice.m_aSounds) {
+		releaseTriggerSlot(oSound.m_nTriggerSlot);
+		fakePublishSoundState(nBackendDeviceId, oSound, true);
+	}
+	oDevice.m_aSounds.clear();
+	oDevice.m_aLoadedFileIds.clear();
+	cancelDeferredPreloads(nBackendDeviceId, -1);
+	if (nBackendDeviceId == m_nDefaultDeviceId) {
+		m_nDefaultDeviceId = -1;
+	}
+	if (! m_bStarted) {
+		return; //--------------------------------------------------------------
+	}
+	AlEvent oAlEvent;
+	oAlEvent.m_eType = AL_EVENT_DEVICE_REMOVED;
+	oAlEvent.m_nBackendDeviceId = nBackendDeviceId;
+	sendEvent(std::move(oAlEvent));
+}
+void FakeOpenAlBackend::setFileDuration(const std::string& sFileName, int32_t nDurationMillisec) noexcept
+{
+	assert(nDurationMillisec > 0);
+	m_aFileDurations.emplace_back(sFileName, nDurationMillisec);
+}
+void FakeOpenAlBackend::setBufferDuration(const uint8_t* p0Buffer, int32_t nDurationMillisec) noexcept
+{
+	assert(p0Buffer != nullptr);
+	assert(nDurationMillisec > 0);
+	m_aBufferDurations.emplace_back(p0Buffer, nDurationMillisec);
+}
+const FakeOpenAlBackend::FakeDevice& FakeOpenAlBackend::getDevice(int32_t nBackendDeviceId) const noexcept
+{
+	assert((nBackendDeviceId >= 0) && (nBackendDeviceId < static_cast<int32_t>(m_aDevices.size())));
+	return m_aDevices[nBackendDeviceId];
+}
+const FakeOpenAlBackend::FakeSound* FakeOpenAlBackend::getSound(int32_t nBackendDeviceId, int32_t nSoundId) const noexcept
+{
+	const FakeDevice& oDevice = getDevice(nBackendDeviceId);
+	const auto itFind = std::find_if(oDevice.m_aSounds.begin(), oDevice.m_aSounds.end(), [&](const FakeSound& oSound)
+	{
+		return (oSound.m_nSoundId == nSoundId);
+	});
+	if (itFind == oDevice.m_aSounds.end()) {
+		return nullptr;
+	}
+	return &(*itFind);
+}
+FakeOpenAlBackend::FakeSound* FakeOpenAlBackend::getSound(FakeDevice& oDevice, int32_t nSoundId) noexcept
+{
+	const auto itFind = std::find_if(oDevice.m_aSounds.begin(), oDevice.m_aSounds.end(), [&](const FakeSound& oSound)
+	{
+		return (oSound.m_nSoundId == nSoundId);
+	});
+	if (itFind == oDevice.m_aSounds.end()) {
+		return nullptr;
+	}
+	return &(*itFind);
+}
+void FakeOpenAlBackend::removeSound(int32_t nBackendDeviceId, int32_t nSoundId) noexcept
+{
+	auto& aSounds = m_aDevices[nBackendDeviceId].m_aSounds;
+	const auto itFind = std::find_if(aSounds.begin(), aSounds.end(), [&](const FakeSound& oSound)
+	{
+		return (oSound.m_nSoundId == nSoundId);
+	});
+	if (itFind == aSounds.end()) {
+		return; //--------------------------------------------------------------
+	}
+	releaseTriggerSlot(itFind->m_nTriggerSlot);
+	fakePublishSoundState(nBackendDeviceId, *itFind, true);
+	aSounds.erase(itFind);
+}
+bool FakeOpenAlBackend::isProgressing(const FakeDevice& oDevice, const FakeSound& oSound) const noexcept
+{
+	// A sound started while the device is paused plays anyway (see OpenAlBackend::openalPlay)
+	// A prepared sound waits to be triggered
+	return (oSound.m_nTriggerSlot < 0) && (! oSound.m_bPaused) && ((! oDevice.m_bPaused) || oSound.m_bStartedWhenDevicePaused)
+			&& ! isSoundGroupPaused(oDevice.m_aSoundGroups, oSound.m_nGroupId);
+}
+int32_t FakeOpenAlBackend::getDurationMillisec(const AlCommand& oCommand) const noexcept
+{
+	if (oCommand.m_p0Buffer == nullptr) {
+		const auto itFind = std::find_if(m_aFileDurations.begin(), m_aFileDurations.end()
+										, [&](const std::pair<std::string, int32_t>& oPair)
+		{
+			return (oPair.first == oCommand.m_sFileName);
+		});
+		if (itFind == m_aFileDurations.end()) {
+			return -1; //-------------------------------------------------------
+		}
+		return itFind->second;
+	} else {
+		const auto itFind = std::find_if(m_aBufferDurations.begin(), m_aBufferDurations.end()
+										, [&](const std::pair<const uint8_t*, int32_t>& oPair)
+		{
+			return (oPair.first == oCommand.m_p0Buffer);
+		});
+		if (itFind == m_aBufferDurations.end()) {
+			return -1; //-------------------------------------------------------
+		}
+		return itFind->second;
+	}
+}
+void FakeOpenAlBackend::sendError(const AlCommand& oCommand) noexcept
+{
+	AlEvent oAlEvent;
+	oAlEvent.m_eType = AL_EVENT_PLAY_ERROR;
+	oAlEvent.m_nBackendDeviceId = oCommand.m_nBackendDeviceId;
+	oAlEvent.m_nSoundId = oCommand.m_nSoundId;
+	oAlEvent.m_nFileId = oCommand.m_nFileId;
+	oAlEvent.m_sError = "File not found";
+	sendEvent(std::move(oAlEvent));
+}
+void FakeOpenAlBackend::execCommands() noexcept
+{
+	assert(m_aReadAlCommands.empty());
+	takeCommands(m_aReadAlCommands);
+	for (AlCommand& oCommand : m_aReadAlCommands) {
+		if (deferPreload(oCommand)) {
+			continue;
+		}
+		execRecordedCommand(oCommand);
+	}
+	m_aReadAlCommands.clear();
+	// Like the offline backends all the deferred preloads are executed
+	takeDeferredPreloads(std::numeric_limits<int32_t>::max(), m_aReadAlCommands);
+	for (const AlCommand& oCommand : m_aReadAlCommands) {
+		execRecordedCommand(oCommand);
+	}
+	m_aReadAlCommands.clear();
+	if (isSomeTriggerPending()) {
+		startTriggeredSounds();
+	}
+	fakePublishStats();
+}
+void FakeOpenAlBackend::startTriggeredSounds() noexcept
+{
+	for (FakeDevice& oDevice : m_aDevices) {
+		for (FakeSound& oSound : oDevice.m_aSounds) {
+			if ((oSound.m_nTriggerSlot >= 0) && takeTrigger(oSound.m_nTriggerSlot)) {
+				oSound.m_nTriggerSlot = -1;
+			}
+		}
+	}
+}
+void FakeOpenAlBackend::execRecordedCommand(const AlCommand& oCommand) noexcept
+{
+	++m_oRawStats.m_aExecutedCommands[oCommand.m_eType];
+	m_nNowMillisec += m_nCommandQueueWaitMillisec;
+	const int64_t nExecStartUsec = getSteadyTimeUsec();
+	execCommand(oCommand);
+	if (isLatencyEnabled()) {
+		recordCommandLatency(oCommand, nExecStartUsec, getSteadyTimeUsec());
+	}
+	m_aExecutedCommands.push_back(oCommand);
+}
+void FakeOpenAlBackend::fakePublishStats() noexcept
+{
+	const int32_t nTotDevices = std::min(static_cast<int32_t>(m_aDevices.size()), SndStatsCapability::s_nMaxStatsDevices);
+	for (int32_t nBackendDeviceId = 0; nBackendDeviceId < SndStatsCapability::s_nMaxStatsDevices; ++nBackendDeviceId) {
+		RawDeviceStats& oRawDeviceStats = m_oRawStats.m_aDevices[nBackendDeviceId];
+		if ((nBackendDeviceId >= nTotDevices) || m_aDevices[nBackendDeviceId].m_bRemoved) {
+			oRawDeviceStats = RawDeviceStats{};
+			continue;
+		}
+		const FakeDevice& oDevice = m_aDevices[nBackendDeviceId];
+		oRawDeviceStats.m_bExists = true;
+		oRawDeviceStats.m_nActiveSources = static_cast<int32_t>(oDevice.m_aSounds.size());
+		oRawDeviceStats.m_nUnusedSources = 0;
+		oRawDeviceStats.m_nBuffers = static_cast<int32_t>(oDevice.m_aLoadedFileIds.size());
+		oRawDeviceStats.m_nBufferBytes = 0;
+		oRawDeviceStats.m_nDownmixSavedBytes = 0;
+		oRawDeviceStats.m_nEvictedBuffers = 0;
+		// the device clock is the simulated time
+		publishDeviceClock(nBackendDeviceId, m_nNowMillisec * 1000000, true);
+		for (const FakeSound& oSound : oDevice.m_aSounds) {
+			fakePublishSoundState(nBackendDeviceId, oSound, false);
+		}
+	}
+	publishStats();
+}
+void FakeOpenAlBackend::fakePublishSoundState(int32_t nBackendDeviceId, const FakeSound& oSound, bool bRemoved) noexcept
+{
+	const FakeDevice& oDevice = m_aDevices[nBackendDeviceId];
+	PlaybackCapability::SOUND_STATE eState;
+	if (bRemoved) {
+		eState = PlaybackCapability::SOUND_STATE_STOPPED;
+	} else if (oSound.m_bPaused || (oDevice.m_bPaused && ! oSound.m_bStartedWhenDevicePaused)
+				|| isSoundGroupPaused(oDevice.m_aSoundGroups, oSound.m_nGroupId)) {
+		eState = PlaybackCapability::SOUND_STATE_PAUSED;
+	} else if ((oSound.m_nTriggerSlot >= 0) || (oSound.m_nStartMillisec >= 0)) {
+		eState = PlaybackCapability::SOUND_STATE_PENDING;
+	} else {
+		eState = PlaybackCapability::SOUND_STATE_PLAYING;
+	}
+	const int32_t nOffsetMillisec = std::min(oSound.m_nPlayedMillisec, oSound.m_nDurationMillisec);
+	// the offset advances with the simulated time
+	publishSoundState(nBackendDeviceId, oSound.m_nSoundId, eState, nOffsetMillisec / 1000.0
+					, oSound.m_nDurationMillisec / 1000.0, oSound.m_bLoop, true);
+}
+void FakeOpenAlBackend::execCommand(const AlCommand& oCommand) noexcept
+{
+	TraceSpan oSpan(*this, m_oMainTraceRing, getCommandTraceName(oCommand.m_eType));
+	assert((oCommand.m_nBackendDeviceId >= 0) && (oCommand.m_nBackendDeviceId < static_cast<int32_t>(m_aDevices.size())));
+	FakeDevice& oDevice = m_aDevices[oCommand.m_nBackendDeviceId];
+	if (oDevice.m_bRemoved) {
+		// command sent before the removal was delivered to the device manager
+		return; //--------------------------------------------------------------
+	}
+	switch (oCommand.m_eType) {
+	case AL_COMMAND_PRELOAD:
+	{
+		if (getDurationMillisec(oCommand) < 0) {
+			sendError(oCommand);
+			sendPreloadedEvent(oCommand, false);
+			return; //----------------------------------------------------------
+		}
+		if (std::find(oDevice.m_aLoadedFileIds.begin(), oDevice.m_aLoadedFileIds.end(), oCommand.m_nFileId)
+				== oDevice.m_aLoadedFileIds.end()) {
+			if (isLatencyEnabled()) {
+				const int64_t nNowUsec = getSteadyTimeUsec();
+				recordDecodeLatency(nNowUsec, nNowUsec);
+			}
+			oDevice.m_aLoadedFileIds.push_back(oCommand.m_nFileId);
+		}
+		sendPreloadedEvent(oCommand, true);
+	} break;
+	case AL_COMMAND_PLAY:
+	{
+		assert(getSound(oDevice, oCommand.m_nSoundId) == nullptr);
+		const int32_t nDurationMillisec = getDurationMillisec(oCommand);
+		if (nDurationMillisec < 0) {
+			releaseTriggerSlot(oCommand.m_nTriggerSlot);
+			sendError(oCommand);
+			return; //----------------------------------------------------------
+		}
+		if (std::find(oDevice.m_aLoadedFileIds.begin(), oDevice.m_aLoadedFileIds.end(), oCommand.m_nFileId)
+				== oDevice.m_aLoadedFileIds.end()) {
+			if (isLatencyEnabled()) {
+				const int64_t nNowUsec = getSteadyTimeUsec();
+				recordDecodeLatency(nNowUsec, nNowUsec);
+			}
+			oDevice.m_aLoadedFileIds.push_back(oCommand.m_nFileId);
+		}
+		FakeSound oSound;
+		oSound.m_nSoundId = oCommand.m_nSoundId;
+		oSound.m_nFileId = oCommand.m_nFileId;
+		oSound.m_nDurationMillisec = nDurationMillisec;
+		oSound.m_bLoop = oCommand.m_bLoop;
+		oSound.m_bStartedWhenDevicePaused = oDevice.m_bPaused;
+		oSound.m_bRelative = oCommand.m_bRelative;
+		oSound.m_fPosX = oCommand.m_fPosX;
+		oSound.m_fPosY = oCommand.m_fPosY;
+		oSound.m_fPosZ = oCommand.m_fPosZ;
+		oSound.m_fVolume = oCommand.m_fVolume;
+		oSound.m_nGroupId = oCommand.m_nGroupId;
+		oSound.m_nTriggerSlot = oCommand.m_nTriggerSlot;
+		if (oCommand.m_nStartClockNanosec >= 0) {
+			// millisec granularity, a past start plays immediately
+			oSound.m_nStartMillisec = std::max(m_nNowMillisec, (oCommand.m_nStartClockNanosec + 999999) / 1000000);
+		}
+		oDevice.m_aSounds.push_back(std::move(oSound));
+	} break;
+	case AL_COMMAND_PAUSE:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			p0Sound->m_bPaused = true;
+		}
+	} break;
+	case AL_COMMAND_RESUME:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			p0Sound->m_bPaused = false;
+		}
+	} break;
+	case AL_COMMAND_STOP:
+	{
+		removeSound(oCommand.m_nBackendDeviceId, oCommand.m_nSoundId);
+	} break;
+	case AL_COMMAND_PAUSE_DEVICE:
+	{
+		oDevice.m_bPaused = true;
+	} break;
+	case AL_COMMAND_RESUME_DEVICE:
+	{
+		if (oDevice.m_bPaused) {
+			for (FakeSound& oSound : oDevice.m_aSounds) {
+				oSound.m_bStartedWhenDevicePaused = false;
+			}
+		}
+		oDevice.m_bPaused = false;
+	} break;
+	case AL_COMMAND_STOP_ALL:
+	{
+		for (const FakeSound& oSound : oDevice.m_aSounds) {
+			releaseTriggerSlot(oSound.m_nTriggerSlot);
+			fakePublishSoundState(oCommand.m_nBackendDeviceId, oSound, true);
+		}
+		oDevice.m_aSounds.clear();
+	} break;
+	case AL_COMMAND_SOUND_POS:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			p0Sound->m_bRelative = oCommand.m_bRelative;
+			p0Sound->m_fPosX = oCommand.m_fPosX;
+			p0Sound->m_fPosY = oCommand.m_fPosY;
+			p0Sound->m_fPosZ = oCommand.m_fPosZ;
+			p0Sound->m_oMotion = SoundMotion{};
+		}
+	} break;
+	case AL_COMMAND_SOUND_MOTION:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			p0Sound->m_bRelative = oCommand.m_bRelative;
+			p0Sound->m_fPosX = oCommand.m_fPosX;
+			p0Sound->m_fPosY = oCommand.m_fPosY;
+			p0Sound->m_fPosZ = oCommand.m_fPosZ;
+			startSoundMotion(p0Sound->m_oMotion, oCommand, getSteadyTimeUsec());
+		}
+	} break;
+	case AL_COMMAND_SOUND_VOL:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			p0Sound->m_fVolume = oCommand.m_fVolume;
+			p0Sound->m_oRamp = SoundRamp{};
+		}
+	} break;
+	case AL_COMMAND_SOUND_RAMP:
+	{
+		FakeSound* p0Sound = getSound(oDevice, oCommand.m_nSoundId);
+		if (p0Sound != nullptr) {
+			startSoundRamp(p0Sound->m_oRamp, p0Sound->m_fVolume, oCommand, getSteadyTimeUsec());
+		}
+	} break;
+	case AL_COMMAND_LISTENER_POS:
+	{
+		oDevice.m_fListenerPosX = oCommand.m_fPosX;
+		oDevice.m_fListenerPosY = oCommand.m_fPosY;
+		oDevice.m_fListenerPosZ = oCommand.m_fPosZ;
+	} break;
+	case AL_COMMAND_LISTENER_VOL:
+	{
+		oDevice.m_fListenerVolume = oCommand.m_fVolume;
+	} break;
+	case AL_COMMAND_CANCEL_PRELOADS:
+	{
+		cancelDeferredPreloads(oCommand.m_nBackendDeviceId, oCommand.m_nBatchId);
+	} break;
+	case AL_COMMAND_GROUP_VOL:
+	{
+		getSoundGroup(oDevice.m_aSoundGroups, oCommand.m_nGroupId).m_fVolume = oCommand.m_fVolume;
+	} break;
+	case AL_COMMAND_PAUSE_GROUP:
+	{
+		getSoundGroup(oDevice.m_aSoundGroups, oCommand.m_nGroupId).m_bPaused = true;
+	} break;
+	case AL_COMMAND_RESUME_GROUP:
+	{
+		getSoundGroup(oDevice.m_aSoundGroups, oCommand.m_nGroupId).m_bPaused = false;
+	} break;
+	case AL_COMMAND_STOP_GROUP:
+	{
+		auto& aSounds = oDevice.m_aSounds;
+		aSounds.erase(std::remove_if(aSounds.begin(), aSounds.end(), [&](const FakeSound& oSound)
+		{
+			if (oSound.m_nGroupId != oCommand.m_nGroupId) {
+				return false; //------------------------------------------------
+			}
+			releaseTriggerSlot(oSound.m_nTriggerSlot);
+			fakePublishSoundState(oCommand.m_nBackendDeviceId, oSound, true);
+			return true;
+		}), aSounds.end());
+	} break;
+	default:
+	{
+		assert(false);
+	} break;
+	}
+}
+bool FakeOpenAlBackend::isSomeSoundProgressing() const noexcept
+{
+	for (const FakeDevice& oDevice : m_aDevices) {
+		for (const FakeSound& oSound : oDevice.m_aSounds) {
+			if (isProgressing(oDevice, oSound)) {
+				return true; //-------------------------------------------------
+			}
+		}
+	}
+	return false;
+}
+int32_t FakeOpenAlBackend::renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept
+{
+	assert(nMillisec >= 0);
+	if (isDispatchingEvents()) {
+		return 0; //------------------------------------------------------------
+	}
+	static constexpr int32_t s_nRenderChunkMillisec = 10;
+	int32_t nRenderedMillisec = 0;
+	while (nRenderedMillisec < nMillisec) {
+		// the listeners of the finished events might have played new sounds
+		execCommands();
+		if (bStopWhenIdle && ! isSomeSoundProgressing()) {
+			break;
+		}
+		const int32_t nChunkMillisec = std::min(s_nRenderChunkMillisec, nMillisec - nRenderedMillisec);
+		advanceMillisec(nChunkMillisec);
+		nRenderedMillisec += nChunkMillisec;
+	}
+	return nRenderedMillisec;
+}
+void FakeOpenAlBackend::advanceMillisec(int32_t nMillisec) noexcept
+{
+	assert(nMillisec >= 0);
+	execCommands();
+	// (remaining millisec, backend device id, sound id) of the sounds finishing
+	std::vector<std::tuple<int32_t, int32_t, int32_t>> aFinishing;
+	const int32_t nTotDevices = static_cast<int32_t>(m_aDevices.size());
+	for (int32_t nBackendDeviceId = 0; nBackendDeviceId < nTotDevices; ++nBackendDeviceId) {
+		FakeDevice& oDevice = m_aDevices[nBackendDeviceId];
+		for (FakeSound& oSound : oDevice.m_aSounds) {
+			if (! isProgressing(oDevice, oSound)) {
+				continue; // for oSound ----
+			}
+			// the millisec of the chunk before the sound starts
+			int32_t nStartOffset = 0;
+			if (oSound.m_nStartMillisec >= 0) {
+				if (oSound.m_nStartMillisec - m_nNowMillisec >= nMillisec) {
+					continue; // for oSound ----
+				}
+				nStartOffset = static_cast<int32_t>(std::max<int64_t>(0, oSound.m_nStartMillisec - m_nNowMillisec));
+				oSound.m_nStartMillisec = -1;
+			}
+			const int32_t nPlayMillisec = nMillisec - nStartOffset;
+			oSound.m_nPlayedMillisec += nPlayMillisec;
+			if (oSound.m_bLoop) {
+				oSound.m_nPlayedMillisec %= oSound.m_nDurationMillisec;
+			} else if (oSound.m_nPlayedMillisec >= oSound.m_nDurationMillisec) {
+				const int32_t nRemaining = nStartOffset + oSound.m_nDurationMillisec - (oSound.m_nPlayedMillisec - nPlayMillisec);
+				aFinishing.emplace_back(nRemaining, nBackendDeviceId, oSound.m_nSoundId);
+			}
+		}
+	}
+	// the finished events are sent in the order the sounds finished
+	std::stable_sort(aFinishing.begin(), aFinishing.end(), [](const std::tuple<int32_t, int32_t, int32_t>& oT1
+															, const std::tuple<int32_t, int32_t, int32_t>& oT2)
+	{
+		return (std::get<0>(oT1) < std::get<0>(oT2));
+	});
+	for (const auto& oFinishing : aFinishing) {
+		const int32_t nBackendDeviceId = std::get<1>(oFinishing);
+		const int32_t nSoundId = std::get<2>(oFinishing);
+		removeSound(nBackendDeviceId, nSoundId);
+		AlEvent oAlEvent;
+		oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
+		oAlEvent.m_nBackendDeviceId = nBackendDeviceId;
+		oAlEvent.m_nSoundId = nSoundId;
+		sendEvent(std::move(oAlEvent));
+	}
+	m_nNowMillisec += nMillisec;
+	for (int32_t nBackendDeviceId = 0; nBackendDeviceId < nTotDevices; ++nBackendDeviceId) {
+		auto& aSounds = m_aDevices[nBackendDeviceId].m_aSounds;
+		std::vector<int32_t> aFadedOut;
+		for (FakeSound& oSound : aSounds) {
+			advanceSoundMotion(oSound.m_oMotion, getSteadyTimeUsec(), oSound.m_fPosX, oSound.m_fPosY, oSound.m_fPosZ);
+			bool bStop;
+			advanceSoundRamp(oSound.m_oRamp, getSteadyTimeUsec(), oSound.m_fVolume, bStop);
+			if (bStop) {
+				aFadedOut.push_back(oSound.m_nSoundId);
+			}
+		}
+		for (const int32_t nSoundId : aFadedOut) {
+			removeSound(nBackendDeviceId, nSoundId);
+			AlEvent oAlEvent;
+			oAlEvent.m_eType = AL_EVENT_PLAY_FINISHED;
+			oAlEvent.m_nBackendDeviceId = nBackendDeviceId;
+			oAlEvent.m_nSoundId = nSoundId;
+			oAlEvent.m_bFadedOut = true;
+			sendEvent(std::move(oAlEvent));
+		}
+	}
+	// like the real backends the commands sent and the sounds triggered
+	// by the real-time listener are executed in the same iteration
+	if (hasCommands() || isSomeTriggerPending()) {
+		execCommands();
+	}
+	fakePublishStats();
+	deliverEvents();
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,202 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   fakeopenalbackend.h
+ */
+
+#ifndef STMI_TESTING_FAKE_OPENAL_BACKEND_H
+#define STMI_TESTING_FAKE_OPENAL_BACKEND_H
+
+#include "backend.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::Backend;
+
+/** Fake backend that doesn't need audio hardware.
+ * There is no backend thread: the test drives it from the main thread by
+ * calling advanceMillisec(), which executes the queued commands, advances
+ * the fake clock (finishing the sounds whose duration has elapsed) and
+ * delivers the resulting events to the device manager as the event loop adapter would.
+ *
+ * Only the files and buffers whose duration was set with setFileDuration()
+ * and setBufferDuration() can be played, all others generate an error.
+ */
+class FakeOpenAlBackend : public Backend
+{
+public:
+	explicit FakeOpenAlBackend(::stmi::OpenAlDeviceManager* p0Owner) noexcept;
+
+	std::string start() noexcept override;
+	/** Renders in chunks of 10 milliseconds with advanceMillisec().
+	 * The fake devices behave like the loopback device of an offline device manager.
+	 */
+	int32_t renderOffline(int32_t nMillisec, bool bStopWhenIdle) noexcept override;
+
+	/** Set the error returned by start().
+	 * @param sError The error. If empty start() succeeds.
+	 */
+	void setStartError(const std::string& sError) noexcept { m_sStartError = sError; }
+	/** Simulates a device.
+	 * Before start() adds a device available at start, after start() a
+	 * device being plugged in (the event is delivered by the next advanceMillisec()).
+	 * @param sName The device name.
+	 * @param bIsDefault Whether the device is the default.
+	 * @return The backend device id.
+	 */
+	int32_t simulateDeviceAdded(const std::string& sName, bool bIsDefault) noexcept;
+	/** Simulates a device being unplugged.
+	 * All its sounds are dropped without finished event, like the OpenAL backend does.
+	 * @param nBackendDeviceId The backend device id. Must exist.
+	 */
+	void simulateDeviceRemoved(int32_t nBackendDeviceId) noexcept;
+
+	/** Makes a file playable.
+	 * @param sFileName The file name.
+	 * @param nDurationMillisec The duration of the sound. Must be positive.
+	 */
+	void setFileDuration(const std::string& sFileName, int32_t nDurationMillisec) noexcept;
+	/** Makes a buffer playable.
+	 * @param p0Buffer The buffer.
+	 * @param nDurationMillisec The duration of the sound. Must be positive.
+	 */
+	void setBufferDuration(const uint8_t* p0Buffer, int32_t nDurationMillisec) noexcept;
+
+	/** Execute queued commands, advance the clock and deliver events.
+	 * The commands sent by the real-time listener are executed before delivering.
+	 * @param nMillisec The time to advance. Cannot be negative.
+	 */
+	void advanceMillisec(int32_t nMillisec) noexcept;
+	/** Execute the queued commands without advancing the clock or delivering events.
+	 * The batch preloads are executed after the other commands, by priority.
+	 */
+	void execCommands() noexcept;
+	/** Deliver the queued events to the device manager.
+	 */
+	void deliverEvents() noexcept { dispatchEvents(); }
+	/** The fake clock.
+	 * @return The milliseconds since the backend was created.
+	 */
+	int64_t getNowMillisec() const noexcept { return m_nNowMillisec; }
+	/** Allows to simulate the time a command waits in the queue.
+	 * The fake clock advances by the given time before each command is executed.
+	 * @param nMillisec The time. Cannot be negative.
+	 */
+	void setCommandQueueWaitMillisec(int32_t nMillisec) noexcept { m_nCommandQueueWaitMillisec = nMillisec; }
+
+	struct FakeSound
+	{
+		int32_t m_nSoundId = -1;
+		int32_t m_nFileId = -1;
+		int32_t m_nDurationMillisec = 0;
+		int32_t m_nPlayedMillisec = 0;
+		int64_t m_nStartMillisec = -1; // The simulated time a scheduled sound starts at or -1 if started
+		int32_t m_nTriggerSlot = -1; // The trigger slot of a prepared sound or -1 if started
+		bool m_bLoop = false;
+		bool m_bPaused = false;
+		bool m_bStartedWhenDevicePaused = false;
+		bool m_bRelative = false;
+		double m_fPosX = 0.0;
+		double m_fPosY = 0.0;
+		double m_fPosZ = 0.0;
+		double m_fVolume = 1.0;
+		int32_t m_nGroupId = -1;
+		SoundMotion m_oMotion;
+		SoundRamp m_oRamp;
+	};
+	struct FakeDevice
+	{
+		std::string m_sName;
+		bool m_bRemoved = false;
+		bool m_bPaused = false;
+		std::vector<int32_t> m_aLoadedFileIds;
+		std::vector<FakeSound> m_aSounds;
+		double m_fListenerPosX = 0.0;
+		double m_fListenerPosY = 0.0;
+		double m_fListenerPosZ = 0.0;
+		double m_fListenerVolume = 1.0;
+		std::vector<SoundGroup> m_aSoundGroups; // Index: group id
+	};
+	/** The simulated device.
+	 * @param nBackendDeviceId The backend device id. Must exist.
+	 * @return The device.
+	 */
+	const FakeDevice& getDevice(int32_t nBackendDeviceId) const noexcept;
+	/** The active sound of a device.
+	 * @param nBackendDeviceId The backend device id. Must exist.
+	 * @param nSoundId The sound id.
+	 * @return The sound or null if not active.
+	 */
+	const FakeSound* getSound(int32_t nBackendDeviceId, int32_t nSoundId) const noexcept;
+	/** All the commands executed so far.
+	 * @return The commands in execution order.
+	 */
+	const std::vector<AlCommand>& getExecutedCommands() const noexcept { return m_aExecutedCommands; }
+
+protected:
+	// The fake clock
+	int64_t getSteadyTimeUsec() const noexcept override { return m_nNowMillisec * 1000; }
+private:
+	// Executes a command and updates stats
+	void execRecordedCommand(const AlCommand& oCommand) noexcept;
+	void execCommand(const AlCommand& oCommand) noexcept;
+	// Returns -1 if file or buffer not playable
+	int32_t getDurationMillisec(const AlCommand& oCommand) const noexcept;
+	FakeSound* getSound(FakeDevice& oDevice, int32_t nSoundId) noexcept;
+	// Removes a sound releasing its trigger slot if prepared
+	void removeSound(int32_t nBackendDeviceId, int32_t nSoundId) noexcept;
+	void startTriggeredSounds() noexcept;
+	bool isProgressing(const FakeDevice& oDevice, const FakeSound& oSound) const noexcept;
+	bool isSomeSoundProgressing() const noexcept;
+	void sendError(const AlCommand& oCommand) noexcept;
+	void sendDeviceAddedEvent(int32_t nBackendDeviceId) noexcept;
+	void fakePublishStats() noexcept;
+	void fakePublishSoundState(int32_t nBackendDeviceId, const FakeSound& oSound, bool bRemoved) noexcept;
+
+private:
+	bool m_bStarted;
+	std::string m_sStartError;
+	int64_t m_nNowMillisec;
+	int32_t m_nCommandQueueWaitMillisec;
+	int32_t m_nDefaultDeviceId;
+	std::vector<FakeDevice> m_aDevices; // Index: nBackendDeviceId
+	std::vector<std::pair<std::string, int32_t>> m_aFileDurations;
+	std::vector<std::pair<const uint8_t*, int32_t>> m_aBufferDurations;
+	std::vector<AlCommand> m_aExecutedCommands;
+	// Used to avoid reallocating
+	std::vector<AlCommand> m_aReadAlCommands;
+private:
+	FakeOpenAlBackend() = delete;
+	FakeOpenAlBackend(const FakeOpenAlBackend& oSource) = delete;
+	FakeOpenAlBackend& operator=(const FakeOpenAlBackend& oSource) = delete;
+};
+
+} // namespace testing
+
+} // namespace stmi
+
+#endif /* STMI_TESTING_FAKE_OPENAL_BACKEND_H */
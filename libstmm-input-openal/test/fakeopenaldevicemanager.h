@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   fakeopenaldevicemanager.h
+ */
+
+#ifndef STMI_TESTING_FAKE_OPENAL_DEVICE_MANAGER_H
+#define STMI_TESTING_FAKE_OPENAL_DEVICE_MANAGER_H
+
+#include "openaldevicemanager.h"
+#include "fakeopenalbackend.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cassert>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+class FakeOpenAlDeviceManager : public OpenAlDeviceManager
+{
+public:
+	/** Creates an instance with a FakeOpenAlBackend.
+	 * @param aDeviceNames The names of the devices available at start.
+	 * @param nDefaultIdx The index into aDeviceNames of the default device or -1 if none.
+	 * @param bEnableEventClasses See OpenAlDeviceManager::create().
+	 * @param aEnDisableEventClasses See OpenAlDeviceManager::create().
+	 * @return The instance. Is not null.
+	 */
+	static shared_ptr<FakeOpenAlDeviceManager> create(const std::vector<std::string>& aDeviceNames, int32_t nDefaultIdx
+													, bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+	{
+		shared_ptr<FakeOpenAlDeviceManager> refInstance(new FakeOpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses));
+		auto refBackend = std::make_unique<FakeOpenAlBackend>(refInstance.get());
+		FakeOpenAlBackend* p0Backend = refBackend.get();
+		const int32_t nTotDevices = static_cast<int32_t>(aDeviceNames.size());
+		for (int32_t nIdx = 0; nIdx < nTotDevices; ++nIdx) {
+			p0Backend->simulateDeviceAdded(aDeviceNames[nIdx], (nIdx == nDefaultIdx));
+		}
+		refInstance->m_p0Backend = p0Backend;
+		#ifndef NDEBUG
+		const std::string sError =
+		#endif //NDEBUG
+		refInstance->init(std::move(refBackend));
+		assert(sError.empty());
+		return refInstance;
+	}
+	/** The backend.
+	 * @return The backend owned by this instance.
+	 */
+	FakeOpenAlBackend& getBackend() noexcept { return *m_p0Backend; }
+protected:
+	FakeOpenAlDeviceManager(bool bEnableEventClasses, const std::vector<Event::Class>& aEnDisableEventClasses) noexcept
+	: OpenAlDeviceManager(bEnableEventClasses, aEnDisableEventClasses)
+	, m_p0Backend(nullptr)
+	{
+	}
+private:
+	FakeOpenAlBackend* m_p0Backend;
+};
+
+} // namespace testing
+
+} // namespace stmi
+
+#endif /* STMI_TESTING_FAKE_OPENAL_DEVICE_MANAGER_H */
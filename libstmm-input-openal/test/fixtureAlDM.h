@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   fixtureAlDM.h
+ */
+
+#ifndef STMI_TESTING_FIXTURE_AL_DM_H
+#define STMI_TESTING_FIXTURE_AL_DM_H
+
+#include "fixtureTestBase.h"
+
+#include "fakeopenaldevicemanager.h"
+
+#include <stmm-input/devicemanager.h>
+#include <stmm-input/event.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+/** Fixture with a FakeOpenAlDeviceManager and a listener recording all events.
+ * By default two devices are available at start: "Fake0" (the default) and "Fake1".
+ */
+class AlDMFixture : public TestBaseFixture
+{
+protected:
+	void setup() override
+	{
+		TestBaseFixture::setup();
+		m_refAlDM = FakeOpenAlDeviceManager::create(getDeviceNames(), getDefaultDeviceIdx(), false, {});
+		m_p0Backend = &(m_refAlDM->getBackend());
+		m_refListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+		{
+			m_aReceivedEvents.push_back(refEvent);
+		});
+		m_refAlDM->addEventListener(m_refListener);
+	}
+	void teardown() override
+	{
+		m_aReceivedEvents.clear();
+		m_refListener.reset();
+		m_p0Backend = nullptr;
+		m_refAlDM.reset();
+		TestBaseFixture::teardown();
+	}
+	virtual std::vector<std::string> getDeviceNames() const
+	{
+		return {"Fake0", "Fake1"};
+	}
+	virtual int32_t getDefaultDeviceIdx() const
+	{
+		return 0;
+	}
+	/** The received events of a given type.
+	 * @return The events in the order they were received.
+	 */
+	template<class T>
+	std::vector<shared_ptr<T>> getReceivedEvents() const
+	{
+		std::vector<shared_ptr<T>> aEvents;
+		for (const auto& refEvent : m_aReceivedEvents) {
+			auto refT = std::dynamic_pointer_cast<T>(refEvent);
+			if (refT) {
+				aEvents.push_back(std::move(refT));
+			}
+		}
+		return aEvents;
+	}
+protected:
+	shared_ptr<FakeOpenAlDeviceManager> m_refAlDM;
+	FakeOpenAlBackend* m_p0Backend = nullptr;
+	shared_ptr<EventListener> m_refListener;
+	std::vector<shared_ptr<Event>> m_aReceivedEvents;
+};
+
+} // namespace testing
+
+} // namespace stmi
+
+#endif /* STMI_TESTING_FIXTURE_AL_DM_H */
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   fixtureTestBase.h
+ */
+
+#ifndef STMI_TESTING_FIXTURE_TEST_BASE_H
+#define STMI_TESTING_FIXTURE_TEST_BASE_H
+
+namespace stmi
+{
+
+namespace testing
+{
+
+/** Base class of fixtures.
+ * Subclasses can't call virtual functions from the constructor
+ * so initialization is done in setup() and cleanup in teardown().
+ * Use STFX<Fixture> as the Catch2 test fixture.
+ */
+class TestBaseFixture
+{
+public:
+	TestBaseFixture() = default;
+	virtual ~TestBaseFixture() = default;
+protected:
+	virtual void setup() {}
+	virtual void teardown() {}
+
+	template<class T> friend class STFX;
+};
+
+template<class T>
+class STFX : public T
+{
+public:
+	STFX()
+	{
+		T::setup();
+	}
+	~STFX()
+	{
+		T::teardown();
+	}
+};
+
+} // namespace testing
+
+} // namespace stmi
+
+#endif /* STMI_TESTING_FIXTURE_TEST_BASE_H */
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testBufferBudget.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "bufferbudget.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::BufferBudget;
+
+TEST_CASE("BufferBudgetUnlimited")
+{
+	BufferBudget oBudget;
+	for (uint32_t nBufferId = 1; nBufferId <= 100; ++nBufferId) {
+		oBudget.add(nBufferId, 1000);
+	}
+	REQUIRE(oBudget.getTotBuffers() == 100);
+	REQUIRE(oBudget.getTotBytes() == 100000);
+	REQUIRE_FALSE(oBudget.isOverLimits());
+	REQUIRE(oBudget.getEvictable([](uint32_t) { return false; }) == 0);
+}
+
+TEST_CASE("BufferBudgetLeastRecentlyUsed")
+{
+	BufferBudget oBudget;
+	oBudget.setLimits(3, -1);
+	oBudget.add(1, 100);
+	oBudget.add(2, 100);
+	oBudget.add(3, 100);
+	REQUIRE_FALSE(oBudget.isOverLimits());
+	oBudget.touch(1);
+	oBudget.add(4, 100);
+	REQUIRE(oBudget.isOverLimits());
+	const auto isNotInUse = [](uint32_t) { return false; };
+	REQUIRE(oBudget.getEvictable(isNotInUse) == 2);
+	// buffers being played are skipped
+	REQUIRE(oBudget.getEvictable([](uint32_t nBufferId) { return (nBufferId == 2); }) == 3);
+	// all in use
+	REQUIRE(oBudget.getEvictable([](uint32_t) { return true; }) == 0);
+	oBudget.remove(2);
+	REQUIRE_FALSE(oBudget.isOverLimits());
+	REQUIRE(oBudget.getEvictable(isNotInUse) == 0);
+	// unknown buffers are ignored
+	oBudget.touch(77);
+	oBudget.remove(77);
+	REQUIRE(oBudget.getTotBuffers() == 3);
+	oBudget.clear();
+	REQUIRE(oBudget.getTotBuffers() == 0);
+	REQUIRE(oBudget.getTotBytes() == 0);
+}
+
+TEST_CASE("BufferBudgetBytes")
+{
+	BufferBudget oBudget;
+	oBudget.setLimits(-1, 1000);
+	oBudget.add(1, 600);
+	oBudget.add(2, 300);
+	REQUIRE_FALSE(oBudget.isOverLimits());
+	oBudget.add(3, 200);
+	REQUIRE(oBudget.isOverLimits());
+	std::vector<uint32_t> aEvicted;
+	const auto isNotInUse = [](uint32_t) { return false; };
+	while (true) {
+		const uint32_t nBufferId = oBudget.getEvictable(isNotInUse);
+		if (nBufferId == 0) {
+			break;
+		}
+		aEvicted.push_back(nBufferId);
+		oBudget.remove(nBufferId);
+	}
+	REQUIRE(aEvicted == std::vector<uint32_t>{1});
+	REQUIRE(oBudget.getTotBytes() == 500);
+}
+
+} // namespace testing
+
+} // namespace stmi
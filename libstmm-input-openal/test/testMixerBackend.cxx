@@ -0,0 +1,420 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testMixerBackend.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wavbuffer.h"
+
+#include "openaldevicemanager.h"
+
+#include <stmm-input-au/playbackcapability.h>
+#include <stmm-input-au/sndfinishedevent.h>
+
+#include <stmm-input-openal/sndstatscapability.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include <poll.h>
+
+namespace stmi
+{
+
+using std::shared_ptr;
+
+namespace testing
+{
+
+namespace
+{
+/** Keeps all the output in memory. */
+class CaptureMixerSink : public MixerSink
+{
+public:
+	explicit CaptureMixerSink(std::vector<int16_t>& aCaptured) noexcept
+	: m_aCaptured(aCaptured)
+	{
+	}
+	std::string open(int32_t /*nFrequency*/, int32_t nChannels) noexcept override
+	{
+		return ((nChannels == 2) ? "" : "Stereo expected");
+	}
+	void write(const int16_t* p0Samples, int32_t nTotFrames) noexcept override
+	{
+		m_aCaptured.insert(m_aCaptured.end(), p0Samples, p0Samples + nTotFrames * 2);
+	}
+	bool isBlocking() const noexcept override { return false; }
+private:
+	std::vector<int16_t>& m_aCaptured;
+};
+
+/** Records the attached file descriptor, the test is the event loop. */
+class RecordingEventLoopAdapter : public EventLoopAdapter
+{
+public:
+	RecordingEventLoopAdapter(int32_t& nAttachedFD, std::function<void()>& oDispatch) noexcept
+	: m_nAttachedFD(nAttachedFD)
+	, m_oDispatch(oDispatch)
+	{
+	}
+	void attach(int32_t nFD, std::function<void()>&& oDispatch) noexcept override
+	{
+		m_nAttachedFD = nFD;
+		m_oDispatch = std::move(oDispatch);
+	}
+	void detach() noexcept override
+	{
+		m_nAttachedFD = -1;
+		m_oDispatch = nullptr;
+	}
+private:
+	int32_t& m_nAttachedFD;
+	std::function<void()>& m_oDispatch;
+};
+
+shared_ptr<PlaybackCapability> getMixerPlayback(const shared_ptr<DeviceManager>& refDM) noexcept
+{
+	for (const auto& refDevice : refDM->getDevices()) {
+		if (refDevice->getName() == "Mixer") {
+			shared_ptr<PlaybackCapability> refPlayback;
+			refDevice->getCapability(refPlayback);
+			return refPlayback;
+		}
+	}
+	return shared_ptr<PlaybackCapability>{};
+}
+} // unnamed namespace
+
+TEST_CASE("MixerOffline")
+{
+	std::vector<int16_t> aCaptured;
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 8000;
+	oInit.m_nPeriodFrames = 80; // 10 milliseconds
+	oInit.m_bOffline = true;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new CaptureMixerSink(aCaptured))
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	REQUIRE(refDM);
+	std::vector<shared_ptr<SndFinishedEvent>> aFinished;
+	auto refListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+	{
+		auto refFinished = std::dynamic_pointer_cast<SndFinishedEvent>(refEvent);
+		if (refFinished) {
+			aFinished.push_back(refFinished);
+		}
+	});
+	refDM->addEventListener(refListener);
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	// 30 milliseconds of constant mono half amplitude
+	const auto aWav = makeWav16(8000, 1, std::vector<int16_t>(240, 16384));
+	// two meters to the right of the listener
+	const auto oSound = refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, false, true, 2.0, 0.0, 0.0);
+	REQUIRE(oSound.m_nSoundId >= 0);
+
+	REQUIRE(refDM->renderOffline(1000, true) == 30);
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSound.m_nSoundId);
+	REQUIRE(aCaptured.size() == 240 * 2);
+	// inverse distance gain 1/2, panned fully right
+	REQUIRE(std::abs(aCaptured[0]) <= 1);
+	REQUIRE(std::abs(aCaptured[1] - 8192) <= 1);
+
+	// idle
+	REQUIRE(refDM->renderOffline(1000, true) == 0);
+	REQUIRE(refDM->renderOffline(20, false) == 20);
+	REQUIRE(aCaptured.size() == (240 + 160) * 2);
+	REQUIRE(aCaptured.back() == 0);
+}
+
+TEST_CASE("MixerOfflineMonoDownmix")
+{
+	std::vector<int16_t> aCaptured;
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 8000;
+	oInit.m_nPeriodFrames = 80;
+	oInit.m_bOffline = true;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new CaptureMixerSink(aCaptured))
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	refDM->setMonoDownmixPolicy(OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	auto refSndStats = std::dynamic_pointer_cast<SndStatsCapability>(refDM->getCapability(SndStatsCapability::getClass()));
+	REQUIRE(refSndStats);
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	// 10 milliseconds, left channel only
+	std::vector<int16_t> aSamples;
+	for (int32_t nFrame = 0; nFrame < 80; ++nFrame) {
+		aSamples.push_back(16384);
+		aSamples.push_back(0);
+	}
+	const auto aWav = makeWav16(8000, 2, aSamples);
+	// one meter to the right of the listener
+	refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, false, true, 1.0, 0.0, 0.0);
+	REQUIRE(refDM->renderOffline(1000, true) == 10);
+	REQUIRE(aCaptured.size() == 80 * 2);
+	// the down-mix (1/4 amplitude) is panned fully right
+	REQUIRE(std::abs(aCaptured[0]) <= 1);
+	REQUIRE(std::abs(aCaptured[1] - 8192) <= 1);
+	{
+		const auto oStats = refSndStats->getStats();
+		REQUIRE(oStats.m_aDevices.size() == 1);
+		REQUIRE(oStats.m_aDevices[0].m_nBuffers == 1);
+		REQUIRE(oStats.m_aDevices[0].m_nDownmixSavedBytes == 80 * static_cast<int64_t>(sizeof(float)));
+	}
+	// at the listener's position the stereo version is needed
+	refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(refDM->renderOffline(1000, true) == 10);
+	REQUIRE(aCaptured.size() == 2 * 80 * 2);
+	REQUIRE(std::abs(aCaptured[160] - 16384) <= 1);
+	REQUIRE(aCaptured[161] == 0);
+	const auto oStats = refSndStats->getStats();
+	REQUIRE(oStats.m_aDevices[0].m_nBuffers == 2);
+	REQUIRE(oStats.m_aDevices[0].m_nDownmixSavedBytes == 0);
+}
+
+TEST_CASE("MixerOfflineErrorAndLoop")
+{
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 8000;
+	oInit.m_nPeriodFrames = 80;
+	oInit.m_bOffline = true;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new NullMixerSink())
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	const auto oMissing = refPlayback->playSound("/nonexistent/file.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	// the error finishes the sound
+	int32_t nTotFinished = 0;
+	auto refListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+	{
+		auto refFinished = std::dynamic_pointer_cast<SndFinishedEvent>(refEvent);
+		if (refFinished && (refFinished->getSoundId() == oMissing.m_nSoundId)) {
+			++nTotFinished;
+		}
+	});
+	refDM->addEventListener(refListener);
+
+	const auto aWav = makeWav16(8000, 2, std::vector<int16_t>(2 * 40, 1000));
+	const auto oLoop = refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, true, false, 0.0, 0.0, 0.0);
+	REQUIRE(refDM->renderOffline(500, true) == 500);
+	REQUIRE(nTotFinished == 1);
+	refPlayback->stopSound(oLoop.m_nSoundId);
+	REQUIRE(refDM->renderOffline(500, true) == 0);
+}
+
+TEST_CASE("MixerOfflineScheduledStart")
+{
+	std::vector<int16_t> aCaptured;
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 8000;
+	oInit.m_nPeriodFrames = 80;
+	oInit.m_bOffline = true;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new CaptureMixerSink(aCaptured))
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+	REQUIRE(refPlayback->getDeviceClockNanosec() == 0);
+
+	// 10 milliseconds of constant stereo
+	const auto aWav = makeWav16(8000, 2, std::vector<int16_t>(2 * 80, 8000));
+	const int32_t nFileId = refPlayback->preloadSound(aWav.data(), static_cast<int32_t>(aWav.size()));
+	REQUIRE(nFileId >= 0);
+	std::vector<PlaybackCapability::SyncedSound> aSounds(2);
+	aSounds[0].m_nFileId = nFileId;
+	aSounds[1].m_nFileId = nFileId;
+	// frame 37 at 8000 Hz
+	const auto aSoundIds = refPlayback->playSoundsTogether(aSounds, 4625000);
+	REQUIRE(aSoundIds.size() == 2);
+	REQUIRE(refDM->renderOffline(1000, true) == 20);
+	REQUIRE(aCaptured.size() == 160 * 2);
+	// sample accurate start and end
+	REQUIRE(aCaptured[36 * 2 + 1] == 0);
+	REQUIRE(std::abs(aCaptured[37 * 2] - 16000) <= 1);
+	REQUIRE(std::abs(aCaptured[116 * 2 + 1] - 16000) <= 1);
+	REQUIRE(aCaptured[117 * 2] == 0);
+	// the rendered time
+	REQUIRE(refPlayback->getDeviceClockNanosec() == 20000000);
+	// a past start plays immediately
+	REQUIRE(refPlayback->playSoundAt(nFileId, 0, 1.0, false, true, 0.0, 0.0, 0.0) >= 0);
+	REQUIRE(refDM->renderOffline(1000, true) == 10);
+	REQUIRE(std::abs(aCaptured[160 * 2] - 8000) <= 1);
+}
+
+// Not run by default: testMixerBackend "[.benchmark]"
+TEST_CASE("MixerTriggerLatencyBenchmark", "[.benchmark]")
+{
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 48000;
+	oInit.m_nPeriodFrames = 256;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new NullMixerSink())
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	refDM->setLatencyStatsEnabled(true);
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	// 1 millisecond
+	const auto aWav = makeWav16(48000, 2, std::vector<int16_t>(2 * 48, 1000));
+	const int32_t nFileId = refPlayback->preloadSound(aWav.data(), static_cast<int32_t>(aWav.size()));
+	REQUIRE(nFileId >= 0);
+	const int32_t nTotTriggers = 200;
+	for (int32_t nTrigger = 0; nTrigger < nTotTriggers; ++nTrigger) {
+		const int32_t nSoundId = refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
+		REQUIRE(nSoundId >= 0);
+		// the mixer thread prepares the voice, the previous one has finished: it's idle
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		REQUIRE(refPlayback->triggerSound(nSoundId));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	const auto oTrigger = refDM->getLatencyStats().m_oTrigger;
+	REQUIRE(oTrigger.m_nTotCount == static_cast<uint64_t>(nTotTriggers));
+	WARN("trigger to start: mean " << (oTrigger.m_nTotUsec / nTotTriggers) << " usec, max " << oTrigger.m_nMaxUsec << " usec");
+	// loose bounds: a triggered sound starts within the next few periods (a period is about 5 ms)
+	const int64_t nPeriodUsec = static_cast<int64_t>(oInit.m_nPeriodFrames) * 1000000 / oInit.m_nFrequency;
+	REQUIRE(oTrigger.m_nTotUsec / nTotTriggers <= 4 * nPeriodUsec);
+	REQUIRE(oTrigger.m_nMaxUsec <= 20 * nPeriodUsec);
+}
+
+TEST_CASE("MixerProducerContentionBenchmark", "[.benchmark]")
+{
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 48000;
+	oInit.m_nPeriodFrames = 256;
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new NullMixerSink())
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	refDM->setThreadSafePlayback(true);
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	const auto aWav = makeWav16(48000, 2, std::vector<int16_t>(2 * 48, 1000));
+	const int32_t nFileId = refPlayback->preloadSound(aWav.data(), static_cast<int32_t>(aWav.size()));
+	REQUIRE(nFileId >= 0);
+	const int32_t nTotOpsPerProducer = 20000;
+	double fSingleOpsPerSec = 0.0;
+	for (int32_t nTotProducers = 1; nTotProducers <= 8; nTotProducers *= 2) {
+		std::vector<std::thread> aProducers;
+		// all the producers start together so that only the contended part is measured
+		std::atomic<int32_t> nReady(0);
+		std::atomic<bool> bGo(false);
+		for (int32_t nProducer = 0; nProducer < nTotProducers; ++nProducer) {
+			aProducers.emplace_back([&]()
+			{
+				++nReady;
+				while (! bGo.load()) {
+					std::this_thread::yield();
+				}
+				for (int32_t nOp = 0; nOp < nTotOpsPerProducer; ++nOp) {
+					const int32_t nSoundId = refPlayback->playSound(nFileId, 0.0, false, true, 0.0, 0.0, 0.0);
+					refPlayback->stopSound(nSoundId);
+				}
+			});
+		}
+		while (nReady.load() < nTotProducers) {
+			std::this_thread::yield();
+		}
+		const auto oStart = std::chrono::steady_clock::now();
+		bGo = true;
+		for (auto& oProducer : aProducers) {
+			oProducer.join();
+		}
+		const auto nUsec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - oStart).count();
+		const double fOpsPerSec = 1000000.0 * nTotProducers * nTotOpsPerProducer / std::max<int64_t>(1, nUsec);
+		if (nTotProducers == 1) {
+			fSingleOpsPerSec = fOpsPerSec;
+		}
+		WARN(nTotProducers << " producers: " << static_cast<int64_t>(fOpsPerSec) << " play+stop/sec ("
+				<< static_cast<int64_t>(fOpsPerSec / nTotProducers) << " per producer), speedup "
+				<< (fOpsPerSec / fSingleOpsPerSec) << " (linear: " << nTotProducers << ")");
+		// loose bound: contention must not make the producers slower together than a single one alone
+		REQUIRE(fOpsPerSec >= 0.5 * fSingleOpsPerSec);
+		// let the mixer thread drain the queue
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+}
+
+TEST_CASE("MixerEventLoopAdapter")
+{
+	OpenAlDeviceManager::MixerInit oInit;
+	oInit.m_nFrequency = 48000;
+	oInit.m_nPeriodFrames = 256;
+	int32_t nAttachedFD = -1;
+	std::function<void()> oDispatch;
+	// no Glib adapter is created
+	auto oPairDM = OpenAlDeviceManager::createMixer(oInit, std::unique_ptr<MixerSink>(new NullMixerSink())
+													, std::unique_ptr<EventLoopAdapter>(new RecordingEventLoopAdapter(nAttachedFD, oDispatch))
+													, false, {});
+	REQUIRE(oPairDM.second.empty());
+	auto& refDM = oPairDM.first;
+	REQUIRE(nAttachedFD >= 0);
+	REQUIRE(nAttachedFD == refDM->getEventFD());
+	REQUIRE(oDispatch);
+	std::vector<int32_t> aFinishedIds;
+	auto refListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+	{
+		auto refFinished = std::dynamic_pointer_cast<SndFinishedEvent>(refEvent);
+		if (refFinished) {
+			aFinishedIds.push_back(refFinished->getSoundId());
+		}
+	});
+	refDM->addEventListener(refListener);
+	auto refPlayback = getMixerPlayback(refDM);
+	REQUIRE(refPlayback);
+
+	// 1 millisecond
+	const auto aWav = makeWav16(48000, 2, std::vector<int16_t>(2 * 48, 1000));
+	const auto oSoundData = refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(oSoundData.m_nSoundId >= 0);
+	// wait like an event loop would
+	struct pollfd oPollFD{nAttachedFD, POLLIN, 0};
+	REQUIRE(::poll(&oPollFD, 1, 2000) == 1);
+	REQUIRE(aFinishedIds.empty());
+	oDispatch();
+	REQUIRE(aFinishedIds.size() == 1);
+	REQUIRE(aFinishedIds[0] == oSoundData.m_nSoundId);
+	REQUIRE(::poll(&oPollFD, 1, 0) == 0);
+
+	refDM->setEventLoopAdapter(std::unique_ptr<EventLoopAdapter>{});
+	REQUIRE(nAttachedFD == -1);
+	REQUIRE_FALSE(oDispatch);
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,199 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testMixerKernel.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "mixerkernel.h"
+#include "pcmconverter.h"
+#include "wavdecoder.h"
+
+#include "wavbuffer.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::MixerKernel;
+using Private::OpenAl::PcmConverter;
+using Private::OpenAl::PcmSound;
+using Private::OpenAl::WavDecoder;
+
+namespace
+{
+std::vector<const MixerKernel*> getKernels() noexcept
+{
+	std::vector<const MixerKernel*> aKernels;
+	aKernels.push_back(&MixerKernel::getScalar());
+	if (MixerKernel::getSse2() != nullptr) {
+		aKernels.push_back(MixerKernel::getSse2());
+	}
+	if (MixerKernel::getAvx2() != nullptr) {
+		aKernels.push_back(MixerKernel::getAvx2());
+	}
+	return aKernels;
+}
+std::vector<float> makeSamples(int32_t nTotSamples) noexcept
+{
+	std::vector<float> aSamples(nTotSamples);
+	for (int32_t nIdx = 0; nIdx < nTotSamples; ++nIdx) {
+		aSamples[nIdx] = static_cast<float>(std::sin(nIdx * 0.1));
+	}
+	return aSamples;
+}
+} // unnamed namespace
+
+TEST_CASE("MixerKernelsSameResult")
+{
+	// odd size to exercise the scalar tails of the SIMD implementations
+	const int32_t nTotFrames = 333;
+	const auto aMono = makeSamples(nTotFrames);
+	const auto aStereo = makeSamples(nTotFrames * 2);
+	std::vector<float> aScalarMix(nTotFrames * 2, 0.25f);
+	const MixerKernel& oScalar = MixerKernel::getScalar();
+	oScalar.m_p0MixMono(aMono.data(), nTotFrames, 0.3f, 0.6f, aScalarMix.data());
+	oScalar.m_p0MixStereo(aStereo.data(), nTotFrames, 0.5f, aScalarMix.data());
+	std::vector<int16_t> aScalarOut(nTotFrames * 2);
+	oScalar.m_p0ToInt16(aScalarMix.data(), nTotFrames * 2, aScalarOut.data());
+
+	for (const MixerKernel* p0Kernel : getKernels()) {
+		INFO(p0Kernel->m_p0Name);
+		std::vector<float> aMix(nTotFrames * 2, 0.25f);
+		p0Kernel->m_p0MixMono(aMono.data(), nTotFrames, 0.3f, 0.6f, aMix.data());
+		p0Kernel->m_p0MixStereo(aStereo.data(), nTotFrames, 0.5f, aMix.data());
+		std::vector<int16_t> aOut(nTotFrames * 2);
+		p0Kernel->m_p0ToInt16(aMix.data(), nTotFrames * 2, aOut.data());
+		for (int32_t nIdx = 0; nIdx < nTotFrames * 2; ++nIdx) {
+			REQUIRE(aMix[nIdx] == Approx(aScalarMix[nIdx]).margin(1e-6));
+			REQUIRE(std::abs(aOut[nIdx] - aScalarOut[nIdx]) <= 1);
+		}
+	}
+}
+
+TEST_CASE("MixerKernelsDownmixInPlace")
+{
+	const int32_t nTotFrames = 37;
+	const auto aStereo = makeSamples(nTotFrames * 2);
+	for (const MixerKernel* p0Kernel : getKernels()) {
+		INFO(p0Kernel->m_p0Name);
+		auto aSamples = aStereo;
+		p0Kernel->m_p0DownmixToMono(aSamples.data(), nTotFrames, aSamples.data());
+		for (int32_t nFrame = 0; nFrame < nTotFrames; ++nFrame) {
+			REQUIRE(aSamples[nFrame] == Approx((aStereo[2 * nFrame] + aStereo[2 * nFrame + 1]) * 0.5f));
+		}
+	}
+}
+
+TEST_CASE("MixerKernelsClip")
+{
+	const std::vector<float> aMix{2.0f, -2.0f, 1.0f, -1.0f, 0.0f, 0.5f, -0.5f, 1.5f, -1.5f};
+	const int32_t nTotSamples = static_cast<int32_t>(aMix.size());
+	for (const MixerKernel* p0Kernel : getKernels()) {
+		INFO(p0Kernel->m_p0Name);
+		std::vector<int16_t> aOut(nTotSamples);
+		p0Kernel->m_p0ToInt16(aMix.data(), nTotSamples, aOut.data());
+		REQUIRE(aOut[0] == 32767);
+		REQUIRE(aOut[1] == -32767);
+		REQUIRE(aOut[2] == 32767);
+		REQUIRE(aOut[3] == -32767);
+		REQUIRE(aOut[4] == 0);
+		REQUIRE(std::abs(aOut[5] - 16383) <= 1);
+		REQUIRE(std::abs(aOut[6] + 16383) <= 1);
+		REQUIRE(aOut[7] == 32767);
+		REQUIRE(aOut[8] == -32767);
+	}
+}
+
+TEST_CASE("WavDecoderAndResample")
+{
+	const std::vector<int16_t> aSamples{0, 16384, -16384, 32767, 0, 0, 8192, -8192};
+	const auto aWav = makeWav16(22050, 2, aSamples);
+	PcmSound oSound;
+	REQUIRE(WavDecoder::decode(aWav.data(), static_cast<int32_t>(aWav.size()), oSound).empty());
+	REQUIRE(oSound.m_nFrequency == 22050);
+	REQUIRE(oSound.m_nChannels == 2);
+	REQUIRE(oSound.getTotFrames() == 4);
+	REQUIRE(oSound.m_aSamples[1] == Approx(0.5f));
+	REQUIRE(oSound.m_aSamples[2] == Approx(-0.5f));
+
+	PcmConverter::resample(oSound, 44100);
+	REQUIRE(oSound.m_nFrequency == 44100);
+	REQUIRE(oSound.m_nChannels == 2);
+	REQUIRE(oSound.getTotFrames() == 8);
+	// linear interpolation between the first two frames
+	REQUIRE(oSound.m_aSamples[2] == Approx(-0.25f));
+	REQUIRE(oSound.m_aSamples[3] == Approx(0.75f).margin(1e-4));
+
+	const uint8_t aGarbage[] = {'R', 'I', 'F', 'F', 0, 0};
+	REQUIRE_FALSE(WavDecoder::decode(aGarbage, sizeof(aGarbage), oSound).empty());
+}
+
+TEST_CASE("PcmDownmixToMono")
+{
+	PcmSound oSound;
+	oSound.m_nFrequency = 8000;
+	oSound.m_nChannels = 2;
+	oSound.m_aSamples = {1.0f, 0.0f, -0.5f, -0.5f, 0.25f, 0.75f};
+	PcmConverter::downmixToMono(oSound);
+	REQUIRE(oSound.m_nChannels == 1);
+	REQUIRE(oSound.m_nFrequency == 8000);
+	REQUIRE(oSound.m_aSamples == std::vector<float>{0.5f, -0.5f, 0.5f});
+	// mono unchanged
+	PcmConverter::downmixToMono(oSound);
+	REQUIRE(oSound.m_aSamples.size() == 3);
+}
+
+// Not run by default: testMixerKernel "[.benchmark]"
+TEST_CASE("MixerKernelsBenchmark", "[.benchmark]")
+{
+	const int32_t nFrequency = 48000;
+	const int32_t nPeriodFrames = 512;
+	const int32_t nTotVoices = 64;
+	const int32_t nTotPeriods = 2000;
+	const auto aSrc = makeSamples(nPeriodFrames);
+	std::vector<float> aMix(nPeriodFrames * 2);
+	std::vector<int16_t> aOut(nPeriodFrames * 2);
+	for (const MixerKernel* p0Kernel : getKernels()) {
+		const auto oStart = std::chrono::steady_clock::now();
+		for (int32_t nPeriod = 0; nPeriod < nTotPeriods; ++nPeriod) {
+			std::fill(aMix.begin(), aMix.end(), 0.0f);
+			for (int32_t nVoice = 0; nVoice < nTotVoices; ++nVoice) {
+				p0Kernel->m_p0MixMono(aSrc.data(), nPeriodFrames, 0.01f, 0.02f, aMix.data());
+			}
+			p0Kernel->m_p0ToInt16(aMix.data(), nPeriodFrames * 2, aOut.data());
+		}
+		const double fElapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - oStart).count();
+		const double fAudioSec = static_cast<double>(nPeriodFrames) * nTotPeriods / nFrequency;
+		// How many voices a core could mix in real time
+		const double fVoicesPerCore = nTotVoices * fAudioSec / fElapsedSec;
+		WARN(p0Kernel->m_p0Name << ": " << static_cast<int64_t>(fVoicesPerCore) << " mono voices per core at " << nFrequency << " Hz");
+		REQUIRE(fElapsedSec > 0.0);
+	}
+}
+
+} // namespace testing
+
+} // namespace stmi
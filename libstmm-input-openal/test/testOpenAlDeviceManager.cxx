@@ -0,0 +1,1230 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testOpenAlDeviceManager.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "fixtureAlDM.h"
+#include "soundbank.h"
+
+#include <stmm-input-au/playbackcapability.h>
+#include <stmm-input-au/sndfinishedbatchevent.h>
+#include <stmm-input-au/sndfinishedevent.h>
+#include <stmm-input-au/sndmgmtcapability.h>
+#include <stmm-input-au/sndpreloadedevent.h>
+
+#include <stmm-input-openal/sndstatscapability.h>
+
+#include <stmm-input-ev/devicemgmtevent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace stmi
+{
+
+using std::shared_ptr;
+
+namespace testing
+{
+
+namespace
+{
+shared_ptr<PlaybackCapability> getPlayback(const shared_ptr<DeviceManager>& refDM, const std::string& sName) noexcept
+{
+	for (const auto& refDevice : refDM->getDevices()) {
+		if (refDevice->getName() == sName) {
+			shared_ptr<PlaybackCapability> refPlayback;
+			refDevice->getCapability(refPlayback);
+			return refPlayback;
+		}
+	}
+	return shared_ptr<PlaybackCapability>{};
+}
+/** Removes a temporary directory and the file in it, even if the test fails. */
+class TempDirCleanup
+{
+public:
+	TempDirCleanup(const std::string& sTempDir, const std::string& sFilePath) noexcept
+	: m_sTempDir(sTempDir)
+	, m_sFilePath(sFilePath)
+	{
+	}
+	~TempDirCleanup() noexcept
+	{
+		// the file might already have been removed
+		std::remove(m_sFilePath.c_str());
+		::rmdir(m_sTempDir.c_str());
+	}
+private:
+	const std::string m_sTempDir;
+	const std::string m_sFilePath;
+};
+/** Triggers the next (prepared) sound when one finishes. */
+class ChainingRealTimeListener : public SndRealTimeListener
+{
+public:
+	ChainingRealTimeListener(const shared_ptr<PlaybackCapability>& refPlayback, int32_t nNextSoundId) noexcept
+	: m_refPlayback(refPlayback)
+	, m_nNextSoundId(nNextSoundId)
+	{
+	}
+	void onSoundFinished(int32_t nSoundId, SndFinishedEvent::FINISHED_TYPE eFinishedType) noexcept override
+	{
+		m_aFinished.emplace_back(nSoundId, eFinishedType);
+		if (eFinishedType == SndFinishedEvent::FINISHED_TYPE_COMPLETED) {
+			m_bTriggered = m_refPlayback->triggerSound(m_nNextSoundId);
+		}
+	}
+	std::vector<std::pair<int32_t, SndFinishedEvent::FINISHED_TYPE>> m_aFinished;
+	bool m_bTriggered = false;
+private:
+	shared_ptr<PlaybackCapability> m_refPlayback;
+	int32_t m_nNextSoundId;
+};
+bool isReadable(int32_t nFD, int32_t nTimeoutMillisec) noexcept
+{
+	struct pollfd oPollFD{nFD, POLLIN, 0};
+	return (::poll(&oPollFD, 1, nTimeoutMillisec) == 1) && ((oPollFD.revents & POLLIN) != 0);
+}
+} // unnamed namespace
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "Constructor")
+{
+	REQUIRE(m_refAlDM.operator bool());
+	REQUIRE(m_refAlDM->getDevices().size() == 2);
+	auto refSndMgmt = std::dynamic_pointer_cast<SndMgmtCapability>(m_refAlDM->getCapability(SndMgmtCapability::getClass()));
+	REQUIRE(refSndMgmt.operator bool());
+	const auto refDefault = refSndMgmt->getDefaultPlayback();
+	REQUIRE(refDefault.operator bool());
+	REQUIRE(refDefault == getPlayback(m_refAlDM, "Fake0"));
+	REQUIRE(refDefault->isDefaultDevice());
+	REQUIRE_FALSE(getPlayback(m_refAlDM, "Fake1")->isDefaultDevice());
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PlaySoundCompletes")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	REQUIRE(refPlayback.operator bool());
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(oSoundData.m_nSoundId >= 0);
+	REQUIRE(oSoundData.m_nFileId >= 0);
+	m_p0Backend->advanceMillisec(50);
+	REQUIRE(m_p0Backend->getSound(0, oSoundData.m_nSoundId) != nullptr);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	m_p0Backend->advanceMillisec(60);
+	REQUIRE(m_p0Backend->getSound(0, oSoundData.m_nSoundId) == nullptr);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+	// the sound is no longer active
+	REQUIRE_FALSE(refPlayback->pauseSound(oSoundData.m_nSoundId));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "FinishedInOrder")
+{
+	m_p0Backend->setFileDuration("long.wav", 300);
+	m_p0Backend->setFileDuration("short.wav", 100);
+	auto refPlayback0 = getPlayback(m_refAlDM, "Fake0");
+	auto refPlayback1 = getPlayback(m_refAlDM, "Fake1");
+	const auto oLong = refPlayback0->playSound("long.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oShort = refPlayback1->playSound("short.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oLoop = refPlayback1->playSound("short.wav", 1.0, true, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(1000);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[0]->getSoundId() == oShort.m_nSoundId);
+	REQUIRE(aFinished[1]->getSoundId() == oLong.m_nSoundId);
+	// looping sounds never finish
+	REQUIRE(m_p0Backend->getSound(1, oLoop.m_nSoundId) != nullptr);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "FileNotFound")
+{
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("missing.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(oSoundData.m_nSoundId >= 0);
+	m_p0Backend->advanceMillisec(0);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadNotFound")
+{
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("missing.wav");
+	REQUIRE(nFileId >= 0);
+	m_p0Backend->advanceMillisec(10);
+	// errors of preloads have no sound to finish
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadedBuffer")
+{
+	static const uint8_t s_aBuffer[4] = {1, 2, 3, 4};
+	m_p0Backend->setBufferDuration(s_aBuffer, 20);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake1");
+	const int32_t nFileId = refPlayback->preloadSound(s_aBuffer, sizeof(s_aBuffer));
+	REQUIRE(nFileId >= 0);
+	m_p0Backend->advanceMillisec(0);
+	const auto& oDevice = m_p0Backend->getDevice(1);
+	REQUIRE(oDevice.m_aLoadedFileIds.size() == 1);
+	REQUIRE(oDevice.m_aLoadedFileIds[0] == nFileId);
+	const int32_t nSoundId = refPlayback->playSound(nFileId, 0.5, false, true, 1.0, 2.0, 3.0);
+	REQUIRE(nSoundId >= 0);
+	m_p0Backend->execCommands();
+	const auto p0Sound = m_p0Backend->getSound(1, nSoundId);
+	REQUIRE(p0Sound != nullptr);
+	REQUIRE(p0Sound->m_fVolume == 0.5);
+	REQUIRE(p0Sound->m_bRelative);
+	REQUIRE(p0Sound->m_fPosY == 2.0);
+	m_p0Backend->advanceMillisec(20);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadBank")
+{
+	char aTemplate[] = "/tmp/stmi-preloadbank-XXXXXX";
+	REQUIRE(::mkdtemp(aTemplate) != nullptr);
+	const std::string sTempDir = aTemplate;
+	const std::string sBankPath = sTempDir + "/sounds.bank";
+	TempDirCleanup oCleanup(sTempDir, sBankPath);
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> aBankEntries;
+	aBankEntries.emplace_back("a.wav", std::vector<uint8_t>{1, 2, 3});
+	aBankEntries.emplace_back("b.wav", std::vector<uint8_t>{4, 5, 6, 7});
+	REQUIRE(Private::OpenAl::SoundBank::write(sBankPath, aBankEntries).empty());
+
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	REQUIRE(refPlayback->preloadBank(sTempDir + "/missing.bank").empty());
+	const auto aEntries = refPlayback->preloadBank(sBankPath);
+	REQUIRE(aEntries.size() == 2);
+	REQUIRE(aEntries[0].m_sName == "a.wav");
+	REQUIRE(aEntries[1].m_sName == "b.wav");
+	REQUIRE(aEntries[0].m_nFileId >= 0);
+	REQUIRE(aEntries[1].m_nFileId >= 0);
+	REQUIRE(aEntries[0].m_nFileId != aEntries[1].m_nFileId);
+	m_p0Backend->execCommands();
+	const auto& aCommands = m_p0Backend->getExecutedCommands();
+	REQUIRE(aCommands.size() == 2);
+	REQUIRE(aCommands[1].m_eType == Backend::AL_COMMAND_PRELOAD);
+	REQUIRE(aCommands[1].m_nFileId == aEntries[1].m_nFileId);
+	REQUIRE(aCommands[1].m_nBufferSize == 4);
+	REQUIRE(aCommands[1].m_p0Buffer[0] == 4);
+
+	// the bank is mapped once
+	const auto aAgainEntries = refPlayback->preloadBank(sBankPath);
+	REQUIRE(aAgainEntries.size() == 2);
+	REQUIRE(aAgainEntries[1].m_nFileId == aEntries[1].m_nFileId);
+	m_p0Backend->execCommands();
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == 2);
+
+	m_p0Backend->setBufferDuration(aCommands[1].m_p0Buffer, 20);
+	const int32_t nSoundId = refPlayback->playSound(aEntries[1].m_nFileId, 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(nSoundId >= 0);
+	m_p0Backend->execCommands();
+	const auto& aPlayCommand = m_p0Backend->getExecutedCommands().back();
+	REQUIRE(aPlayCommand.m_eType == Backend::AL_COMMAND_PLAY);
+	REQUIRE(aPlayCommand.m_p0Buffer == aCommands[1].m_p0Buffer);
+	m_p0Backend->advanceMillisec(20);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+
+	// the mapping stays valid after the file is removed
+	REQUIRE(std::remove(sBankPath.c_str()) == 0);
+	const auto aRemovedEntries = refPlayback->preloadBank(sBankPath);
+	const auto itEntryA = std::find_if(aRemovedEntries.begin(), aRemovedEntries.end(), [](const PlaybackCapability::BankEntry& oEntry)
+	{
+		return oEntry.m_sName == "a.wav";
+	});
+	REQUIRE(itEntryA != aRemovedEntries.end());
+	REQUIRE(itEntryA->m_nFileId == aEntries[0].m_nFileId);
+	m_p0Backend->setBufferDuration(aCommands[0].m_p0Buffer, 20);
+	const int32_t nRemovedSoundId = refPlayback->playSound(itEntryA->m_nFileId, 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(nRemovedSoundId >= 0);
+	m_p0Backend->execCommands();
+	const auto& aRemovedPlayCommand = m_p0Backend->getExecutedCommands().back();
+	REQUIRE(aRemovedPlayCommand.m_eType == Backend::AL_COMMAND_PLAY);
+	REQUIRE(aRemovedPlayCommand.m_p0Buffer[0] == 1);
+	m_p0Backend->advanceMillisec(20);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[1]->getSoundId() == nRemovedSoundId);
+	REQUIRE(aFinished[1]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadSounds")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oBatch = refPlayback->preloadSounds({"a.wav", "missing.wav", "b.wav"});
+	REQUIRE(oBatch.m_nBatchId >= 0);
+	REQUIRE(oBatch.m_aFileIds.size() == 3);
+	REQUIRE(oBatch.m_aFileIds[0] != oBatch.m_aFileIds[2]);
+	m_p0Backend->advanceMillisec(0);
+	const auto aPreloaded = getReceivedEvents<SndPreloadedEvent>();
+	REQUIRE(aPreloaded.size() == 4);
+	REQUIRE(aPreloaded[0]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_FILE_LOADED);
+	REQUIRE(aPreloaded[0]->getFileId() == oBatch.m_aFileIds[0]);
+	REQUIRE(aPreloaded[1]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_FILE_FAILED);
+	REQUIRE(aPreloaded[1]->getFileId() == oBatch.m_aFileIds[1]);
+	REQUIRE(aPreloaded[2]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_FILE_LOADED);
+	REQUIRE(aPreloaded[3]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_BATCH_COMPLETED);
+	REQUIRE(aPreloaded[3]->getBatchId() == oBatch.m_nBatchId);
+	REQUIRE(aPreloaded[3]->getTotFailed() == 1);
+	REQUIRE(m_p0Backend->getDevice(0).m_aLoadedFileIds.size() == 2);
+
+	// a second batch gets the same file ids
+	const auto oAgainBatch = refPlayback->preloadSounds({"b.wav"});
+	REQUIRE(oAgainBatch.m_nBatchId != oBatch.m_nBatchId);
+	REQUIRE(oAgainBatch.m_aFileIds.size() == 1);
+	REQUIRE(oAgainBatch.m_aFileIds[0] == oBatch.m_aFileIds[2]);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadSoundsDeviceRemoved")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake1");
+	const auto oBatch = refPlayback->preloadSounds({"a.wav"});
+	REQUIRE(oBatch.m_nBatchId >= 0);
+	m_p0Backend->simulateDeviceRemoved(1);
+	m_p0Backend->advanceMillisec(10);
+	const auto aPreloaded = getReceivedEvents<SndPreloadedEvent>();
+	REQUIRE_FALSE(aPreloaded.empty());
+	REQUIRE(aPreloaded.back()->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_BATCH_ABORTED);
+	REQUIRE(aPreloaded.back()->getBatchId() == oBatch.m_nBatchId);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreloadSoundsPriority")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	m_p0Backend->setFileDuration("c.wav", 100);
+	m_p0Backend->setFileDuration("click.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oLowBatch = refPlayback->preloadSounds({"a.wav", "b.wav"}, PlaybackCapability::PRELOAD_PRIORITY_LOW);
+	const auto oHighBatch = refPlayback->preloadSounds({"c.wav"}, PlaybackCapability::PRELOAD_PRIORITY_HIGH);
+	// doesn't wait for the preloads
+	const auto oSoundData = refPlayback->playSound("click.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->execCommands();
+	const auto& aCommands = m_p0Backend->getExecutedCommands();
+	REQUIRE(aCommands.size() == 4);
+	REQUIRE(aCommands[0].m_eType == Backend::AL_COMMAND_PLAY);
+	REQUIRE(aCommands[0].m_nSoundId == oSoundData.m_nSoundId);
+	REQUIRE(aCommands[1].m_nFileId == oHighBatch.m_aFileIds[0]);
+	REQUIRE(aCommands[2].m_nFileId == oLowBatch.m_aFileIds[0]);
+	REQUIRE(aCommands[3].m_nFileId == oLowBatch.m_aFileIds[1]);
+	m_p0Backend->deliverEvents();
+	const auto aPreloaded = getReceivedEvents<SndPreloadedEvent>();
+	REQUIRE(aPreloaded.size() == 5);
+	REQUIRE(aPreloaded[1]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_BATCH_COMPLETED);
+	REQUIRE(aPreloaded[1]->getBatchId() == oHighBatch.m_nBatchId);
+	REQUIRE(aPreloaded[4]->getPreloadedType() == SndPreloadedEvent::PRELOADED_TYPE_BATCH_COMPLETED);
+	REQUIRE(aPreloaded[4]->getBatchId() == oLowBatch.m_nBatchId);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "CancelPreloadBatch")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oCancelledBatch = refPlayback->preloadSounds({"a.wav"});
+	const auto oBatch = refPlayback->preloadSounds({"b.wav"});
+	REQUIRE(refPlayback->cancelPreloadBatch(oCancelledBatch.m_nBatchId));
+	REQUIRE_FALSE(refPlayback->cancelPreloadBatch(oCancelledBatch.m_nBatchId));
+	m_p0Backend->advanceMillisec(0);
+	for (const auto& oCommand : m_p0Backend->getExecutedCommands()) {
+		if (oCommand.m_eType == Backend::AL_COMMAND_PRELOAD) {
+			REQUIRE(oCommand.m_nBatchId != oCancelledBatch.m_nBatchId);
+		}
+	}
+	REQUIRE(m_p0Backend->getDevice(0).m_aLoadedFileIds.size() == 1);
+	const auto aPreloaded = getReceivedEvents<SndPreloadedEvent>();
+	REQUIRE(aPreloaded.size() == 2);
+	for (const auto& refPreloaded : aPreloaded) {
+		REQUIRE(refPreloaded->getBatchId() == oBatch.m_nBatchId);
+	}
+	// already completed
+	REQUIRE_FALSE(refPlayback->cancelPreloadBatch(oBatch.m_nBatchId));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "StopSound")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(refPlayback->stopSound(oSoundData.m_nSoundId));
+	// already stopped
+	REQUIRE_FALSE(refPlayback->stopSound(oSoundData.m_nSoundId));
+	m_p0Backend->advanceMillisec(200);
+	REQUIRE(m_p0Backend->getSound(0, oSoundData.m_nSoundId) == nullptr);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PauseResume")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(40);
+	REQUIRE(refPlayback->pauseSound(oSoundData.m_nSoundId));
+	m_p0Backend->advanceMillisec(500);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	REQUIRE(refPlayback->resumeSound(oSoundData.m_nSoundId));
+	m_p0Backend->advanceMillisec(50);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	REQUIRE(refPlayback->pauseDevice());
+	m_p0Backend->advanceMillisec(500);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	REQUIRE(refPlayback->resumeDevice());
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "SoundGroups")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nMusicGroupId = refPlayback->getSoundGroup("music");
+	const int32_t nSfxGroupId = refPlayback->getSoundGroup("sfx");
+	REQUIRE(nMusicGroupId >= 0);
+	REQUIRE(nSfxGroupId != nMusicGroupId);
+	REQUIRE(refPlayback->getSoundGroup("music") == nMusicGroupId);
+	// invalid group
+	REQUIRE(refPlayback->playSoundInGroup(nSfxGroupId + 1, "a.wav", 1.0, false, false, 0.0, 0.0, 0.0).m_nSoundId < 0);
+	const auto oMusic1 = refPlayback->playSoundInGroup(nMusicGroupId, "a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oMusic2 = refPlayback->playSoundInGroup(nMusicGroupId, "a.wav", 1.0, true, false, 0.0, 0.0, 0.0);
+	const auto oSfx = refPlayback->playSoundInGroup(nSfxGroupId, "a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	const auto nTotCommands = m_p0Backend->getExecutedCommands().size();
+	REQUIRE(refPlayback->setGroupVol(nMusicGroupId, 0.5));
+	m_p0Backend->advanceMillisec(0);
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == nTotCommands + 1);
+	REQUIRE(m_p0Backend->getDevice(0).m_aSoundGroups[nMusicGroupId].m_fVolume == 0.5);
+	REQUIRE(refPlayback->pauseGroup(nMusicGroupId));
+	// already paused
+	REQUIRE_FALSE(refPlayback->pauseGroup(nMusicGroupId));
+	m_p0Backend->advanceMillisec(500);
+	// only the sound effect finished
+	auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSfx.m_nSoundId);
+	REQUIRE(refPlayback->resumeGroup(nMusicGroupId));
+	REQUIRE_FALSE(refPlayback->resumeGroup(nMusicGroupId));
+	m_p0Backend->advanceMillisec(100);
+	aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[1]->getSoundId() == oMusic1.m_nSoundId);
+	// the looping sound is stopped without finished event
+	REQUIRE(refPlayback->stopGroup(nMusicGroupId));
+	REQUIRE_FALSE(refPlayback->stopSound(oMusic2.m_nSoundId));
+	m_p0Backend->advanceMillisec(500);
+	REQUIRE(m_p0Backend->getSound(0, oMusic2.m_nSoundId) == nullptr);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 2);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "SoundMotion")
+{
+	m_p0Backend->setFileDuration("a.wav", 1000);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, true, false, 1.0, 0.0, 0.0, 10.0, 0.0, -20.0);
+	REQUIRE(oSoundData.m_nSoundId >= 0);
+	m_p0Backend->advanceMillisec(0);
+	const auto nTotCommands = m_p0Backend->getExecutedCommands().size();
+	m_p0Backend->advanceMillisec(500);
+	// the backend moved the sound without commands
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == nTotCommands);
+	const auto* p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound != nullptr);
+	REQUIRE(p0Sound->m_fPosX == Approx(6.0));
+	REQUIRE(p0Sound->m_fPosZ == Approx(-10.0));
+	// move to a target
+	REQUIRE(refPlayback->setSoundMotionTo(oSoundData.m_nSoundId, false, 0.0, 0.0, 0.0, 0.0, 4.0, 0.0, 200));
+	m_p0Backend->advanceMillisec(100);
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fPosY == Approx(2.0));
+	m_p0Backend->advanceMillisec(300);
+	// arrived
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fPosY == 4.0);
+	REQUIRE_FALSE(p0Sound->m_oMotion.m_bMoving);
+	// setting the position stops the motion
+	REQUIRE(refPlayback->setSoundMotion(oSoundData.m_nSoundId, true, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0));
+	REQUIRE(refPlayback->setSoundPos(oSoundData.m_nSoundId, true, 0.0, 0.0, -1.0));
+	m_p0Backend->advanceMillisec(100);
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fPosX == 0.0);
+	REQUIRE_FALSE(p0Sound->m_oMotion.m_bMoving);
+	// no arrival time
+	REQUIRE_FALSE(refPlayback->setSoundMotionTo(oSoundData.m_nSoundId, true, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0));
+	REQUIRE_FALSE(refPlayback->setSoundMotionTo(oSoundData.m_nSoundId, true, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, -5));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "VolumeRamps")
+{
+	m_p0Backend->setFileDuration("a.wav", 1000);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 0.0, true, false, 0.0, 0.0, 0.0);
+	REQUIRE(refPlayback->rampSoundVol(oSoundData.m_nSoundId, 1.0, 200, PlaybackCapability::RAMP_CURVE_LINEAR));
+	m_p0Backend->advanceMillisec(0);
+	const auto nTotCommands = m_p0Backend->getExecutedCommands().size();
+	m_p0Backend->advanceMillisec(50);
+	const auto* p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fVolume == Approx(0.25));
+	m_p0Backend->advanceMillisec(50);
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fVolume == Approx(0.5));
+	m_p0Backend->advanceMillisec(200);
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fVolume == 1.0);
+	REQUIRE_FALSE(p0Sound->m_oRamp.m_bRamping);
+	// the backend evaluated the ramp without commands
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == nTotCommands);
+	// setting the volume cancels the fade out
+	REQUIRE(refPlayback->fadeOutAndStop(oSoundData.m_nSoundId, 100, PlaybackCapability::RAMP_CURVE_SMOOTH));
+	REQUIRE(refPlayback->setSoundVol(oSoundData.m_nSoundId, 0.8));
+	m_p0Backend->advanceMillisec(200);
+	REQUIRE(m_p0Backend->getSound(0, oSoundData.m_nSoundId) != nullptr);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	REQUIRE(refPlayback->fadeOutAndStop(oSoundData.m_nSoundId, 100, PlaybackCapability::RAMP_CURVE_EXPONENTIAL));
+	m_p0Backend->advanceMillisec(50);
+	p0Sound = m_p0Backend->getSound(0, oSoundData.m_nSoundId);
+	REQUIRE(p0Sound->m_fVolume < 0.8);
+	REQUIRE(p0Sound->m_fVolume > 0.0);
+	m_p0Backend->advanceMillisec(50);
+	REQUIRE(m_p0Backend->getSound(0, oSoundData.m_nSoundId) == nullptr);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_FADED_OUT);
+	REQUIRE_FALSE(refPlayback->fadeOutAndStop(oSoundData.m_nSoundId, 100, PlaybackCapability::RAMP_CURVE_LINEAR));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "ScheduledStart")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("a.wav");
+	REQUIRE(nFileId >= 0);
+	m_p0Backend->advanceMillisec(20);
+	const int64_t nClockNanosec = refPlayback->getDeviceClockNanosec();
+	REQUIRE(nClockNanosec == 20000000);
+	// invalid start time and file id
+	REQUIRE(refPlayback->playSoundAt(nFileId, -1, 1.0, false, true, 0.0, 0.0, 0.0) < 0);
+	REQUIRE(refPlayback->playSoundAt(nFileId + 100, nClockNanosec, 1.0, false, true, 0.0, 0.0, 0.0) < 0);
+	const int32_t nSoundId = refPlayback->playSoundAt(nFileId, nClockNanosec + 50000000, 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(nSoundId >= 0);
+	m_p0Backend->advanceMillisec(140);
+	// started at 70 millisec
+	REQUIRE(m_p0Backend->getSound(0, nSoundId)->m_nPlayedMillisec == 90);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	m_p0Backend->advanceMillisec(20);
+	auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == nSoundId);
+
+	const auto nTotCommands = m_p0Backend->getExecutedCommands().size();
+	std::vector<PlaybackCapability::SyncedSound> aSounds(2);
+	aSounds[0].m_nFileId = nFileId;
+	aSounds[1].m_nFileId = nFileId;
+	aSounds[1].m_bLoop = true;
+	aSounds[1].m_fVolume = 0.5;
+	// one of the sounds is invalid: none is played
+	aSounds[1].m_nGroupId = 7;
+	REQUIRE(refPlayback->playSoundsTogether(aSounds, 0).empty());
+	aSounds[1].m_nGroupId = -1;
+	REQUIRE(refPlayback->playSoundsTogether(aSounds, -1).empty());
+	m_p0Backend->advanceMillisec(0);
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == nTotCommands);
+	const int64_t nStartNanosec = refPlayback->getDeviceClockNanosec() + 10000000;
+	const auto aSoundIds = refPlayback->playSoundsTogether(aSounds, nStartNanosec);
+	REQUIRE(aSoundIds.size() == 2);
+	m_p0Backend->advanceMillisec(5);
+	const auto& aCommands = m_p0Backend->getExecutedCommands();
+	REQUIRE(aCommands.size() == nTotCommands + 2);
+	REQUIRE(aCommands[nTotCommands].m_nStartClockNanosec == nStartNanosec);
+	REQUIRE(aCommands[nTotCommands + 1].m_nStartClockNanosec == nStartNanosec);
+	REQUIRE(m_p0Backend->getSound(0, aSoundIds[0])->m_nPlayedMillisec == 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_p0Backend->getSound(0, aSoundIds[0])->m_nPlayedMillisec == 5);
+	REQUIRE(m_p0Backend->getSound(0, aSoundIds[1])->m_nPlayedMillisec == 5);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreparedSounds")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("a.wav");
+	REQUIRE(nFileId >= 0);
+	REQUIRE(refPlayback->prepareSound(nFileId + 100, 1.0, false, true, 0.0, 0.0, 0.0) < 0);
+	m_refAlDM->setLatencyStatsEnabled(true);
+	const int32_t nSoundId = refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(nSoundId >= 0);
+	m_p0Backend->advanceMillisec(200);
+	// prepared but not started
+	REQUIRE(m_p0Backend->getSound(0, nSoundId)->m_nPlayedMillisec == 0);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	const auto nTotCommands = m_p0Backend->getExecutedCommands().size();
+	REQUIRE(refPlayback->triggerSound(nSoundId));
+	REQUIRE_FALSE(refPlayback->triggerSound(nSoundId));
+	m_p0Backend->advanceMillisec(50);
+	// no command was sent
+	REQUIRE(m_p0Backend->getExecutedCommands().size() == nTotCommands);
+	REQUIRE(m_p0Backend->getSound(0, nSoundId)->m_nPlayedMillisec == 50);
+	REQUIRE(m_refAlDM->getLatencyStats().m_oTrigger.m_nTotCount == 1);
+	// taken by the first command execution after the trigger: loose bound
+	REQUIRE(m_refAlDM->getLatencyStats().m_oTrigger.m_nMaxUsec < 1000000);
+	m_p0Backend->advanceMillisec(60);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == nSoundId);
+	// only prepared sounds can be triggered
+	const int32_t nPlayedId = refPlayback->playSound(nFileId, 1.0, true, true, 0.0, 0.0, 0.0);
+	REQUIRE_FALSE(refPlayback->triggerSound(nPlayedId));
+
+	// the number of prepared sounds is limited
+	const int32_t nMaxPrepared = FakeOpenAlBackend::s_nMaxTriggerSlots;
+	std::vector<int32_t> aPreparedIds;
+	for (int32_t nCount = 0; nCount < nMaxPrepared; ++nCount) {
+		aPreparedIds.push_back(refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0));
+		REQUIRE(aPreparedIds.back() >= 0);
+	}
+	REQUIRE(refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0) < 0);
+	m_p0Backend->advanceMillisec(10);
+	// the slot of a stopped prepared sound is released by the backend
+	REQUIRE(refPlayback->stopSound(aPreparedIds[0]));
+	REQUIRE_FALSE(refPlayback->triggerSound(aPreparedIds[0]));
+	REQUIRE(refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0) < 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0) >= 0);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "PreparedSoundStaleTrigger")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("a.wav");
+	REQUIRE(nFileId >= 0);
+	const int32_t nOldId = refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(nOldId >= 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(refPlayback->stopSound(nOldId));
+	// the backend releases the slot
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_p0Backend->getSound(0, nOldId) == nullptr);
+	// reuses the slot of the stopped sound
+	const int32_t nNewId = refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
+	REQUIRE(nNewId >= 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE_FALSE(refPlayback->triggerSound(nOldId));
+	m_p0Backend->advanceMillisec(20);
+	REQUIRE(m_p0Backend->getSound(0, nNewId)->m_nPlayedMillisec == 0);
+	REQUIRE(refPlayback->triggerSound(nNewId));
+	m_p0Backend->advanceMillisec(20);
+	REQUIRE(m_p0Backend->getSound(0, nNewId)->m_nPlayedMillisec == 20);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "SoundState")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, true, 0.0, 0.0, 0.0);
+	const int32_t nSoundId = oSoundData.m_nSoundId;
+	REQUIRE(nSoundId >= 0);
+	// not executed yet
+	REQUIRE(refPlayback->getSoundState(nSoundId).m_eState == PlaybackCapability::SOUND_STATE_PENDING);
+	m_p0Backend->advanceMillisec(30);
+	auto oState = refPlayback->getSoundState(nSoundId);
+	REQUIRE(oState.m_eState == PlaybackCapability::SOUND_STATE_PLAYING);
+	REQUIRE(oState.m_fOffsetSec == Approx(0.03));
+	REQUIRE(oState.m_fLengthSec == Approx(0.1));
+	REQUIRE(refPlayback->pauseSound(nSoundId));
+	// the backend doesn't know yet
+	REQUIRE(refPlayback->getSoundState(nSoundId).m_eState == PlaybackCapability::SOUND_STATE_PLAYING);
+	m_p0Backend->advanceMillisec(20);
+	oState = refPlayback->getSoundState(nSoundId);
+	REQUIRE(oState.m_eState == PlaybackCapability::SOUND_STATE_PAUSED);
+	REQUIRE(oState.m_fOffsetSec == Approx(0.03));
+	REQUIRE(refPlayback->resumeSound(nSoundId));
+	m_p0Backend->advanceMillisec(100);
+	// finished
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+	oState = refPlayback->getSoundState(nSoundId);
+	REQUIRE(oState.m_eState == PlaybackCapability::SOUND_STATE_STOPPED);
+	REQUIRE(oState.m_fOffsetSec == Approx(0.1));
+
+	const int32_t nLoopId = refPlayback->playSound(oSoundData.m_nFileId, 1.0, true, true, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(130);
+	oState = refPlayback->getSoundState(nLoopId);
+	REQUIRE(oState.m_eState == PlaybackCapability::SOUND_STATE_PLAYING);
+	REQUIRE(oState.m_fOffsetSec == Approx(0.03));
+	REQUIRE(refPlayback->stopSound(nLoopId));
+	// stopped even though the backend doesn't know yet
+	oState = refPlayback->getSoundState(nLoopId);
+	REQUIRE(oState.m_eState == PlaybackCapability::SOUND_STATE_STOPPED);
+	REQUIRE(oState.m_fOffsetSec == Approx(0.03));
+
+	// not a sound of the device
+	auto refPlayback1 = getPlayback(m_refAlDM, "Fake1");
+	const int32_t nOtherId = refPlayback1->playSound("a.wav", 1.0, true, true, 0.0, 0.0, 0.0).m_nSoundId;
+	REQUIRE(nOtherId >= 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(refPlayback->getSoundState(nOtherId).m_eState == PlaybackCapability::SOUND_STATE_UNKNOWN);
+	REQUIRE(refPlayback->getSoundState(nLoopId + 1000).m_eState == PlaybackCapability::SOUND_STATE_UNKNOWN);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "DeviceRemovedAbortsSounds")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake1");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, true, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	m_p0Backend->simulateDeviceRemoved(1);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->getDevices().size() == 1);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_ABORTED);
+	const auto aMgmt = getReceivedEvents<DeviceMgmtEvent>();
+	REQUIRE(aMgmt.size() == 1);
+	REQUIRE(aMgmt[0]->getDeviceMgmtType() == DeviceMgmtEvent::DEVICE_MGMT_REMOVED);
+	// the device no longer accepts commands
+	REQUIRE(refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0).m_nSoundId < 0);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "DeviceRemovedAbortsSoundsInPlayOrder")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake1");
+	std::vector<int32_t> aSoundIds;
+	for (int32_t nCount = 0; nCount < 40; ++nCount) {
+		const int32_t nSoundId = refPlayback->playSound("a.wav", 1.0, true, false, 0.0, 0.0, 0.0).m_nSoundId;
+		REQUIRE(nSoundId >= 0);
+		aSoundIds.push_back(nSoundId);
+	}
+	// removing from the middle of the tables must not change the order
+	for (int32_t nIdx = 3; nIdx < 40; nIdx += 7) {
+		REQUIRE(refPlayback->stopSound(aSoundIds[nIdx]));
+	}
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	m_p0Backend->simulateDeviceRemoved(1);
+	m_p0Backend->advanceMillisec(10);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	std::vector<int32_t> aAbortedIds;
+	for (const auto& refFinished : aFinished) {
+		REQUIRE(refFinished->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_ABORTED);
+		aAbortedIds.push_back(refFinished->getSoundId());
+	}
+	std::vector<int32_t> aExpectedIds;
+	for (int32_t nIdx = 0; nIdx < 40; ++nIdx) {
+		if ((nIdx % 7) != 3) {
+			aExpectedIds.push_back(aSoundIds[nIdx]);
+		}
+	}
+	REQUIRE(aAbortedIds == aExpectedIds);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "DeviceAdded")
+{
+	m_p0Backend->simulateDeviceAdded("Fake2", false);
+	REQUIRE(m_refAlDM->getDevices().size() == 2);
+	m_p0Backend->advanceMillisec(0);
+	REQUIRE(m_refAlDM->getDevices().size() == 3);
+	const auto aMgmt = getReceivedEvents<DeviceMgmtEvent>();
+	REQUIRE(aMgmt.size() == 1);
+	REQUIRE(aMgmt[0]->getDeviceMgmtType() == DeviceMgmtEvent::DEVICE_MGMT_ADDED);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake2");
+	REQUIRE(refPlayback.operator bool());
+	REQUIRE_FALSE(refPlayback->isDefaultDevice());
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "ListenerRemoved")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->removeEventListener(m_refListener, true));
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_LISTENER_REMOVED);
+	m_p0Backend->advanceMillisec(100);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "SndFinishedBatching")
+{
+	m_refAlDM->setSndFinishedBatching(true);
+	REQUIRE(m_refAlDM->isSndFinishedBatching());
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback0 = getPlayback(m_refAlDM, "Fake0");
+	auto refPlayback1 = getPlayback(m_refAlDM, "Fake1");
+	const int32_t nTotSounds = 200;
+	std::set<int32_t> aSoundIds;
+	for (int32_t nCount = 0; nCount < nTotSounds; ++nCount) {
+		aSoundIds.insert(refPlayback0->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0).m_nSoundId);
+	}
+	std::set<int32_t> aLoopIds;
+	for (int32_t nCount = 0; nCount < 3; ++nCount) {
+		aLoopIds.insert(refPlayback1->playSound("a.wav", 1.0, true, false, 0.0, 0.0, 0.0).m_nSoundId);
+	}
+	const int64_t nBeforeUsec = DeviceManager::getNowTimeMicroseconds();
+	m_p0Backend->advanceMillisec(150);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	auto aBatches = getReceivedEvents<SndFinishedBatchEvent>();
+	// one event for all the sounds finished in the same dispatch
+	REQUIRE(aBatches.size() == 1);
+	REQUIRE(aBatches[0]->getPlaybackCapability() == refPlayback0);
+	REQUIRE(aBatches[0]->getTotEntries() == nTotSounds);
+	std::set<int32_t> aFinishedIds;
+	for (const auto& oEntry : aBatches[0]->getEntries()) {
+		REQUIRE(oEntry.m_eFinishedType == SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+		REQUIRE(oEntry.m_nTimeUsec >= nBeforeUsec);
+		REQUIRE(oEntry.m_nTimeUsec <= aBatches[0]->getTimeUsec());
+		aFinishedIds.insert(oEntry.m_nSoundId);
+	}
+	REQUIRE(aFinishedIds == aSoundIds);
+
+	m_p0Backend->simulateDeviceRemoved(1);
+	m_p0Backend->advanceMillisec(10);
+	aBatches = getReceivedEvents<SndFinishedBatchEvent>();
+	REQUIRE(aBatches.size() == 2);
+	REQUIRE(aBatches[1]->getTotEntries() == 3);
+	aFinishedIds.clear();
+	for (int32_t nIdx = 0; nIdx < aBatches[1]->getTotEntries(); ++nIdx) {
+		const auto& oEntry = aBatches[1]->getEntry(nIdx);
+		REQUIRE(oEntry.m_eFinishedType == SndFinishedEvent::FINISHED_TYPE_ABORTED);
+		aFinishedIds.insert(oEntry.m_nSoundId);
+	}
+	REQUIRE(aFinishedIds == aLoopIds);
+
+	const auto oLoop = refPlayback0->playSound("a.wav", 1.0, true, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->removeEventListener(m_refListener, true));
+	aBatches = getReceivedEvents<SndFinishedBatchEvent>();
+	REQUIRE(aBatches.size() == 3);
+	REQUIRE(aBatches[2]->getTotEntries() == 1);
+	REQUIRE(aBatches[2]->getEntry(0).m_nSoundId == oLoop.m_nSoundId);
+	REQUIRE(aBatches[2]->getEntry(0).m_eFinishedType == SndFinishedEvent::FINISHED_TYPE_LISTENER_REMOVED);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "LatencyStats")
+{
+	REQUIRE_FALSE(m_refAlDM->isLatencyStatsEnabled());
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(200);
+	{
+		const auto oStats = m_refAlDM->getLatencyStats();
+		REQUIRE(oStats.m_aQueueWait[OpenAlDeviceManager::COMMAND_TYPE_PLAY].m_nTotCount == 0);
+		REQUIRE(oStats.m_oFinishedDelivery.m_nTotCount == 0);
+	}
+	m_refAlDM->setLatencyStatsEnabled(true);
+	REQUIRE(m_refAlDM->isLatencyStatsEnabled());
+	m_p0Backend->setCommandQueueWaitMillisec(3);
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(refPlayback->setSoundVol(oSoundData.m_nSoundId, 0.5));
+	m_p0Backend->advanceMillisec(200);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 2);
+	const auto oStats = m_refAlDM->getLatencyStats();
+	const auto& oPlayWait = oStats.m_aQueueWait[OpenAlDeviceManager::COMMAND_TYPE_PLAY];
+	REQUIRE(oPlayWait.m_nTotCount == 1);
+	REQUIRE(oPlayWait.m_nTotUsec == 3000);
+	// 3000 usec is in [2048, 4096)
+	REQUIRE(oPlayWait.m_aBucketCounts[12] == 1);
+	const auto& oVolWait = oStats.m_aQueueWait[OpenAlDeviceManager::COMMAND_TYPE_SOUND_VOL];
+	REQUIRE(oVolWait.m_nTotCount == 1);
+	REQUIRE(oVolWait.m_nMaxUsec == 6000);
+	REQUIRE(oStats.m_aExecution[OpenAlDeviceManager::COMMAND_TYPE_PLAY].m_nTotCount == 1);
+	REQUIRE(oStats.m_aExecution[OpenAlDeviceManager::COMMAND_TYPE_PLAY].m_aBucketCounts[0] == 1);
+	REQUIRE(oStats.m_aQueueWait[OpenAlDeviceManager::COMMAND_TYPE_STOP].m_nTotCount == 0);
+	REQUIRE(oStats.m_oFinishedDelivery.m_nTotCount == 1);
+	m_refAlDM->resetLatencyStats();
+	REQUIRE(m_refAlDM->getLatencyStats().m_oFinishedDelivery.m_nTotCount == 0);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "DecodeLatencyStats")
+{
+	m_refAlDM->setLatencyStatsEnabled(true);
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	REQUIRE(refPlayback->preloadSound("a.wav") >= 0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->getLatencyStats().m_oDecode.m_nTotCount == 1);
+	// already decoded
+	refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->getLatencyStats().m_oDecode.m_nTotCount == 1);
+	refPlayback->playSound("b.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(10);
+	REQUIRE(m_refAlDM->getLatencyStats().m_oDecode.m_nTotCount == 2);
+
+	m_refAlDM->setDecodedBufferBudget(10, 1000000);
+	REQUIRE(m_refAlDM->getDecodedBufferBudgetBuffers() == 10);
+	REQUIRE(m_refAlDM->getDecodedBufferBudgetBytes() == 1000000);
+	m_refAlDM->setDecodeOnDemand(true);
+	REQUIRE(m_refAlDM->isDecodeOnDemand());
+	m_refAlDM->setStreamingThreshold(100000);
+	REQUIRE(m_refAlDM->getStreamingThreshold() == 100000);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "SndStats")
+{
+	auto refSndStats = std::dynamic_pointer_cast<SndStatsCapability>(m_refAlDM->getCapability(SndStatsCapability::getClass()));
+	REQUIRE(refSndStats.operator bool());
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake1");
+	refPlayback->playSound("a.wav", 1.0, true, false, 0.0, 0.0, 0.0);
+	refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	refPlayback->preloadSound("b.wav");
+	{
+		const auto oStats = refSndStats->getStats();
+		REQUIRE(oStats.m_aExecutedCommands[OpenAlDeviceManager::COMMAND_TYPE_PLAY] == 0);
+	}
+	m_p0Backend->advanceMillisec(10);
+	const auto oStats = refSndStats->getStats();
+	REQUIRE(oStats.m_aDevices.size() == 2);
+	REQUIRE(oStats.m_nCommandQueueDepth == 3);
+	REQUIRE(oStats.m_nCommandQueueHighWater == 3);
+	REQUIRE(oStats.m_aExecutedCommands[OpenAlDeviceManager::COMMAND_TYPE_PLAY] == 2);
+	REQUIRE(oStats.m_aExecutedCommands[OpenAlDeviceManager::COMMAND_TYPE_PRELOAD] == 1);
+	REQUIRE(oStats.m_nEventsPending == 0);
+	const auto& oDevice1Stats = oStats.m_aDevices[1];
+	REQUIRE(oDevice1Stats.m_nDeviceId == refPlayback->getDevice()->getId());
+	REQUIRE(oDevice1Stats.m_nActiveSources == 2);
+	REQUIRE(oDevice1Stats.m_nBuffers == 2);
+	REQUIRE(oStats.m_aDevices[0].m_nActiveSources == 0);
+
+	m_p0Backend->simulateDeviceRemoved(0);
+	m_p0Backend->execCommands();
+	REQUIRE(refSndStats->getStats().m_aDevices.size() == 1);
+	REQUIRE(refSndStats->getStats().m_nEventsPending == 1);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "MonoDownmixPolicy")
+{
+	REQUIRE(m_refAlDM->getMonoDownmixPolicy() == OpenAlDeviceManager::MONO_DOWNMIX_POLICY_KEEP_STEREO);
+	m_refAlDM->setFileMonoDownmixPolicy("a.wav", OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	REQUIRE(m_refAlDM->getFileMonoDownmixPolicy("a.wav") == OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	REQUIRE(m_refAlDM->getFileMonoDownmixPolicy("b.wav") == OpenAlDeviceManager::MONO_DOWNMIX_POLICY_KEEP_STEREO);
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	refPlayback->playSound("a.wav", 1.0, false, false, 1.0, 0.0, 0.0);
+	refPlayback->playSound("b.wav", 1.0, false, false, 1.0, 0.0, 0.0);
+	m_refAlDM->setMonoDownmixPolicy(OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	m_refAlDM->setFileMonoDownmixPolicy("a.wav", OpenAlDeviceManager::MONO_DOWNMIX_POLICY_KEEP_STEREO);
+	refPlayback->playSound("a.wav", 1.0, false, false, 1.0, 0.0, 0.0);
+	refPlayback->playSound("b.wav", 1.0, false, false, 1.0, 0.0, 0.0);
+	m_refAlDM->resetFileMonoDownmixPolicy("a.wav");
+	REQUIRE(m_refAlDM->getFileMonoDownmixPolicy("a.wav") == OpenAlDeviceManager::MONO_DOWNMIX_POLICY_POSITIONAL);
+	m_p0Backend->execCommands();
+	const auto& aCommands = m_p0Backend->getExecutedCommands();
+	REQUIRE(aCommands.size() == 4);
+	REQUIRE(aCommands[0].m_bMonoDownmix);
+	REQUIRE_FALSE(aCommands[1].m_bMonoDownmix);
+	REQUIRE_FALSE(aCommands[2].m_bMonoDownmix);
+	REQUIRE(aCommands[3].m_bMonoDownmix);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "RenderOffline")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 30);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundA = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	// chain b.wav to the end of a.wav
+	int32_t nSoundIdB = -1;
+	auto refChainListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+	{
+		auto refFinished = std::dynamic_pointer_cast<SndFinishedEvent>(refEvent);
+		if (refFinished && (refFinished->getSoundId() == oSoundA.m_nSoundId)) {
+			nSoundIdB = refPlayback->playSound("b.wav", 1.0, false, false, 0.0, 0.0, 0.0).m_nSoundId;
+		}
+	});
+	m_refAlDM->addEventListener(refChainListener);
+
+	REQUIRE(m_refAlDM->renderOffline(60, true) == 60);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	REQUIRE(m_refAlDM->renderOffline(1000, true) == 70);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundA.m_nSoundId);
+	REQUIRE(nSoundIdB >= 0);
+	REQUIRE(aFinished[1]->getSoundId() == nSoundIdB);
+	// idle
+	REQUIRE(m_refAlDM->renderOffline(1000, true) == 0);
+	REQUIRE(m_refAlDM->renderOffline(25, false) == 25);
+	REQUIRE(m_p0Backend->getNowMillisec() == 155);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "ThreadSafePlayback")
+{
+	REQUIRE_FALSE(m_refAlDM->isThreadSafePlayback());
+	m_refAlDM->setThreadSafePlayback(true);
+	REQUIRE(m_refAlDM->isThreadSafePlayback());
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("a.wav");
+	REQUIRE(nFileId >= 0);
+
+	const int32_t nTotThreads = 4;
+	const int32_t nTotPerThread = 250;
+	std::vector<std::vector<int32_t>> aThreadSoundIds(nTotThreads);
+	std::vector<std::vector<int32_t>> aThreadFileIds(nTotThreads);
+	std::vector<std::thread> aThreads;
+	for (int32_t nThread = 0; nThread < nTotThreads; ++nThread) {
+		aThreads.emplace_back([&, nThread]()
+		{
+			auto& aSoundIds = aThreadSoundIds[nThread];
+			for (int32_t nCount = 0; nCount < nTotPerThread; ++nCount) {
+				aSoundIds.push_back(refPlayback->playSound(nFileId, 1.0, false, false, 0.0, 0.0, 0.0));
+			}
+			// concurrent registration of the same files
+			aThreadFileIds[nThread].push_back(refPlayback->preloadSound("b.wav"));
+			aThreadFileIds[nThread].push_back(refPlayback->playSound("c.wav", 1.0, false, false, 0.0, 0.0, 0.0).m_nFileId);
+			// stop every other sound of this thread
+			for (int32_t nCount = 0; nCount < nTotPerThread; nCount += 2) {
+				refPlayback->stopSound(aSoundIds[nCount]);
+			}
+		});
+	}
+	for (auto& oThread : aThreads) {
+		oThread.join();
+	}
+	std::set<int32_t> oSoundIds;
+	for (const auto& aSoundIds : aThreadSoundIds) {
+		for (const int32_t nSoundId : aSoundIds) {
+			REQUIRE(nSoundId >= 0);
+			oSoundIds.insert(nSoundId);
+		}
+	}
+	REQUIRE(oSoundIds.size() == static_cast<std::size_t>(nTotThreads * nTotPerThread));
+	for (const auto& aFileIds : aThreadFileIds) {
+		REQUIRE(aFileIds == aThreadFileIds[0]);
+	}
+
+	m_p0Backend->advanceMillisec(10);
+	for (const auto& aSoundIds : aThreadSoundIds) {
+		for (int32_t nCount = 0; nCount < nTotPerThread; ++nCount) {
+			const bool bStopped = ((nCount % 2) == 0);
+			REQUIRE((m_p0Backend->getSound(0, aSoundIds[nCount]) == nullptr) == bStopped);
+		}
+	}
+	m_p0Backend->advanceMillisec(100);
+	// the sounds played by the worker threads are reported to the listener
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == static_cast<std::size_t>(nTotThreads * nTotPerThread / 2));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "ThreadSafePlaybackContendedProducers")
+{
+	m_refAlDM->setThreadSafePlayback(true);
+	m_p0Backend->setFileDuration("a.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileId = refPlayback->preloadSound("a.wav");
+	REQUIRE(nFileId >= 0);
+
+	const int32_t nTotProducers = 8;
+	const int32_t nTotPerProducer = 200;
+	std::vector<std::vector<int32_t>> aProducerSoundIds(nTotProducers);
+	std::vector<std::thread> aProducers;
+	// all the producers start together so that they contend for the same locks
+	std::atomic<int32_t> nReady(0);
+	std::atomic<bool> bGo(false);
+	for (int32_t nProducer = 0; nProducer < nTotProducers; ++nProducer) {
+		aProducers.emplace_back([&, nProducer]()
+		{
+			auto& aSoundIds = aProducerSoundIds[nProducer];
+			++nReady;
+			while (! bGo.load()) {
+				std::this_thread::yield();
+			}
+			for (int32_t nCount = 0; nCount < nTotPerProducer; ++nCount) {
+				// a play+stop pair followed by a sound that is left playing
+				const int32_t nStoppedId = refPlayback->playSound(nFileId, 1.0, false, false, 0.0, 0.0, 0.0);
+				aSoundIds.push_back(nStoppedId);
+				refPlayback->stopSound(nStoppedId);
+				aSoundIds.push_back(refPlayback->playSound(nFileId, 1.0, false, false, 0.0, 0.0, 0.0));
+			}
+		});
+	}
+	while (nReady.load() < nTotProducers) {
+		std::this_thread::yield();
+	}
+	bGo = true;
+	for (auto& oProducer : aProducers) {
+		oProducer.join();
+	}
+	std::set<int32_t> oSoundIds;
+	std::set<int32_t> oPlayingIds;
+	for (const auto& aSoundIds : aProducerSoundIds) {
+		REQUIRE(aSoundIds.size() == static_cast<std::size_t>(2 * nTotPerProducer));
+		for (std::size_t nIdx = 0; nIdx < aSoundIds.size(); ++nIdx) {
+			REQUIRE(aSoundIds[nIdx] >= 0);
+			oSoundIds.insert(aSoundIds[nIdx]);
+			if ((nIdx % 2) == 1) {
+				oPlayingIds.insert(aSoundIds[nIdx]);
+			}
+		}
+	}
+	// every sound id is unique
+	REQUIRE(oSoundIds.size() == static_cast<std::size_t>(2 * nTotProducers * nTotPerProducer));
+
+	m_p0Backend->advanceMillisec(10);
+	// every sound that wasn't stopped is played by the backend
+	for (const auto& aSoundIds : aProducerSoundIds) {
+		for (std::size_t nIdx = 0; nIdx < aSoundIds.size(); ++nIdx) {
+			const bool bStopped = ((nIdx % 2) == 0);
+			REQUIRE((m_p0Backend->getSound(0, aSoundIds[nIdx]) == nullptr) == bStopped);
+		}
+	}
+	m_p0Backend->advanceMillisec(100);
+	// and finishes exactly once
+	std::set<int32_t> oFinishedIds;
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	for (const auto& refFinished : aFinished) {
+		oFinishedIds.insert(refFinished->getSoundId());
+	}
+	REQUIRE(aFinished.size() == oPlayingIds.size());
+	REQUIRE(oFinishedIds == oPlayingIds);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "EventFDDispatchPending")
+{
+	const int32_t nFD = m_refAlDM->getEventFD();
+	REQUIRE(nFD >= 0);
+	REQUIRE_FALSE(isReadable(nFD, 0));
+	m_p0Backend->setFileDuration("a.wav", 10);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundData = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oNotFound = refPlayback->playSound("notfound.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->execCommands();
+	// the error event is pending
+	REQUIRE(isReadable(nFD, 0));
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().empty());
+	m_refAlDM->dispatchPending();
+	REQUIRE_FALSE(isReadable(nFD, 0));
+	auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 1);
+	REQUIRE(aFinished[0]->getSoundId() == oNotFound.m_nSoundId);
+	REQUIRE(aFinished[0]->getFinishedType() == SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND);
+	// nothing pending
+	m_refAlDM->dispatchPending();
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 1);
+	m_p0Backend->advanceMillisec(20);
+	aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[1]->getSoundId() == oSoundData.m_nSoundId);
+	REQUIRE_FALSE(isReadable(nFD, 0));
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "DispatchPendingNotReentered")
+{
+	m_p0Backend->setFileDuration("a.wav", 10);
+	m_p0Backend->setFileDuration("b.wav", 10);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const auto oSoundA = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oSoundB = refPlayback->playSound("b.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	int32_t nTotNestedCalls = 0;
+	int32_t nNestedRendered = -1;
+	auto refNestingListener = std::make_shared<EventListener>([&](const shared_ptr<Event>& refEvent)
+	{
+		auto refFinished = std::dynamic_pointer_cast<SndFinishedEvent>(refEvent);
+		if (refFinished && (nTotNestedCalls == 0)) {
+			++nTotNestedCalls;
+			// both do nothing while the events are being sent
+			m_refAlDM->dispatchPending();
+			nNestedRendered = m_refAlDM->renderOffline(50, false);
+		}
+	});
+	m_refAlDM->addEventListener(refNestingListener);
+	m_p0Backend->advanceMillisec(20);
+	REQUIRE(nTotNestedCalls == 1);
+	REQUIRE(nNestedRendered == 0);
+	REQUIRE(m_p0Backend->getNowMillisec() == 20);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[0]->getSoundId() == oSoundA.m_nSoundId);
+	REQUIRE(aFinished[1]->getSoundId() == oSoundB.m_nSoundId);
+}
+
+TEST_CASE_METHOD(STFX<AlDMFixture>, "RealTimeListenerChainsSounds")
+{
+	m_p0Backend->setFileDuration("a.wav", 100);
+	m_p0Backend->setFileDuration("b.wav", 100);
+	auto refPlayback = getPlayback(m_refAlDM, "Fake0");
+	const int32_t nFileIdB = refPlayback->preloadSound("b.wav");
+	REQUIRE(nFileIdB >= 0);
+	const int32_t nSoundIdB = refPlayback->prepareSound(nFileIdB, 1.0, false, false, 0.0, 0.0, 0.0);
+	REQUIRE(nSoundIdB >= 0);
+	auto refRealTimeListener = std::make_shared<ChainingRealTimeListener>(refPlayback, nSoundIdB);
+	// called by another thread
+	REQUIRE_FALSE(m_refAlDM->setRealTimeListener(refRealTimeListener));
+	m_refAlDM->setThreadSafePlayback(true);
+	REQUIRE(m_refAlDM->setRealTimeListener(refRealTimeListener));
+	const auto oSoundA = refPlayback->playSound("a.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	const auto oNotFound = refPlayback->playSound("notfound.wav", 1.0, false, false, 0.0, 0.0, 0.0);
+	m_p0Backend->advanceMillisec(50);
+	REQUIRE(refRealTimeListener->m_aFinished.size() == 1);
+	REQUIRE(refRealTimeListener->m_aFinished[0].first == oNotFound.m_nSoundId);
+	REQUIRE(refRealTimeListener->m_aFinished[0].second == SndFinishedEvent::FINISHED_TYPE_FILE_NOT_FOUND);
+	REQUIRE_FALSE(refRealTimeListener->m_bTriggered);
+	REQUIRE(m_p0Backend->getSound(0, nSoundIdB)->m_nTriggerSlot >= 0);
+	m_p0Backend->advanceMillisec(60);
+	REQUIRE(refRealTimeListener->m_aFinished.size() == 2);
+	REQUIRE(refRealTimeListener->m_aFinished[1].first == oSoundA.m_nSoundId);
+	REQUIRE(refRealTimeListener->m_aFinished[1].second == SndFinishedEvent::FINISHED_TYPE_COMPLETED);
+	REQUIRE(refRealTimeListener->m_bTriggered);
+	// already started when the event listeners are told that a.wav finished
+	REQUIRE(m_p0Backend->getSound(0, nSoundIdB)->m_nTriggerSlot < 0);
+	const auto aFinished = getReceivedEvents<SndFinishedEvent>();
+	REQUIRE(aFinished.size() == 2);
+	REQUIRE(aFinished[1]->getSoundId() == oSoundA.m_nSoundId);
+
+	REQUIRE(m_refAlDM->setRealTimeListener(shared_ptr<SndRealTimeListener>{}));
+	m_p0Backend->advanceMillisec(110);
+	REQUIRE(m_p0Backend->getSound(0, nSoundIdB) == nullptr);
+	REQUIRE(refRealTimeListener->m_aFinished.size() == 2);
+	REQUIRE(getReceivedEvents<SndFinishedEvent>().size() == 3);
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testOpenAlOffline.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "wavbuffer.h"
+
+#include "openaldevicemanager.h"
+#include "openalbackend.h"
+
+#include <stmm-input-au/playbackcapability.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stmi
+{
+
+using std::shared_ptr;
+
+namespace testing
+{
+
+namespace
+{
+/** Offline OpenAL instance giving access to its backend. */
+class OfflineOpenAlDeviceManager : public OpenAlDeviceManager
+{
+public:
+	/** Creates an offline instance with an OpenAlBackend.
+	 * @return The instance or null if OpenAL can't render offline (ex. no ALC_SOFT_loopback).
+	 */
+	static shared_ptr<OfflineOpenAlDeviceManager> create() noexcept
+	{
+		shared_ptr<OfflineOpenAlDeviceManager> refInstance(new OfflineOpenAlDeviceManager());
+		auto refBackend = Private::OpenAl::OpenAlBackend::createOffline(refInstance.get(), LoopbackInit{});
+		refInstance->m_p0Backend = refBackend.get();
+		const std::string sError = refInstance->init(std::move(refBackend));
+		if (! sError.empty()) {
+			return shared_ptr<OfflineOpenAlDeviceManager>{}; //-----------------
+		}
+		return refInstance;
+	}
+	/** The backend.
+	 * @return The backend owned by this instance.
+	 */
+	Private::OpenAl::OpenAlBackend& getBackend() noexcept { return *m_p0Backend; }
+protected:
+	OfflineOpenAlDeviceManager() noexcept
+	: OpenAlDeviceManager(false, {})
+	, m_p0Backend(nullptr)
+	{
+	}
+private:
+	Private::OpenAl::OpenAlBackend* m_p0Backend;
+};
+
+shared_ptr<PlaybackCapability> getLoopbackPlayback(const shared_ptr<DeviceManager>& refDM) noexcept
+{
+	for (const auto& refDevice : refDM->getDevices()) {
+		shared_ptr<PlaybackCapability> refPlayback;
+		refDevice->getCapability(refPlayback);
+		if (refPlayback) {
+			return refPlayback;
+		}
+	}
+	return shared_ptr<PlaybackCapability>{};
+}
+// 100 milliseconds of silence at the default loopback frequency
+std::vector<uint8_t> makeSilentWav() noexcept
+{
+	const int32_t nFrequency = OpenAlDeviceManager::LoopbackInit{}.m_nFrequency;
+	return makeWav16(nFrequency, 1, std::vector<int16_t>(nFrequency / 10, 0));
+}
+} // unnamed namespace
+
+TEST_CASE("OpenAlOfflineFadeOutRecyclesFinishedEvents")
+{
+	auto refDM = OfflineOpenAlDeviceManager::create();
+	if (! refDM) {
+		WARN("OpenAL can't render offline: skipped");
+		return; //--------------------------------------------------------------
+	}
+	auto refPlayback = getLoopbackPlayback(refDM);
+	REQUIRE(refPlayback);
+	const auto aWav = makeSilentWav();
+	const int32_t nTotSounds = 4;
+	auto oPlayAndFadeOut = [&]()
+	{
+		for (int32_t nCount = 0; nCount < nTotSounds; ++nCount) {
+			const auto oSound = refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, true, true, 0.0, 0.0, 0.0);
+			REQUIRE(oSound.m_nSoundId >= 0);
+			REQUIRE(refPlayback->fadeOutAndStop(oSound.m_nSoundId, 20, PlaybackCapability::RAMP_CURVE_LINEAR));
+		}
+		REQUIRE(refDM->renderOffline(200, false) == 200);
+	};
+	oPlayAndFadeOut();
+	// an entry for each sound playing at the same time
+	const int32_t nTotToFinish = refDM->getBackend().getTotToFinishAlEvents();
+	REQUIRE(nTotToFinish >= nTotSounds);
+	for (int32_t nRound = 0; nRound < 10; ++nRound) {
+		oPlayAndFadeOut();
+	}
+	// the entries of the faded out sounds are recycled
+	REQUIRE(refDM->getBackend().getTotToFinishAlEvents() == nTotToFinish);
+}
+
+TEST_CASE("OpenAlOfflineStopGroupRecyclesFinishedEvents")
+{
+	auto refDM = OfflineOpenAlDeviceManager::create();
+	if (! refDM) {
+		WARN("OpenAL can't render offline: skipped");
+		return; //--------------------------------------------------------------
+	}
+	auto refPlayback = getLoopbackPlayback(refDM);
+	REQUIRE(refPlayback);
+	const int32_t nGroupId = refPlayback->getSoundGroup("Music");
+	REQUIRE(nGroupId >= 0);
+	const auto aWav = makeSilentWav();
+	const int32_t nTotSounds = 4;
+	auto oPlayAndStopGroup = [&]()
+	{
+		for (int32_t nCount = 0; nCount < nTotSounds; ++nCount) {
+			const auto oSound = refPlayback->playSoundInGroup(nGroupId, aWav.data(), static_cast<int32_t>(aWav.size())
+															, 1.0, true, true, 0.0, 0.0, 0.0);
+			REQUIRE(oSound.m_nSoundId >= 0);
+		}
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+		REQUIRE(refPlayback->stopGroup(nGroupId));
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+	};
+	oPlayAndStopGroup();
+	const int32_t nTotToFinish = refDM->getBackend().getTotToFinishAlEvents();
+	REQUIRE(nTotToFinish >= nTotSounds);
+	for (int32_t nRound = 0; nRound < 10; ++nRound) {
+		oPlayAndStopGroup();
+	}
+	// the entries of the stopped sounds are recycled
+	REQUIRE(refDM->getBackend().getTotToFinishAlEvents() == nTotToFinish);
+}
+
+TEST_CASE("OpenAlOfflineStopRecyclesFinishedEvents")
+{
+	auto refDM = OfflineOpenAlDeviceManager::create();
+	if (! refDM) {
+		WARN("OpenAL can't render offline: skipped");
+		return; //--------------------------------------------------------------
+	}
+	auto refPlayback = getLoopbackPlayback(refDM);
+	REQUIRE(refPlayback);
+	const auto aWav = makeSilentWav();
+	const int32_t nTotSounds = 4;
+	auto oPlayAndStop = [&]()
+	{
+		std::vector<int32_t> aSoundIds;
+		for (int32_t nCount = 0; nCount < nTotSounds; ++nCount) {
+			const auto oSound = refPlayback->playSound(aWav.data(), static_cast<int32_t>(aWav.size()), 1.0, false, true, 0.0, 0.0, 0.0);
+			REQUIRE(oSound.m_nSoundId >= 0);
+			aSoundIds.push_back(oSound.m_nSoundId);
+		}
+		// stopped before they finish
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+		for (const int32_t nSoundId : aSoundIds) {
+			REQUIRE(refPlayback->stopSound(nSoundId));
+		}
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+	};
+	oPlayAndStop();
+	const int32_t nTotToFinish = refDM->getBackend().getTotToFinishAlEvents();
+	REQUIRE(nTotToFinish >= nTotSounds);
+	for (int32_t nRound = 0; nRound < 10; ++nRound) {
+		oPlayAndStop();
+	}
+	// the entries of the stopped sounds are recycled
+	REQUIRE(refDM->getBackend().getTotToFinishAlEvents() == nTotToFinish);
+}
+
+TEST_CASE("OpenAlOfflineStopScheduledRecyclesFinishedEvents")
+{
+	auto refDM = OfflineOpenAlDeviceManager::create();
+	if (! refDM) {
+		WARN("OpenAL can't render offline: skipped");
+		return; //--------------------------------------------------------------
+	}
+	auto refPlayback = getLoopbackPlayback(refDM);
+	REQUIRE(refPlayback);
+	const auto aWav = makeSilentWav();
+	const int32_t nFileId = refPlayback->preloadSound(aWav.data(), static_cast<int32_t>(aWav.size()));
+	REQUIRE(nFileId >= 0);
+	REQUIRE(refDM->renderOffline(10, false) == 10);
+	const int32_t nTotSounds = 4;
+	auto oScheduleAndStop = [&]()
+	{
+		const int64_t nStartNanosec = refPlayback->getDeviceClockNanosec() + 1000000000;
+		std::vector<int32_t> aSoundIds;
+		for (int32_t nCount = 0; nCount < nTotSounds; ++nCount) {
+			const int32_t nSoundId = refPlayback->playSoundAt(nFileId, nStartNanosec, 1.0, false, true, 0.0, 0.0, 0.0);
+			REQUIRE(nSoundId >= 0);
+			aSoundIds.push_back(nSoundId);
+		}
+		// stopped before they start
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+		for (const int32_t nSoundId : aSoundIds) {
+			REQUIRE(refPlayback->stopSound(nSoundId));
+		}
+		REQUIRE(refDM->renderOffline(20, false) == 20);
+	};
+	oScheduleAndStop();
+	const int32_t nTotToFinish = refDM->getBackend().getTotToFinishAlEvents();
+	REQUIRE(nTotToFinish >= nTotSounds);
+	for (int32_t nRound = 0; nRound < 10; ++nRound) {
+		oScheduleAndStop();
+	}
+	// the entries of the stopped scheduled sounds are recycled
+	REQUIRE(refDM->getBackend().getTotToFinishAlEvents() == nTotToFinish);
+}
+
+TEST_CASE("OpenAlOfflineTriggerLatency")
+{
+	auto refDM = OfflineOpenAlDeviceManager::create();
+	if (! refDM) {
+		WARN("OpenAL can't render offline: skipped");
+		return; //--------------------------------------------------------------
+	}
+	refDM->setLatencyStatsEnabled(true);
+	auto refPlayback = getLoopbackPlayback(refDM);
+	REQUIRE(refPlayback);
+	const auto aWav = makeSilentWav();
+	const int32_t nFileId = refPlayback->preloadSound(aWav.data(), static_cast<int32_t>(aWav.size()));
+	REQUIRE(nFileId >= 0);
+	const int32_t nTotTriggers = 10;
+	for (int32_t nTrigger = 0; nTrigger < nTotTriggers; ++nTrigger) {
+		const int32_t nSoundId = refPlayback->prepareSound(nFileId, 1.0, false, true, 0.0, 0.0, 0.0);
+		REQUIRE(nSoundId >= 0);
+		// the source is set up but not started
+		REQUIRE(refDM->renderOffline(10, false) == 10);
+		REQUIRE(refPlayback->triggerSound(nSoundId));
+		REQUIRE(refDM->renderOffline(10, false) == 10);
+		REQUIRE(refPlayback->stopSound(nSoundId));
+	}
+	const auto oTrigger = refDM->getLatencyStats().m_oTrigger;
+	REQUIRE(oTrigger.m_nTotCount == static_cast<uint64_t>(nTotTriggers));
+	// the trigger is taken by the next render call: loose bound
+	REQUIRE(oTrigger.m_nMaxUsec < 1000000);
+}
+
+} // namespace testing
+
+} // namespace stmi
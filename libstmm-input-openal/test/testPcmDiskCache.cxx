@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testPcmDiskCache.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "pcmdiskcache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::PcmDiskCache;
+
+namespace
+{
+void writeFile(const std::string& sPath, const std::string& sContent) noexcept
+{
+	std::ofstream oFile(sPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	oFile << sContent;
+}
+} // unnamed namespace
+
+TEST_CASE("PcmDiskCacheStoreLookup")
+{
+	char aTemplate[] = "/tmp/stmi-pcmcache-XXXXXX";
+	REQUIRE(::mkdtemp(aTemplate) != nullptr);
+	const std::string sTempDir = aTemplate;
+	const std::string sCacheDir = sTempDir + "/cache";
+	const std::string sSoundPath = sTempDir + "/a.wav";
+	writeFile(sSoundPath, "not really a wav");
+
+	PcmDiskCache::Key oKey;
+	REQUIRE(PcmDiskCache::getFileKey(sSoundPath, oKey));
+	REQUIRE(oKey.m_nFileSize == 16);
+	oKey.m_nOptions = 3;
+	oKey.m_nTargetFrequency = 48000;
+
+	PcmDiskCache::Mapping oMapping;
+	REQUIRE_FALSE(PcmDiskCache::lookup(sCacheDir, oKey, oMapping));
+
+	const std::vector<int16_t> aSamples{1, -2, 3, -4, 5, -6, 7};
+	PcmDiskCache::Data oData;
+	oData.m_nFormat = 0x1101;
+	oData.m_nFrequency = 48000;
+	oData.m_bDownmixed = true;
+	oData.m_p0Data = reinterpret_cast<const uint8_t*>(aSamples.data());
+	oData.m_nDataSize = static_cast<int32_t>(aSamples.size() * sizeof(int16_t));
+	REQUIRE(PcmDiskCache::store(sCacheDir, oKey, oData).empty());
+
+	REQUIRE(PcmDiskCache::lookup(sCacheDir, oKey, oMapping));
+	{
+		const PcmDiskCache::Data& oMapped = oMapping.getData();
+		REQUIRE(oMapped.m_nFormat == 0x1101);
+		REQUIRE(oMapped.m_nFrequency == 48000);
+		REQUIRE(oMapped.m_nBlockFrames == 0);
+		REQUIRE(oMapped.m_bDownmixed);
+		REQUIRE(oMapped.m_nDataSize == oData.m_nDataSize);
+		// aligned for direct upload
+		REQUIRE((reinterpret_cast<uintptr_t>(oMapped.m_p0Data) % 64) == 0);
+		const int16_t* p0Mapped = reinterpret_cast<const int16_t*>(oMapped.m_p0Data);
+		REQUIRE(std::vector<int16_t>(p0Mapped, p0Mapped + aSamples.size()) == aSamples);
+	}
+	oMapping.release();
+	REQUIRE(oMapping.getData().m_p0Data == nullptr);
+
+	// other conversion options
+	PcmDiskCache::Key oOtherKey = oKey;
+	oOtherKey.m_nTargetFrequency = 44100;
+	REQUIRE_FALSE(PcmDiskCache::lookup(sCacheDir, oOtherKey, oMapping));
+
+	// the sound file changed
+	writeFile(sSoundPath, "not really a wav either");
+	PcmDiskCache::Key oChangedKey;
+	REQUIRE(PcmDiskCache::getFileKey(sSoundPath, oChangedKey));
+	oChangedKey.m_nOptions = oKey.m_nOptions;
+	oChangedKey.m_nTargetFrequency = oKey.m_nTargetFrequency;
+	REQUIRE_FALSE(PcmDiskCache::lookup(sCacheDir, oChangedKey, oMapping));
+
+	// corrupted entry
+	const std::string sEntryPath = PcmDiskCache::getEntryPath(sCacheDir, oKey);
+	writeFile(sEntryPath, "garbage");
+	REQUIRE_FALSE(PcmDiskCache::lookup(sCacheDir, oKey, oMapping));
+
+	REQUIRE_FALSE(PcmDiskCache::getFileKey(sTempDir + "/missing.wav", oOtherKey));
+
+	std::remove(sEntryPath.c_str());
+	std::remove(sSoundPath.c_str());
+	::rmdir(sCacheDir.c_str());
+	::rmdir(sTempDir.c_str());
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,210 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testPcmEncoder.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "pcmencoder.h"
+#include "wavdecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::PcmEncoder;
+using Private::OpenAl::PcmSound;
+
+namespace
+{
+PcmSound makeSound(int32_t nChannels, int32_t nTotFrames) noexcept
+{
+	PcmSound oSound;
+	oSound.m_nFrequency = 44100;
+	oSound.m_nChannels = nChannels;
+	oSound.m_aSamples.resize(nChannels * nTotFrames);
+	for (int32_t nFrame = 0; nFrame < nTotFrames; ++nFrame) {
+		for (int32_t nChannel = 0; nChannel < nChannels; ++nChannel) {
+			// a different frequency per channel
+			oSound.m_aSamples[nFrame * nChannels + nChannel] = static_cast<float>(0.8 * std::sin(nFrame * 0.05 * (nChannel + 1)));
+		}
+	}
+	return oSound;
+}
+int32_t toInt16(float fSample) noexcept
+{
+	return static_cast<int32_t>(std::lrint(fSample * 32767.0f));
+}
+// Reference decoders, as OpenAL Soft does
+int32_t decodeMulaw(uint8_t nByte) noexcept
+{
+	const int32_t nVal = (~nByte) & 0xFF;
+	const int32_t nMagnitude = ((((nVal & 0x0F) << 3) + 0x84) << ((nVal & 0x70) >> 4)) - 0x84;
+	return (((nVal & 0x80) != 0) ? -nMagnitude : nMagnitude);
+}
+void decodeIma4(const std::vector<uint8_t>& aData, int32_t nChannels, int32_t nBlockFrames, std::vector<int32_t>& aSamples) noexcept
+{
+	const int8_t* p0IndexTable = PcmEncoder::getIma4IndexTable();
+	const int16_t* p0StepTable = PcmEncoder::getIma4StepTable();
+	const int32_t nBlockBytes = PcmEncoder::getIma4BlockBytes(nChannels, nBlockFrames);
+	const int32_t nTotBlocks = static_cast<int32_t>(aData.size()) / nBlockBytes;
+	aSamples.assign(nTotBlocks * nBlockFrames * nChannels, 0);
+	for (int32_t nBlock = 0; nBlock < nTotBlocks; ++nBlock) {
+		const uint8_t* p0Block = aData.data() + nBlock * nBlockBytes;
+		int32_t* p0Out = aSamples.data() + nBlock * nBlockFrames * nChannels;
+		for (int32_t nChannel = 0; nChannel < nChannels; ++nChannel) {
+			const uint8_t* p0Header = p0Block + 4 * nChannel;
+			int32_t nPredictor = static_cast<int16_t>(p0Header[0] | (p0Header[1] << 8));
+			int32_t nStepIdx = p0Header[2];
+			p0Out[nChannel] = nPredictor;
+			for (int32_t nFrame = 1; nFrame < nBlockFrames; ++nFrame) {
+				const int32_t nGroup = (nFrame - 1) / 8;
+				const int32_t nInGroup = (nFrame - 1) % 8;
+				const uint8_t nByte = p0Block[4 * nChannels + (nGroup * nChannels + nChannel) * 4 + nInGroup / 2];
+				const int32_t nCode = (((nInGroup % 2) == 0) ? (nByte & 0x0F) : (nByte >> 4));
+				const int32_t nStep = p0StepTable[nStepIdx];
+				int32_t nDelta = nStep >> 3;
+				if ((nCode & 4) != 0) { nDelta += nStep; }
+				if ((nCode & 2) != 0) { nDelta += nStep >> 1; }
+				if ((nCode & 1) != 0) { nDelta += nStep >> 2; }
+				nPredictor += (((nCode & 8) != 0) ? -nDelta : nDelta);
+				nPredictor = std::min(32767, std::max(-32768, nPredictor));
+				nStepIdx = std::min(88, std::max(0, nStepIdx + p0IndexTable[nCode]));
+				p0Out[nFrame * nChannels + nChannel] = nPredictor;
+			}
+		}
+	}
+}
+} // unnamed namespace
+
+TEST_CASE("PcmEncoderMulaw")
+{
+	const PcmSound oSound = makeSound(2, 1000);
+	std::vector<uint8_t> aData;
+	PcmEncoder::encodeMulaw(oSound, aData);
+	REQUIRE(aData.size() == oSound.m_aSamples.size());
+	for (int32_t nIdx = 0; nIdx < static_cast<int32_t>(aData.size()); ++nIdx) {
+		const int32_t nOriginal = toInt16(oSound.m_aSamples[nIdx]);
+		const int32_t nDecoded = decodeMulaw(aData[nIdx]);
+		// logarithmic quantization: the error grows with the magnitude
+		REQUIRE(std::abs(nDecoded - nOriginal) <= 4 + std::abs(nOriginal) / 16);
+	}
+	PcmSound oSilence;
+	oSilence.m_nChannels = 1;
+	oSilence.m_aSamples = {0.0f, 1.0f, -1.0f};
+	PcmEncoder::encodeMulaw(oSilence, aData);
+	REQUIRE(aData[0] == 0xFF);
+	REQUIRE(decodeMulaw(aData[1]) == 32124);
+	REQUIRE(decodeMulaw(aData[2]) == -32124);
+}
+
+TEST_CASE("PcmEncoderIma4")
+{
+	for (const int32_t nChannels : {1, 2}) {
+		for (const int32_t nBlockFrames : {65, 505}) {
+			INFO("Channels: " << nChannels << " block frames: " << nBlockFrames);
+			// not a multiple of the block size: the last block is padded
+			const int32_t nTotFrames = 3 * nBlockFrames + 7;
+			const PcmSound oSound = makeSound(nChannels, nTotFrames);
+			std::vector<uint8_t> aData;
+			PcmEncoder::encodeIma4(oSound, nBlockFrames, aData);
+			REQUIRE(static_cast<int32_t>(aData.size()) == 4 * PcmEncoder::getIma4BlockBytes(nChannels, nBlockFrames));
+			std::vector<int32_t> aDecoded;
+			decodeIma4(aData, nChannels, nBlockFrames, aDecoded);
+			double fErrorSquares = 0.0;
+			double fSignalSquares = 0.0;
+			for (int32_t nIdx = 0; nIdx < nTotFrames * nChannels; ++nIdx) {
+				const double fOriginal = toInt16(oSound.m_aSamples[nIdx]);
+				const double fError = aDecoded[nIdx] - fOriginal;
+				fErrorSquares += fError * fError;
+				fSignalSquares += fOriginal * fOriginal;
+			}
+			const double fSnrDb = 10.0 * std::log10(fSignalSquares / fErrorSquares);
+			REQUIRE(fSnrDb > 20.0);
+			// the first frame of each block is exact
+			REQUIRE(aDecoded[nBlockFrames * nChannels] == toInt16(oSound.m_aSamples[nBlockFrames * nChannels]));
+			// padding is silent-ish
+			REQUIRE(std::abs(aDecoded.back()) < 2000);
+		}
+	}
+}
+
+// Not run by default: testPcmEncoder "[.benchmark]"
+// Resident memory of the formats against the cost of decoding them while mixing.
+TEST_CASE("PcmEncoderBenchmark", "[.benchmark]")
+{
+	const int32_t nFrequency = 44100;
+	const int32_t nTotFrames = nFrequency * 10;
+	const PcmSound oSound = makeSound(1, nTotFrames);
+	const int64_t nPcm16Bytes = static_cast<int64_t>(nTotFrames) * 2;
+	std::vector<int16_t> aPcm16(nTotFrames);
+	for (int32_t nIdx = 0; nIdx < nTotFrames; ++nIdx) {
+		aPcm16[nIdx] = static_cast<int16_t>(toInt16(oSound.m_aSamples[nIdx]));
+	}
+	std::vector<uint8_t> aMulaw;
+	PcmEncoder::encodeMulaw(oSound, aMulaw);
+	std::vector<uint8_t> aIma4;
+	PcmEncoder::encodeIma4(oSound, 505, aIma4);
+	WARN("PCM16: " << nPcm16Bytes << " bytes, mulaw: " << aMulaw.size() << " bytes (x"
+		<< static_cast<double>(nPcm16Bytes) / aMulaw.size() << "), IMA4: " << aIma4.size() << " bytes (x"
+		<< static_cast<double>(nPcm16Bytes) / aIma4.size() << ")");
+
+	const double fAudioSec = static_cast<double>(nTotFrames) / nFrequency;
+	std::vector<float> aMix(nTotFrames);
+	auto reportVoices = [&](const char* p0Name, double fElapsedSec)
+	{
+		// How many voices a core could decode and mix in real time
+		WARN(p0Name << ": " << static_cast<int64_t>(fAudioSec / fElapsedSec) << " mono voices per core at " << nFrequency << " Hz");
+	};
+	{
+		const auto oStart = std::chrono::steady_clock::now();
+		for (int32_t nIdx = 0; nIdx < nTotFrames; ++nIdx) {
+			aMix[nIdx] += aPcm16[nIdx] * (0.5f / 32768.0f);
+		}
+		reportVoices("PCM16", std::chrono::duration<double>(std::chrono::steady_clock::now() - oStart).count());
+	}
+	{
+		const auto oStart = std::chrono::steady_clock::now();
+		for (int32_t nIdx = 0; nIdx < nTotFrames; ++nIdx) {
+			aMix[nIdx] += decodeMulaw(aMulaw[nIdx]) * (0.5f / 32768.0f);
+		}
+		reportVoices("mulaw", std::chrono::duration<double>(std::chrono::steady_clock::now() - oStart).count());
+	}
+	{
+		const auto oStart = std::chrono::steady_clock::now();
+		std::vector<int32_t> aDecoded;
+		decodeIma4(aIma4, 1, 505, aDecoded);
+		for (int32_t nIdx = 0; nIdx < nTotFrames; ++nIdx) {
+			aMix[nIdx] += aDecoded[nIdx] * (0.5f / 32768.0f);
+		}
+		reportVoices("IMA4", std::chrono::duration<double>(std::chrono::steady_clock::now() - oStart).count());
+	}
+	REQUIRE(aMix[1] != 0.0f);
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testSoundBank.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "soundbank.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::SoundBank;
+
+TEST_CASE("SoundBankWriteOpen")
+{
+	char aTemplate[] = "/tmp/stmi-soundbank-XXXXXX";
+	REQUIRE(::mkdtemp(aTemplate) != nullptr);
+	const std::string sTempDir = aTemplate;
+	const std::string sBankPath = sTempDir + "/sounds.bank";
+
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> aEntries;
+	for (int32_t nIdx = 0; nIdx < 100; ++nIdx) {
+		std::vector<uint8_t> aData(static_cast<std::size_t>(nIdx * 7), static_cast<uint8_t>(nIdx));
+		aEntries.emplace_back("fx/sound" + std::to_string(nIdx) + ".wav", std::move(aData));
+	}
+	REQUIRE(SoundBank::write(sBankPath, aEntries).empty());
+
+	SoundBank oBank;
+	REQUIRE(oBank.open(sBankPath).empty());
+	REQUIRE(oBank.getPath() == sBankPath);
+	REQUIRE(oBank.getTotEntries() == 100);
+	for (int32_t nIdx = 0; nIdx < 100; ++nIdx) {
+		const auto& oEntry = aEntries[nIdx];
+		REQUIRE(oBank.getEntryName(nIdx) == oEntry.first);
+		REQUIRE(oBank.findEntry(oEntry.first) == nIdx);
+		REQUIRE(oBank.getEntrySize(nIdx) == static_cast<int32_t>(oEntry.second.size()));
+		const uint8_t* p0Data = oBank.getEntryData(nIdx);
+		// aligned for direct upload
+		REQUIRE((reinterpret_cast<uintptr_t>(p0Data) % 64) == 0);
+		REQUIRE(std::vector<uint8_t>(p0Data, p0Data + oEntry.second.size()) == oEntry.second);
+	}
+	REQUIRE(oBank.findEntry("fx/sound100.wav") == -1);
+	REQUIRE(oBank.findEntry("") == -1);
+
+	oBank.close();
+	REQUIRE(oBank.getTotEntries() == 0);
+	REQUIRE(oBank.findEntry("fx/sound1.wav") == -1);
+
+	std::remove(sBankPath.c_str());
+	::rmdir(sTempDir.c_str());
+}
+
+TEST_CASE("SoundBankEmpty")
+{
+	char aTemplate[] = "/tmp/stmi-soundbank-XXXXXX";
+	REQUIRE(::mkdtemp(aTemplate) != nullptr);
+	const std::string sTempDir = aTemplate;
+	const std::string sBankPath = sTempDir + "/empty.bank";
+
+	REQUIRE(SoundBank::write(sBankPath, {}).empty());
+	SoundBank oBank;
+	REQUIRE(oBank.open(sBankPath).empty());
+	REQUIRE(oBank.getTotEntries() == 0);
+	REQUIRE(oBank.findEntry("a.wav") == -1);
+
+	std::remove(sBankPath.c_str());
+	::rmdir(sTempDir.c_str());
+}
+
+TEST_CASE("SoundBankErrors")
+{
+	char aTemplate[] = "/tmp/stmi-soundbank-XXXXXX";
+	REQUIRE(::mkdtemp(aTemplate) != nullptr);
+	const std::string sTempDir = aTemplate;
+	const std::string sBankPath = sTempDir + "/bad.bank";
+
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> aEntries;
+	aEntries.emplace_back("a.wav", std::vector<uint8_t>{1, 2, 3});
+	aEntries.emplace_back("a.wav", std::vector<uint8_t>{4, 5});
+	REQUIRE_FALSE(SoundBank::write(sBankPath, aEntries).empty());
+	aEntries.back().first = "";
+	REQUIRE_FALSE(SoundBank::write(sBankPath, aEntries).empty());
+
+	SoundBank oBank;
+	REQUIRE_FALSE(oBank.open(sTempDir + "/missing.bank").empty());
+
+	aEntries.back().first = "b.wav";
+	REQUIRE(SoundBank::write(sBankPath, aEntries).empty());
+	{
+		// truncated
+		std::ifstream oIn(sBankPath, std::ios::in | std::ios::binary);
+		std::string sContent((std::istreambuf_iterator<char>(oIn)), std::istreambuf_iterator<char>());
+		oIn.close();
+		std::ofstream oOut(sBankPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		oOut << sContent.substr(0, sContent.size() - 1);
+	}
+	REQUIRE_FALSE(oBank.open(sBankPath).empty());
+	REQUIRE(oBank.getTotEntries() == 0);
+	{
+		std::ofstream oOut(sBankPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		oOut << "garbage";
+	}
+	REQUIRE_FALSE(oBank.open(sBankPath).empty());
+
+	std::remove(sBankPath.c_str());
+	::rmdir(sTempDir.c_str());
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   testTraceRecorder.cxx
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "tracerecorder.h"
+
+#include <sstream>
+#include <string>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+using Private::OpenAl::TraceRecorder;
+
+namespace
+{
+int32_t countOccurrences(const std::string& sText, const std::string& sSub) noexcept
+{
+	int32_t nCount = 0;
+	auto nPos = sText.find(sSub);
+	while (nPos != std::string::npos) {
+		++nCount;
+		nPos = sText.find(sSub, nPos + sSub.size());
+	}
+	return nCount;
+}
+} // namespace
+
+TEST_CASE("testTraceRecorder, Write")
+{
+	TraceRecorder oRecorder;
+	REQUIRE_FALSE(oRecorder.isEnabled());
+	auto& oMainRing = oRecorder.addThread("main");
+	auto& oOtherRing = oRecorder.addThread("other");
+	oMainRing.addSpan("spanA", 100, 150);
+	oOtherRing.addSpan("spanB", 120, 125);
+	std::ostringstream oOut;
+	oRecorder.write(oOut);
+	const std::string sJson = oOut.str();
+	REQUIRE(sJson.find("{\"traceEvents\":[") == 0);
+	REQUIRE(countOccurrences(sJson, "\"ph\":\"M\"") == 2);
+	REQUIRE(sJson.find("\"args\":{\"name\":\"other\"}") != std::string::npos);
+	REQUIRE(sJson.find("{\"name\":\"spanA\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":100,\"dur\":50}") != std::string::npos);
+	REQUIRE(sJson.find("{\"name\":\"spanB\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":120,\"dur\":5}") != std::string::npos);
+
+	oRecorder.clear();
+	std::ostringstream oOutCleared;
+	oRecorder.write(oOutCleared);
+	REQUIRE(countOccurrences(oOutCleared.str(), "\"ph\":\"X\"") == 0);
+}
+
+TEST_CASE("testTraceRecorder, RingOverwritesOldest")
+{
+	TraceRecorder oRecorder;
+	auto& oRing = oRecorder.addThread("main");
+	const int32_t nTotSpans = 10000;
+	for (int32_t nSpan = 0; nSpan < nTotSpans; ++nSpan) {
+		oRing.addSpan((nSpan == 0) ? "first" : "other", nSpan, nSpan + 1);
+	}
+	std::ostringstream oOut;
+	oRecorder.write(oOut);
+	const std::string sJson = oOut.str();
+	const int32_t nTotWritten = countOccurrences(sJson, "\"ph\":\"X\"");
+	REQUIRE(nTotWritten > 0);
+	REQUIRE(nTotWritten < nTotSpans);
+	REQUIRE(sJson.find("\"first\"") == std::string::npos);
+	REQUIRE(sJson.find("\"ts\":" + std::to_string(nTotSpans - 1) + ",") != std::string::npos);
+}
+
+} // namespace testing
+
+} // namespace stmi
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   wavbuffer.h
+ */
+
+#ifndef STMI_TESTING_WAV_BUFFER_H
+#define STMI_TESTING_WAV_BUFFER_H
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace stmi
+{
+
+namespace testing
+{
+
+inline void appendWavUInt16(std::vector<uint8_t>& aData, uint16_t nValue) noexcept
+{
+	aData.push_back(static_cast<uint8_t>(nValue & 0xFF));
+	aData.push_back(static_cast<uint8_t>(nValue >> 8));
+}
+inline void appendWavUInt32(std::vector<uint8_t>& aData, uint32_t nValue) noexcept
+{
+	appendWavUInt16(aData, static_cast<uint16_t>(nValue & 0xFFFF));
+	appendWavUInt16(aData, static_cast<uint16_t>(nValue >> 16));
+}
+/** Creates the content of a 16 bit PCM WAV file.
+ * @param nFrequency The sample rate.
+ * @param nChannels The number of channels.
+ * @param aSamples The interleaved samples.
+ * @return The file content.
+ */
+inline std::vector<uint8_t> makeWav16(int32_t nFrequency, int32_t nChannels, const std::vector<int16_t>& aSamples) noexcept
+{
+	std::vector<uint8_t> aData;
+	const uint32_t nDataSize = static_cast<uint32_t>(aSamples.size() * 2);
+	aData.insert(aData.end(), {'R', 'I', 'F', 'F'});
+	appendWavUInt32(aData, 36 + nDataSize);
+	aData.insert(aData.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+	appendWavUInt32(aData, 16);
+	appendWavUInt16(aData, 1); // PCM
+	appendWavUInt16(aData, static_cast<uint16_t>(nChannels));
+	appendWavUInt32(aData, static_cast<uint32_t>(nFrequency));
+	appendWavUInt32(aData, static_cast<uint32_t>(nFrequency * nChannels * 2));
+	appendWavUInt16(aData, static_cast<uint16_t>(nChannels * 2));
+	appendWavUInt16(aData, 16);
+	aData.insert(aData.end(), {'d', 'a', 't', 'a'});
+	appendWavUInt32(aData, nDataSize);
+	for (const int16_t nSample : aSamples) {
+		appendWavUInt16(aData, static_cast<uint16_t>(nSample));
+	}
+	return aData;
+}
+
+} // namespace testing
+
+} // namespace stmi
+
+#endif /* STMI_TESTING_WAV_BUFFER_H */
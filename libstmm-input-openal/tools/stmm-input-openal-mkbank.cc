@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2020  Stefano Marsili, <stemars@gmx.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+/*
+ * File:   stmm-input-openal-mkbank.cc
+ */
+
+#include "soundbank.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace stmi
+{
+
+namespace
+{
+
+void printUsage() noexcept
+{
+	std::cout << "Usage: stmm-input-openal-mkbank [-h] SOUNDS_DIR BANK_FILE" << '\n';
+	std::cout << "Build a sound bank from the files in a directory." << '\n';
+	std::cout << "The entries are named after the path of the files relative" << '\n';
+	std::cout << "to SOUNDS_DIR (ex. \"explosions/big.wav\")." << '\n';
+}
+
+// Collects the relative paths of the regular files, recursively
+bool collectFiles(const std::string& sBaseDir, const std::string& sRelDir, std::vector<std::string>& aRelPaths) noexcept
+{
+	const std::string sDir = (sRelDir.empty() ? sBaseDir : sBaseDir + "/" + sRelDir);
+	DIR* p0Dir = ::opendir(sDir.c_str());
+	if (p0Dir == nullptr) {
+		std::cout << "Error: could not open directory " << sDir << '\n';
+		return false; //--------------------------------------------------------
+	}
+	bool bOk = true;
+	while (const struct dirent* p0Entry = ::readdir(p0Dir)) {
+		const std::string sName = p0Entry->d_name;
+		if ((sName == ".") || (sName == "..")) {
+			continue;
+		}
+		const std::string sRelPath = (sRelDir.empty() ? sName : sRelDir + "/" + sName);
+		struct stat oStat;
+		if (::stat((sBaseDir + "/" + sRelPath).c_str(), &oStat) != 0) {
+			continue;
+		}
+		if (S_ISDIR(oStat.st_mode)) {
+			bOk = collectFiles(sBaseDir, sRelPath, aRelPaths);
+			if (! bOk) {
+				break;
+			}
+		} else if (S_ISREG(oStat.st_mode)) {
+			aRelPaths.push_back(sRelPath);
+		}
+	}
+	::closedir(p0Dir);
+	return bOk;
+}
+
+bool readFile(const std::string& sPath, std::vector<uint8_t>& aData) noexcept
+{
+	std::ifstream oFile(sPath, std::ios::in | std::ios::binary);
+	if (! oFile) {
+		return false; //--------------------------------------------------------
+	}
+	aData.assign(std::istreambuf_iterator<char>(oFile), std::istreambuf_iterator<char>());
+	return ! oFile.bad();
+}
+
+int mkBank(int nArgC, char** aArgV) noexcept
+{
+	std::vector<std::string> aArgs;
+	for (int nIdx = 1; nIdx < nArgC; ++nIdx) {
+		const std::string sArg = aArgV[nIdx];
+		if ((sArg == "-h") || (sArg == "--help")) {
+			printUsage();
+			return 0; //--------------------------------------------------------
+		}
+		aArgs.push_back(sArg);
+	}
+	if (aArgs.size() != 2) {
+		printUsage();
+		return 1; //------------------------------------------------------------
+	}
+	const std::string& sSoundsDir = aArgs[0];
+	const std::string& sBankPath = aArgs[1];
+
+	std::vector<std::string> aRelPaths;
+	if (! collectFiles(sSoundsDir, "", aRelPaths)) {
+		return 1; //------------------------------------------------------------
+	}
+	// Deterministic output
+	std::sort(aRelPaths.begin(), aRelPaths.end());
+
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> aEntries;
+	aEntries.reserve(aRelPaths.size());
+	for (const auto& sRelPath : aRelPaths) {
+		std::vector<uint8_t> aData;
+		if (! readFile(sSoundsDir + "/" + sRelPath, aData)) {
+			std::cout << "Error: could not read file " << sRelPath << '\n';
+			return 1; //--------------------------------------------------------
+		}
+		aEntries.emplace_back(sRelPath, std::move(aData));
+	}
+	const std::string sError = Private::OpenAl::SoundBank::write(sBankPath, aEntries);
+	if (! sError.empty()) {
+		std::cout << "Error: " << sError << '\n';
+		return 1; //------------------------------------------------------------
+	}
+	std::cout << "Written " << aEntries.size() << " entries to " << sBankPath << '\n';
+	return 0;
+}
+
+} // unnamed namespace
+
+} // namespace stmi
+
+int main(int nArgC, char** aArgV)
+{
+	return stmi::mkBank(nArgC, aArgV);
+}